@@ -17,6 +17,10 @@
 #include <TH3D.h>
 #include <TH1I.h>
 #include "./JPetOptionsTools/JPetOptionsTools.h"
+#include "JPetParamBank/JPetParamBank.h"
+#include <algorithm>
+#include <limits>
+#include <cmath>
 using namespace jpet_options_tools;
 
 FilterEvents::FilterEvents(const char* name) : JPetUserTask(name) {}
@@ -43,6 +47,10 @@ bool FilterEvents::init()
   getStatistics().getObject<TH1I>("number_of_hits_filtered_by_condition")->Fill("Cut on second hit TOT", 1);
   getStatistics().getObject<TH1I>("number_of_hits_filtered_by_condition")->Fill("Cut on annihilation point Z", 1);
 
+  auto opts = getOptions();
+  if (isOptionSet(opts, kListModeFileKey)) {
+    return openListModeFile(getOptionAsString(opts, kListModeFileKey));
+  }
   return true;
 }
 
@@ -61,6 +69,12 @@ bool FilterEvents::exec()
           if (!checkConditions(hits[i], hits[i + 1]))
             continue;
           fOutputEvents->add<JPetEvent>(event);
+          if (fListModeFile.isOpen()) {
+            fListModeFile.addEvent(hits[i].getBarrelSlot().getID(), hits[i + 1].getBarrelSlot().getID(),
+                                   hits[i].getPosX(), hits[i].getPosY(), hits[i].getPosZ(),
+                                   hits[i + 1].getPosX(), hits[i + 1].getPosY(), hits[i + 1].getPosZ(),
+                                   hits[i].getTime() - hits[i + 1].getTime());
+          }
         }
       }
     }
@@ -73,9 +87,38 @@ bool FilterEvents::exec()
 
 bool FilterEvents::terminate()
 {
+  if (fListModeFile.isOpen()) {
+    INFO(Form("Written %lu coincidences to the list-mode file", (unsigned long) fListModeFile.getNumberOfEvents()));
+    return fListModeFile.close();
+  }
   return true;
 }
 
+/**
+ * Geometry table of the list-mode file is indexed by the barrel slot ID,
+ * with the position of the slot the same as the one given to hits
+ */
+bool FilterEvents::openListModeFile(const std::string& fileName)
+{
+  const JPetParamBank& bank = getParamBank();
+  int maxSlotID = 0;
+  for (const auto& slot : bank.getBarrelSlots()) {
+    maxSlotID = std::max(maxSlotID, slot.first);
+  }
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  std::vector<ListModeDetector> detectors(maxSlotID + 1, ListModeDetector{nan, nan});
+  for (const auto& slot : bank.getBarrelSlots()) {
+    const double radius = slot.second->getLayer().getRadius();
+    const double theta = slot.second->getTheta() * M_PI / 180.;
+    detectors[slot.first] = ListModeDetector{static_cast<float>(radius * std::cos(theta)), static_cast<float>(radius * std::sin(theta))};
+  }
+  float stripLength = 0.f;
+  if (!bank.getScintillators().empty()) {
+    stripLength = bank.getScintillators().begin()->second->getScinSize(JPetScin::Dimension::kLength);
+  }
+  return fListModeFile.open(fileName, detectors, stripLength);
+}
+
 bool FilterEvents::checkConditions(const JPetHit& first, const JPetHit& second)
 {
   if (!cutOnZ(first, second)) {
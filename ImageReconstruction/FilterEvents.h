@@ -23,6 +23,7 @@
 #endif
 
 #include "JPetUserTask/JPetUserTask.h"
+#include "ListModeFile.h"
 #include <memory>
 
 /**
@@ -33,6 +34,8 @@
  * - FilterEvents_TOT_Min_Value_In_Ns_float
  * - FilterEvents_TOT_Max_Value_IN_Ns_float
  * - FilterEvents_Angle_Delta_Min_Value_float
+ * Accepted coincidences are also written to the list-mode file, with barrel
+ * slot IDs as detector IDs, if FilterEvents_ListModeFile_std::string is set.
  */
 class FilterEvents : public JPetUserTask
 {
@@ -52,6 +55,7 @@ private:
   double calculateSumOfTOTs(const JPetPhysSignal& signal);
   bool checkConditions(const JPetHit& first, const JPetHit& second);
   void setUpOptions();
+  bool openListModeFile(const std::string& fileName);
 
   const std::string kCutOnZValueKey = "FilterEvents_Cut_On_Z_Value_float";
   const std::string kCutOnLORDistanceKey = "FilterEvents_Cut_On_LOR_Distance_From_Center_float";
@@ -59,6 +63,7 @@ private:
   const std::string kCutOnTOTMinValueKey = "FilterEvents_TOT_Min_Value_In_Ns_float";
   const std::string kCutOnTOTMaxValueKey = "FilterEvents_TOT_Max_Value_In_Ns_float";
   const std::string kCutOnAngleDeltaMinValueKey = "FilterEvents_Angle_Delta_Min_Value_float";
+  const std::string kListModeFileKey = "FilterEvents_ListModeFile_std::string";
 
   const int kNumberOfHitsInEventHisto = 10;
   const int kNumberOfConditions = 6;
@@ -70,6 +75,8 @@ private:
   float fTOTMinValueInNs = 15;
   float fTOTMaxValueInNs = 25;
   float fAngleDeltaMinValue = 20;
+
+  ListModeWriter fListModeFile;
 };
 
 #endif /*  !FILTEREVENTS_H */
@@ -0,0 +1,279 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file ListModeFile.cpp
+ */
+
+#include "JPetLoggerInclude.h"
+#include "ListModeFile.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cstring>
+#include <limits>
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+const char kListModeMagic[8] = {'J', 'P', 'E', 'T', 'L', 'O', 'R', 'S'};
+const uint32_t kListModeVersion = 2;
+const uint32_t kListModeByteOrder = 0x01020304;
+const size_t kBufferSize = 1 << 16;
+
+static_assert(sizeof(ListModeEvent) == 20, "Events of the list-mode file are expected to be 20 bytes long");
+
+uint64_t alignOffset(uint64_t offset)
+{
+  return (offset + 7) & ~uint64_t(7);
+}
+
+template <typename T>
+bool quantise(float value, float unit, T& result)
+{
+  double quantised = round(value / unit);
+  if (!(quantised >= numeric_limits<T>::min() && quantised <= numeric_limits<T>::max())) return false;
+  result = static_cast<T>(quantised);
+  return true;
+}
+}
+
+/**
+ * 20 um steps of X and Y cover +/- 65.5 cm, 10 um steps of Z cover +/- 32.7 cm,
+ * 0.1 ps steps of TOF cover +/- 214 us
+ */
+const float ListModeWriter::kDefaultXYUnit = 0.002f;
+const float ListModeWriter::kDefaultZUnit = 0.001f;
+const float ListModeWriter::kDefaultTOFUnit = 0.1f;
+
+ListModeWriter::ListModeWriter()
+{
+  memset(&fHeader, 0, sizeof(fHeader));
+}
+
+ListModeWriter::~ListModeWriter()
+{
+  if (isOpen()) close();
+}
+
+/**
+ * Writing the header, with no events yet, and the geometry table
+ */
+bool ListModeWriter::open(const string& fileName, const vector<ListModeDetector>& detectors,
+                          float stripLength, float xyUnit, float zUnit, float tofUnit)
+{
+  if (isOpen()) close();
+  if (detectors.empty() || detectors.size() > numeric_limits<uint16_t>::max() + 1u || xyUnit <= 0.f || zUnit <= 0.f || tofUnit <= 0.f) {
+    ERROR(Form("Invalid geometry or scaling of the list-mode file %s", fileName.c_str()));
+    return false;
+  }
+  fFileName = fileName;
+  memset(&fHeader, 0, sizeof(fHeader));
+  memcpy(fHeader.magic, kListModeMagic, sizeof(fHeader.magic));
+  fHeader.version = kListModeVersion;
+  fHeader.byteOrder = kListModeByteOrder;
+  fHeader.eventsOffset = alignOffset(sizeof(fHeader) + detectors.size() * sizeof(ListModeDetector));
+  fHeader.numberOfDetectors = detectors.size();
+  fHeader.stripLength = stripLength;
+  fHeader.zUnit = zUnit;
+  fHeader.tofUnit = tofUnit;
+  fHeader.xyUnit = xyUnit;
+  fNumberOfRejectedEvents = 0;
+  fBuffer.clear();
+  fBuffer.reserve(kBufferSize);
+  fFile.open(fFileName, ios::binary | ios::trunc);
+  if (!fFile.is_open()) {
+    ERROR(Form("Unable to open file %s for the list-mode data", fFileName.c_str()));
+    return false;
+  }
+  const char padding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  fFile.write(reinterpret_cast<const char*>(&fHeader), sizeof(fHeader));
+  fFile.write(reinterpret_cast<const char*>(detectors.data()), detectors.size() * sizeof(ListModeDetector));
+  fFile.write(padding, fHeader.eventsOffset - fFile.tellp());
+  return true;
+}
+
+bool ListModeWriter::isOpen() const
+{
+  return fFile.is_open();
+}
+
+/**
+ * Adding the coincidence of two hits, positions in [cm], time of flight
+ * equal to the time of the first hit minus the time of the second one [ps]
+ */
+bool ListModeWriter::addEvent(int firstDetector, int secondDetector, float firstX, float firstY, float firstZ,
+                              float secondX, float secondY, float secondZ, float tof)
+{
+  if (firstDetector < secondDetector) {
+    swap(firstDetector, secondDetector);
+    swap(firstX, secondX);
+    swap(firstY, secondY);
+    swap(firstZ, secondZ);
+    tof = -tof;
+  }
+  ListModeEvent event;
+  if (secondDetector < 0 || firstDetector >= static_cast<int>(fHeader.numberOfDetectors)
+      || !quantise(firstX, fHeader.xyUnit, event.firstX) || !quantise(firstY, fHeader.xyUnit, event.firstY)
+      || !quantise(firstZ, fHeader.zUnit, event.firstZ) || !quantise(secondX, fHeader.xyUnit, event.secondX)
+      || !quantise(secondY, fHeader.xyUnit, event.secondY) || !quantise(secondZ, fHeader.zUnit, event.secondZ)
+      || !quantise(tof, fHeader.tofUnit, event.tof)) {
+    fNumberOfRejectedEvents++;
+    return false;
+  }
+  event.firstDetector = firstDetector;
+  event.secondDetector = secondDetector;
+  fBuffer.push_back(event);
+  if (fBuffer.size() == kBufferSize) flush();
+  return true;
+}
+
+void ListModeWriter::flush()
+{
+  fFile.write(reinterpret_cast<const char*>(fBuffer.data()), fBuffer.size() * sizeof(ListModeEvent));
+  fHeader.numberOfEvents += fBuffer.size();
+  fBuffer.clear();
+}
+
+uint64_t ListModeWriter::getNumberOfEvents() const
+{
+  return fHeader.numberOfEvents + fBuffer.size();
+}
+
+uint64_t ListModeWriter::getNumberOfRejectedEvents() const
+{
+  return fNumberOfRejectedEvents;
+}
+
+/**
+ * Writing the remaining events and the final number of events in the header
+ */
+bool ListModeWriter::close()
+{
+  if (!isOpen()) return false;
+  flush();
+  fFile.seekp(0);
+  fFile.write(reinterpret_cast<const char*>(&fHeader), sizeof(fHeader));
+  fFile.close();
+  if (fFile.fail()) {
+    ERROR(Form("Writing of the list-mode file %s failed", fFileName.c_str()));
+    return false;
+  }
+  if (fNumberOfRejectedEvents > 0) {
+    WARNING(Form("%lu events out of the range of the list-mode file %s were rejected",
+                 (unsigned long) fNumberOfRejectedEvents, fFileName.c_str()));
+  }
+  return true;
+}
+
+ListModeReader::ListModeReader() {}
+
+ListModeReader::~ListModeReader()
+{
+  close();
+}
+
+bool ListModeReader::isListModeFile(const string& fileName)
+{
+  char magic[sizeof(kListModeMagic)];
+  ifstream file(fileName, ios::binary);
+  return file.read(magic, sizeof(magic)) && memcmp(magic, kListModeMagic, sizeof(magic)) == 0;
+}
+
+/**
+ * Mapping the file into memory and checking that the geometry table
+ * and all the events fit in it
+ */
+bool ListModeReader::open(const string& fileName)
+{
+  close();
+  int descriptor = ::open(fileName.c_str(), O_RDONLY);
+  if (descriptor < 0) {
+    ERROR(Form("Unable to open the list-mode file %s", fileName.c_str()));
+    return false;
+  }
+  struct stat status;
+  if (fstat(descriptor, &status) != 0 || status.st_size < (off_t) sizeof(ListModeHeader)) {
+    ERROR(Form("File %s is too short for the list-mode data", fileName.c_str()));
+    ::close(descriptor);
+    return false;
+  }
+  void* data = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+  ::close(descriptor);
+  if (data == MAP_FAILED) {
+    ERROR(Form("Unable to map the list-mode file %s into memory", fileName.c_str()));
+    return false;
+  }
+  madvise(data, status.st_size, MADV_SEQUENTIAL);
+  fData = static_cast<const char*>(data);
+  fSize = status.st_size;
+  fHeader = reinterpret_cast<const ListModeHeader*>(fData);
+  bool valid = memcmp(fHeader->magic, kListModeMagic, sizeof(kListModeMagic)) == 0
+    && fHeader->version == kListModeVersion && fHeader->byteOrder == kListModeByteOrder
+    && fHeader->xyUnit > 0.f && fHeader->zUnit > 0.f && fHeader->tofUnit > 0.f && fHeader->eventsOffset % 8 == 0
+    && sizeof(ListModeHeader) + fHeader->numberOfDetectors * sizeof(ListModeDetector) <= fHeader->eventsOffset
+    && fHeader->eventsOffset + fHeader->numberOfEvents * sizeof(ListModeEvent) <= fSize;
+  if (!valid) {
+    ERROR(Form("File %s is not a valid list-mode file of version %u", fileName.c_str(), kListModeVersion));
+    close();
+    return false;
+  }
+  fDetectors = reinterpret_cast<const ListModeDetector*>(fData + sizeof(ListModeHeader));
+  INFO(Form("List-mode file %s opened, %lu events with %u detectors", fileName.c_str(),
+    (unsigned long) fHeader->numberOfEvents, fHeader->numberOfDetectors));
+  return true;
+}
+
+void ListModeReader::close()
+{
+  if (fData) munmap(const_cast<char*>(fData), fSize);
+  fData = nullptr;
+  fSize = 0;
+  fHeader = nullptr;
+  fDetectors = nullptr;
+}
+
+bool ListModeReader::isOpen() const
+{
+  return fData != nullptr;
+}
+
+const ListModeHeader& ListModeReader::getHeader() const
+{
+  return *fHeader;
+}
+
+uint64_t ListModeReader::getNumberOfEvents() const
+{
+  return fHeader ? fHeader->numberOfEvents : 0;
+}
+
+uint32_t ListModeReader::getNumberOfDetectors() const
+{
+  return fHeader ? fHeader->numberOfDetectors : 0;
+}
+
+/**
+ * IDs are checked on writing, readers of files from other sources
+ * should compare them with getNumberOfDetectors()
+ */
+const ListModeDetector& ListModeReader::getDetector(uint16_t id) const
+{
+  return fDetectors[id];
+}
+
+const ListModeEvent* ListModeReader::getEvents() const
+{
+  return reinterpret_cast<const ListModeEvent*>(fData + fHeader->eventsOffset);
+}
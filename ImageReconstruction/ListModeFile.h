@@ -0,0 +1,142 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file ListModeFile.h
+ */
+
+#ifndef LISTMODEFILE_H
+#define LISTMODEFILE_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Header at the beginning of the list-mode file
+ *
+ * Header is followed by the geometry table, numberOfDetectors entries
+ * with the position of the center of each detector indexed by its ID,
+ * and by numberOfEvents fixed width events starting at eventsOffset.
+ * X and Y positions of hits are stored in units of xyUnit [cm], Z positions
+ * in units of zUnit [cm], times of flight in units of tofUnit [ps].
+ */
+struct ListModeHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint64_t numberOfEvents;
+  uint64_t eventsOffset;
+  uint32_t numberOfDetectors;
+  float stripLength;
+  float zUnit;
+  float tofUnit;
+  float xyUnit;
+};
+
+/**
+ * @brief Position of the center of the detector in the XY plane [cm],
+ * NaN for IDs not used by the geometry
+ */
+struct ListModeDetector {
+  float x;
+  float y;
+};
+
+/**
+ * @brief One coincidence, with the first detector ID greater than the second
+ * one and the time of flight equal to the time of the first hit minus the
+ * time of the second one. Positions are the ones of the hits, not of the
+ * centers of detectors.
+ */
+struct ListModeEvent {
+  uint16_t firstDetector;
+  uint16_t secondDetector;
+  int16_t firstX;
+  int16_t firstY;
+  int16_t firstZ;
+  int16_t secondX;
+  int16_t secondY;
+  int16_t secondZ;
+  int32_t tof;
+};
+
+/**
+ * @brief Writer of the list-mode file of coincidences
+ *
+ * Events are quantised and buffered, the number of events is written
+ * to the header on close. Events with positions or times out of the range
+ * of the quantised values, or with unknown detectors, are rejected.
+ */
+class ListModeWriter
+{
+public:
+  static const float kDefaultXYUnit;
+  static const float kDefaultZUnit;
+  static const float kDefaultTOFUnit;
+
+  ListModeWriter();
+  ~ListModeWriter();
+  bool open(const std::string& fileName, const std::vector<ListModeDetector>& detectors,
+            float stripLength, float xyUnit = kDefaultXYUnit, float zUnit = kDefaultZUnit, float tofUnit = kDefaultTOFUnit);
+  bool addEvent(int firstDetector, int secondDetector, float firstX, float firstY, float firstZ,
+                float secondX, float secondY, float secondZ, float tof);
+  bool close();
+  bool isOpen() const;
+  uint64_t getNumberOfEvents() const;
+  uint64_t getNumberOfRejectedEvents() const;
+
+private:
+  ListModeWriter(const ListModeWriter&);
+  void operator=(const ListModeWriter&);
+  void flush();
+  std::string fFileName;
+  std::ofstream fFile;
+  ListModeHeader fHeader;
+  std::vector<ListModeEvent> fBuffer;
+  uint64_t fNumberOfRejectedEvents = 0;
+};
+
+/**
+ * @brief Reader of the list-mode file, mapping the whole file into memory
+ *
+ * Events are used in place as an array, getXY(), getZ() and getTOF()
+ * convert the quantised values back to [cm] and [ps].
+ */
+class ListModeReader
+{
+public:
+  ListModeReader();
+  ~ListModeReader();
+  static bool isListModeFile(const std::string& fileName);
+  bool open(const std::string& fileName);
+  void close();
+  bool isOpen() const;
+  const ListModeHeader& getHeader() const;
+  uint64_t getNumberOfEvents() const;
+  uint32_t getNumberOfDetectors() const;
+  const ListModeDetector& getDetector(uint16_t id) const;
+  const ListModeEvent* getEvents() const;
+  float getXY(int16_t xy) const { return xy * fHeader->xyUnit; }
+  float getZ(int16_t z) const { return z * fHeader->zUnit; }
+  float getTOF(int32_t tof) const { return tof * fHeader->tofUnit; }
+
+private:
+  ListModeReader(const ListModeReader&);
+  void operator=(const ListModeReader&);
+  const char* fData = nullptr;
+  size_t fSize = 0;
+  const ListModeHeader* fHeader = nullptr;
+  const ListModeDetector* fDetectors = nullptr;
+};
+
+#endif /* !LISTMODEFILE_H */
@@ -0,0 +1,102 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file ListModeFileTest.cpp
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE ListModeFileTest
+
+#include <boost/test/unit_test.hpp>
+#include "ListModeFile.h"
+#include <cstdio>
+#include <cmath>
+
+std::vector<ListModeDetector> getTestDetectors()
+{
+  std::vector<ListModeDetector> detectors;
+  detectors.push_back(ListModeDetector{NAN, NAN});
+  for (int i = 0; i < 4; i++) {
+    detectors.push_back(ListModeDetector{static_cast<float>(42.5 * std::cos(i * M_PI / 2)), static_cast<float>(42.5 * std::sin(i * M_PI / 2))});
+  }
+  return detectors;
+}
+
+BOOST_AUTO_TEST_SUITE(ListModeFileTestSuite)
+
+BOOST_AUTO_TEST_CASE(writeRead_test)
+{
+  const std::string fileName = "ListModeFileTest_writeRead.lor";
+  ListModeWriter writer;
+  BOOST_REQUIRE(writer.open(fileName, getTestDetectors(), 50.f));
+  BOOST_REQUIRE(writer.addEvent(3, 1, -41.f, 3.5f, 10.f, 42.f, -1.25f, -5.f, 250.f));
+  // Detectors are ordered with the first one greater than the second one
+  BOOST_REQUIRE(writer.addEvent(2, 4, 2.f, 57.5f, 1.2345f, -0.5f, -42.f, 0.f, 100.f));
+  // Z and X out of the range of quantised values and unknown detector
+  BOOST_REQUIRE(!writer.addEvent(1, 2, 42.f, 0.f, 40.f, 0.f, 42.f, 0.f, 0.f));
+  BOOST_REQUIRE(!writer.addEvent(1, 2, 70.f, 0.f, 0.f, 0.f, 42.f, 0.f, 0.f));
+  BOOST_REQUIRE(!writer.addEvent(1, 5, 42.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f));
+  BOOST_REQUIRE_EQUAL(writer.getNumberOfEvents(), 2u);
+  BOOST_REQUIRE_EQUAL(writer.getNumberOfRejectedEvents(), 3u);
+  BOOST_REQUIRE(writer.close());
+
+  BOOST_REQUIRE(ListModeReader::isListModeFile(fileName));
+  ListModeReader reader;
+  BOOST_REQUIRE(reader.open(fileName));
+  BOOST_REQUIRE_EQUAL(reader.getNumberOfEvents(), 2u);
+  BOOST_REQUIRE_EQUAL(reader.getNumberOfDetectors(), 5u);
+  BOOST_REQUIRE_EQUAL(reader.getHeader().stripLength, 50.f);
+  BOOST_REQUIRE(std::isnan(reader.getDetector(0).x));
+  BOOST_REQUIRE_CLOSE(reader.getDetector(1).x, 42.5f, 1.e-4);
+  BOOST_REQUIRE_CLOSE(reader.getDetector(2).y, 42.5f, 1.e-4);
+
+  const float xyEpsilon = reader.getHeader().xyUnit / 2;
+  const float zEpsilon = reader.getHeader().zUnit / 2;
+  const float tofEpsilon = reader.getHeader().tofUnit / 2;
+  const ListModeEvent* events = reader.getEvents();
+  BOOST_REQUIRE_EQUAL(events[0].firstDetector, 3);
+  BOOST_REQUIRE_EQUAL(events[0].secondDetector, 1);
+  BOOST_REQUIRE_SMALL(reader.getXY(events[0].firstX) + 41.f, xyEpsilon);
+  BOOST_REQUIRE_SMALL(reader.getXY(events[0].firstY) - 3.5f, xyEpsilon);
+  BOOST_REQUIRE_SMALL(reader.getXY(events[0].secondX) - 42.f, xyEpsilon);
+  BOOST_REQUIRE_SMALL(reader.getXY(events[0].secondY) + 1.25f, xyEpsilon);
+  BOOST_REQUIRE_SMALL(reader.getZ(events[0].firstZ) - 10.f, zEpsilon);
+  BOOST_REQUIRE_SMALL(reader.getZ(events[0].secondZ) + 5.f, zEpsilon);
+  BOOST_REQUIRE_SMALL(reader.getTOF(events[0].tof) - 250.f, tofEpsilon);
+  BOOST_REQUIRE_EQUAL(events[1].firstDetector, 4);
+  BOOST_REQUIRE_EQUAL(events[1].secondDetector, 2);
+  BOOST_REQUIRE_SMALL(reader.getXY(events[1].firstX) + 0.5f, xyEpsilon);
+  BOOST_REQUIRE_SMALL(reader.getXY(events[1].firstY) + 42.f, xyEpsilon);
+  BOOST_REQUIRE_SMALL(reader.getXY(events[1].secondX) - 2.f, xyEpsilon);
+  BOOST_REQUIRE_SMALL(reader.getXY(events[1].secondY) - 57.5f, xyEpsilon);
+  BOOST_REQUIRE_SMALL(reader.getZ(events[1].firstZ), zEpsilon);
+  BOOST_REQUIRE_SMALL(reader.getZ(events[1].secondZ) - 1.2345f, zEpsilon);
+  BOOST_REQUIRE_SMALL(reader.getTOF(events[1].tof) + 100.f, tofEpsilon);
+  reader.close();
+  std::remove(fileName.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(invalidFile_test)
+{
+  const std::string fileName = "ListModeFileTest_invalid.lor";
+  ListModeReader reader;
+  BOOST_REQUIRE(!reader.open("ListModeFileTest_missing.lor"));
+  std::ofstream(fileName) << std::string(1000, 'x');
+  BOOST_REQUIRE(!ListModeReader::isListModeFile(fileName));
+  BOOST_REQUIRE(!reader.open(fileName));
+  BOOST_REQUIRE(!reader.isOpen());
+  ListModeWriter writer;
+  BOOST_REQUIRE(!writer.open(fileName, std::vector<ListModeDetector>(), 50.f));
+  std::remove(fileName.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
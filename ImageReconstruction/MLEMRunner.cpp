@@ -20,6 +20,7 @@
 #include "JPetHit/JPetHit.h"
 #include "JPetParamBank/JPetParamBank.h"
 #include <iomanip> //std::setprecision
+#include <cmath>
 
 using namespace jpet_options_tools;
 
@@ -45,11 +46,23 @@ MLEMRunner::~MLEMRunner()
 bool MLEMRunner::init()
 {
   setUpOptions();
-  return setUpRunReconstructionWithMatrix();
+  auto opts = getOptions();
+  if (isOptionSet(opts, kListModeOutFileNameKey)) {
+    if (!openListModeOutput(getOptionAsString(opts, kListModeOutFileNameKey)))
+      return false;
+  }
+  if (!setUpRunReconstructionWithMatrix())
+    return false;
+  if (!fListModeInFileName.empty()) {
+    return readListModeInput(fListModeInFileName);
+  }
+  return true;
 }
 
 bool MLEMRunner::exec()
 {
+  if (!fListModeInFileName.empty())
+    return true;
   if (const auto& timeWindow = dynamic_cast<const JPetTimeWindow* const>(fEvent)) {
     const unsigned int numberOfEventsInTimeWindow = timeWindow->getNumberOfEvents();
     for (unsigned int i = 0; i < numberOfEventsInTimeWindow; i++) {
@@ -67,6 +80,9 @@ bool MLEMRunner::terminate()
 {
   INFO("Reconstructed " + std::to_string(fReconstructedEvents) + " events out of " + std::to_string(fReconstructedEvents + fMissedEvents) +
        " total(" + std::to_string(fMissedEvents) + " missed)");
+  if (fListModeOutput.isOpen()) {
+    fListModeOutput.close();
+  }
   runReconstruction();
   return true;
 }
@@ -77,13 +93,13 @@ bool MLEMRunner::parseEvent(const JPetEvent& event)
   if (hits.size() != 2) {
     return false;
   }
-  const float x1 = hits[0].getPosX();
-  const float y1 = hits[0].getPosY();
+  float x1 = hits[0].getPosX();
+  float y1 = hits[0].getPosY();
   float z1 = hits[0].getPosZ();
   float t1 = hits[0].getTime();
 
-  const float x2 = hits[1].getPosX();
-  const float y2 = hits[1].getPosY();
+  float x2 = hits[1].getPosX();
+  float y2 = hits[1].getPosY();
   float z2 = hits[1].getPosZ();
   float t2 = hits[1].getTime();
 
@@ -105,17 +121,80 @@ bool MLEMRunner::parseEvent(const JPetEvent& event)
 
   if (d1 < d2) {
     std::swap(d1, d2);
+    std::swap(x1, x2);
+    std::swap(y1, y2);
     std::swap(z1, z2);
     std::swap(t1, t2);
   }
   double dl = (t1 - t2) * kSpeedOfLightMetersPerPs;
 
   fReconstructionStringStream << d1 << " " << d2 << " " << z1* kCentimetersToMeters << " " << z2* kCentimetersToMeters << " " << dl << "\n";
-  fOutputStream << d1 << " " << d2 << " " << z1* kCentimetersToMeters << " " << z2* kCentimetersToMeters << " " << dl << "\n";
+  if (fListModeOutput.isOpen()) {
+    fListModeOutput.addEvent(d1, d2, x1, y1, z1, x2, y2, z2, t1 - t2);
+  } else {
+    fOutputStream << d1 << " " << d2 << " " << z1* kCentimetersToMeters << " " << z2* kCentimetersToMeters << " " << dl << "\n";
+  }
 
   return true;
 }
 
+/**
+ * Detector IDs of the list-mode output are the numbers of detectors in the scanner
+ */
+bool MLEMRunner::openListModeOutput(const std::string& fileName)
+{
+  std::vector<ListModeDetector> detectors;
+  for (const auto& center : fScanner.detector_centers()) {
+    detectors.push_back(ListModeDetector{static_cast<float>(center.x / kCentimetersToMeters), static_cast<float>(center.y / kCentimetersToMeters)});
+  }
+  return fListModeOutput.open(fileName, detectors, 2.f * fHalfStripLenght);
+}
+
+/**
+ * Translating list-mode data, written by this module or by FilterEvents, to the format
+ * of the reconstruction. Detectors of the file are matched with the ones of the scanner
+ * by the position of their centers, so files with any numbering of detectors are accepted.
+ */
+bool MLEMRunner::readListModeInput(const std::string& fileName)
+{
+  ListModeReader reader;
+  if (!reader.open(fileName)) {
+    return false;
+  }
+  std::vector<int> scannerDetectors(reader.getNumberOfDetectors(), -1);
+  for (unsigned int id = 0; id < reader.getNumberOfDetectors(); id++) {
+    const auto& detector = reader.getDetector(id);
+    if (std::isnan(detector.x) || std::isnan(detector.y))
+      continue;
+    for (size_t i = 0; i < fScanner.size(); ++i) {
+      if (fScanner[i].contains(Point(detector.x * kCentimetersToMeters, detector.y * kCentimetersToMeters), EPSILON))
+        scannerDetectors[id] = i;
+    }
+  }
+
+  const ListModeEvent* events = reader.getEvents();
+  for (uint64_t i = 0; i < reader.getNumberOfEvents(); i++) {
+    const auto& event = events[i];
+    int d1 = event.firstDetector < reader.getNumberOfDetectors() ? scannerDetectors[event.firstDetector] : -1;
+    int d2 = event.secondDetector < reader.getNumberOfDetectors() ? scannerDetectors[event.secondDetector] : -1;
+    float z1 = reader.getZ(event.firstZ);
+    float z2 = reader.getZ(event.secondZ);
+    double dl = reader.getTOF(event.tof) * kSpeedOfLightMetersPerPs;
+    if (d1 < 0 || d2 < 0 || std::abs(z1 * kCentimetersToMeters) > fHalfStripLenght || std::abs(z2 * kCentimetersToMeters) > fHalfStripLenght) {
+      fMissedEvents++;
+      continue;
+    }
+    if (d1 < d2) {
+      std::swap(d1, d2);
+      std::swap(z1, z2);
+      dl = -dl;
+    }
+    fReconstructionStringStream << d1 << " " << d2 << " " << z1* kCentimetersToMeters << " " << z2* kCentimetersToMeters << " " << dl << "\n";
+    fReconstructedEvents++;
+  }
+  return true;
+}
+
 void MLEMRunner::setUpOptions()
 {
   auto opts = getOptions();
@@ -123,7 +202,13 @@ void MLEMRunner::setUpOptions()
     fOutFileName = getOptionAsString(opts, kOutFileNameKey);
   }
 
-  fOutputStream.open(fOutFileName, std::ofstream::out | std::ofstream::app);
+  if (isOptionSet(opts, kListModeInFileNameKey)) {
+    fListModeInFileName = getOptionAsString(opts, kListModeInFileNameKey);
+  }
+
+  if (!isOptionSet(opts, kListModeOutFileNameKey)) {
+    fOutputStream.open(fOutFileName, std::ofstream::out | std::ofstream::app);
+  }
   std::vector<float> radius;
   radius.reserve(3);
   std::vector<int> scintillators;
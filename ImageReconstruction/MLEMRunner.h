@@ -25,6 +25,7 @@
 #include "JPetEvent/JPetEvent.h"
 #include "JPetLoggerInclude.h"
 #include "JPetUserTask/JPetUserTask.h"
+#include "ListModeFile.h"
 #include <fstream>
 
 #include "util/png_writer.h"
@@ -69,6 +70,8 @@
  *  "MLEMRunner_ReconstuctionIterations_int" : number of iterations in reconstruction
  *  "MLEMRunner_TOFSigmaAlongZAxis_float" : error of measurement of Z position along scintillator in meters
  *  "MLEMRunner_TOFSigmaAxis_float" :  error of measurement TOF along LOR (or TOR in case of 3D) in meters
+ *  "MLEMRunner_ListModeOutFileName_std::string" : filename of list-mode file where translated data will be saved instead of ascii file
+ *  "MLEMRunner_ListModeInFileName_std::string" : filename of list-mode file with data reconstructed instead of input events
  */
 
 class MLEMRunner : public JPetUserTask
@@ -105,6 +108,8 @@ private:
 
   void setUpOptions();
   bool parseEvent(const JPetEvent& event);
+  bool openListModeOutput(const std::string& fileName);
+  bool readListModeInput(const std::string& fileName);
   SquareMatrix runGenerateSystemMatrix();
   void setSystemMatrix();
   bool setUpRunReconstructionWithMatrix();
@@ -124,6 +129,8 @@ private:
 
   const std::string kReconstructionOutputPathKey = "MLEMRunner_ReconstructionOutputPath_std::string";
   const std::string kReconstructionIterationsKey = "MLEMRunner_ReconstuctionIterations_int";
+  const std::string kListModeOutFileNameKey = "MLEMRunner_ListModeOutFileName_std::string";
+  const std::string kListModeInFileNameKey = "MLEMRunner_ListModeInFileName_std::string";
 
   const double kSpeedOfLightMetersPerPs = 299792458.0e-12;
   const double kCentimetersToMeters = 0.01;
@@ -139,6 +146,8 @@ private:
 
   std::ofstream fOutputStream;                   // outputs data in format accepted by 3d_hybrid_reconstruction
   std::stringstream fReconstructionStringStream; // connection between parsing events and reconstruction
+  ListModeWriter fListModeOutput;                // outputs data in list-mode format instead of fOutputStream
+  std::string fListModeInFileName;               // if set, data are read from list-mode file instead of events
 
   int fNumberOfPixelsInOneDimension = 160;             // Dimension of 1 axis in 3d reconstructed image(n-pixels)
   double fPixelSize = 0.004;                           // Size of 1 pixel in m(s-pixel)
@@ -14,6 +14,7 @@
  */
 
 #include "SinogramCreator.h"
+#include <cmath>
 #include <TH2I.h>
 #include <TH2F.h>
 #include <TH3F.h>
@@ -47,17 +48,22 @@ bool SinogramCreator::init()
   getStatistics().getObject<TH1F>("pos_dis")->SetCanExtend(TH1::kAllAxes);
 #endif
 
+  const int maxDistanceNumber = std::ceil(fMaxReconstructionLayerRadius * 2 * (1.f / fReconstructionDistanceAccuracy)) + 1;
+  fSinogram = new SinogramResultType *[fZSplitNumber];
+  for (int i = 0; i < fZSplitNumber; i++) {
+    fSinogram[i] = new SinogramResultType(maxDistanceNumber, (std::vector<unsigned int>(kReconstructionMaxAngle, 0)));
+  }
+
+  if (!fListModeFile.empty()) {
+    return readListModeFile(fListModeFile);
+  }
   return true;
 }
 
 bool SinogramCreator::exec()
 {
-  const int maxDistanceNumber = std::ceil(fMaxReconstructionLayerRadius * 2 * (1.f / fReconstructionDistanceAccuracy)) + 1;
-  if (fSinogram == nullptr) {
-    fSinogram = new SinogramResultType *[fZSplitNumber];
-    for (int i = 0; i < fZSplitNumber; i++) {
-      fSinogram[i] = new SinogramResultType(maxDistanceNumber, (std::vector<unsigned int>(kReconstructionMaxAngle, 0)));
-    }
+  if (!fListModeFile.empty()) {
+    return true;
   }
   if (const auto& timeWindow = dynamic_cast<const JPetTimeWindow* const>(fEvent)) {
     const unsigned int numberOfEventsInTimeWindow = timeWindow->getNumberOfEvents();
@@ -77,16 +83,7 @@ bool SinogramCreator::exec()
       const float firstZ = firstHit.getPosZ();
       const float secondZ = secondHit.getPosZ();
 
-      for (int i = 0; i < fZSplitNumber; i++) {
-        if (!checkSplitRange(firstZ, secondZ, i)) {
-          continue;
-        }
-        const auto sinogramResult = SinogramCreatorTools::getSinogramRepresentation(firstX, firstY, secondX, secondY, fMaxReconstructionLayerRadius, fReconstructionDistanceAccuracy, maxDistanceNumber, kReconstructionMaxAngle);
-        fCurrentValueInSinogram[i] = ++fSinogram[i]->at(sinogramResult.first).at(sinogramResult.second);
-        if (fCurrentValueInSinogram[i] > fMaxValueInSinogram[i]) {
-          fMaxValueInSinogram[i] = fCurrentValueInSinogram[i]; // save max value of sinogram
-        }
-      }
+      fillSinogram(firstX, firstY, firstZ, secondX, secondY, secondZ);
     }
   } else {
     ERROR("Returned event is not TimeWindow");
@@ -95,6 +92,39 @@ bool SinogramCreator::exec()
   return true;
 }
 
+void SinogramCreator::fillSinogram(float firstX, float firstY, float firstZ, float secondX, float secondY, float secondZ)
+{
+  const int maxDistanceNumber = std::ceil(fMaxReconstructionLayerRadius * 2 * (1.f / fReconstructionDistanceAccuracy)) + 1;
+  for (int i = 0; i < fZSplitNumber; i++) {
+    if (!checkSplitRange(firstZ, secondZ, i)) {
+      continue;
+    }
+    const auto sinogramResult = SinogramCreatorTools::getSinogramRepresentation(firstX, firstY, secondX, secondY, fMaxReconstructionLayerRadius, fReconstructionDistanceAccuracy, maxDistanceNumber, kReconstructionMaxAngle);
+    fCurrentValueInSinogram[i] = ++fSinogram[i]->at(sinogramResult.first).at(sinogramResult.second);
+    if (fCurrentValueInSinogram[i] > fMaxValueInSinogram[i]) {
+      fMaxValueInSinogram[i] = fCurrentValueInSinogram[i]; // save max value of sinogram
+    }
+  }
+}
+
+/**
+ * Filling sinograms with all events of the list-mode file, with the positions of their hits
+ */
+bool SinogramCreator::readListModeFile(const std::string& fileName)
+{
+  ListModeReader reader;
+  if (!reader.open(fileName)) {
+    return false;
+  }
+  const ListModeEvent* events = reader.getEvents();
+  for (uint64_t i = 0; i < reader.getNumberOfEvents(); i++) {
+    const auto& event = events[i];
+    fillSinogram(reader.getXY(event.firstX), reader.getXY(event.firstY), reader.getZ(event.firstZ),
+                 reader.getXY(event.secondX), reader.getXY(event.secondY), reader.getZ(event.secondZ));
+  }
+  return true;
+}
+
 bool SinogramCreator::checkSplitRange(float firstZ, float secondZ, int i)
 {
   return firstZ >= fZSplitRange[i].first && firstZ <= fZSplitRange[i].second && secondZ >= fZSplitRange[i].first && secondZ <= fZSplitRange[i].second;
@@ -144,6 +174,10 @@ void SinogramCreator::setUpOptions()
     fScintillatorLenght = getOptionAsFloat(opts, kScintillatorLenght);
   }
 
+  if (isOptionSet(opts, kListModeFileKey)) {
+    fListModeFile = getOptionAsString(opts, kListModeFileKey);
+  }
+
   const JPetParamBank& bank = getParamBank();
   const JPetGeomMapping mapping(bank);
   fMaxReconstructionLayerRadius = mapping.getRadiusOfLayer(mapping.getLayersCount() - 1);
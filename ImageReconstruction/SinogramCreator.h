@@ -26,6 +26,7 @@
 #include "JPetHit/JPetHit.h"
 #include "JPetUserTask/JPetUserTask.h"
 #include "SinogramCreatorTools.h"
+#include "ListModeFile.h"
 #include <string>
 #include <vector>
 
@@ -51,6 +52,7 @@
  * corresponds to 0.1 cm in reality
  * - "SinogramCreator_SinogramZSplitNumber_int": defines number of splits around "z" coordinate
  * - "SinogramCreator_ScintillatorLenght_float": defines scintillator lenght in "z" coordinate
+ * - "SinogramCreator_ListModeFile_std::string": defines list-mode file used instead of input events
  */
 class SinogramCreator : public JPetUserTask {
 public:
@@ -66,6 +68,8 @@ private:
 
   void setUpOptions();
   bool checkSplitRange(float firstZ, float secondZ, int i);
+  void fillSinogram(float firstX, float firstY, float firstZ, float secondX, float secondY, float secondZ);
+  bool readListModeFile(const std::string& fileName);
   using SinogramResultType = std::vector<std::vector<unsigned int>>;
 
   SinogramResultType** fSinogram = nullptr;
@@ -74,6 +78,7 @@ private:
   const std::string kReconstructionDistanceAccuracy = "SinogramCreator_ReconstructionDistanceAccuracy_float";
   const std::string kZSplitNumber = "SinogramCreator_SinogramZSplitNumber_int";
   const std::string kScintillatorLenght = "SinogramCreator_ScintillatorLenght_float";
+  const std::string kListModeFileKey = "SinogramCreator_ListModeFile_std::string";
 
   const int kReconstructionMaxAngle = 180;
   const float EPSILON = 0.000001f;
@@ -81,6 +86,7 @@ private:
   std::vector<std::pair<float, float>> fZSplitRange;
 
   std::string fOutFileName = "sinogram";
+  std::string fListModeFile;
   int* fMaxValueInSinogram = nullptr; // to fill later in output file
   int* fCurrentValueInSinogram = nullptr;
 
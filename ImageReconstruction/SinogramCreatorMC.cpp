@@ -14,6 +14,7 @@
  */
 
 #include "SinogramCreatorMC.h"
+#include <cmath>
 #include <TH1F.h>
 #include <TH2I.h>
 using namespace jpet_options_tools;
@@ -49,6 +50,19 @@ bool SinogramCreatorMC::init() {
 }
 
 void SinogramCreatorMC::generateSinogram() {
+  const int maxDistanceNumber = std::ceil(fMaxReconstructionLayerRadius * 2 * (1.f / fReconstructionDistanceAccuracy)) + 1;
+  if (fSinogram == nullptr) {
+    fSinogram = new SinogramResultType*[fZSplitNumber];
+    for (int i = 0; i < fZSplitNumber; i++) {
+      fSinogram[i] = new SinogramResultType(maxDistanceNumber, (std::vector<unsigned int>(kReconstructionMaxAngle, 0)));
+    }
+  }
+
+  if (ListModeReader::isListModeFile(fInputData)) {
+    generateSinogramFromListModeFile();
+    return;
+  }
+
   std::ifstream in(fInputData);
 
   float firstX = 0.f;
@@ -58,29 +72,42 @@ void SinogramCreatorMC::generateSinogram() {
   float firstZ = 0.f;
   float secondZ = 0.f;
 
-  const int maxDistanceNumber = std::ceil(fMaxReconstructionLayerRadius * 2 * (1.f / fReconstructionDistanceAccuracy)) + 1;
-  if (fSinogram == nullptr) {
-    fSinogram = new SinogramResultType*[fZSplitNumber];
-    for (int i = 0; i < fZSplitNumber; i++) {
-      fSinogram[i] = new SinogramResultType(maxDistanceNumber, (std::vector<unsigned int>(kReconstructionMaxAngle, 0)));
-    }
-  }
-
   while (in.peek() != EOF) {
 
     in >> firstX >> firstY >> firstZ >> secondX >> secondY >> secondZ;
 
-    for (int i = 0; i < fZSplitNumber; i++) {
-      if (!checkSplitRange(firstZ, secondZ, i)) {
-        continue;
-      }
-      const auto sinogramResult =
-          SinogramCreatorTools::getSinogramRepresentation(firstX, firstY, secondX, secondY, fMaxReconstructionLayerRadius,
-                                                          fReconstructionDistanceAccuracy, maxDistanceNumber, kReconstructionMaxAngle);
-      fCurrentValueInSinogram[i] = ++fSinogram[i]->at(sinogramResult.first).at(sinogramResult.second);
-      if (fCurrentValueInSinogram[i] > fMaxValueInSinogram[i]) {
-        fMaxValueInSinogram[i] = fCurrentValueInSinogram[i]; // save max value of sinogram
-      }
+    fillSinogram(firstX, firstY, firstZ, secondX, secondY, secondZ);
+  }
+}
+
+/**
+ * Input data in the list-mode format, with the same positions of hits as in the text input
+ */
+void SinogramCreatorMC::generateSinogramFromListModeFile() {
+  ListModeReader reader;
+  if (!reader.open(fInputData)) {
+    return;
+  }
+  const ListModeEvent* events = reader.getEvents();
+  for (uint64_t i = 0; i < reader.getNumberOfEvents(); i++) {
+    const auto& event = events[i];
+    fillSinogram(reader.getXY(event.firstX), reader.getXY(event.firstY), reader.getZ(event.firstZ),
+                 reader.getXY(event.secondX), reader.getXY(event.secondY), reader.getZ(event.secondZ));
+  }
+}
+
+void SinogramCreatorMC::fillSinogram(float firstX, float firstY, float firstZ, float secondX, float secondY, float secondZ) {
+  const int maxDistanceNumber = std::ceil(fMaxReconstructionLayerRadius * 2 * (1.f / fReconstructionDistanceAccuracy)) + 1;
+  for (int i = 0; i < fZSplitNumber; i++) {
+    if (!checkSplitRange(firstZ, secondZ, i)) {
+      continue;
+    }
+    const auto sinogramResult =
+        SinogramCreatorTools::getSinogramRepresentation(firstX, firstY, secondX, secondY, fMaxReconstructionLayerRadius,
+                                                        fReconstructionDistanceAccuracy, maxDistanceNumber, kReconstructionMaxAngle);
+    fCurrentValueInSinogram[i] = ++fSinogram[i]->at(sinogramResult.first).at(sinogramResult.second);
+    if (fCurrentValueInSinogram[i] > fMaxValueInSinogram[i]) {
+      fMaxValueInSinogram[i] = fCurrentValueInSinogram[i]; // save max value of sinogram
     }
   }
 }
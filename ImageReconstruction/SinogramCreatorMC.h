@@ -24,6 +24,7 @@
 
 #include "JPetUserTask/JPetUserTask.h"
 #include "SinogramCreatorTools.h"
+#include "ListModeFile.h"
 #include "JPetHit/JPetHit.h"
 #include <vector>
 #include <string>
@@ -42,6 +43,8 @@ private:
   SinogramCreatorMC &operator=(const SinogramCreatorMC &) = delete;
 
   void generateSinogram();
+  void generateSinogramFromListModeFile();
+  void fillSinogram(float firstX, float firstY, float firstZ, float secondX, float secondY, float secondZ);
   void setUpOptions();
   bool checkSplitRange(float firstZ, float secondZ, int i);
   using SinogramResultType = std::vector<std::vector<unsigned int>>;
@@ -19,17 +19,18 @@
 #include "MLEMRunner.h"
 #include "SinogramCreator.h"
 #include "SinogramCreatorMC.h"
+#include "../LargeBarrelAnalysis/InstrumentedTask.h"
 using namespace std;
 
 int main(int argc, const char* argv[]) {
   try {
     JPetManager& manager = JPetManager::getManager();
 
-    manager.registerTask<FilterEvents>("FilterEvents");
-    manager.registerTask<ImageReco>("ImageReco");
-    manager.registerTask<SinogramCreator>("SinogramCreator");
-    manager.registerTask<SinogramCreatorMC>("SinogramCreatorMC");
-    manager.registerTask<MLEMRunner>("MLEMRunner");
+    manager.registerTask<InstrumentedTask<FilterEvents>>("FilterEvents");
+    manager.registerTask<InstrumentedTask<ImageReco>>("ImageReco");
+    manager.registerTask<InstrumentedTask<SinogramCreator>>("SinogramCreator");
+    manager.registerTask<InstrumentedTask<SinogramCreatorMC>>("SinogramCreatorMC");
+    manager.registerTask<InstrumentedTask<MLEMRunner>>("MLEMRunner");
 
     manager.useTask("FilterEvents", "unk.evt", "reco.unk.evt");
     manager.useTask("MLEMRunner", "reco.unk.evt", "");
@@ -66,6 +66,7 @@ bool EventCategorizerImaging::init()
   } else {
     WARNING(Form("No value of the %s parameter provided by the user. Using default value of %lf.", kDecayInto3MinAngleParamKey.c_str(), fDecayInto3MinAngle));
   }
+  fHistoRegistry.configure(fParams.getOptions());
   if (fSaveControlHistos) {
     getStatistics().createHistogram(
       new TH1F("2Gamma_TimeDiff", "2 Gamma Hits Time Difference", 200, 0.0, 10.0)
@@ -149,6 +150,7 @@ bool EventCategorizerImaging::init()
     );
     getStatistics().getHisto1D("3AnnihTimeDiff")->SetXTitle("Time difference [ns]");
     getStatistics().getHisto1D("3AnnihTimeDiff")->SetYTitle("Counts");
+    fStreamHistos = EventCategorizerTools::getStreamHistos(getStatistics(), &fHistoRegistry);
   }
   return true;
 }
@@ -157,6 +159,7 @@ bool EventCategorizerImaging::exec()
 {
   vector<JPetEvent> events;
   if (auto timeWindow = dynamic_cast<const JPetTimeWindow* const>(fEvent)) {
+    fHistoRegistry.beginWindow();
     uint n = timeWindow->getNumberOfEvents();
     for (uint i = 0; i < n; ++i) {
       const auto& event = dynamic_cast<const JPetEvent&>(timeWindow->operator[](i));
@@ -166,6 +169,7 @@ bool EventCategorizerImaging::exec()
         if (imagingEvent.getHits().size()) { events.push_back(imagingEvent); }
       }
     }
+    fHistoRegistry.endWindow();
   } else {
     return false;
   }
@@ -176,6 +180,7 @@ bool EventCategorizerImaging::exec()
 
 bool EventCategorizerImaging::terminate()
 {
+  fHistoRegistry.merge();
   INFO("Imaging streaming ended.");
   return true;
 }
@@ -196,10 +201,11 @@ JPetEvent EventCategorizerImaging::imageReconstruction(vector<JPetHit> hits)
       imagingEvent.addHit(hits[i]);
     }
   }
-  if (EventCategorizerTools::stream2Gamma(imagingEvent, getStatistics(), fSaveControlHistos, fBackToBackAngleWindow, fMaxTimeDiff)) {
+  auto streamHistos = fHistoRegistry.isWindowSampled() ? fStreamHistos : EventStreamHistos();
+  if (EventCategorizerTools::stream2Gamma(imagingEvent, streamHistos, fBackToBackAngleWindow, fMaxTimeDiff)) {
     imagingEvent.addEventType(JPetEventType::k2Gamma);
   }
-  if (EventCategorizerTools::stream3Gamma(imagingEvent, getStatistics(), fSaveControlHistos, fDecayInto3MinAngle, fMaxTimeDiff, fMaxDistOfDecayPlaneFromCenter)) {
+  if (EventCategorizerTools::stream3Gamma(imagingEvent, streamHistos, fDecayInto3MinAngle, fMaxTimeDiff, fMaxDistOfDecayPlaneFromCenter)) {
     imagingEvent.addEventType(JPetEventType::k3Gamma);
   }
   return imagingEvent;
@@ -21,6 +21,8 @@
 #include <JPetUserTask/JPetUserTask.h>
 #include <JPetEvent/JPetEvent.h>
 #include <JPetHit/JPetHit.h>
+#include "../LargeBarrelAnalysis/EventCategorizerTools.h"
+#include "../LargeBarrelAnalysis/HistogramHandles.h"
 #include <vector>
 #include <map>
 
@@ -57,6 +59,8 @@ protected:
 	double fMaxTimeDiff = 1000.;
 	double fMaxZPos = 23.;
 	bool fSaveControlHistos = true;
+	HistoRegistry fHistoRegistry;
+	EventStreamHistos fStreamHistos;
 	void saveEvents(const std::vector<JPetEvent>& event);
 };
 
@@ -23,15 +23,46 @@
 #include <TString.h>
 #include <TDirectory.h>
 #include <vector>
+#include <algorithm>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 #include <JPetOptionsTools/JPetOptionsTools.h>
 #include <JPetTimer/JPetTimer.h>
+#include "../LargeBarrelAnalysis/ParallelFitter.h"
+#include "../LargeBarrelAnalysis/ShardedRun.h"
 
 using namespace jpet_options_tools;
 using namespace std;
 
+namespace
+{
+/**
+ * Times of thresholds 1-4 of both edges of the signal, true only if
+ * the signal has exactly 4 thresholds on both edges
+ */
+bool readThresholdTimes(const JPetPhysSignal& signal, double times[2][4])
+{
+  const auto& rawSignal = signal.getRecoSignal().getRawSignal();
+  auto leads = rawSignal.getPoints(JPetSigCh::Leading, JPetRawSignal::ByThrNum);
+  auto trails = rawSignal.getPoints(JPetSigCh::Trailing, JPetRawSignal::ByThrNum);
+  if (leads.size() != 4 || trails.size() != 4) return false;
+  bool found[2][4] = {{false, false, false, false}, {false, false, false, false}};
+  for (int edge = 0; edge < 2; edge++) {
+    for (const auto& sigCh : edge == 0 ? leads : trails) {
+      int thr = sigCh.getThresholdNumber();
+      if (thr < 1 || thr > 4) return false;
+      times[edge][thr - 1] = sigCh.getValue();
+      found[edge][thr - 1] = true;
+    }
+  }
+  for (int thr = 0; thr < 4; thr++) {
+    if (!found[0][thr] || !found[1][thr]) return false;
+  }
+  return true;
+}
+}
+
 InterThresholdCalibration::InterThresholdCalibration(const char* name): JPetUserTask(name) {}
 
 
@@ -48,10 +79,6 @@ bool InterThresholdCalibration::init()
 
   fBarrelMap = new JPetGeomMapping(getParamBank());
 
-  for ( int layer = 0; layer < getParamBank().getLayersSize(); layer++) {
-    kSl_max.push_back(fBarrelMap->getSlotsCount( getParamBank().getLayer(layer) ) );
-  }
-
   fOutputEvents = new JPetTimeWindow("JPetEvent");
 
   //This line has to be added since starting from v6 we use cointainers
@@ -72,47 +99,66 @@ bool InterThresholdCalibration::init()
   if ( isOptionSet(fParams.getOptions(), fMin_evKey))
     fMin_ev = getOptionAsDouble(fParams.getOptions(), fMin_evKey);
 
-  std::ofstream output;
-
-  output.open(fOutputFile, std::ios::app); //open the final output file in append mode
-  if (output.tellp() == 0) {             //if the file is empty/new write the header
-    output << "# Threshold time calibration constants" << std::endl;
-    output << "# correction and offset with respect to the t1 (for thr a)" << std::endl;
-    output << "# time differences for thresholds are following: t2-t1 (1), t3-t1 (2), t4-t1 (3)" << std::endl;
-    output << "# Description of the parameters: layer(1-3) | slot(1-48/96) | side(A-B) | thr time diffr: 1 (ab), 2 (ac), 3 (ad) | offset_value_leading | offset_uncertainty_leading | offset_value_trailing | offset_uncertainty_trailing | sigma_offset_leading | sigma_offset_trailing | (chi2/ndf)_leading | (chi2/ndf)_trailing" << std::endl;
-    output << "# Calibration started on " << local_time;
-  } else {
-    output << "# Calibration started on " << local_time; //if the file was already on disk write only the time at which the calibration started
-    output.close();
+  fFitThreads = ParallelFitter::getNumberOfThreads(fParams.getOptions());
+  fPeakMethod = PeakEstimator::getMethod(fParams.getOptions());
+
+  fDeferFit = ShardedRun::isFitDeferred(fParams.getOptions());
+
+  //results are written only by the run fitting the merged histograms of the shards
+  if (!fDeferFit) {
+    std::ofstream output;
+
+    output.open(fOutputFile, std::ios::app); //open the final output file in append mode
+    if (output.tellp() == 0) {             //if the file is empty/new write the header
+      output << "# Threshold time calibration constants" << std::endl;
+      output << "# correction and offset with respect to the t1 (for thr a)" << std::endl;
+      output << "# time differences for thresholds are following: t2-t1 (1), t3-t1 (2), t4-t1 (3)" << std::endl;
+      output << "# Description of the parameters: layer(1-3) | slot(1-48/96) | side(A-B) | thr time diffr: 1 (ab), 2 (ac), 3 (ad) | offset_value_leading | offset_uncertainty_leading | offset_value_trailing | offset_uncertainty_trailing | sigma_offset_leading | sigma_offset_trailing | (chi2/ndf)_leading | (chi2/ndf)_trailing" << std::endl;
+      output << "# Calibration started on " << local_time;
+    } else {
+      output << "# Calibration started on " << local_time; //if the file was already on disk write only the time at which the calibration started
+      output.close();
+    }
   }
 
-  //histograms
-
-  for (int lay = 1; lay <= kSl_max.size() + 1; lay++) { // loop over layers
-    for (int sl = 1; sl <= kSl_max[lay - 1]; sl++) { // loop over slots
-      for (int thre = 2; thre <= 4; thre++) { // loop over th diffr times
-	
-//leading
-//histos for side A
-        const char* histo_name_l_A = Form("timeDiffA_leading_layer_%d_slot_%d_thr_1%d", lay, sl, thre);
-        getStatistics().createHistogram( new TH1F(histo_name_l_A, histo_name_l_A, 200, -2., 2.));
-
-//histos for side B
-        const char* histo_name_l_B = Form("timeDiffB_leading_layer_%d_slot_%d_thr_1%d", lay, sl, thre);
-        getStatistics().createHistogram(new TH1F(histo_name_l_B, histo_name_l_B, 300, -3., 3.) );
-
-//trailing
-//histos for side A
-        const char* histo_name_t_A = Form("timeDiffA_trailing_layer_%d_slot_%d_thr_1%d", lay, sl, thre);
-        getStatistics().createHistogram( new TH1F(histo_name_t_A, histo_name_t_A, 200, -2., 2.));
-	
-//histos for side B
-        const char* histo_name_t_B = Form("timeDiffB_trailing_layer_%d_slot_%d_thr_1%d", lay, sl, thre);
-        getStatistics().createHistogram(new TH1F(histo_name_t_B, histo_name_t_B, 300, -3., 3.));
+  //histograms, in the dense array indexed by the layer and slot numbers of the mapping
+  int maxSlotID = -1;
+  for (const auto& slot : getParamBank().getBarrelSlots()) {
+    fNumberOfLayers = std::max(fNumberOfLayers, static_cast<int>(fBarrelMap->getLayerNumber(slot.second->getLayer())));
+    fMaxSlots = std::max(fMaxSlots, static_cast<int>(fBarrelMap->getSlotNumber(*slot.second)));
+    maxSlotID = std::max(maxSlotID, slot.first);
+  }
+  fSlotIndex.assign(maxSlotID + 1, -1);
+  fTimeDiffHistos.assign(fNumberOfLayers * fMaxSlots * kThresholdPairs * 2 * 2, HistoHandle());
+
+  const char* sides[2] = {"A", "B"};
+  const char* edges[2] = {"leading", "trailing"};
+  for (const auto& slot : getParamBank().getBarrelSlots()) {
+    int lay = fBarrelMap->getLayerNumber(slot.second->getLayer());
+    int sl = fBarrelMap->getSlotNumber(*slot.second);
+    int slotIndex = (lay - 1) * fMaxSlots + sl - 1;
+    fSlotIndex[slot.first] = slotIndex;
+    for (int thre = 2; thre <= 4; thre++) { // loop over th diffr times
+      for (int side = 0; side < 2; side++) {
+        for (int edge = 0; edge < 2; edge++) {
+          std::string histo_name = Form("timeDiff%s_%s_layer_%d_slot_%d_thr_1%d", sides[side], edges[edge], lay, sl, thre);
+          if (side == 0) { //histos for side A
+            getStatistics().createHistogram(new TH1F(histo_name.c_str(), histo_name.c_str(), 200, -2., 2.));
+          } else { //histos for side B
+            getStatistics().createHistogram(new TH1F(histo_name.c_str(), histo_name.c_str(), 300, -3., 3.));
+          }
+          fTimeDiffHistos[getHistoIndex(slotIndex, thre - 2, side, edge)] = HistoHandle::direct(getStatistics(), histo_name);
+        }
       }
     }
   }
 
+  //histograms summed over the shards of the run are only fitted
+  if (ShardedRun::hasMergedStatistics(fParams.getOptions())) {
+    if (!ShardedRun::loadMergedStatistics(fParams.getOptions(), getStatistics())) return false;
+    fFitOnly = true;
+  }
+
   INFO("#############");
   INFO("CALIB_INIT: INITIALIZATION DONE!");
   INFO("#############");
@@ -122,6 +168,7 @@ bool InterThresholdCalibration::init()
 
 bool InterThresholdCalibration::exec()
 {
+  if (fFitOnly) return true;
   std::vector <JPetHit> fhitsCalib;
 
   //getting the data from event in propriate format
@@ -150,253 +197,161 @@ bool InterThresholdCalibration::exec()
 
 bool InterThresholdCalibration::terminate()
 {
-  // create output txt file with calibration parameters
-  std::ofstream results_fit;
-  results_fit.open(fOutputFile, std::ios::app);
-
-  for (int lay = 1; lay <= kSl_max.size() + 1; lay++) { // loop over layers
-    for (int sl = 1; sl <= kSl_max[lay - 1]; sl++) { // loop over slots
+  if (fDeferFit) {
+    INFO("CALIB_INFO: Fits deferred to the merge of the shards of the run");
+    return true;
+  }
+  //fits of one threshold difference of a slot, indexes of the fits in the fitter
+  struct ThresholdFits {
+    int lay, sl, th;
+    size_t leading_A, leading_B, trailing_A, trailing_B;
+  };
+  //fit in the range of 0.2 ns around the highest bin
+  ParallelFitter fitter(fFitThreads, fPeakMethod);
+  auto addFit = [&fitter](TH1F* histo) {
+    double highestBin = histo->GetBinCenter(histo->GetMaximumBin());
+    return fitter.add(histo, highestBin - 0.2, highestBin + 0.2, histo->GetName());
+  };
+  std::vector<ThresholdFits> fits;
+
+  auto getHisto = [this](int slotIndex, int th, int side, int edge) {
+    return static_cast<TH1F*>(fTimeDiffHistos[getHistoIndex(slotIndex, th - 1, side, edge)].getHisto());
+  };
+
+  for (int lay = 1; lay <= fNumberOfLayers; lay++) { // loop over layers
+    for (int sl = 1; sl <= fMaxSlots; sl++) { // loop over slots
+      const int slotIndex = (lay - 1) * fMaxSlots + sl - 1;
+      //layers with less slots than the largest one
+      if (!fTimeDiffHistos[getHistoIndex(slotIndex, 0, 0, 0)].isValid()) continue;
       for (int th = 1; th <= 3; th++) { // loop over th diffr times
+        TH1F* histoToSave_leading_A = getHisto(slotIndex, th, 0, 0);
+        TH1F* histoToSave_leading_B = getHisto(slotIndex, th, 1, 0);
+        TH1F* histoToSave_trailing_A = getHisto(slotIndex, th, 0, 1);
+        TH1F* histoToSave_trailing_B = getHisto(slotIndex, th, 1, 1);
 
-        //leading
-        //histos for side A
-        const char* histo_name_l_A = Form("timeDiffA_leading_layer_%d_slot_%d_thr_1%d", lay, sl, th + 1);
-        TH1F* histoToSave_leading_A = getStatistics().getHisto1D(histo_name_l_A);
-                
-        //histos for side B
-        const char* histo_name_l_B = Form("timeDiffB_leading_layer_%d_slot_%d_thr_1%d", lay, sl, th + 1);
-        TH1F* histoToSave_leading_B = getStatistics().getHisto1D(histo_name_l_B);
-
-        //trailing
-        //histos for side A
-        const char* histo_name_t_A = Form("timeDiffA_trailing_layer_%d_slot_%d_thr_1%d", lay, sl, th + 1);
-        TH1F* histoToSave_trailing_A = getStatistics().getHisto1D(histo_name_t_A);
-        
-        //histos for side B
-        const char* histo_name_t_B = Form("timeDiffB_trailing_layer_%d_slot_%d_thr_1%d", lay, sl, th + 1);
-        TH1F* histoToSave_trailing_B = getStatistics().getHisto1D(histo_name_t_B);
-        
 	//minimal criteria for histograms
         if (histoToSave_leading_A->GetEntries() != 0 && histoToSave_leading_B->GetEntries() != 0
             && histoToSave_trailing_A->GetEntries() != 0 && histoToSave_trailing_B->GetEntries() != 0) {
-          INFO("#############");
-          INFO("CALIB_INFO: Fitting histogams for layer= " + std::to_string(lay) + ", slot= " + std::to_string(sl) + ", time diffr threshold= " + std::to_string(th));
-          INFO("#############");
-
-          if (histoToSave_leading_A->GetEntries() <= fMin_ev) {
-            results_fit << "#WARNING: Statistics used to determine the leading edge (A) threshold calibration constant was less than " << fMin_ev << " events!" << endl;
-            WARNING(": Statistics used to determine the leading edge (A) threshold calibration constant was less than " + std::to_string(fMin_ev) + " events!");
-          }
-
-          if (histoToSave_leading_B->GetEntries() <= fMin_ev) {
-            results_fit << "#WARNING: Statistics used to determine the leading edge (B) threshold calibration constant was less than " << fMin_ev << " events!" << endl;
-            WARNING(": Statistics used to determine the leading edge (B) threshold calibration constant was less than " + std::to_string(fMin_ev) + " events!");
-          }
-
-          if (histoToSave_trailing_A->GetEntries() <= fMin_ev) {
-            results_fit << "#WARNING: Statistics used to determine the trailing edge (A) threshold calibration constant was less than " << fMin_ev << " events!" << endl;
-            WARNING(": Statistics used to determine the trailing edge (A) threshold calibration constant was less than " + std::to_string(fMin_ev) + " events!");
-          }
-
-          if (histoToSave_trailing_B->GetEntries() <= fMin_ev) {
-            results_fit << "#WARNING: Statistics used to determine the trailing edge (B) threshold calibration constant was less than " << fMin_ev << " events!" << endl;
-            WARNING(": Statistics used to determine the trailing edge (B) threshold calibration constant was less than " + std::to_string(fMin_ev) + " events!");
-          }
-
-	  //fit scintilators
-          double highestBin_l_A = histoToSave_leading_A->GetBinCenter(histoToSave_leading_A->GetMaximumBin());
-          histoToSave_leading_A->Fit("gaus", "", "", highestBin_l_A - 0.2, highestBin_l_A + 0.2);
-          histoToSave_leading_A->Draw();
-
-          double highestBin_l_B = histoToSave_leading_B->GetBinCenter(histoToSave_leading_B->GetMaximumBin());
-          histoToSave_leading_B->Fit("gaus", "", "", highestBin_l_B - 0.2, highestBin_l_B + 0.2);
-          histoToSave_leading_B->Draw();
-
-          double highestBin_t_A = histoToSave_trailing_A->GetBinCenter(histoToSave_trailing_A->GetMaximumBin());
-          histoToSave_trailing_A->Fit("gaus", "", "", highestBin_t_A - 0.2, highestBin_t_A + 0.2);
-          histoToSave_trailing_A->Draw();
-
-          double highestBin_t_B = histoToSave_trailing_B->GetBinCenter(histoToSave_trailing_B->GetMaximumBin());
-          histoToSave_trailing_B->Fit("gaus", "", "", highestBin_t_B - 0.2, highestBin_t_B + 0.2);
-          histoToSave_trailing_B->Draw();
-
-          TF1* fit_l_A = histoToSave_leading_A->GetFunction("gaus");
-          TF1* fit_l_B = histoToSave_leading_B->GetFunction("gaus");
-          TF1* fit_t_A = histoToSave_trailing_A->GetFunction("gaus");
-          TF1* fit_t_B = histoToSave_trailing_B->GetFunction("gaus");
-
-          double position_peak_l_A = fit_l_A->GetParameter(1);
-          double position_peak_error_l_A = fit_l_A->GetParError(1);
-          double sigma_peak_l_A = fit_l_A->GetParameter(2);
-          double chi2_ndf_l_A = fit_l_A->GetChisquare() / fit_l_A->GetNDF();
-
-          double position_peak_l_B = fit_l_B->GetParameter(1);
-          double position_peak_error_l_B = fit_l_B->GetParError(1);
-          double sigma_peak_l_B = fit_l_B->GetParameter(2);
-          double chi2_ndf_l_B = fit_l_B->GetChisquare() / fit_l_B->GetNDF();
-
-          double position_peak_t_A = fit_t_A->GetParameter(1);
-          double position_peak_error_t_A = fit_t_A->GetParError(1);
-          double sigma_peak_t_A = fit_t_A->GetParameter(2);
-          double chi2_ndf_t_A = fit_t_A->GetChisquare() / fit_t_A->GetNDF();
-
-          double position_peak_t_B = fit_t_B->GetParameter(1);
-          double position_peak_error_t_B = fit_t_B->GetParError(1);
-          double sigma_peak_t_B = fit_t_B->GetParameter(2);
-          double chi2_ndf_t_B = fit_t_B->GetChisquare() / fit_t_B->GetNDF();
-
-
-          if ((position_peak_error_l_A / position_peak_l_A) >= fFrac_err) {
-            results_fit << "#WFIT: Large uncertainty on the calibration constant!" << endl;
-          }
-
-          if ((position_peak_error_l_B / position_peak_l_B) >= fFrac_err) {
-            results_fit << "#WFIT: Large uncertainty on the calibration constant!" << endl;
-          }
-
-          if ((position_peak_error_t_A / position_peak_t_A) >= fFrac_err) {
-            results_fit << "#WFIT: Large uncertainty on the calibration constant!" << endl;
-          }
-
-          if ((position_peak_error_t_B / position_peak_t_B) >= fFrac_err) {
-            results_fit << "#WFIT: Large uncertainty on the calibration constant!" << endl;
-          }
-
-	  // writing to apropriate format (txt file)
-	  //side A
-          results_fit << lay << "\t" << sl << "\t" << "A" << "\t" << th << "\t" << position_peak_l_A << "\t" << position_peak_error_l_A << "\t" << position_peak_t_A << "\t" << position_peak_error_t_A << "\t" << sigma_peak_l_A
-                      << "\t" << sigma_peak_t_A << "\t"  << chi2_ndf_l_A << "\t" << chi2_ndf_t_A << endl;
-	  
-	  //side B
-          results_fit << lay << "\t" << sl << "\t" << "B" << "\t" << th << "\t" << position_peak_l_B << "\t" << position_peak_error_l_B << "\t" << position_peak_t_B << "\t" << position_peak_error_t_B << "\t" << sigma_peak_l_B
-                      << "\t" << sigma_peak_t_B << "\t"  << chi2_ndf_l_B << "\t" << chi2_ndf_t_B << endl;
-	  
+          fits.push_back({lay, sl, th, addFit(histoToSave_leading_A), addFit(histoToSave_leading_B),
+            addFit(histoToSave_trailing_A), addFit(histoToSave_trailing_B)});
         } else {
           ERROR(": ONE OF THE HISTOGRAMS FOR THRESHOLD " + std::to_string(th) + " LAYER " + std::to_string(lay) + " SLOT " + std::to_string(sl) + " IS EMPTY, WE CANNOT CALIBRATE IT");
         }
       }
     }
   }
-  
-  results_fit.close();
-
-  return true;
-}
-
-//////////////////////////////////
-
-void InterThresholdCalibration::fillHistosForHit(const JPetHit& hit)
-{
-
-  auto lead_times_A = hit.getSignalA().getRecoSignal().getRawSignal().getTimesVsThresholdNumber(JPetSigCh::Leading);
-  auto trail_times_A = hit.getSignalA().getRecoSignal().getRawSignal().getTimesVsThresholdNumber(JPetSigCh::Trailing);
-
-  auto lead_times_B = hit.getSignalB().getRecoSignal().getRawSignal().getTimesVsThresholdNumber(JPetSigCh::Leading);
-  auto trail_times_B = hit.getSignalB().getRecoSignal().getRawSignal().getTimesVsThresholdNumber(JPetSigCh::Trailing);
-
-  //take slot number for the hit
-  int slot_number = hit.getBarrelSlot().getID();
-  int layer_number = hit.getBarrelSlot().getLayer().getID();
-  int slot_nr;
-
-  if (layer_number == 1) slot_nr = slot_number;
-  if (layer_number == 2) slot_nr = slot_number - 48;
-  if (layer_number == 3) slot_nr = slot_number - 96;
-
-  double thr_time_diff_t_A[5], thr_time_diff_A[5];
-  double thr_time_diff_t_B[5], thr_time_diff_B[5];
-  double lead_times_first_A, lead_times_first_B;
-  double trail_times_first_A, trail_times_first_B;
 
-  // leading edge
+  //all histograms are fitted at once, results are written in the order of the loops above
+  fitter.run();
+  fitter.reportFailures("InterThresholdCalibration");
 
-  // A
-  for (auto& thr_time_pair : lead_times_A) {
-    
-    int thr = thr_time_pair.first;
-
-    if (lead_times_A.count(thr) > 0 && trail_times_A.count(thr) > 0 && lead_times_A.size() == 4 && trail_times_A.size() == 4) { //exactly 4 thresholds
-
-      lead_times_first_A = lead_times_A[1];
+  // create output txt file with calibration parameters
+  std::ofstream results_fit;
+  results_fit.open(fOutputFile, std::ios::app);
 
-      if (thr >= 2) {
-	
-        thr_time_diff_A[thr] = lead_times_A[thr] / 1000 - lead_times_first_A / 1000;
-	
-        char* histo_name_l_A = Form("timeDiffA_leading_layer_%d_slot_%d_thr_1%d", layer_number, slot_nr, thr);
-        getStatistics().getHisto1D(histo_name_l_A)->Fill(thr_time_diff_A[thr]);
-      }
+  for (const auto& thresholdFits : fits) {
+    const int lay = thresholdFits.lay;
+    const int sl = thresholdFits.sl;
+    const int th = thresholdFits.th;
+    const FitJob& fit_l_A = fitter[thresholdFits.leading_A];
+    const FitJob& fit_l_B = fitter[thresholdFits.leading_B];
+    const FitJob& fit_t_A = fitter[thresholdFits.trailing_A];
+    const FitJob& fit_t_B = fitter[thresholdFits.trailing_B];
+
+    if (fit_l_A.histogram->GetEntries() <= fMin_ev) {
+      results_fit << "#WARNING: Statistics used to determine the leading edge (A) threshold calibration constant was less than " << fMin_ev << " events!" << endl;
+      WARNING(": Statistics used to determine the leading edge (A) threshold calibration constant was less than " + std::to_string(fMin_ev) + " events!");
     }
-  }
-  
-  // B
-  for (auto& thr_time_pair : lead_times_B) {
-
-    int thr = thr_time_pair.first;
-
-    if (lead_times_B.count(thr) > 0 && trail_times_B.count(thr) > 0 && lead_times_B.size() == 4 && trail_times_B.size() == 4) {
-
-      lead_times_first_B = lead_times_B[1];
-
-      if (thr >= 2) {
-
-        thr_time_diff_B[thr] = lead_times_B[thr] / 1000 - lead_times_first_B / 1000;
 
-        char* histo_name_l_B = Form("timeDiffB_leading_layer_%d_slot_%d_thr_1%d", layer_number, slot_nr, thr);
-        getStatistics().getHisto1D(histo_name_l_B)->Fill(thr_time_diff_B[thr]);
-      }
+    if (fit_l_B.histogram->GetEntries() <= fMin_ev) {
+      results_fit << "#WARNING: Statistics used to determine the leading edge (B) threshold calibration constant was less than " << fMin_ev << " events!" << endl;
+      WARNING(": Statistics used to determine the leading edge (B) threshold calibration constant was less than " + std::to_string(fMin_ev) + " events!");
     }
-  }
 
+    if (fit_t_A.histogram->GetEntries() <= fMin_ev) {
+      results_fit << "#WARNING: Statistics used to determine the trailing edge (A) threshold calibration constant was less than " << fMin_ev << " events!" << endl;
+      WARNING(": Statistics used to determine the trailing edge (A) threshold calibration constant was less than " + std::to_string(fMin_ev) + " events!");
+    }
 
-  // trailing edge
-  for (auto& thr_time_pair : trail_times_A) {
+    if (fit_t_B.histogram->GetEntries() <= fMin_ev) {
+      results_fit << "#WARNING: Statistics used to determine the trailing edge (B) threshold calibration constant was less than " << fMin_ev << " events!" << endl;
+      WARNING(": Statistics used to determine the trailing edge (B) threshold calibration constant was less than " + std::to_string(fMin_ev) + " events!");
+    }
 
-    int thr = thr_time_pair.first;
+    if (!fit_l_A.succeeded || !fit_l_B.succeeded || !fit_t_A.succeeded || !fit_t_B.succeeded) {
+      results_fit << "#WFIT: Fit failed for layer " << lay << " slot " << sl << " thr time diffr " << th << ", not calibrated!" << endl;
+      continue;
+    }
 
-    if (trail_times_A.count(thr) > 0 && lead_times_A.count(thr) > 0 && lead_times_A.size() == 4 && trail_times_A.size() == 4) {
+    double position_peak_l_A = fit_l_A.position;
+    double position_peak_error_l_A = fit_l_A.positionError;
+    double sigma_peak_l_A = fit_l_A.sigma;
+    double chi2_ndf_l_A = fit_l_A.chi2 / fit_l_A.ndf;
 
-      trail_times_first_A = trail_times_A[1];
+    double position_peak_l_B = fit_l_B.position;
+    double position_peak_error_l_B = fit_l_B.positionError;
+    double sigma_peak_l_B = fit_l_B.sigma;
+    double chi2_ndf_l_B = fit_l_B.chi2 / fit_l_B.ndf;
 
-      if (thr >= 2) {
+    double position_peak_t_A = fit_t_A.position;
+    double position_peak_error_t_A = fit_t_A.positionError;
+    double sigma_peak_t_A = fit_t_A.sigma;
+    double chi2_ndf_t_A = fit_t_A.chi2 / fit_t_A.ndf;
 
-        thr_time_diff_t_A[thr] = trail_times_A[thr] / 1000 - trail_times_first_A / 1000;
+    double position_peak_t_B = fit_t_B.position;
+    double position_peak_error_t_B = fit_t_B.positionError;
+    double sigma_peak_t_B = fit_t_B.sigma;
+    double chi2_ndf_t_B = fit_t_B.chi2 / fit_t_B.ndf;
 
-        char* histo_name_t_A = Form("timeDiffA_trailing_layer_%d_slot_%d_thr_1%d", layer_number, slot_nr, thr);
-        getStatistics().getHisto1D(histo_name_t_A)->Fill(thr_time_diff_t_A[thr]);
 
-      }
+    if ((position_peak_error_l_A / position_peak_l_A) >= fFrac_err) {
+      results_fit << "#WFIT: Large uncertainty on the calibration constant!" << endl;
     }
-  }
 
+    if ((position_peak_error_l_B / position_peak_l_B) >= fFrac_err) {
+      results_fit << "#WFIT: Large uncertainty on the calibration constant!" << endl;
+    }
 
-  for (auto& thr_time_pair : trail_times_B) {
-
-    int thr = thr_time_pair.first;
-
-    if (trail_times_B.count(thr) > 0 && lead_times_B.count(thr) > 0 && lead_times_B.size() == 4 && trail_times_B.size() == 4) {
-
-
-      trail_times_first_B = trail_times_B[1];
-
-      if (thr >= 2) {
+    if ((position_peak_error_t_A / position_peak_t_A) >= fFrac_err) {
+      results_fit << "#WFIT: Large uncertainty on the calibration constant!" << endl;
+    }
 
-        thr_time_diff_t_B[thr] = trail_times_B[thr] / 1000 - trail_times_first_B / 1000;
+    if ((position_peak_error_t_B / position_peak_t_B) >= fFrac_err) {
+      results_fit << "#WFIT: Large uncertainty on the calibration constant!" << endl;
+    }
 
-        char* histo_name_t_B = Form("timeDiffB_trailing_layer_%d_slot_%d_thr_1%d", layer_number, slot_nr, thr);
-        getStatistics().getHisto1D(histo_name_t_B)->Fill(thr_time_diff_t_B[thr]);
+    // writing to apropriate format (txt file)
+    //side A
+    results_fit << lay << "\t" << sl << "\t" << "A" << "\t" << th << "\t" << position_peak_l_A << "\t" << position_peak_error_l_A << "\t" << position_peak_t_A << "\t" << position_peak_error_t_A << "\t" << sigma_peak_l_A
+                << "\t" << sigma_peak_t_A << "\t"  << chi2_ndf_l_A << "\t" << chi2_ndf_t_A << endl;
 
-      }
-    }
+    //side B
+    results_fit << lay << "\t" << sl << "\t" << "B" << "\t" << th << "\t" << position_peak_l_B << "\t" << position_peak_error_l_B << "\t" << position_peak_t_B << "\t" << position_peak_error_t_B << "\t" << sigma_peak_l_B
+                << "\t" << sigma_peak_t_B << "\t"  << chi2_ndf_l_B << "\t" << chi2_ndf_t_B << endl;
   }
   
+  results_fit.close();
+
+  return true;
 }
 
+//////////////////////////////////
 
-const char* InterThresholdCalibration::formatUniqueSlotDescription(const JPetBarrelSlot& slot, int threshold, const char* prefix = "")
+void InterThresholdCalibration::fillHistosForHit(const JPetHit& hit)
 {
-  int slot_number = fBarrelMap->getSlotNumber(slot);
-  int layer_number = fBarrelMap->getLayerNumber(slot.getLayer());
-
-  return Form("%slayer_%d_slot_%d_thr_%d", prefix, layer_number, slot_number, threshold);
+  int slotID = hit.getBarrelSlot().getID();
+  if (slotID < 0 || slotID >= static_cast<int>(fSlotIndex.size()) || fSlotIndex[slotID] < 0) return;
+  const int slotIndex = fSlotIndex[slotID];
+
+  for (int side = 0; side < 2; side++) {
+    //times of thresholds 1-4 of the leading and trailing edge
+    double times[2][4];
+    if (!readThresholdTimes(side == 0 ? hit.getSignalA() : hit.getSignalB(), times)) continue;
+    for (int edge = 0; edge < 2; edge++) {
+      for (int thrPair = 0; thrPair < kThresholdPairs; thrPair++) {
+        double thr_time_diff = times[edge][thrPair + 1] / 1000 - times[edge][0] / 1000;
+        fTimeDiffHistos[getHistoIndex(slotIndex, thrPair, side, edge)].fill(thr_time_diff);
+      }
+    }
+  }
 }
@@ -20,12 +20,23 @@
 #include <JPetRawSignal/JPetRawSignal.h>
 #include <JPetGeomMapping/JPetGeomMapping.h>
 #include <JPetTimer/JPetTimer.h>
+#include "../LargeBarrelAnalysis/HistogramHandles.h"
+#include "../LargeBarrelAnalysis/PeakEstimator.h"
+#include <vector>
 class JPetWriter;
 #ifdef __CINT__
 //when cint is used instead of compiler, override word is not recognized
 //nevertheless it's needed for checking if the structure of project is correct
 #	define override
 #endif
+/**
+ * @brief User Task: calibration of times of thresholds 2-4 with respect to the threshold 1
+ *
+ * Histograms of differences of times of thresholds are kept in a dense array
+ * [layer][slot][threshold pair][side][edge], with layers and slots numbered
+ * by JPetGeomMapping, built in init(). Hits are assigned to the array by the ID
+ * of the barrel slot, so each hit is only a few fills, with no lookups by names.
+ */
 class InterThresholdCalibration: public JPetUserTask
 {
 public:
@@ -35,8 +46,12 @@ public:
   virtual bool exec()override;
   virtual bool terminate()override;
 protected:
-  const char* formatUniqueSlotDescription(const JPetBarrelSlot& slot, int threshold, const char* prefix);
   void fillHistosForHit(const JPetHit& hit);
+  int getHistoIndex(int slotIndex, int thrPair, int side, int edge) const
+  {
+    return ((slotIndex * kThresholdPairs + thrPair) * 2 + side) * 2 + edge;
+  }
+  static const int kThresholdPairs = 3; //time differences t2-t1, t3-t1, t4-t1
   JPetGeomMapping* fBarrelMap = nullptr;
   std::string fOutputFile = "TimeConstantsInterThrCalib.txt";
   const std::string fOutputFileKey = "InterThresholdCalibration_TimeConstantsInterThrCalibOutputFile_std::string";
@@ -46,9 +61,14 @@ protected:
   const std::string fFrac_errKey = "InterThresholdCalibration_Frac_err_double";
   int fMin_ev = 100;     //minimal number of events for a distribution to be fitted
   const std::string fMin_evKey = "InterThresholdCalibration_Min_ev_int";
-  std::vector<double> kSl_max; //amount of slots per each layer
-  double fThr_time_diff_t_A[5], fThr_time_diff_A[5];
-  double fThr_time_diff_t_B[5], fThr_time_diff_B[5];
+  int fNumberOfLayers = 0; //layers of the barrel, numbered from 1 by the mapping
+  int fMaxSlots = 0; //slots in the largest layer, size of the slot dimension of the array
+  std::vector<int> fSlotIndex; //index of the layer and slot, (layer - 1) * fMaxSlots + slot - 1, for each barrel slot ID, -1 if none
+  std::vector<HistoHandle> fTimeDiffHistos; //[layer][slot][thrPair][side][edge], side 0 is A, edge 0 is leading
+  unsigned fFitThreads = 0; //threads of the fits in terminate(), 0 for one per core
+  PeakEstimator::Method fPeakMethod = PeakEstimator::kFit; //Gaussian fits or analytic estimates of peaks
+  bool fDeferFit = false; //histograms are fitted after the merge of shards of the run
+  bool fFitOnly = false;  //histograms are read from the merged shards, no windows are processed
 
 };
 #endif /*  !InterThresholdCalibration_H */
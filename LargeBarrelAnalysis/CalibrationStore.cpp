@@ -0,0 +1,202 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file CalibrationStore.cpp
+ */
+
+#include "JPetLoggerInclude.h"
+#include "CalibrationStore.h"
+#include <algorithm>
+#include <iterator>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <limits>
+
+using namespace std;
+
+const string CalibrationStore::kIntervalHeader = "#@";
+
+namespace
+{
+const double kMaxTime = numeric_limits<double>::max();
+
+CalibrationInterval makeInterval(const UniversalFileLoader::TOMBChToParameter& parameters)
+{
+  CalibrationInterval interval;
+  interval.startTime = -kMaxTime;
+  interval.endTime = kMaxTime;
+  interval.parameters = parameters;
+  return interval;
+}
+}
+
+CalibrationStore::CalibrationStore()
+{
+  build(vector<CalibrationInterval>(), -1);
+}
+
+/**
+ * Loading the calibration of the given run from the file. Returns false
+ * if there are no parameters or the header of an interval is not correct.
+ */
+bool CalibrationStore::load(
+  const string& confFile, const UniversalFileLoader::TOMBChMap& tombMap,
+  int run, const string& cacheDirectory)
+{
+  string contents;
+  ifstream file(confFile, ios::binary);
+  if (file) contents.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+  bool hasIntervals = contents.compare(0, kIntervalHeader.size(), kIntervalHeader) == 0
+    || contents.find("\n" + kIntervalHeader) != string::npos;
+  if (!hasIntervals) {
+    auto parameters = UniversalFileLoader::loadConfigurationParameters(confFile, tombMap, cacheDirectory);
+    build(vector<CalibrationInterval>(1, makeInterval(parameters)), run);
+    return !empty();
+  }
+  INFO("Loading time dependent parameters from file: " + confFile);
+  vector<CalibrationInterval> intervals;
+  if (!readIntervals(contents, tombMap, intervals)) {
+    build(vector<CalibrationInterval>(), run);
+    return false;
+  }
+  build(intervals, run);
+  INFO(Form("%lu intervals of validity in file %s, divided into %lu periods of run %d",
+    (unsigned long) intervals.size(), confFile.c_str(), (unsigned long) fPeriods.size(), run));
+  return !empty();
+}
+
+/**
+ * Dividing times of the run into periods at the bounds of the intervals of the run
+ * or of any run. Each channel of a period takes its parameters from the last
+ * interval containing the whole period, adjacent periods of the same parameters
+ * are joined.
+ */
+void CalibrationStore::build(const vector<CalibrationInterval>& intervals, int run)
+{
+  vector<const CalibrationInterval*> selected;
+  vector<double> bounds = { -kMaxTime, kMaxTime};
+  for (const auto& interval : intervals) {
+    if (interval.run != -1 && interval.run != run) continue;
+    selected.push_back(&interval);
+    bounds.push_back(interval.startTime);
+    bounds.push_back(interval.endTime);
+  }
+  sort(bounds.begin(), bounds.end());
+  bounds.erase(unique(bounds.begin(), bounds.end()), bounds.end());
+  fPeriods.clear();
+  fCurrent = 0;
+  for (size_t i = 0; i + 1 < bounds.size(); i++) {
+    Period period = {bounds[i], bounds[i + 1], UniversalFileLoader::TOMBChToParameter()};
+    for (auto interval : selected) {
+      if (interval->startTime > period.startTime || interval->endTime < period.endTime) continue;
+      for (const auto& parameters : interval->parameters) {
+        period.parameters[parameters.first] = parameters.second;
+      }
+    }
+    if (!fPeriods.empty() && fPeriods.back().parameters == period.parameters) {
+      fPeriods.back().endTime = period.endTime;
+    } else {
+      fPeriods.push_back(period);
+    }
+  }
+}
+
+/**
+ * Reading intervals from the contents of the file, lines of each interval
+ * are parsed by UniversalFileLoader. Header lines are comments for the loader.
+ */
+bool CalibrationStore::readIntervals(
+  const string& contents, const UniversalFileLoader::TOMBChMap& tombMap,
+  vector<CalibrationInterval>& intervals)
+{
+  intervals.clear();
+  CalibrationInterval interval = makeInterval(UniversalFileLoader::TOMBChToParameter());
+  bool afterHeader = false;
+  size_t blockStart = 0;
+  auto addInterval = [&](size_t blockEnd) {
+    auto records = UniversalFileLoader::parseConfigurationParameters(
+      contents.substr(blockStart, blockEnd - blockStart));
+    interval.parameters = UniversalFileLoader::generateConfigurationParameters(records, tombMap);
+    // Lines before the first header are kept only if there are any
+    if (afterHeader || !interval.parameters.empty()) intervals.push_back(interval);
+  };
+  size_t position = 0;
+  while (position < contents.size()) {
+    size_t lineEnd = contents.find('\n', position);
+    if (lineEnd == string::npos) lineEnd = contents.size();
+    if (contents.compare(position, kIntervalHeader.size(), kIntervalHeader) == 0) {
+      addInterval(position);
+      auto header = contents.substr(position, lineEnd - position);
+      if (!parseIntervalHeader(header, interval)) {
+        ERROR("Header of the interval of validity seems to be incorrect:" + header);
+        return false;
+      }
+      afterHeader = true;
+      blockStart = min(lineEnd + 1, contents.size());
+    }
+    position = lineEnd + 1;
+  }
+  addInterval(contents.size());
+  return true;
+}
+
+/**
+ * Header of the interval: #@ run <run number or *> [<start time> [<end time>]]
+ * Times are given in ps from the start of the run, missing ones do not limit the interval.
+ */
+bool CalibrationStore::parseIntervalHeader(const string& line, CalibrationInterval& interval)
+{
+  if (line.compare(0, kIntervalHeader.size(), kIntervalHeader) != 0) return false;
+  istringstream stream(line.substr(kIntervalHeader.size()));
+  vector<string> fields(istream_iterator<string>(stream), (istream_iterator<string>()));
+  if (fields.size() < 2 || fields.size() > 4 || fields[0] != "run") return false;
+  char* end = nullptr;
+  if (fields[1] == "*") {
+    interval.run = -1;
+  } else {
+    interval.run = strtol(fields[1].c_str(), &end, 10);
+    if (*end != '\0' || interval.run < 0) return false;
+  }
+  interval.startTime = -kMaxTime;
+  interval.endTime = kMaxTime;
+  if (fields.size() > 2) {
+    interval.startTime = strtod(fields[2].c_str(), &end);
+    if (*end != '\0') return false;
+  }
+  if (fields.size() > 3) {
+    interval.endTime = strtod(fields[3].c_str(), &end);
+    if (*end != '\0') return false;
+  }
+  return interval.startTime < interval.endTime;
+}
+
+/**
+ * Selecting the period of the given time, in ps from the start of the run.
+ * The period of the previous window is checked first, as it is usually the same.
+ */
+void CalibrationStore::selectTime(double time)
+{
+  const auto& current = fPeriods[fCurrent];
+  if (time >= current.startTime && time < current.endTime) return;
+  auto period = upper_bound(fPeriods.begin(), fPeriods.end(), time,
+    [](double value, const Period& period) { return value < period.startTime; });
+  fCurrent = period == fPeriods.begin() ? 0 : distance(fPeriods.begin(), period) - 1;
+}
+
+bool CalibrationStore::empty() const
+{
+  for (const auto& period : fPeriods) {
+    if (!period.parameters.empty()) return false;
+  }
+  return true;
+}
@@ -0,0 +1,77 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file CalibrationStore.h
+ */
+
+#ifndef CALIBRATIONSTORE_H
+#define CALIBRATIONSTORE_H
+
+#include "UniversalFileLoader.h"
+#include <string>
+#include <vector>
+
+/**
+ * @brief Interval of validity of parameters of some channels, given in a file
+ *
+ * Run number -1 stands for any run. Times are given in ps from the start
+ * of the run, start time is inclusive and end time is exclusive.
+ */
+struct CalibrationInterval {
+  int run = -1;
+  double startTime = 0.0;
+  double endTime = 0.0;
+  UniversalFileLoader::TOMBChToParameter parameters;
+};
+
+/**
+ * @brief Time dependent calibration of a run
+ *
+ * Built from a file of the format of UniversalFileLoader, divided into
+ * intervals of validity with header lines:
+ * #@ run <run number or *> [<start time> [<end time>]]
+ * Lines before the first header are valid for any run at any time.
+ * Each channel takes its parameters from the last interval of the file
+ * that contains the time. Times of the run are divided in advance into periods
+ * with the same parameters of all channels. A task selects the period for each
+ * window with selectTime(), then getParameters() gives the map for the period
+ * with no search. Files with no headers are loaded with the cache of the loader.
+ */
+class CalibrationStore
+{
+public:
+  CalibrationStore();
+  bool load(const std::string& confFile, const UniversalFileLoader::TOMBChMap& tombMap,
+    int run, const std::string& cacheDirectory = "");
+  void build(const std::vector<CalibrationInterval>& intervals, int run);
+  static bool readIntervals(const std::string& contents, const UniversalFileLoader::TOMBChMap& tombMap,
+    std::vector<CalibrationInterval>& intervals);
+  static bool parseIntervalHeader(const std::string& line, CalibrationInterval& interval);
+  void selectTime(double time);
+  const UniversalFileLoader::TOMBChToParameter& getParameters() const { return fPeriods[fCurrent].parameters; }
+  bool isTimeDependent() const { return fPeriods.size() > 1; }
+  size_t getNumberOfPeriods() const { return fPeriods.size(); }
+  bool empty() const;
+
+  static const std::string kIntervalHeader;
+
+private:
+  struct Period {
+    double startTime;
+    double endTime;
+    UniversalFileLoader::TOMBChToParameter parameters;
+  };
+  std::vector<Period> fPeriods;
+  size_t fCurrent = 0;
+};
+
+#endif /* !CALIBRATIONSTORE_H */
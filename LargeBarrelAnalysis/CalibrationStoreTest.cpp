@@ -0,0 +1,112 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file CalibrationStoreTest.cpp
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE CalibrationStoreTest
+
+#include <boost/test/unit_test.hpp>
+#include "CalibrationStore.h"
+#include <fstream>
+#include <cstdio>
+
+const UniversalFileLoader::TOMBChMap kTombMap = {
+  {std::make_tuple(1, 1, JPetPM::SideA, 1), 22},
+  {std::make_tuple(1, 1, JPetPM::SideB, 1), 23}
+};
+
+BOOST_AUTO_TEST_SUITE(CalibrationStoreTestSuite)
+
+BOOST_AUTO_TEST_CASE(parseIntervalHeader_test)
+{
+  CalibrationInterval interval;
+  BOOST_REQUIRE(CalibrationStore::parseIntervalHeader("#@ run 5 100 200.5", interval));
+  BOOST_REQUIRE_EQUAL(interval.run, 5);
+  BOOST_REQUIRE_EQUAL(interval.startTime, 100.0);
+  BOOST_REQUIRE_EQUAL(interval.endTime, 200.5);
+  BOOST_REQUIRE(CalibrationStore::parseIntervalHeader("#@ run * 1e12", interval));
+  BOOST_REQUIRE_EQUAL(interval.run, -1);
+  BOOST_REQUIRE_EQUAL(interval.startTime, 1e12);
+  BOOST_REQUIRE(interval.endTime > 1e300);
+  BOOST_REQUIRE(!CalibrationStore::parseIntervalHeader("#@ run x", interval));
+  BOOST_REQUIRE(!CalibrationStore::parseIntervalHeader("#@ run 5 200 100", interval));
+  BOOST_REQUIRE(!CalibrationStore::parseIntervalHeader("#@ runs 5", interval));
+  BOOST_REQUIRE(!CalibrationStore::parseIntervalHeader("#@ run 5 1 2 3", interval));
+}
+
+BOOST_AUTO_TEST_CASE(empty_store)
+{
+  CalibrationStore store;
+  BOOST_REQUIRE(store.empty());
+  BOOST_REQUIRE(!store.isTimeDependent());
+  store.selectTime(100.0);
+  BOOST_REQUIRE(store.getParameters().empty());
+}
+
+BOOST_AUTO_TEST_CASE(load_intervals)
+{
+  const std::string fileName = "CalibrationStoreTest.txt";
+  std::ofstream file(fileName);
+  file << "# Default values\n"
+    << "1 1 A 1 1.0 0 0 0 0 0 0 0\n"
+    << "1 1 B 1 2.0 0 0 0 0 0 0 0\n"
+    << "#@ run 7 1000 2000\n"
+    << "1 1 A 1 3.0 0 0 0 0 0 0 0\n"
+    << "#@ run 8 0 5000\n"
+    << "1 1 A 1 4.0 0 0 0 0 0 0 0\n"
+    << "#@ run * 1500\n"
+    << "1 1 B 1 5.0 0 0 0 0 0 0 0\n";
+  file.close();
+
+  CalibrationStore store;
+  BOOST_REQUIRE(store.load(fileName, kTombMap, 7));
+  BOOST_REQUIRE(store.isTimeDependent());
+  BOOST_REQUIRE_EQUAL(store.getNumberOfPeriods(), 4u);
+  store.selectTime(0.0);
+  BOOST_REQUIRE_EQUAL(store.getParameters().at(22).at(0), 1.0);
+  BOOST_REQUIRE_EQUAL(store.getParameters().at(23).at(0), 2.0);
+  store.selectTime(1000.0);
+  BOOST_REQUIRE_EQUAL(store.getParameters().at(22).at(0), 3.0);
+  BOOST_REQUIRE_EQUAL(store.getParameters().at(23).at(0), 2.0);
+  store.selectTime(1999.0);
+  BOOST_REQUIRE_EQUAL(store.getParameters().at(22).at(0), 3.0);
+  BOOST_REQUIRE_EQUAL(store.getParameters().at(23).at(0), 5.0);
+  store.selectTime(2000.0);
+  BOOST_REQUIRE_EQUAL(store.getParameters().at(22).at(0), 1.0);
+  BOOST_REQUIRE_EQUAL(store.getParameters().at(23).at(0), 5.0);
+  store.selectTime(-1.0);
+  BOOST_REQUIRE_EQUAL(store.getParameters().at(23).at(0), 2.0);
+
+  // Intervals of run 8 only
+  BOOST_REQUIRE(store.load(fileName, kTombMap, 9));
+  BOOST_REQUIRE_EQUAL(store.getNumberOfPeriods(), 2u);
+  store.selectTime(1000.0);
+  BOOST_REQUIRE_EQUAL(store.getParameters().at(22).at(0), 1.0);
+
+  file.open(fileName);
+  file << "1 1 A 1 1.0 0 0 0 0 0 0 0\n" << "#@ run 7 x\n";
+  file.close();
+  BOOST_REQUIRE(!store.load(fileName, kTombMap, 7));
+  BOOST_REQUIRE(store.empty());
+
+  file.open(fileName);
+  file << "1 1 A 1 1.0 0 0 0 0 0 0 0\n";
+  file.close();
+  BOOST_REQUIRE(store.load(fileName, kTombMap, 7));
+  BOOST_REQUIRE(!store.isTimeDependent());
+  BOOST_REQUIRE_EQUAL(store.getParameters().at(22).at(0), 1.0);
+  std::remove(fileName.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
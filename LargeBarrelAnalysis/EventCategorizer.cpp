@@ -17,6 +17,7 @@
 #include <JPetWriter/JPetWriter.h>
 #include "EventCategorizerTools.h"
 #include "EventCategorizer.h"
+#include "Tracing.h"
 #include <iostream>
 
 using namespace jpet_options_tools;
@@ -72,7 +73,12 @@ bool EventCategorizer::init()
   // Input events type
   fOutputEvents = new JPetTimeWindow("JPetEvent");
   // Initialise hisotgrams
-  if(fSaveControlHistos) initialiseHistograms();
+  fHistoRegistry.configure(fParams.getOptions());
+  if(fSaveControlHistos) {
+    initialiseHistograms();
+    fHistos = EventCategorizerTools::getHistos(getStatistics(), &fHistoRegistry);
+    fAllXYPos = fHistoRegistry.resolve(getStatistics(), "All_XYpos");
+  }
   return true;
 }
 
@@ -80,36 +86,13 @@ bool EventCategorizer::exec()
 {
   if (auto timeWindow = dynamic_cast<const JPetTimeWindow* const>(fEvent)) {
     vector<JPetEvent> events;
+    fHistoRegistry.beginWindow();
     for (uint i = 0; i < timeWindow->getNumberOfEvents(); i++) {
       const auto& event = dynamic_cast<const JPetEvent&>(timeWindow->operator[](i));
-
-      // Check types of current event
-      bool is2Gamma = EventCategorizerTools::checkFor2Gamma(
-        event, getStatistics(), fSaveControlHistos, fB2BSlotThetaDiff
-      );
-      bool is3Gamma = EventCategorizerTools::checkFor3Gamma(
-        event, getStatistics(), fSaveControlHistos
-      );
-      bool isPrompt = EventCategorizerTools::checkForPrompt(
-        event, getStatistics(), fSaveControlHistos, fDeexTOTCutMin, fDeexTOTCutMax
-      );
-      bool isScattered = EventCategorizerTools::checkForScatter(
-        event, getStatistics(), fSaveControlHistos, fScatterTOFTimeDiff
-      );
-
-      JPetEvent newEvent = event;
-      if(is2Gamma) newEvent.addEventType(JPetEventType::k2Gamma);
-      if(is3Gamma) newEvent.addEventType(JPetEventType::k3Gamma);
-      if(isPrompt) newEvent.addEventType(JPetEventType::kPrompt);
-      if(isScattered) newEvent.addEventType(JPetEventType::kScattered);
-
-      if(fSaveControlHistos){
-        for(auto hit : event.getHits()){
-          getStatistics().getHisto2D("All_XYpos")->Fill(hit.getPosX(), hit.getPosY());
-        }
-      }
+      JPetEvent newEvent = categorizeEvent(event);
       events.push_back(newEvent);
     }
+    fHistoRegistry.endWindow();
     saveEvents(events);
   } else { return false; }
   return true;
@@ -117,12 +100,48 @@ bool EventCategorizer::exec()
 
 bool EventCategorizer::terminate()
 {
+  fHistoRegistry.merge();
   INFO("Event categorization completed.");
   return true;
 }
 
+/**
+* Adding types to the event, based on the checks from the tools class
+*/
+JPetEvent EventCategorizer::categorizeEvent(const JPetEvent& event)
+{
+  // Control histograms are filled only for the sampled windows
+  bool saveHistos = fSaveControlHistos && fHistoRegistry.isWindowSampled();
+  auto histos = saveHistos ? fHistos : EventCategorizerHistos();
+  // Check types of current event
+  bool is2Gamma = EventCategorizerTools::checkFor2Gamma(
+    event, histos, fB2BSlotThetaDiff
+  );
+  bool is3Gamma = EventCategorizerTools::checkFor3Gamma(event, histos);
+  bool isPrompt = EventCategorizerTools::checkForPrompt(
+    event, histos, fDeexTOTCutMin, fDeexTOTCutMax
+  );
+  bool isScattered = EventCategorizerTools::checkForScatter(
+    event, histos, fScatterTOFTimeDiff
+  );
+
+  JPetEvent newEvent = event;
+  if(is2Gamma) newEvent.addEventType(JPetEventType::k2Gamma);
+  if(is3Gamma) newEvent.addEventType(JPetEventType::k3Gamma);
+  if(isPrompt) newEvent.addEventType(JPetEventType::kPrompt);
+  if(isScattered) newEvent.addEventType(JPetEventType::kScattered);
+
+  if(saveHistos){
+    for(auto hit : event.getHits()){
+      fAllXYPos.fill(hit.getPosX(), hit.getPosY());
+    }
+  }
+  return newEvent;
+}
+
 void EventCategorizer::saveEvents(const vector<JPetEvent>& events)
 {
+  TraceSpan span("EventCategorizer::saveEvents", "output");
   for (const auto& event : events) { fOutputEvents->add<JPetEvent>(event); }
 }
 
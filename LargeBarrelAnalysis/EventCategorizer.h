@@ -18,6 +18,7 @@
 
 #include <JPetUserTask/JPetUserTask.h>
 #include "EventCategorizerTools.h"
+#include "HistogramHandles.h"
 #include <JPetEvent/JPetEvent.h>
 #include <JPetHit/JPetHit.h>
 #include <vector>
@@ -52,11 +53,15 @@ protected:
 	const std::string kDeexTOTCutMaxParamKey = "Deex_Categorizer_TOT_Cut_Max_float";
 	const std::string kSaveControlHistosParamKey = "Save_Control_Histograms_bool";
 	void saveEvents(const std::vector<JPetEvent>& event);
+	JPetEvent categorizeEvent(const JPetEvent& event);
 	double fScatterTOFTimeDiff = 2000.0;
 	double fB2BSlotThetaDiff = 3.0;
 	double fDeexTOTCutMin = 30000.0;
 	double fDeexTOTCutMax = 50000.0;
 	bool fSaveControlHistos = true;
+	HistoRegistry fHistoRegistry;
+	EventCategorizerHistos fHistos;
+	HistoHandle fAllXYPos;
 	void initialiseHistograms();
 };
 #endif /* !EVENTCATEGORIZER_H */
@@ -0,0 +1,388 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file EventCategorizerMultiStream.cpp
+ */
+
+#include <JPetOptionsTools/JPetOptionsTools.h>
+#include "EventCategorizerMultiStream.h"
+#include <JPetWriter/JPetWriter.h>
+#include "EventCategorizerTools.h"
+#include "Tracing.h"
+#include <TH2F.h>
+#include <sstream>
+
+using namespace jpet_options_tools;
+using namespace std;
+
+EventCategorizerMultiStream::EventCategorizerMultiStream(const char* name): EventCategorizer(name)
+{
+  fImaging.extension = "imag.evt";
+  fPhysics.extension = "phys.evt";
+  fCosmic.extension = "cosmic.evt";
+}
+
+EventCategorizerMultiStream::~EventCategorizerMultiStream() {}
+
+bool EventCategorizerMultiStream::init()
+{
+  if (!EventCategorizer::init()) return false;
+  INFO("Multi stream event categorization started.");
+  if (isOptionSet(fParams.getOptions(), kStreamsParamKey)) {
+    fStreams = getOptionAsString(fParams.getOptions(), kStreamsParamKey);
+  } else {
+    WARNING(Form(
+      "No value of the %s parameter provided by the user. Using default value of %s.",
+      kStreamsParamKey.c_str(), fStreams.c_str()
+    ));
+  }
+  fStandardStream = false;
+  istringstream streamsList(fStreams);
+  string streamName;
+  while (getline(streamsList, streamName, ',')) {
+    streamName.erase(0, streamName.find_first_not_of(" \t"));
+    streamName.erase(streamName.find_last_not_of(" \t") + 1);
+    if (streamName == "standard") fStandardStream = true;
+    else if (streamName == "imaging") fImaging.enabled = true;
+    else if (streamName == "physics") fPhysics.enabled = true;
+    else if (streamName == "cosmic") fCosmic.enabled = true;
+    else if (!streamName.empty()) {
+      WARNING(Form("Unknown stream %s in the %s parameter - ignoring it.",
+        streamName.c_str(), kStreamsParamKey.c_str()));
+    }
+  }
+
+  readStreamParameter(kMinAnnihilationParamKey, fMinAnnihilationTOT);
+  readStreamParameter(kMaxAnnihilationParamKey, fMaxAnnihilationTOT);
+  readStreamParameter(kMinDeexcitationParamKey, fMinDeexcitationTOT);
+  readStreamParameter(kMaxDeexcitationParamKey, fMaxDeexcitationTOT);
+  readStreamParameter(kMaxZPosParamKey, fMaxZPos);
+  readStreamParameter(kMaxDistOfDecayPlaneFromCenterParamKey, fMaxDistOfDecayPlaneFromCenter);
+  readStreamParameter(kMaxTimeDiffParamKey, fMaxTimeDiff);
+  readStreamParameter(kBackToBackAngleWindowParamKey, fBackToBackAngleWindow);
+  readStreamParameter(kDecayInto3MinAngleParamKey, fDecayInto3MinAngle);
+  readStreamParameter(kMinCosmicTOTParamKey, fMinCosmicTOT);
+
+  if (!openStream(fImaging) || !openStream(fPhysics) || !openStream(fCosmic)) {
+    return false;
+  }
+  if (fSaveControlHistos) {
+    initialiseStreamHistograms();
+    for (auto stream : {&fImaging, &fPhysics}) {
+      if (stream->enabled) {
+        stream->histos = EventCategorizerTools::getStreamHistos(stream->histoStats, &fHistoRegistry);
+      }
+    }
+    if (fPhysics.enabled) {
+      fAllHitTOT = fHistoRegistry.resolve(getStatistics(), "AllHitTOT");
+      fAnnihHitsNumber = fHistoRegistry.resolve(getStatistics(), "AnnihHitsNumber");
+      fDeexHitsNumber = fHistoRegistry.resolve(getStatistics(), "DeexHitsNumber");
+      fDeexAnnihTimeDiff = fHistoRegistry.resolve(getStatistics(), "DeexAnnihTimeDiff");
+    }
+    if (fCosmic.enabled) {
+      fCosmicTOT = fHistoRegistry.resolve(getStatistics(), "Cosmic_TOT");
+      fCosmicHitsPerEvent = fHistoRegistry.resolve(getStatistics(), "CosmicHitsPerEvent");
+    }
+  }
+  return true;
+}
+
+bool EventCategorizerMultiStream::exec()
+{
+  if (auto timeWindow = dynamic_cast<const JPetTimeWindow* const>(fEvent)) {
+    vector<JPetEvent> events;
+    fHistoRegistry.beginWindow();
+    for (uint i = 0; i < timeWindow->getNumberOfEvents(); i++) {
+      const auto& event = dynamic_cast<const JPetEvent&>(timeWindow->operator[](i));
+      if (fStandardStream) events.push_back(categorizeEvent(event));
+      processEvent(event);
+    }
+    fHistoRegistry.endWindow();
+    saveEvents(events);
+    // Additional streams are saved window by window, same as the main output
+    for (auto stream : {&fImaging, &fPhysics, &fCosmic}) {
+      if (stream->enabled) {
+        TraceSpan span("EventCategorizerMultiStream::write", "io");
+        stream->writer->write(*(stream->events));
+        stream->events->Clear();
+      }
+    }
+  } else { return false; }
+  return true;
+}
+
+bool EventCategorizerMultiStream::terminate()
+{
+  closeStream(fImaging);
+  closeStream(fPhysics);
+  closeStream(fCosmic);
+  fHistoRegistry.merge();
+  // Histograms of the streaming are moved to the statistics of the task
+  for (auto stream : {&fImaging, &fPhysics}) {
+    for (const auto& histoName : stream->histoNames) {
+      auto histo = stream->histoStats.getObject<TH1>(histoName.c_str());
+      getStatistics().createHistogram(histo->Clone((stream->histoPrefix + histoName).c_str()));
+    }
+  }
+  INFO("Multi stream event categorization completed.");
+  return EventCategorizer::terminate();
+}
+
+/**
+* Selection of hits and events for all enabled additional streams.
+* TOT of each hit is calculated once and used by all the selections.
+*/
+void EventCategorizerMultiStream::processEvent(const JPetEvent& event)
+{
+  if (!fImaging.enabled && !fPhysics.enabled && !fCosmic.enabled) return;
+  const auto& hits = event.getHits();
+  vector<double> hitTOTs(hits.size());
+  for (unsigned i = 0; i < hits.size(); i++) {
+    hitTOTs[i] = EventCategorizerTools::calculateTOT(hits[i]);
+  }
+
+  JPetEvent physicEvent;
+  JPetEvent annihilationHits;
+  JPetEvent deexcitationHits;
+  JPetEvent cosmicEvent;
+  for (unsigned i = 0; i < hits.size(); i++) {
+    double TOTofHit = hitTOTs[i];
+    if (fCosmic.enabled && TOTofHit >= fMinCosmicTOT) {
+      cosmicEvent.addHit(hits[i]);
+      fCosmicTOT.fill(TOTofHit / 1000.);
+    }
+    if (fabs(hits[i].getPosZ()) >= fMaxZPos) continue;
+    bool isAnnihilation = TOTofHit >= fMinAnnihilationTOT && TOTofHit <= fMaxAnnihilationTOT;
+    if (isAnnihilation) annihilationHits.addHit(hits[i]);
+    if (fPhysics.enabled) {
+      fAllHitTOT.fill(TOTofHit / 1000.);
+      if (isAnnihilation) physicEvent.addHit(hits[i]);
+      if (TOTofHit >= fMinDeexcitationTOT && TOTofHit <= fMaxDeexcitationTOT) {
+        physicEvent.addHit(hits[i]);
+        deexcitationHits.addHit(hits[i]);
+      }
+    }
+  }
+
+  // Imaging stream, as its standalone task, takes only events with more than one hit
+  bool imagingSelected = fImaging.enabled && hits.size() > 1;
+  if (imagingSelected || fPhysics.enabled) {
+    // Result of the streaming is the same for both streams, it is repeated only to fill histograms of each one
+    bool is2Gamma = false, is3Gamma = false, streamed = false;
+    for (auto stream : {&fPhysics, &fImaging}) {
+      if (!stream->enabled || (stream == &fImaging && !imagingSelected)) continue;
+      bool fillHistos = stream->histos.enabled && fHistoRegistry.isWindowSampled();
+      if (streamed && !fillHistos) continue;
+      auto streamHistos = fillHistos ? stream->histos : EventStreamHistos();
+      is2Gamma = EventCategorizerTools::stream2Gamma(
+        annihilationHits, streamHistos, fBackToBackAngleWindow, fMaxTimeDiff
+      );
+      is3Gamma = EventCategorizerTools::stream3Gamma(
+        annihilationHits, streamHistos,
+        fDecayInto3MinAngle, fMaxTimeDiff, fMaxDistOfDecayPlaneFromCenter
+      );
+      streamed = true;
+    }
+    if (imagingSelected && annihilationHits.getHits().size()) {
+      JPetEvent imagingEvent = annihilationHits;
+      if (is2Gamma) imagingEvent.addEventType(JPetEventType::k2Gamma);
+      if (is3Gamma) imagingEvent.addEventType(JPetEventType::k3Gamma);
+      fImaging.events->add<JPetEvent>(imagingEvent);
+    }
+    if (fPhysics.enabled) {
+      fAnnihHitsNumber.fill(annihilationHits.getHits().size());
+      fDeexHitsNumber.fill(deexcitationHits.getHits().size());
+      vector<JPetEventType> types;
+      if (deexcitationHits.getHits().size() > 0) {
+        types.push_back(JPetEventType::kPrompt);
+        if (fSaveControlHistos && annihilationHits.getHits().size() > 0) {
+          fDeexAnnihTimeDiff.fill(
+            annihilationHits.getHits().at(0).getTime() - deexcitationHits.getHits().at(0).getTime()
+          );
+        }
+      }
+      if (is2Gamma) types.push_back(JPetEventType::k2Gamma);
+      if (is3Gamma) types.push_back(JPetEventType::k3Gamma);
+      for (auto type : types) {
+        if (physicEvent.isOnlyTypeOf(JPetEventType::kUnknown)) {
+          physicEvent.setEventType(type);
+        } else {
+          physicEvent.addEventType(type);
+        }
+      }
+      if (physicEvent.getHits().size()) fPhysics.events->add<JPetEvent>(physicEvent);
+    }
+  }
+
+  if (fCosmic.enabled) {
+    fCosmicHitsPerEvent.fill(cosmicEvent.getHits().size());
+    if (cosmicEvent.getHits().size()) fCosmic.events->add<JPetEvent>(cosmicEvent);
+  }
+}
+
+void EventCategorizerMultiStream::readStreamParameter(const string& key, double& value)
+{
+  if (isOptionSet(fParams.getOptions(), key)) {
+    value = getOptionAsFloat(fParams.getOptions(), key);
+  } else {
+    WARNING(Form(
+      "No value of the %s parameter provided by the user. Using default value of %lf.",
+      key.c_str(), value
+    ));
+  }
+}
+
+/**
+* Opening the file of the additional stream. Name of the file is created
+* from the name of the task output file, with the extension of the stream.
+*/
+bool EventCategorizerMultiStream::openStream(CategoryStream& stream)
+{
+  if (!stream.enabled) return true;
+  string fileName = getOutputFile(fParams.getOptions());
+  auto position = fileName.rfind(kStandardExtension);
+  if (position == string::npos) {
+    // Extension of the task output is replaced with the one of the stream
+    fileName = fileName.substr(0, fileName.rfind(".root"));
+    fileName = fileName.substr(0, fileName.rfind(".") + 1);
+  } else {
+    fileName = fileName.substr(0, position);
+  }
+  fileName += stream.extension + ".root";
+  stream.writer = new JPetWriter(fileName.c_str());
+  if (!stream.writer->isOpen()) {
+    ERROR(Form("Unable to open file %s for the %s stream.", fileName.c_str(), stream.extension.c_str()));
+    return false;
+  }
+  stream.events = new JPetTimeWindow("JPetEvent");
+  INFO(Form("Events of the %s stream will be saved in %s", stream.extension.c_str(), fileName.c_str()));
+  return true;
+}
+
+void EventCategorizerMultiStream::closeStream(CategoryStream& stream)
+{
+  if (stream.writer) {
+    stream.writer->writeObject(&getParamBank(), "ParamBank");
+    stream.writer->closeFile();
+    delete stream.writer;
+    stream.writer = nullptr;
+  }
+  if (stream.events) {
+    delete stream.events;
+    stream.events = nullptr;
+  }
+}
+
+void EventCategorizerMultiStream::initialiseStreamingHistograms(
+  CategoryStream& stream, double max2GammaTimeDiff, int nPlaneDistBins, double maxPlaneDist)
+{
+  createStreamHisto(stream,
+    new TH1F("2Gamma_TimeDiff", "2 Gamma Hits Time Difference", 200, 0.0, max2GammaTimeDiff),
+    "Hits time difference [ns]", "Counts");
+  createStreamHisto(stream,
+    new TH1F("2Gamma_ThetaDiff", "2 Gamma Hits angles", 180, -0.5, 179.5),
+    "Hits theta diff [deg]", "Counts");
+  createStreamHisto(stream,
+    new TH1F("2Gamma_DLOR", "Delta LOR distance", 100, 0.0, 50.0),
+    "Delta LOR [cm]", "Counts");
+  createStreamHisto(stream,
+    new TH1F("2Annih_TimeDiff", "2 gamma annihilation Hits Time Difference", 200, 0.0, fMaxTimeDiff/1000.0),
+    "Time difference between 2 annihilation hits [ns]", "Counts");
+  createStreamHisto(stream,
+    new TH1F("2Annih_ThetaDiff", "Annihilation Hits Theta Diff",
+      (int) 4*fBackToBackAngleWindow, 180.-fBackToBackAngleWindow, 180.+fBackToBackAngleWindow),
+    "Annihilation hits theta diff [deg]", "Counts");
+  createStreamHisto(stream,
+    new TH1F("2Annih_DLOR", "Delta LOR distance", 100, 0.0, 50.0),
+    "Annihilation hits Delta LOR [cm]", "Counts");
+  createStreamHisto(stream,
+    new TH2F("2Annih_XY", "Reconstructed XY position of annihilation point", 220, -54.5, 54.5, 220, -54.5, 54.5),
+    "Annihilation point X [cm]", "Annihilation point Y [cm]");
+  createStreamHisto(stream,
+    new TH1F("2Annih_Z", "Reconstructed Z position of annihilation point", 220, -54.5, 54.5),
+    "Annihilation point Z [cm]", "Counts");
+  createStreamHisto(stream,
+    new TH2F("3GammaThetas", "3 Gamma Thetas plot", 251, -0.5, 250.5, 201, -0.5, 200.5),
+    "Transformed thetas 1-2 [deg]", "Transformed thetas 2-3 [deg]");
+  createStreamHisto(stream,
+    new TH1F("3GammaPlaneDist", "3 Gamma Plane Distance to Center", nPlaneDistBins, 0.0, maxPlaneDist),
+    "Distance [cm]", "Counts");
+  createStreamHisto(stream,
+    new TH1F("3GammaTimeDiff", "3 gamma last and first hit time difference", 200, 0.0, 20.0),
+    "Time difference [ns]", "Counts");
+  createStreamHisto(stream,
+    new TH1F("3AnnihPlaneDist", "3 Gamma Annihilation Plane Distance to Center",
+      100, 0.0, fMaxDistOfDecayPlaneFromCenter),
+    "Distance [cm]", "Counts");
+  createStreamHisto(stream,
+    new TH1F("3AnnihTimeDiff", "3 gamma Annihilation last and first hit time difference",
+      200, 0.0, fMaxTimeDiff/1000.0),
+    "Time difference [ns]", "Counts");
+}
+
+void EventCategorizerMultiStream::createStreamHisto(
+  CategoryStream& stream, TH1* histo, const char* xTitle, const char* yTitle)
+{
+  stream.histoStats.createHistogram(histo);
+  stream.histoNames.push_back(histo->GetName());
+  histo->SetXTitle(xTitle);
+  histo->SetYTitle(yTitle);
+}
+
+void EventCategorizerMultiStream::initialiseStreamHistograms()
+{
+  // Histograms of 2 and 3 gamma streaming, with the binning of the standalone imaging and physics tasks
+  if (fImaging.enabled) {
+    fImaging.histoPrefix = "Imaging_";
+    initialiseStreamingHistograms(fImaging, 10.0, 100, 10.0);
+  }
+  if (fPhysics.enabled) {
+    fPhysics.histoPrefix = "Physics_";
+    initialiseStreamingHistograms(fPhysics, 100.0, 200, 50.0);
+  }
+
+  // Histograms of physics stream
+  if (fPhysics.enabled) {
+    getStatistics().createHistogram(
+      new TH1F("AllHitTOT", "TOT of all Hits in physics stream", 200, 0.0, 100.0));
+    getStatistics().getHisto1D("AllHitTOT")->SetXTitle("TOT [ns]");
+    getStatistics().getHisto1D("AllHitTOT")->SetYTitle("Number of hits");
+
+    getStatistics().createHistogram(
+      new TH1F("AnnihHitsNumber", "Number of Annihilation Hits in Event", 50, -0.5, 49.5));
+    getStatistics().getHisto1D("AnnihHitsNumber")->SetXTitle("Number of Annihilation Hits in a Event");
+    getStatistics().getHisto1D("AnnihHitsNumber")->SetYTitle("Counts");
+
+    getStatistics().createHistogram(
+      new TH1F("DeexHitsNumber", "Number of Deexcitation Hits in Event", 50, -0.5, 49.5));
+    getStatistics().getHisto1D("DeexHitsNumber")->SetXTitle("Number of Deexcitation Hits in Event");
+    getStatistics().getHisto1D("DeexHitsNumber")->SetYTitle("Counts");
+
+    getStatistics().createHistogram(
+      new TH1F("DeexAnnihTimeDiff", "Deexcitation-Annihilation Hits Time Difference", 200, -200.0, 200.0));
+    getStatistics().getHisto1D("DeexAnnihTimeDiff")->SetXTitle("Time difference between deexcitation and annihilation hits [ns]");
+    getStatistics().getHisto1D("DeexAnnihTimeDiff")->SetYTitle("Counts");
+  }
+
+  // Histograms of cosmic stream
+  if (fCosmic.enabled) {
+    getStatistics().createHistogram(
+      new TH1F("Cosmic_TOT", "TOT of Cosmic Hits", 200, fMinCosmicTOT/1000.0, 100.0));
+    getStatistics().getHisto1D("Cosmic_TOT")->SetXTitle("TOT [ns]");
+    getStatistics().getHisto1D("Cosmic_TOT")->SetYTitle("Counts");
+
+    getStatistics().createHistogram(
+      new TH1F("CosmicHitsPerEvent", "Number of Cosmic Hits in Event", 50, -0.5, 49.5));
+    getStatistics().getHisto1D("CosmicHitsPerEvent")->SetXTitle("Number of Cosmic Hits in Event");
+    getStatistics().getHisto1D("CosmicHitsPerEvent")->SetYTitle("Counts");
+  }
+}
@@ -0,0 +1,113 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file EventCategorizerMultiStream.h
+ */
+
+#ifndef EVENTCATEGORIZERMULTISTREAM_H
+#define EVENTCATEGORIZERMULTISTREAM_H
+
+#include <JPetStatistics/JPetStatistics.h>
+#include "EventCategorizer.h"
+#include <TH1.h>
+#include <string>
+#include <vector>
+
+class JPetWriter;
+
+#ifdef __CINT__
+#	define override
+#endif
+
+/**
+ * @brief User Task categorizing Events into several output streams in one pass
+ *
+ * Task reads each event once and runs any configured subset of the standard,
+ * imaging, physics and cosmic selections, that otherwise are done by separate
+ * executables. TOT of every hit is calculated only once per event and shared
+ * between the selections. Since imaging and physics streams use the same
+ * annihilation hits selection, 2 and 3 gamma streaming is also done once,
+ * and repeated only to fill the control histograms of the other stream.
+ * These keep the binning of the standalone tasks, with Imaging_ and Physics_
+ * prefixes in the statistics of the task.
+ * Standard stream is saved as the output of the task (cat.evt), other streams
+ * are saved next to it, in the files with imag.evt, phys.evt and cosmic.evt
+ * extensions. Selection of streams is given with the user parameter
+ * EventCategorizerMultiStream_Streams_std::string, as a comma separated list.
+ */
+class EventCategorizerMultiStream : public EventCategorizer{
+public:
+	EventCategorizerMultiStream(const char * name);
+	virtual ~EventCategorizerMultiStream();
+	virtual bool init() override;
+	virtual bool exec() override;
+	virtual bool terminate() override;
+
+protected:
+	/**
+	 * @brief Output of one of the additional streams, saved to a separate file
+	 */
+	struct CategoryStream {
+		bool enabled = false;
+		std::string extension;
+		JPetWriter* writer = nullptr;
+		JPetTimeWindow* events = nullptr;
+		/// Histograms of 2 and 3 gamma streaming of the imaging and physics streams
+		std::string histoPrefix;
+		JPetStatistics histoStats;
+		std::vector<std::string> histoNames;
+		EventStreamHistos histos;
+	};
+	const std::string kStreamsParamKey = "EventCategorizerMultiStream_Streams_std::string";
+	const std::string kMaxDistOfDecayPlaneFromCenterParamKey = "EventCategorizer_MaxDistOfDecayPlaneFromCenter_float";
+	const std::string kBackToBackAngleWindowParamKey = "EventCategorizer_BackToBackAngleWindow_float";
+	const std::string kDecayInto3MinAngleParamKey = "EventCategorizer_DecayInto3MinAngle_float";
+	const std::string kMinAnnihilationParamKey = "EventCategorizer_MinAnnihilationTOT_float";
+	const std::string kMaxAnnihilationParamKey = "EventCategorizer_MaxAnnihilationTOT_float";
+	const std::string kMinDeexcitationParamKey = "EventCategorizer_MinDeexcitationTOT_float";
+	const std::string kMaxDeexcitationParamKey = "EventCategorizer_MaxDeexcitationTOT_float";
+	const std::string kMaxTimeDiffParamKey = "EventCategorizer_MaxTimeDiff_float";
+	const std::string kMaxZPosParamKey = "EventCategorizer_MaxHitZPos_float";
+	const std::string kMinCosmicTOTParamKey = "EventCategorizer_MinCosmicTOT_float";
+	const std::string kStandardExtension = "cat.evt";
+	std::string fStreams = "standard";
+	bool fStandardStream = true;
+	CategoryStream fImaging;
+	CategoryStream fPhysics;
+	CategoryStream fCosmic;
+	HistoHandle fAllHitTOT;
+	HistoHandle fAnnihHitsNumber;
+	HistoHandle fDeexHitsNumber;
+	HistoHandle fDeexAnnihTimeDiff;
+	HistoHandle fCosmicTOT;
+	HistoHandle fCosmicHitsPerEvent;
+	double fMaxDistOfDecayPlaneFromCenter = 5.;
+	double fMinAnnihilationTOT = 10000.0;
+	double fMaxAnnihilationTOT = 25000.0;
+	double fMinDeexcitationTOT = 30000.0;
+	double fMaxDeexcitationTOT = 50000.0;
+	double fBackToBackAngleWindow = 3.;
+	double fDecayInto3MinAngle = 190.;
+	double fMaxTimeDiff = 1000.;
+	double fMaxZPos = 23.;
+	double fMinCosmicTOT = 55000.0;
+	void readStreamParameter(const std::string& key, double& value);
+	bool openStream(CategoryStream& stream);
+	void closeStream(CategoryStream& stream);
+	void processEvent(const JPetEvent& event);
+	void initialiseStreamHistograms();
+	void initialiseStreamingHistograms(CategoryStream& stream, double max2GammaTimeDiff,
+		int nPlaneDistBins, double maxPlaneDist);
+	void createStreamHisto(CategoryStream& stream, TH1* histo, const char* xTitle, const char* yTitle);
+};
+
+#endif /* !EVENTCATEGORIZERMULTISTREAM_H */
@@ -0,0 +1,281 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file EventCategorizerSweep.cpp
+ */
+
+#include <JPetOptionsTools/JPetOptionsTools.h>
+#include <JPetWriter/JPetWriter.h>
+#include "EventCategorizerSweep.h"
+#include "EventCategorizerTools.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <limits>
+#include <TH2F.h>
+
+using namespace jpet_options_tools;
+using namespace std;
+
+EventCategorizerSweep::EventCategorizerSweep(const char* name): JPetUserTask(name) {}
+
+EventCategorizerSweep::~EventCategorizerSweep() {}
+
+bool EventCategorizerSweep::init()
+{
+  INFO("Event categorization parameter sweep started.");
+  if (isOptionSet(fParams.getOptions(), kOutputFileParamKey)) {
+    fOutputFile = getOptionAsString(fParams.getOptions(), kOutputFileParamKey);
+  }
+  if (isOptionSet(fParams.getOptions(), kMinAnnihilationParamKey)) {
+    fMinAnnihilationTOT = getOptionAsFloat(fParams.getOptions(), kMinAnnihilationParamKey);
+  }
+  if (isOptionSet(fParams.getOptions(), kMaxAnnihilationParamKey)) {
+    fMaxAnnihilationTOT = getOptionAsFloat(fParams.getOptions(), kMaxAnnihilationParamKey);
+  }
+  if (isOptionSet(fParams.getOptions(), kMaxZPosParamKey)) {
+    fMaxZPos = getOptionAsFloat(fParams.getOptions(), kMaxZPosParamKey);
+  }
+  if (isOptionSet(fParams.getOptions(), kSaveControlHistosParamKey)) {
+    fSaveControlHistos = getOptionAsBool(fParams.getOptions(), kSaveControlHistosParamKey);
+  }
+  if (!readGrid()) return false;
+  fCounts.assign(fGrid.size(), vector<unsigned long>(kNumberOfSweepCategories, 0));
+  INFO(Form("Number of parameter sets in the sweep: %lu", fGrid.size()));
+  // No events are saved by this task
+  fOutputEvents = new JPetTimeWindow("JPetEvent");
+  return true;
+}
+
+bool EventCategorizerSweep::exec()
+{
+  if (auto timeWindow = dynamic_cast<const JPetTimeWindow* const>(fEvent)) {
+    for (uint i = 0; i < timeWindow->getNumberOfEvents(); i++) {
+      const auto& event = dynamic_cast<const JPetEvent&>(timeWindow->operator[](i));
+      countCategories(calculateFeatures(event));
+      fNumberOfEvents++;
+    }
+  } else { return false; }
+  return true;
+}
+
+bool EventCategorizerSweep::terminate()
+{
+  saveTable();
+  if (fSaveControlHistos) saveHistogram();
+  INFO("Event categorization parameter sweep completed.");
+  return true;
+}
+
+/**
+* Reading lists of values of the swept parameters and creating the grid as their
+* cartesian product. Parameters without the list have one, default value.
+*/
+bool EventCategorizerSweep::readGrid()
+{
+  vector<vector<double>> values(kNumberOfSweepParameters);
+  for (int par = 0; par < kNumberOfSweepParameters; par++) {
+    if (!isOptionSet(fParams.getOptions(), kSweepParamKeys.at(par))) {
+      values[par].push_back(kSweepDefaults.at(par));
+      continue;
+    }
+    istringstream valuesList(getOptionAsString(fParams.getOptions(), kSweepParamKeys.at(par)));
+    string value;
+    while (getline(valuesList, value, ',')) {
+      istringstream valueStream(value);
+      double number = 0.0;
+      if (!(valueStream >> number)) {
+        ERROR(Form("Wrong value '%s' in the %s parameter", value.c_str(), kSweepParamKeys.at(par).c_str()));
+        return false;
+      }
+      values[par].push_back(number);
+    }
+    if (values[par].empty()) {
+      ERROR(Form("No values given in the %s parameter", kSweepParamKeys.at(par).c_str()));
+      return false;
+    }
+  }
+  fGrid.clear();
+  vector<unsigned> index(kNumberOfSweepParameters, 0);
+  while (true) {
+    vector<double> point(kNumberOfSweepParameters);
+    for (int par = 0; par < kNumberOfSweepParameters; par++) {
+      point[par] = values[par][index[par]];
+    }
+    fGrid.push_back(point);
+    int par = kNumberOfSweepParameters - 1;
+    while (par >= 0 && ++index[par] == values[par].size()) {
+      index[par] = 0;
+      par--;
+    }
+    if (par < 0) break;
+  }
+  return true;
+}
+
+/**
+* Calculation of all parameter independent quantities, that are used by
+* the categorization checks. Definitions follow EventCategorizerTools methods.
+*/
+EventCategorizerSweep::EventFeatures EventCategorizerSweep::calculateFeatures(const JPetEvent& event) const
+{
+  EventFeatures features;
+  const auto& hits = event.getHits();
+  features.numberOfHits = hits.size();
+  features.minSlotThetaDeviation = numeric_limits<double>::max();
+  features.minScatterDeviation = numeric_limits<double>::max();
+
+  vector<unsigned> annihilationHits;
+  for (unsigned i = 0; i < hits.size(); i++) {
+    double tot = EventCategorizerTools::calculateTOT(hits[i]);
+    features.hitTOTs.push_back(tot);
+    if (tot >= fMinAnnihilationTOT && tot <= fMaxAnnihilationTOT && fabs(hits[i].getPosZ()) < fMaxZPos) {
+      annihilationHits.push_back(i);
+    }
+  }
+
+  // Back to back and scatter checks on all pairs of hits
+  for (unsigned i = 0; i < hits.size(); i++) {
+    for (unsigned j = i + 1; j < hits.size(); j++) {
+      const JPetHit& firstHit = hits[i].getTime() < hits[j].getTime() ? hits[i] : hits[j];
+      const JPetHit& secondHit = hits[i].getTime() < hits[j].getTime() ? hits[j] : hits[i];
+      double thetaDiff = fabs(firstHit.getBarrelSlot().getTheta() - secondHit.getBarrelSlot().getTheta());
+      features.minSlotThetaDeviation = min(features.minSlotThetaDeviation, fabs(thetaDiff - 180.0));
+      double scattTOF = EventCategorizerTools::calculateScatteringTime(firstHit, secondHit);
+      double timeDiff = secondHit.getTime() - firstHit.getTime();
+      features.minScatterDeviation = min(features.minScatterDeviation, fabs(scattTOF - timeDiff));
+    }
+  }
+
+  // Streaming checks on pairs and triplets of annihilation hits
+  for (unsigned i = 0; i < annihilationHits.size(); i++) {
+    const JPetHit& firstHit = hits[annihilationHits[i]];
+    for (unsigned j = i + 1; j < annihilationHits.size(); j++) {
+      const JPetHit& secondHit = hits[annihilationHits[j]];
+      double theta1 = min(firstHit.getBarrelSlot().getTheta(), secondHit.getBarrelSlot().getTheta());
+      double theta2 = max(firstHit.getBarrelSlot().getTheta(), secondHit.getBarrelSlot().getTheta());
+      PairFeatures pair;
+      pair.thetaDeviation = fabs(min(theta2 - theta1, 360.0 - theta2 + theta1) - 180.0);
+      pair.timeDiff = fabs(firstHit.getTime() - secondHit.getTime());
+      features.annihilationPairs.push_back(pair);
+      for (unsigned k = j + 1; k < annihilationHits.size(); k++) {
+        const JPetHit& thirdHit = hits[annihilationHits[k]];
+        vector<double> thetaAngles = {
+          firstHit.getBarrelSlot().getTheta(),
+          secondHit.getBarrelSlot().getTheta(),
+          thirdHit.getBarrelSlot().getTheta()
+        };
+        sort(thetaAngles.begin(), thetaAngles.end());
+        vector<double> relativeAngles = {
+          thetaAngles.at(1) - thetaAngles.at(0),
+          thetaAngles.at(2) - thetaAngles.at(1),
+          360.0 - thetaAngles.at(2) + thetaAngles.at(0)
+        };
+        sort(relativeAngles.begin(), relativeAngles.end());
+        TripletFeatures triplet;
+        triplet.transformedAngle = relativeAngles.at(1) + relativeAngles.at(0);
+        triplet.timeDiff = fabs(thirdHit.getTime() - firstHit.getTime());
+        triplet.planeCenterDist = EventCategorizerTools::calculatePlaneCenterDistance(
+          firstHit, secondHit, thirdHit
+        );
+        features.annihilationTriplets.push_back(triplet);
+      }
+    }
+  }
+  return features;
+}
+
+/**
+* Comparing features of the event with each point of the grid
+*/
+void EventCategorizerSweep::countCategories(const EventFeatures& features)
+{
+  for (unsigned point = 0; point < fGrid.size(); point++) {
+    const auto& par = fGrid[point];
+    auto& counts = fCounts[point];
+    if (features.numberOfHits >= 2 && features.minSlotThetaDeviation < par[kB2BSlotThetaDiff]) {
+      counts[k2Gamma]++;
+    }
+    if (features.numberOfHits >= 3) counts[k3Gamma]++;
+    for (auto tot : features.hitTOTs) {
+      if (tot > par[kDeexTOTCutMin] && tot < par[kDeexTOTCutMax]) {
+        counts[kPrompt]++;
+        break;
+      }
+    }
+    if (features.numberOfHits >= 2 && features.minScatterDeviation < par[kScatterTOFTimeDiff]) {
+      counts[kScattered]++;
+    }
+    for (const auto& pair : features.annihilationPairs) {
+      if (pair.thetaDeviation < par[kStream2GammaAngleWindow]
+          && pair.timeDiff < par[kStream2GammaTimeDiff]) {
+        counts[kStream2Gamma]++;
+        break;
+      }
+    }
+    for (const auto& triplet : features.annihilationTriplets) {
+      if (triplet.transformedAngle > par[kStream3GammaMinAngle]
+          && triplet.timeDiff < par[kStream3GammaTimeDiff]
+          && triplet.planeCenterDist < par[kStream3GammaPlaneDist]) {
+        counts[kStream3Gamma]++;
+        break;
+      }
+    }
+  }
+}
+
+/**
+* Table with one line for each point of the grid: parameter values,
+* number of all events and numbers of events in each category
+*/
+void EventCategorizerSweep::saveTable() const
+{
+  ofstream outputFile(fOutputFile);
+  if (!outputFile.is_open()) {
+    ERROR(Form("Unable to open file %s for the sweep results", fOutputFile.c_str()));
+    return;
+  }
+  outputFile << "# set";
+  for (const auto& name : kSweepParamNames) outputFile << "\t" << name;
+  outputFile << "\tEvents";
+  for (const auto& name : kSweepCategoryNames) outputFile << "\t" << name;
+  outputFile << endl;
+  for (unsigned point = 0; point < fGrid.size(); point++) {
+    outputFile << point;
+    for (auto value : fGrid[point]) outputFile << "\t" << value;
+    outputFile << "\t" << fNumberOfEvents;
+    for (auto count : fCounts[point]) outputFile << "\t" << count;
+    outputFile << endl;
+  }
+  outputFile.close();
+  INFO(Form("Results of the parameter sweep saved in %s", fOutputFile.c_str()));
+}
+
+void EventCategorizerSweep::saveHistogram()
+{
+  getStatistics().createHistogram(
+    new TH2F("Sweep_Category_Counts", "Number of events in categories for each parameter set",
+      fGrid.size(), -0.5, fGrid.size() - 0.5,
+      kNumberOfSweepCategories, -0.5, kNumberOfSweepCategories - 0.5));
+  auto histo = getStatistics().getHisto2D("Sweep_Category_Counts");
+  histo->GetXaxis()->SetTitle("Parameter set");
+  histo->GetYaxis()->SetTitle("Category");
+  for (int cat = 0; cat < kNumberOfSweepCategories; cat++) {
+    histo->GetYaxis()->SetBinLabel(cat + 1, kSweepCategoryNames.at(cat).c_str());
+  }
+  for (unsigned point = 0; point < fGrid.size(); point++) {
+    for (int cat = 0; cat < kNumberOfSweepCategories; cat++) {
+      histo->SetBinContent(point + 1, cat + 1, fCounts[point][cat]);
+    }
+  }
+}
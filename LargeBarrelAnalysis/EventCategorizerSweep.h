@@ -0,0 +1,129 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file EventCategorizerSweep.h
+ */
+
+#ifndef EVENTCATEGORIZERSWEEP_H
+#define EVENTCATEGORIZERSWEEP_H
+
+#include <JPetUserTask/JPetUserTask.h>
+#include <JPetEvent/JPetEvent.h>
+#include <JPetHit/JPetHit.h>
+#include <string>
+#include <vector>
+
+class JPetWriter;
+
+#ifdef __CINT__
+#define override
+#endif
+
+/**
+ * @brief User Task evaluating a grid of categorization parameters in one pass
+ *
+ * For each parameter the user can give a comma separated list of values,
+ * the grid is a cartesian product of these lists. Features of hits, pairs
+ * and triplets of hits that the categorization cuts are based on, are calculated
+ * once per event and compared with each point of the grid. No events are saved,
+ * the result is a table with numbers of events in each category for every
+ * point of the grid, and optionally a histogram with the same counts.
+ */
+class EventCategorizerSweep: public JPetUserTask
+{
+public:
+  EventCategorizerSweep(const char * name);
+  virtual ~EventCategorizerSweep();
+  virtual bool init() override;
+  virtual bool exec() override;
+  virtual bool terminate() override;
+
+  enum SweepParameter {
+    kB2BSlotThetaDiff, kScatterTOFTimeDiff, kDeexTOTCutMin, kDeexTOTCutMax,
+    kStream2GammaAngleWindow, kStream2GammaTimeDiff,
+    kStream3GammaMinAngle, kStream3GammaTimeDiff, kStream3GammaPlaneDist,
+    kNumberOfSweepParameters
+  };
+  enum SweepCategory {
+    k2Gamma, k3Gamma, kPrompt, kScattered, kStream2Gamma, kStream3Gamma,
+    kNumberOfSweepCategories
+  };
+
+protected:
+  /**
+   * @brief Features of a pair of hits used by the back-to-back and scatter checks
+   */
+  struct PairFeatures {
+    double thetaDeviation = 0.0;
+    double timeDiff = 0.0;
+  };
+  /**
+   * @brief Features of a triplet of hits used by the 3 gamma streaming check
+   */
+  struct TripletFeatures {
+    double transformedAngle = 0.0;
+    double timeDiff = 0.0;
+    double planeCenterDist = 0.0;
+  };
+  /**
+   * @brief Parameter independent features of one event
+   */
+  struct EventFeatures {
+    unsigned numberOfHits = 0;
+    double minSlotThetaDeviation = 0.0;
+    double minScatterDeviation = 0.0;
+    std::vector<double> hitTOTs;
+    std::vector<PairFeatures> annihilationPairs;
+    std::vector<TripletFeatures> annihilationTriplets;
+  };
+  EventFeatures calculateFeatures(const JPetEvent& event) const;
+  void countCategories(const EventFeatures& features);
+  bool readGrid();
+  void saveTable() const;
+  void saveHistogram();
+  const std::vector<std::string> kSweepParamKeys = {
+    "EventCategorizerSweep_B2BSlotThetaDiff_std::string",
+    "EventCategorizerSweep_ScatterTOFTimeDiff_std::string",
+    "EventCategorizerSweep_DeexTOTCutMin_std::string",
+    "EventCategorizerSweep_DeexTOTCutMax_std::string",
+    "EventCategorizerSweep_Stream2GammaAngleWindow_std::string",
+    "EventCategorizerSweep_Stream2GammaTimeDiff_std::string",
+    "EventCategorizerSweep_Stream3GammaMinAngle_std::string",
+    "EventCategorizerSweep_Stream3GammaTimeDiff_std::string",
+    "EventCategorizerSweep_Stream3GammaPlaneDist_std::string"
+  };
+  const std::vector<std::string> kSweepParamNames = {
+    "B2BSlotThetaDiff", "ScatterTOFTimeDiff", "DeexTOTCutMin", "DeexTOTCutMax",
+    "Stream2GammaAngleWindow", "Stream2GammaTimeDiff",
+    "Stream3GammaMinAngle", "Stream3GammaTimeDiff", "Stream3GammaPlaneDist"
+  };
+  const std::vector<std::string> kSweepCategoryNames = {
+    "2Gamma", "3Gamma", "Prompt", "Scattered", "Stream2Gamma", "Stream3Gamma"
+  };
+  const std::vector<double> kSweepDefaults = {
+    3.0, 2000.0, 30000.0, 50000.0, 3.0, 1000.0, 190.0, 1000.0, 5.0
+  };
+  const std::string kOutputFileParamKey = "EventCategorizerSweep_OutputFile_std::string";
+  const std::string kMinAnnihilationParamKey = "EventCategorizer_MinAnnihilationTOT_float";
+  const std::string kMaxAnnihilationParamKey = "EventCategorizer_MaxAnnihilationTOT_float";
+  const std::string kMaxZPosParamKey = "EventCategorizer_MaxHitZPos_float";
+  const std::string kSaveControlHistosParamKey = "Save_Control_Histograms_bool";
+  std::string fOutputFile = "categorizationSweep.txt";
+  double fMinAnnihilationTOT = 10000.0;
+  double fMaxAnnihilationTOT = 25000.0;
+  double fMaxZPos = 23.;
+  bool fSaveControlHistos = true;
+  unsigned long fNumberOfEvents = 0;
+  std::vector<std::vector<double>> fGrid;
+  std::vector<std::vector<unsigned long>> fCounts;
+};
+#endif /* !EVENTCATEGORIZERSWEEP_H */
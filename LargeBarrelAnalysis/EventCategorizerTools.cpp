@@ -19,12 +19,65 @@
 
 using namespace std;
 
+/**
+* Resolving handles of the categorization histograms. Without the registry,
+* handles fill the histograms directly.
+*/
+EventCategorizerHistos EventCategorizerTools::getHistos(JPetStatistics& stats, HistoRegistry* registry)
+{
+  auto resolve = [&stats, registry] (const string& name) {
+    return registry ? registry->resolve(stats, name) : HistoHandle::direct(stats, name);
+  };
+  EventCategorizerHistos histos;
+  histos.enabled = true;
+  histos.gamma2ZPos = resolve("2Gamma_Zpos");
+  histos.gamma2TimeDiff = resolve("2Gamma_TimeDiff");
+  histos.gamma2Dist = resolve("2Gamma_Dist");
+  histos.annihTOF = resolve("Annih_TOF");
+  histos.annihPointXY = resolve("AnnihPoint_XY");
+  histos.annihPointXZ = resolve("AnnihPoint_XZ");
+  histos.annihPointYZ = resolve("AnnihPoint_YZ");
+  histos.gamma3Angles = resolve("3Gamma_Angles");
+  histos.deexTOTCut = resolve("Deex_TOT_cut");
+  histos.scatterTOFTimeDiff = resolve("ScatterTOF_TimeDiff");
+  histos.scatterAnglePrimaryTOT = resolve("ScatterAngle_PrimaryTOT");
+  histos.scatterAngleScatterTOT = resolve("ScatterAngle_ScatterTOT");
+  return histos;
+}
+
+/**
+* Resolving handles of the streaming histograms
+*/
+EventStreamHistos EventCategorizerTools::getStreamHistos(JPetStatistics& stats, HistoRegistry* registry)
+{
+  auto resolve = [&stats, registry] (const string& name) {
+    return registry ? registry->resolve(stats, name) : HistoHandle::direct(stats, name);
+  };
+  EventStreamHistos histos;
+  histos.enabled = true;
+  histos.gamma2TimeDiff = resolve("2Gamma_TimeDiff");
+  histos.gamma2DLOR = resolve("2Gamma_DLOR");
+  histos.gamma2ThetaDiff = resolve("2Gamma_ThetaDiff");
+  histos.annih2TimeDiff = resolve("2Annih_TimeDiff");
+  histos.annih2DLOR = resolve("2Annih_DLOR");
+  histos.annih2ThetaDiff = resolve("2Annih_ThetaDiff");
+  histos.annih2XY = resolve("2Annih_XY");
+  histos.annih2Z = resolve("2Annih_Z");
+  histos.gamma3TimeDiff = resolve("3GammaTimeDiff");
+  histos.gamma3Thetas = resolve("3GammaThetas");
+  histos.gamma3PlaneDist = resolve("3GammaPlaneDist");
+  histos.annih3PlaneDist = resolve("3AnnihPlaneDist");
+  histos.annih3TimeDiff = resolve("3AnnihTimeDiff");
+  return histos;
+}
+
 /**
 * Method for determining type of event - back to back 2 gamma
 */
-bool EventCategorizerTools::checkFor2Gamma(const JPetEvent& event, JPetStatistics& stats,
-    bool saveHistos, double b2bSlotThetaDiff)
+bool EventCategorizerTools::checkFor2Gamma(const JPetEvent& event,
+    const EventCategorizerHistos& histos, double b2bSlotThetaDiff)
 {
+  bool saveHistos = histos.enabled;
   if (event.getHits().size() < 2) {
     return false;
   }
@@ -45,15 +98,17 @@ bool EventCategorizerTools::checkFor2Gamma(const JPetEvent& event, JPetStatistic
       if (thetaDiff > minTheta && thetaDiff < maxTheta) {
         if (saveHistos) {
           double distance = calculateDistance(secondHit, firstHit);
-          TVector3 annhilationPoint = calculateAnnihilationPoint(firstHit, secondHit);
-          stats.getHisto1D("2Gamma_Zpos")->Fill(firstHit.getPosZ());
-          stats.getHisto1D("2Gamma_Zpos")->Fill(secondHit.getPosZ());
-          stats.getHisto1D("2Gamma_TimeDiff")->Fill(secondHit.getTime() - firstHit.getTime());
-          stats.getHisto1D("2Gamma_Dist")->Fill(distance);
-          stats.getHisto1D("Annih_TOF")->Fill(calculateTOF(firstHit, secondHit));
-          stats.getHisto2D("AnnihPoint_XY")->Fill(annhilationPoint.X(), annhilationPoint.Y());
-          stats.getHisto2D("AnnihPoint_XZ")->Fill(annhilationPoint.X(), annhilationPoint.Z());
-          stats.getHisto2D("AnnihPoint_YZ")->Fill(annhilationPoint.Y(), annhilationPoint.Z());
+          Vec3 annhilationPoint = calculateAnnihilationPoint(
+            getPosition(firstHit), getPosition(secondHit), calculateTOF(firstHit, secondHit)
+          );
+          histos.gamma2ZPos.fill(firstHit.getPosZ());
+          histos.gamma2ZPos.fill(secondHit.getPosZ());
+          histos.gamma2TimeDiff.fill(secondHit.getTime() - firstHit.getTime());
+          histos.gamma2Dist.fill(distance);
+          histos.annihTOF.fill(calculateTOF(firstHit, secondHit));
+          histos.annihPointXY.fill(annhilationPoint.x, annhilationPoint.y);
+          histos.annihPointXZ.fill(annhilationPoint.x, annhilationPoint.z);
+          histos.annihPointYZ.fill(annhilationPoint.y, annhilationPoint.z);
         }
         return true;
       }
@@ -65,8 +120,9 @@ bool EventCategorizerTools::checkFor2Gamma(const JPetEvent& event, JPetStatistic
 /**
 * Method for determining type of event - 3Gamma
 */
-bool EventCategorizerTools::checkFor3Gamma(const JPetEvent& event, JPetStatistics& stats, bool saveHistos)
+bool EventCategorizerTools::checkFor3Gamma(const JPetEvent& event, const EventCategorizerHistos& histos)
 {
+  bool saveHistos = histos.enabled;
   if (event.getHits().size() < 3) return false;
   for (uint i = 0; i < event.getHits().size(); i++) {
     for (uint j = i + 1; j < event.getHits().size(); j++) {
@@ -90,7 +146,7 @@ bool EventCategorizerTools::checkFor3Gamma(const JPetEvent& event, JPetStatistic
         double transformedY = relativeAngles.at(1) - relativeAngles.at(0);
 
         if (saveHistos) {
-          stats.getHisto2D("3Gamma_Angles")->Fill(transformedX, transformedY);
+          histos.gamma3Angles.fill(transformedX, transformedY);
         }
       }
     }
@@ -102,14 +158,15 @@ bool EventCategorizerTools::checkFor3Gamma(const JPetEvent& event, JPetStatistic
 * Method for determining type of event - prompt
 */
 bool EventCategorizerTools::checkForPrompt(
-  const JPetEvent& event, JPetStatistics& stats, bool saveHistos,
+  const JPetEvent& event, const EventCategorizerHistos& histos,
   double deexTOTCutMin, double deexTOTCutMax)
 {
+  bool saveHistos = histos.enabled;
   for (unsigned i = 0; i < event.getHits().size(); i++) {
     double tot = calculateTOT(event.getHits().at(i));
     if (tot > deexTOTCutMin && tot < deexTOTCutMax) {
       if (saveHistos) {
-        stats.getHisto1D("Deex_TOT_cut")->Fill(tot);
+        histos.deexTOTCut.fill(tot);
       }
       return true;
     }
@@ -121,9 +178,10 @@ bool EventCategorizerTools::checkForPrompt(
 * Method for determining type of event - scatter
 */
 bool EventCategorizerTools::checkForScatter(
-  const JPetEvent& event, JPetStatistics& stats, bool saveHistos, double scatterTOFTimeDiff
+  const JPetEvent& event, const EventCategorizerHistos& histos, double scatterTOFTimeDiff
 )
 {
+  bool saveHistos = histos.enabled;
   if (event.getHits().size() < 2) {
     return false;
   }
@@ -143,13 +201,13 @@ bool EventCategorizerTools::checkForScatter(
       double timeDiff = scatterHit.getTime() - primaryHit.getTime();
 
       if (saveHistos) {
-        stats.getHisto1D("ScatterTOF_TimeDiff")->Fill(fabs(scattTOF - timeDiff));
+        histos.scatterTOFTimeDiff.fill(fabs(scattTOF - timeDiff));
       }
 
       if (fabs(scattTOF - timeDiff) < scatterTOFTimeDiff) {
         if (saveHistos) {
-          stats.getHisto2D("ScatterAngle_PrimaryTOT")->Fill(scattAngle, calculateTOT(primaryHit));
-          stats.getHisto2D("ScatterAngle_ScatterTOT")->Fill(scattAngle, calculateTOT(scatterHit));
+          histos.scatterAnglePrimaryTOT.fill(scattAngle, calculateTOT(primaryHit));
+          histos.scatterAngleScatterTOT.fill(scattAngle, calculateTOT(scatterHit));
         }
         return true;
       }
@@ -188,12 +246,25 @@ double EventCategorizerTools::calculateTOT(const JPetHit& hit)
   return tot;
 }
 
+/**
+* Position of the hit as a value type, without creating TVector3
+*/
+Vec3 EventCategorizerTools::getPosition(const JPetHit& hit)
+{
+  return Vec3(hit.getPosX(), hit.getPosY(), hit.getPosZ());
+}
+
 /**
 * Calculation of distance between two hits
 */
 double EventCategorizerTools::calculateDistance(const JPetHit& hit1, const JPetHit& hit2)
 {
-  return (hit1.getPos() - hit2.getPos()).Mag();
+  return calculateDistance(getPosition(hit1), getPosition(hit2));
+}
+
+double EventCategorizerTools::calculateDistance(const Vec3& pos1, const Vec3& pos2)
+{
+  return (pos1 - pos2).norm();
 }
 
 /**
@@ -212,7 +283,12 @@ double EventCategorizerTools::calculateScatteringTime(const JPetHit& hit1, const
 */
 double EventCategorizerTools::calculateScatteringAngle(const JPetHit& hit1, const JPetHit& hit2)
 {
-  return TMath::RadToDeg() * hit1.getPos().Angle(hit2.getPos() - hit1.getPos());
+  return calculateScatteringAngle(getPosition(hit1), getPosition(hit2));
+}
+
+double EventCategorizerTools::calculateScatteringAngle(const Vec3& pos1, const Vec3& pos2)
+{
+  return TMath::RadToDeg() * pos1.angle(pos2 - pos1);
 }
 
 /**
@@ -221,19 +297,20 @@ double EventCategorizerTools::calculateScatteringAngle(const JPetHit& hit1, cons
 TVector3 EventCategorizerTools::calculateAnnihilationPoint(const JPetHit& hitA, const JPetHit& hitB)
 {
   double tof = EventCategorizerTools::calculateTOF(hitA, hitB);
-  return calculateAnnihilationPoint(hitA.getPos(), hitB.getPos(), tof);
+  return calculateAnnihilationPoint(getPosition(hitA), getPosition(hitB), tof).toTVector3();
 }
 
 TVector3 EventCategorizerTools::calculateAnnihilationPoint(const TVector3& hitA, const TVector3& hitB, double tof)
 {
-  TVector3 middleOfLOR = 0.5 * (hitA + hitB);
-  TVector3 versorOnLOR = (hitB - hitA).Unit()  ;
+  return calculateAnnihilationPoint(Vec3(hitA), Vec3(hitB), tof).toTVector3();
+}
 
+Vec3 EventCategorizerTools::calculateAnnihilationPoint(const Vec3& hitA, const Vec3& hitB, double tof)
+{
+  Vec3 middleOfLOR = 0.5 * (hitA + hitB);
+  Vec3 versorOnLOR = (hitB - hitA).unit();
   double shift = 0.5 * tof  * kLightVelocity_cm_ns / 1000.0;
-  TVector3 annihilationPoint(middleOfLOR.X() + shift * versorOnLOR.X(),
-                             middleOfLOR.Y() + shift * versorOnLOR.Y(),
-                             middleOfLOR.Z() + shift * versorOnLOR.Z());
-  return annihilationPoint;
+  return middleOfLOR + shift * versorOnLOR;
 }
 
 double EventCategorizerTools::calculateTOFByConvention(const JPetHit& hitA, const JPetHit& hitB)
@@ -261,10 +338,17 @@ double EventCategorizerTools::calculateTOF(double time1, double time2)
 double EventCategorizerTools::calculatePlaneCenterDistance(
   const JPetHit& firstHit, const JPetHit& secondHit, const JPetHit& thirdHit)
 {
-  TVector3 crossProd = (secondHit.getPos() - firstHit.getPos()).Cross(thirdHit.getPos() - secondHit.getPos());
-  double distCoef = -crossProd.X() * secondHit.getPosX() - crossProd.Y() * secondHit.getPosY() - crossProd.Z() * secondHit.getPosZ();
-  if (crossProd.Mag() != 0) {
-    return fabs(distCoef) / crossProd.Mag();
+  return calculatePlaneCenterDistance(getPosition(firstHit), getPosition(secondHit), getPosition(thirdHit));
+}
+
+double EventCategorizerTools::calculatePlaneCenterDistance(
+  const Vec3& firstPos, const Vec3& secondPos, const Vec3& thirdPos)
+{
+  Vec3 crossProd = (secondPos - firstPos).cross(thirdPos - secondPos);
+  double distCoef = -crossProd.dot(secondPos);
+  double crossProdNorm = crossProd.norm();
+  if (crossProdNorm != 0) {
+    return fabs(distCoef) / crossProdNorm;
   } else {
     ERROR("One of the hit has zero position vector - unable to calculate distance from the center of the surface");
     return -1.;
@@ -277,10 +361,11 @@ double EventCategorizerTools::calculatePlaneCenterDistance(
 * and implemented again
 */
 bool EventCategorizerTools::stream2Gamma(
-  const JPetEvent& event, JPetStatistics& stats, bool saveHistos,
+  const JPetEvent& event, const EventStreamHistos& histos,
   double b2bSlotThetaDiff, double b2bTimeDiff
 )
 {
+  bool saveHistos = histos.enabled;
   if (event.getHits().size() < 2) {
     return false;
   }
@@ -301,18 +386,20 @@ bool EventCategorizerTools::stream2Gamma(
       double theta2 = max(firstHit.getBarrelSlot().getTheta(), secondHit.getBarrelSlot().getTheta());
       double thetaDiff = min(theta2 - theta1, 360.0 - theta2 + theta1);
       if (saveHistos) {
-        stats.getHisto1D("2Gamma_TimeDiff")->Fill(timeDiff / 1000.0);
-        stats.getHisto1D("2Gamma_DLOR")->Fill(deltaLor);
-        stats.getHisto1D("2Gamma_ThetaDiff")->Fill(thetaDiff);
+        histos.gamma2TimeDiff.fill(timeDiff / 1000.0);
+        histos.gamma2DLOR.fill(deltaLor);
+        histos.gamma2ThetaDiff.fill(thetaDiff);
       }
       if (fabs(thetaDiff - 180.0) < b2bSlotThetaDiff && timeDiff < b2bTimeDiff) {
         if (saveHistos) {
-          TVector3 annhilationPoint = calculateAnnihilationPoint(firstHit, secondHit);
-          stats.getHisto1D("2Annih_TimeDiff")->Fill(timeDiff / 1000.0);
-          stats.getHisto1D("2Annih_DLOR")->Fill(deltaLor);
-          stats.getHisto1D("2Annih_ThetaDiff")->Fill(thetaDiff);
-          stats.getHisto2D("2Annih_XY")->Fill(annhilationPoint.X(), annhilationPoint.Y());
-          stats.getHisto1D("2Annih_Z")->Fill(annhilationPoint.Z());
+          Vec3 annhilationPoint = calculateAnnihilationPoint(
+            getPosition(firstHit), getPosition(secondHit), calculateTOF(firstHit, secondHit)
+          );
+          histos.annih2TimeDiff.fill(timeDiff / 1000.0);
+          histos.annih2DLOR.fill(deltaLor);
+          histos.annih2ThetaDiff.fill(thetaDiff);
+          histos.annih2XY.fill(annhilationPoint.x, annhilationPoint.y);
+          histos.annih2Z.fill(annhilationPoint.z);
         }
         return true;
       }
@@ -325,10 +412,11 @@ bool EventCategorizerTools::stream2Gamma(
 * Method for determining type of event for streaming - 3 gamma annihilation
 */
 bool EventCategorizerTools::stream3Gamma(
-  const JPetEvent& event, JPetStatistics& stats, bool saveHistos,
+  const JPetEvent& event, const EventStreamHistos& histos,
   double d3SlotThetaMin, double d3TimeDiff, double d3PlaneCenterDist
 )
 {
+  bool saveHistos = histos.enabled;
   if (event.getHits().size() < 3) {
     return false;
   }
@@ -356,14 +444,14 @@ bool EventCategorizerTools::stream3Gamma(
         double timeDiff = fabs(thirdHit.getTime() - firstHit.getTime());
         double planeCenterDist = calculatePlaneCenterDistance(firstHit, secondHit, thirdHit);
         if (saveHistos) {
-          stats.getHisto1D("3GammaTimeDiff")->Fill(timeDiff);
-          stats.getHisto2D("3GammaThetas")->Fill(transformedX, transformedY);
-          stats.getHisto1D("3GammaPlaneDist")->Fill(planeCenterDist);
+          histos.gamma3TimeDiff.fill(timeDiff);
+          histos.gamma3Thetas.fill(transformedX, transformedY);
+          histos.gamma3PlaneDist.fill(planeCenterDist);
         }
         if (transformedX > d3SlotThetaMin && timeDiff < d3TimeDiff && planeCenterDist < d3PlaneCenterDist) {
           if (saveHistos) {
-            stats.getHisto1D("3AnnihPlaneDist")->Fill(planeCenterDist);
-            stats.getHisto1D("3AnnihTimeDiff")->Fill(timeDiff);
+            histos.annih3PlaneDist.fill(planeCenterDist);
+            histos.annih3TimeDiff.fill(timeDiff);
           }
           return true;
         }
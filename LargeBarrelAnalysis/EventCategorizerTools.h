@@ -19,10 +19,51 @@
 #include <JPetStatistics/JPetStatistics.h>
 #include <JPetEvent/JPetEvent.h>
 #include <JPetHit/JPetHit.h>
+#include "HistogramHandles.h"
+#include "Vec3.h"
 
 static const double kLightVelocity_cm_ns = 29.9792458;
 static const double kUndefinedValue = 999.0;
 
+/**
+ * @brief Handles of the control histograms filled by the categorization checks
+ */
+struct EventCategorizerHistos {
+  bool enabled = false;
+  HistoHandle gamma2ZPos;
+  HistoHandle gamma2TimeDiff;
+  HistoHandle gamma2Dist;
+  HistoHandle annihTOF;
+  HistoHandle annihPointXY;
+  HistoHandle annihPointXZ;
+  HistoHandle annihPointYZ;
+  HistoHandle gamma3Angles;
+  HistoHandle deexTOTCut;
+  HistoHandle scatterTOFTimeDiff;
+  HistoHandle scatterAnglePrimaryTOT;
+  HistoHandle scatterAngleScatterTOT;
+};
+
+/**
+ * @brief Handles of the control histograms filled by the streaming checks
+ */
+struct EventStreamHistos {
+  bool enabled = false;
+  HistoHandle gamma2TimeDiff;
+  HistoHandle gamma2DLOR;
+  HistoHandle gamma2ThetaDiff;
+  HistoHandle annih2TimeDiff;
+  HistoHandle annih2DLOR;
+  HistoHandle annih2ThetaDiff;
+  HistoHandle annih2XY;
+  HistoHandle annih2Z;
+  HistoHandle gamma3TimeDiff;
+  HistoHandle gamma3Thetas;
+  HistoHandle gamma3PlaneDist;
+  HistoHandle annih3PlaneDist;
+  HistoHandle annih3TimeDiff;
+};
+
 /**
  * @brief Tools for Event Categorization
  *
@@ -31,17 +72,22 @@ static const double kUndefinedValue = 999.0;
 class EventCategorizerTools
 {
 public:
-  static bool checkFor2Gamma(const JPetEvent& event, JPetStatistics& stats,
-                             bool saveHistos, double b2bSlotThetaDiff);
-  static bool checkFor3Gamma(const JPetEvent& event, JPetStatistics& stats, bool saveHistos);
-  static bool checkForPrompt(const JPetEvent& event, JPetStatistics& stats,
-                             bool saveHistos, double deexTOTCutMin, double deexTOTCutMax);
-  static bool checkForScatter(const JPetEvent& event, JPetStatistics& stats,
-                              bool saveHistos, double scatterTOFTimeDiff);
+  static EventCategorizerHistos getHistos(JPetStatistics& stats, HistoRegistry* registry = nullptr);
+  static EventStreamHistos getStreamHistos(JPetStatistics& stats, HistoRegistry* registry = nullptr);
+  static bool checkFor2Gamma(const JPetEvent& event, const EventCategorizerHistos& histos,
+                             double b2bSlotThetaDiff);
+  static bool checkFor3Gamma(const JPetEvent& event, const EventCategorizerHistos& histos);
+  static bool checkForPrompt(const JPetEvent& event, const EventCategorizerHistos& histos,
+                             double deexTOTCutMin, double deexTOTCutMax);
+  static bool checkForScatter(const JPetEvent& event, const EventCategorizerHistos& histos,
+                              double scatterTOFTimeDiff);
   static double calculateTOT(const JPetHit& hit);
+  static Vec3 getPosition(const JPetHit& hit);
   static double calculateDistance(const JPetHit& hit1, const JPetHit& hit2);
+  static double calculateDistance(const Vec3& pos1, const Vec3& pos2);
   static double calculateScatteringTime(const JPetHit& hit1, const JPetHit& hit2);
   static double calculateScatteringAngle(const JPetHit& hit1, const JPetHit& hit2);
+  static double calculateScatteringAngle(const Vec3& pos1, const Vec3& pos2);
   /// Tof is calculated as  time1 -time2.
   static double calculateTOF(const JPetHit& hitA, const JPetHit& hitB);
   static double calculateTOF(double time1, double time2);
@@ -51,12 +97,15 @@ public:
   static double calculateTOFByConvention(const JPetHit& hitA, const JPetHit& hitB);
   static TVector3 calculateAnnihilationPoint(const JPetHit& hitA, const JPetHit& hitB);
   static TVector3 calculateAnnihilationPoint(const TVector3& hitA, const TVector3& hitB, double tof);
+  static Vec3 calculateAnnihilationPoint(const Vec3& hitA, const Vec3& hitB, double tof);
   static double calculatePlaneCenterDistance(const JPetHit& firstHit,
       const JPetHit& secondHit, const JPetHit& thirdHit);
-  static bool stream2Gamma(const JPetEvent& event, JPetStatistics& stats,
-                           bool saveHistos, double b2bSlotThetaDiff, double b2bTimeDiff);
-  static bool stream3Gamma(const JPetEvent& event, JPetStatistics& stats,
-                           bool saveHistos, double d3SlotThetaMin, double d3TimeDiff, double d3DistanceFromCenter);
+  static double calculatePlaneCenterDistance(const Vec3& firstPos,
+      const Vec3& secondPos, const Vec3& thirdPos);
+  static bool stream2Gamma(const JPetEvent& event, const EventStreamHistos& histos,
+                           double b2bSlotThetaDiff, double b2bTimeDiff);
+  static bool stream3Gamma(const JPetEvent& event, const EventStreamHistos& histos,
+                           double d3SlotThetaMin, double d3TimeDiff, double d3DistanceFromCenter);
 };
 
 #endif /* !EVENTCATEGORIZERTOOLS_H */
@@ -64,12 +64,11 @@ BOOST_AUTO_TEST_CASE(checkFor2GammaTest)
   event3.addHit(secondHit);
   event3.addHit(fourthHit);
 
-  JPetStatistics stats;
-  BOOST_REQUIRE(!EventCategorizerTools::checkFor2Gamma(event, stats, false, 3.0));
-  BOOST_REQUIRE(EventCategorizerTools::checkFor2Gamma(event0, stats, false, 3.0));
-  BOOST_REQUIRE(EventCategorizerTools::checkFor2Gamma(event1, stats, false, 3.0));
-  BOOST_REQUIRE(EventCategorizerTools::checkFor2Gamma(event2, stats, false, 3.0));
-  BOOST_REQUIRE(!EventCategorizerTools::checkFor2Gamma(event3, stats, false, 3.0));
+  BOOST_REQUIRE(!EventCategorizerTools::checkFor2Gamma(event, EventCategorizerHistos(), 3.0));
+  BOOST_REQUIRE(EventCategorizerTools::checkFor2Gamma(event0, EventCategorizerHistos(), 3.0));
+  BOOST_REQUIRE(EventCategorizerTools::checkFor2Gamma(event1, EventCategorizerHistos(), 3.0));
+  BOOST_REQUIRE(EventCategorizerTools::checkFor2Gamma(event2, EventCategorizerHistos(), 3.0));
+  BOOST_REQUIRE(!EventCategorizerTools::checkFor2Gamma(event3, EventCategorizerHistos(), 3.0));
 }
 
 BOOST_AUTO_TEST_CASE(checkFor3GammaTest)
@@ -107,11 +106,10 @@ BOOST_AUTO_TEST_CASE(checkFor3GammaTest)
   event3.addHit(thirdHit);
   event3.addHit(fourthHit);
 
-  JPetStatistics stats;
-  BOOST_REQUIRE(!EventCategorizerTools::checkFor3Gamma(event0, stats, false));
-  BOOST_REQUIRE(!EventCategorizerTools::checkFor3Gamma(event1, stats, false));
-  BOOST_REQUIRE(EventCategorizerTools::checkFor3Gamma(event2, stats, false));
-  BOOST_REQUIRE(EventCategorizerTools::checkFor3Gamma(event3, stats, false));
+  BOOST_REQUIRE(!EventCategorizerTools::checkFor3Gamma(event0, EventCategorizerHistos()));
+  BOOST_REQUIRE(!EventCategorizerTools::checkFor3Gamma(event1, EventCategorizerHistos()));
+  BOOST_REQUIRE(EventCategorizerTools::checkFor3Gamma(event2, EventCategorizerHistos()));
+  BOOST_REQUIRE(EventCategorizerTools::checkFor3Gamma(event3, EventCategorizerHistos()));
 }
 
 BOOST_AUTO_TEST_CASE(checkForPromptTest_checkTOTCalc)
@@ -278,13 +276,12 @@ BOOST_AUTO_TEST_CASE(checkForPromptTest_checkTOTCalc)
   event5.addHit(hit2);
   event5.addHit(hit3);
 
-  JPetStatistics stats;
 
-  BOOST_REQUIRE(!EventCategorizerTools::checkForPrompt(event1, stats, false, 40.0, 60.0));
-  BOOST_REQUIRE(!EventCategorizerTools::checkForPrompt(event2, stats, false, 200.0, 400.0));
-  BOOST_REQUIRE(!EventCategorizerTools::checkForPrompt(event3, stats, false, 200.0, 400.0));
-  BOOST_REQUIRE(EventCategorizerTools::checkForPrompt(event4, stats, false, 40.0, 600.0));
-  BOOST_REQUIRE(EventCategorizerTools::checkForPrompt(event5, stats, false, 500.0, 600.0));
+  BOOST_REQUIRE(!EventCategorizerTools::checkForPrompt(event1, EventCategorizerHistos(), 40.0, 60.0));
+  BOOST_REQUIRE(!EventCategorizerTools::checkForPrompt(event2, EventCategorizerHistos(), 200.0, 400.0));
+  BOOST_REQUIRE(!EventCategorizerTools::checkForPrompt(event3, EventCategorizerHistos(), 200.0, 400.0));
+  BOOST_REQUIRE(EventCategorizerTools::checkForPrompt(event4, EventCategorizerHistos(), 40.0, 600.0));
+  BOOST_REQUIRE(EventCategorizerTools::checkForPrompt(event5, EventCategorizerHistos(), 500.0, 600.0));
 }
 
 BOOST_AUTO_TEST_CASE(checkForScatterTest)
@@ -303,10 +300,9 @@ BOOST_AUTO_TEST_CASE(checkForScatterTest)
   JPetEvent event1;
   event1.addHit(firstHit);
 
-  JPetStatistics stats;
-  BOOST_REQUIRE(EventCategorizerTools::checkForScatter(event, stats, false, 2000.0));
-  BOOST_REQUIRE(!EventCategorizerTools::checkForScatter(event, stats, false, 0.000001));
-  BOOST_REQUIRE(!EventCategorizerTools::checkForScatter(event1, stats, false, 2000.0));
+  BOOST_REQUIRE(EventCategorizerTools::checkForScatter(event, EventCategorizerHistos(), 2000.0));
+  BOOST_REQUIRE(!EventCategorizerTools::checkForScatter(event, EventCategorizerHistos(), 0.000001));
+  BOOST_REQUIRE(!EventCategorizerTools::checkForScatter(event1, EventCategorizerHistos(), 2000.0));
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -612,10 +608,9 @@ BOOST_AUTO_TEST_CASE(stream2GammaTest)
   event.addHit(firstHit);
   event.addHit(secondHit);
 
-  JPetStatistics stats;
-  BOOST_REQUIRE(EventCategorizerTools::stream2Gamma(event, stats, false, 5.0, 1000.0));
-  BOOST_REQUIRE(!EventCategorizerTools::stream2Gamma(event, stats, false, 1.0, 1000.0));
-  BOOST_REQUIRE(!EventCategorizerTools::stream2Gamma(event, stats, false, 5.0, 10.0));
+  BOOST_REQUIRE(EventCategorizerTools::stream2Gamma(event, EventStreamHistos(), 5.0, 1000.0));
+  BOOST_REQUIRE(!EventCategorizerTools::stream2Gamma(event, EventStreamHistos(), 1.0, 1000.0));
+  BOOST_REQUIRE(!EventCategorizerTools::stream2Gamma(event, EventStreamHistos(), 5.0, 10.0));
 }
 
 BOOST_AUTO_TEST_CASE(stream3GammaTest)
@@ -645,11 +640,62 @@ BOOST_AUTO_TEST_CASE(stream3GammaTest)
   event.addHit(secondHit);
   event.addHit(thirdHit);
 
-  JPetStatistics stats;
-  BOOST_REQUIRE(EventCategorizerTools::stream3Gamma(event, stats, false, 190.0, 1000.0, 5.0));
-  BOOST_REQUIRE(!EventCategorizerTools::stream3Gamma(event, stats, false, 300.0, 1000.0, 5.0));
-  BOOST_REQUIRE(!EventCategorizerTools::stream3Gamma(event, stats, false, 190.0, 10.0, 5.0));
-  BOOST_REQUIRE(!EventCategorizerTools::stream3Gamma(event, stats, false, 190.0, 1000.0, 0.1));
+  BOOST_REQUIRE(EventCategorizerTools::stream3Gamma(event, EventStreamHistos(), 190.0, 1000.0, 5.0));
+  BOOST_REQUIRE(!EventCategorizerTools::stream3Gamma(event, EventStreamHistos(), 300.0, 1000.0, 5.0));
+  BOOST_REQUIRE(!EventCategorizerTools::stream3Gamma(event, EventStreamHistos(), 190.0, 10.0, 5.0));
+  BOOST_REQUIRE(!EventCategorizerTools::stream3Gamma(event, EventStreamHistos(), 190.0, 1000.0, 0.1));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(GeometryToolsSuite)
+
+BOOST_AUTO_TEST_CASE(vec3Operations)
+{
+  constexpr Vec3 first(1.0, 2.0, 3.0);
+  constexpr Vec3 second(4.0, -5.0, 6.0);
+  static_assert(first.dot(second) == 12.0, "Vec3 dot product should be constexpr");
+  Vec3 cross = first.cross(second);
+  TVector3 crossRef = first.toTVector3().Cross(second.toTVector3());
+  BOOST_REQUIRE_CLOSE(cross.x, crossRef.X(), kEpsilon);
+  BOOST_REQUIRE_CLOSE(cross.y, crossRef.Y(), kEpsilon);
+  BOOST_REQUIRE_CLOSE(cross.z, crossRef.Z(), kEpsilon);
+  BOOST_REQUIRE_CLOSE(first.norm(), first.toTVector3().Mag(), kEpsilon);
+  BOOST_REQUIRE_CLOSE(first.angle(second), first.toTVector3().Angle(second.toTVector3()), kEpsilon);
+  BOOST_REQUIRE_EQUAL(Vec3().unit().norm(), 0.0);
+  BOOST_REQUIRE_EQUAL(first.angle(Vec3()), 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(hitAndVec3OverloadsAgree)
+{
+  JPetHit firstHit;
+  JPetHit secondHit;
+  JPetHit thirdHit;
+  firstHit.setPos(2.1, 4.1, 5.6);
+  secondHit.setPos(2.8, 8.3, 9.2);
+  thirdHit.setPos(7.3, 5.2, 6.1);
+  firstHit.setTime(200.0);
+  secondHit.setTime(500.0);
+
+  Vec3 firstPos(2.1, 4.1, 5.6);
+  Vec3 secondPos(2.8, 8.3, 9.2);
+  Vec3 thirdPos(7.3, 5.2, 6.1);
+
+  BOOST_REQUIRE_CLOSE(
+    EventCategorizerTools::calculateDistance(firstHit, secondHit),
+    EventCategorizerTools::calculateDistance(firstPos, secondPos), kEpsilon);
+  BOOST_REQUIRE_CLOSE(
+    EventCategorizerTools::calculateScatteringAngle(firstHit, secondHit),
+    EventCategorizerTools::calculateScatteringAngle(firstPos, secondPos), kEpsilon);
+  BOOST_REQUIRE_CLOSE(
+    EventCategorizerTools::calculatePlaneCenterDistance(firstHit, secondHit, thirdHit),
+    EventCategorizerTools::calculatePlaneCenterDistance(firstPos, secondPos, thirdPos), kEpsilon);
+
+  TVector3 point = EventCategorizerTools::calculateAnnihilationPoint(firstHit, secondHit);
+  Vec3 pointVec = EventCategorizerTools::calculateAnnihilationPoint(firstPos, secondPos, -300.0);
+  BOOST_REQUIRE_CLOSE(point.X(), pointVec.x, kEpsilon);
+  BOOST_REQUIRE_CLOSE(point.Y(), pointVec.y, kEpsilon);
+  BOOST_REQUIRE_CLOSE(point.Z(), pointVec.z, kEpsilon);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
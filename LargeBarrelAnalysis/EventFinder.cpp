@@ -18,6 +18,8 @@ using namespace std;
 #include <JPetOptionsTools/JPetOptionsTools.h>
 #include <JPetWriter/JPetWriter.h>
 #include "EventFinder.h"
+#include "Tracing.h"
+#include <algorithm>
 #include <iostream>
 
 using namespace jpet_options_tools;
@@ -67,27 +69,111 @@ bool EventFinder::init()
     fSaveControlHistos = getOptionAsBool(fParams.getOptions(), kSaveControlHistosParamKey);
   }
 
+  // Hits read from the columnar store, windows are then driven by the store
+  if (isOptionSet(fParams.getOptions(), kHitStoreFileParamKey)) {
+    auto hitStoreFile = getOptionAsString(fParams.getOptions(), kHitStoreFileParamKey);
+    if (!hitStoreFile.empty()) {
+      if (!fHitStore.open(hitStoreFile)) return false;
+      fStoreWindow.reset(new JPetTimeWindow("JPetHit"));
+    }
+  }
+
   // Initialize histograms
-  if (fSaveControlHistos) { initialiseHistograms(); }
+  fHistoRegistry.configure(fParams.getOptions());
+  if (fSaveControlHistos) {
+    initialiseHistograms();
+    fHitsPerEventAll = fHistoRegistry.resolve(getStatistics(), "hits_per_event_all");
+    fHitsPerEventSelected = fHistoRegistry.resolve(getStatistics(), "hits_per_event_selected");
+    fGoodVsBadEvents = fHistoRegistry.resolve(getStatistics(), "good_vs_bad_events");
+  }
   return true;
 }
 
 bool EventFinder::exec()
 {
+  // Windows of the hit store are processed in terminate(), the input is not used
+  if (fHitStore.isOpen()) return true;
   if (auto timeWindow = dynamic_cast<const JPetTimeWindow* const>(fEvent)) {
+    fHistoRegistry.beginWindow();
     saveEvents(buildEvents(*timeWindow));
+    fHistoRegistry.endWindow();
   } else { return false; }
   return true;
 }
 
+/**
+* Events built from the hit store are saved in the file named after the task
+* output, with its extension replaced with unk.evt, unless the windows
+* of the store were already processed by FusedPipeline.
+*/
 bool EventFinder::terminate()
 {
+  bool result = true;
+  if (fHitStore.isOpen() && !fHitStoreProcessed) {
+    string fileName = getOutputFile(fParams.getOptions());
+    if (fileName.find(kStoreOutputExtension) != string::npos) {
+      ERROR(Form("With the hit store output of the task cannot have the %s extension, it is used for the saved events.",
+        kStoreOutputExtension.c_str()));
+      result = false;
+    } else {
+      fileName = fileName.substr(0, fileName.rfind(".root"));
+      fileName = fileName.substr(0, fileName.rfind(".") + 1) + kStoreOutputExtension + ".root";
+      JPetWriter writer(fileName.c_str());
+      if (writer.isOpen()) {
+        INFO(Form("Events built from the hit store will be saved in %s", fileName.c_str()));
+        result = processHitStore([&writer](const JPetTimeWindow& events) {
+          TraceSpan span("EventFinder::write", "io");
+          writer.write(events);
+          return true;
+        });
+        writer.writeObject(&getParamBank(), "ParamBank");
+        writer.closeFile();
+      } else {
+        ERROR(Form("Unable to open file %s for the events built from the hit store.", fileName.c_str()));
+        result = false;
+      }
+    }
+  }
+  fHistoRegistry.merge();
   INFO("Event fiding ended.");
+  return result;
+}
+
+/**
+* Events of all windows of the hit store, in order, are given to the sink.
+* Window of the store is the entry of the hits file of Hit Finder, its start
+* time is calculated from the length of windows. Windows out of the
+* WindowRange_* slice are empty, the ones after its last window are not given.
+*/
+bool EventFinder::processHitStore(const StoreWindowSink& sink)
+{
+  fHitStoreProcessed = true;
+  auto range = WindowIndexer::getRange(fParams.getOptions());
+  auto windowLength = WindowIndexer::getWindowLength(fParams.getOptions());
+  uint64_t nWindows = fHitStore.getNumberOfWindows();
+  if (range.lastWindow >= 0) nWindows = min<uint64_t>(nWindows, range.lastWindow + 1);
+  INFO(Form("Building events from %lu windows of the hit store.", (unsigned long) nWindows));
+  for (uint64_t window = 0; window < nWindows; window++) {
+    fOutputEvents->Clear();
+    if (range.contains(window, window * windowLength)) {
+      fStoreWindow->Clear();
+      if (!fHitStore.fillTimeWindow(window, *fStoreWindow, getParamBank())) {
+        ERROR(Form("Unable to read window %lu of the hit store.", (unsigned long) window));
+        return false;
+      }
+      fHistoRegistry.beginWindow();
+      saveEvents(buildEvents(*fStoreWindow));
+      fHistoRegistry.endWindow();
+    }
+    if (!sink(*fOutputEvents)) return false;
+  }
+  fOutputEvents->Clear();
   return true;
 }
 
 void EventFinder::saveEvents(const vector<JPetEvent>& events)
 {
+  TraceSpan span("EventFinder::saveEvents", "output");
   for (const auto& event : events){
     fOutputEvents->add<JPetEvent>(event);
   }
@@ -99,7 +185,9 @@ void EventFinder::saveEvents(const vector<JPetEvent>& events)
  */
 vector<JPetEvent> EventFinder::buildEvents(const JPetTimeWindow& timeWindow)
 {
+  TraceSpan span("EventFinder::buildEvents", "matching");
   vector<JPetEvent> eventVec;
+  bool saveHistos = fSaveControlHistos && fHistoRegistry.isWindowSampled();
   const unsigned int nHits = timeWindow.getNumberOfEvents();
   unsigned int count = 0;
   while(count<nHits){
@@ -131,20 +219,20 @@ vector<JPetEvent> EventFinder::buildEvents(const JPetTimeWindow& timeWindow)
       } else { break; }
     }
     count+=nextCount;
-    if(fSaveControlHistos) {
-      getStatistics().getHisto1D("hits_per_event_all")->Fill(event.getHits().size());
+    if(saveHistos) {
+      fHitsPerEventAll.fill(event.getHits().size());
       if(event.getRecoFlag()==JPetEvent::Good){
-        getStatistics().getHisto1D("good_vs_bad_events")->Fill(1);
+        fGoodVsBadEvents.fill(1);
       } else if(event.getRecoFlag()==JPetEvent::Corrupted){
-        getStatistics().getHisto1D("good_vs_bad_events")->Fill(2);
+        fGoodVsBadEvents.fill(2);
       } else {
-        getStatistics().getHisto1D("good_vs_bad_events")->Fill(3);
+        fGoodVsBadEvents.fill(3);
       }
     }
     if(event.getHits().size() >= fMinMultiplicity){
       eventVec.push_back(event);
-      if(fSaveControlHistos) {
-        getStatistics().getHisto1D("hits_per_event_selected")->Fill(event.getHits().size());
+      if(saveHistos) {
+        fHitsPerEventSelected.fill(event.getHits().size());
       }
     }
   }
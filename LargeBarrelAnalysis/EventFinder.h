@@ -19,6 +19,11 @@
 #include <JPetUserTask/JPetUserTask.h>
 #include <JPetEvent/JPetEvent.h>
 #include <JPetHit/JPetHit.h>
+#include "HistogramHandles.h"
+#include "WindowIndex.h"
+#include "HitStore.h"
+#include <functional>
+#include <memory>
 #include <vector>
 #include <map>
 
@@ -36,15 +41,25 @@ class JPetWriter;
  * default, but it can be provided by the user in parameters file.
  * Also user can require to save only Events of minimum multiplicity
  * and if include Corrupted Hits in the created events.
+ * With EventFinder_HitStoreFile_std::string set, hits are taken from the
+ * columnar hit store written by HitFinder and windows are driven by the store,
+ * not by the input file, which is not used. All windows of the store are
+ * processed in terminate(), windows out of the WindowRange_* slice are left
+ * empty, and events are saved by the task itself in the unk.evt file,
+ * so the output of the task should be given a different extension.
  */
 class EventFinder: public JPetUserTask
 {
 public:
+  /// Receiver of the events of each window of the hit store
+  typedef std::function<bool(const JPetTimeWindow& events)> StoreWindowSink;
   EventFinder(const char * name);
   virtual ~EventFinder();
   virtual bool init() override;
   virtual bool exec() override;
   virtual bool terminate() override;
+  bool isReadingHitStore() const { return fHitStore.isOpen(); }
+  bool processHitStore(const StoreWindowSink& sink);
 
 protected:
   std::vector<JPetEvent> buildEvents(const JPetTimeWindow & hits);
@@ -54,9 +69,18 @@ protected:
   const std::string kEventMinMultiplicity = "EventFinder_MinEventMultiplicity_int";
   const std::string kSaveControlHistosParamKey = "Save_Control_Histograms_bool";
   const std::string kEventTimeParamKey = "EventFinder_EventTime_float";
+  const std::string kHitStoreFileParamKey = "EventFinder_HitStoreFile_std::string";
   double fEventTimeWindow = 5000.0;
   bool fUseCorruptedHits = false;
   bool fSaveControlHistos = true;
   uint fMinMultiplicity = 1;
+  const std::string kStoreOutputExtension = "unk.evt";
+  HitStoreReader fHitStore;
+  std::unique_ptr<JPetTimeWindow> fStoreWindow;
+  bool fHitStoreProcessed = false;
+  HistoRegistry fHistoRegistry;
+  HistoHandle fHitsPerEventAll;
+  HistoHandle fHitsPerEventSelected;
+  HistoHandle fGoodVsBadEvents;
 };
 #endif /* !EVENTFINDER_H */
@@ -0,0 +1,354 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file FusedPipeline.cpp
+ */
+
+#include <JPetOptionsTools/JPetOptionsTools.h>
+#include <JPetParams/JPetParams.h>
+#include <JPetWriter/JPetWriter.h>
+#include <JPetEvent/JPetEvent.h>
+#include <JPetData/JPetData.h>
+#include "EventCategorizerMultiStream.h"
+#include "TimeWindowCreator.h"
+#include "SignalTransformer.h"
+#include "InstrumentedTask.h"
+#include "Tracing.h"
+#include "FusedPipeline.h"
+#include "SignalFinder.h"
+#include "EventFinder.h"
+#include "HitFinder.h"
+#include <sstream>
+#include <chrono>
+#include <TROOT.h>
+#include <TH1F.h>
+
+using namespace jpet_options_tools;
+using namespace std;
+
+FusedPipeline::FusedPipeline(const char* name): JPetUserTask(name)
+{
+  // Windows are indexed and skipped by the wrapper of this task, stages are only profiled
+  addStage(new InstrumentedTask<TimeWindowCreator>("TimeWindowCreator", false), "tslot.calib");
+  addStage(new InstrumentedTask<SignalFinder>("SignalFinder", false), "raw.sig");
+  addStage(new InstrumentedTask<SignalTransformer>("SignalTransformer", false), "phys.sig");
+  addStage(new InstrumentedTask<HitFinder>("HitFinder", false), "hits");
+  addStage(new InstrumentedTask<EventFinder>("EventFinder", false), "unk.evt");
+  addStage(new InstrumentedTask<EventCategorizerMultiStream>("EventCategorizerMultiStream", false), kOutputExtension);
+}
+
+FusedPipeline::~FusedPipeline() {}
+
+void FusedPipeline::addStage(JPetUserTask* task, const string& extension)
+{
+  PipelineStage stage;
+  stage.extension = extension;
+  stage.task.reset(task);
+  fStages.push_back(move(stage));
+}
+
+bool FusedPipeline::init()
+{
+  INFO("Fused reconstruction pipeline started.");
+  fOutputEvents = new JPetTimeWindow("JPetEvent");
+  if (isOptionSet(fParams.getOptions(), kPipelinedParamKey)) {
+    fPipelined = getOptionAsBool(fParams.getOptions(), kPipelinedParamKey);
+  }
+  if (isOptionSet(fParams.getOptions(), kQueueSizeParamKey)) {
+    fQueueSize = getOptionAsInt(fParams.getOptions(), kQueueSizeParamKey);
+    if (fQueueSize < 1) {
+      WARNING(Form("Wrong value of the %s parameter, using queues of size 1.", kQueueSizeParamKey.c_str()));
+      fQueueSize = 1;
+    }
+  }
+  if (isOptionSet(fParams.getOptions(), kSaveControlHistosParamKey)) {
+    fSaveControlHistos = getOptionAsBool(fParams.getOptions(), kSaveControlHistosParamKey);
+  }
+  // Hits are read from the store by EventFinder, so the previous stages are not needed
+  if (isOptionSet(fParams.getOptions(), kHitStoreFileParamKey)
+    && !getOptionAsString(fParams.getOptions(), kHitStoreFileParamKey).empty()) {
+    while (fStages.front().extension != "unk.evt") fStages.erase(fStages.begin());
+    fHitStoreDriven = true;
+    INFO("Hits are read from the hit store, stages before EventFinder are skipped.");
+    if (fPipelined) {
+      WARNING("Windows of the hit store are passed through the stages in turn, the pipelined mode is not used.");
+      fPipelined = false;
+    }
+  }
+  if (isOptionSet(fParams.getOptions(), kSavedStagesParamKey)) {
+    istringstream stagesList(getOptionAsString(fParams.getOptions(), kSavedStagesParamKey));
+    string extension;
+    while (getline(stagesList, extension, ',')) {
+      extension.erase(0, extension.find_first_not_of(" \t"));
+      extension.erase(extension.find_last_not_of(" \t") + 1);
+      if (extension.empty() || extension == kOutputExtension) continue;
+      bool found = false;
+      for (auto& stage : fStages) {
+        if (stage.extension == extension) {
+          found = true;
+          if (!openStageFile(stage)) return false;
+        }
+      }
+      if (!found) {
+        WARNING(Form("Unknown stage %s in the %s parameter - ignoring it.",
+          extension.c_str(), kSavedStagesParamKey.c_str()));
+      }
+    }
+  }
+  // All stages share the options, the statistics and the windows of this task
+  for (auto& stage : fStages) {
+    stage.task->setStatistics(&getStatistics());
+    if (auto follower = dynamic_cast<WindowFollower*>(stage.task.get())) {
+      follower->setWindowWrapper(fWindowWrapper);
+    }
+    if (!stage.task->init(fParams)) {
+      ERROR(Form("Initialization of the %s stage failed.", stage.extension.c_str()));
+      return false;
+    }
+  }
+  if (fPipelined || fHitStoreDriven) {
+    // Output of the last stage is not the one of exec(), so it is saved here
+    if (getOutputFile(fParams.getOptions()).find(kOutputExtension) != string::npos) {
+      ERROR(Form("In the pipelined mode or with the hit store output of the task cannot have the %s extension, it is used for the saved events.",
+        kOutputExtension.c_str()));
+      return false;
+    }
+    if (!openStageFile(fStages.back())) return false;
+  }
+  if (fPipelined) startPipeline();
+  return true;
+}
+
+/**
+* Time window is passed through all stages, output of each stage is
+* the input of the next one. Outputs of the stages are cleared after
+* the whole chain is processed, the last one is copied to the task output.
+*/
+bool FusedPipeline::exec()
+{
+  // Windows of the hit store are processed in terminate(), the input is not used
+  if (fHitStoreDriven) return true;
+  if (fPipelined) {
+    // Input object belongs to the reader, so the copy is passed to the first stage
+    fStages.front().input->push(fEvent->Clone());
+    return true;
+  }
+  bool result = runStages(fEvent, 0);
+  if (result) {
+    auto events = fStages.back().task->getOutputEvents();
+    for (uint i = 0; i < events->getNumberOfEvents(); i++) {
+      fOutputEvents->add<JPetEvent>(dynamic_cast<const JPetEvent&>(events->operator[](i)));
+    }
+  }
+  for (auto& stage : fStages) {
+    if (auto output = stage.task->getOutputEvents()) output->Clear();
+  }
+  return result;
+}
+
+/**
+* Window is passed through the stages from the given one to the last one,
+* outputs of the stages with the files are saved.
+*/
+bool FusedPipeline::runStages(const TObject* input, unsigned firstStage)
+{
+  for (unsigned index = firstStage; index < fStages.size(); index++) {
+    auto& stage = fStages[index];
+    JPetData data(*const_cast<TObject*>(input));
+    if (!stage.task->run(data)) return false;
+    auto output = stage.task->getOutputEvents();
+    if (stage.writer) {
+      TraceSpan span("FusedPipeline::write", "io");
+      stage.writer->write(*output);
+    }
+    input = output;
+  }
+  return true;
+}
+
+/**
+* Windows of the hit store are driven by EventFinder, its events are passed
+* through the following stages and saved in the cat.evt file.
+*/
+bool FusedPipeline::processHitStore()
+{
+  auto eventFinder = dynamic_cast<EventFinder*>(fStages.front().task.get());
+  if (!eventFinder || !eventFinder->isReadingHitStore()) {
+    ERROR("Event Finder stage of the pipeline does not read the hit store.");
+    return false;
+  }
+  return eventFinder->processHitStore([this](const JPetTimeWindow& events) {
+    auto& first = fStages.front();
+    if (first.writer) {
+      TraceSpan span("FusedPipeline::write", "io");
+      first.writer->write(events);
+    }
+    bool result = runStages(&events, 1);
+    for (unsigned index = 1; index < fStages.size(); index++) {
+      if (auto output = fStages[index].task->getOutputEvents()) output->Clear();
+    }
+    return result;
+  });
+}
+
+bool FusedPipeline::terminate()
+{
+  if (fPipelined) {
+    stopPipeline();
+    reportPipelineStats();
+  }
+  bool result = true;
+  if (fHitStoreDriven && !processHitStore()) result = false;
+  for (auto& stage : fStages) {
+    JPetParams stageParams = fParams;
+    if (!stage.task->terminate(stageParams)) result = false;
+    closeStageFile(stage);
+  }
+  INFO("Fused reconstruction pipeline completed.");
+  return result;
+}
+
+/**
+* Opening the file for the output of the stage. Name of the file is created
+* from the name of the task output file, with the extension of the stage.
+*/
+bool FusedPipeline::openStageFile(PipelineStage& stage)
+{
+  if (stage.writer) return true;
+  string fileName = getOutputFile(fParams.getOptions());
+  auto position = fileName.rfind(kOutputExtension);
+  if (position == string::npos) {
+    // Extension of the task output is replaced with the one of the stage
+    fileName = fileName.substr(0, fileName.rfind(".root"));
+    fileName = fileName.substr(0, fileName.rfind(".") + 1);
+  } else {
+    fileName = fileName.substr(0, position);
+  }
+  fileName += stage.extension + ".root";
+  stage.writer = new JPetWriter(fileName.c_str());
+  if (!stage.writer->isOpen()) {
+    ERROR(Form("Unable to open file %s for the %s stage.", fileName.c_str(), stage.extension.c_str()));
+    return false;
+  }
+  INFO(Form("Output of the %s stage will be saved in %s", stage.extension.c_str(), fileName.c_str()));
+  return true;
+}
+
+void FusedPipeline::closeStageFile(PipelineStage& stage)
+{
+  if (stage.writer) {
+    stage.writer->writeObject(&getParamBank(), "ParamBank");
+    stage.writer->closeFile();
+    delete stage.writer;
+    stage.writer = nullptr;
+  }
+}
+
+void FusedPipeline::startPipeline()
+{
+  ROOT::EnableThreadSafety();
+  for (auto& stage : fStages) {
+    stage.input.reset(new SpscQueue<TObject*>(fQueueSize));
+  }
+  for (unsigned index = 0; index < fStages.size(); index++) {
+    fStages[index].thread = thread(&FusedPipeline::runStage, this, index);
+  }
+  INFO(Form("Pipeline of %lu stages started, with queues of size %d.", fStages.size(), fQueueSize));
+}
+
+/**
+* End of data is marked with null pointer, that is passed by each stage
+* to the next one after all previous windows.
+*/
+void FusedPipeline::stopPipeline()
+{
+  fStages.front().input->push(nullptr);
+  for (auto& stage : fStages) {
+    if (stage.thread.joinable()) stage.thread.join();
+  }
+}
+
+/**
+* Loop of the stage thread. Output window of the task is reused by the task,
+* so its copy is passed to the next stage.
+*/
+void FusedPipeline::runStage(unsigned index)
+{
+  auto& stage = fStages[index];
+  auto next = index + 1 < fStages.size() ? fStages[index + 1].input.get() : nullptr;
+  while (TObject* input = stage.input->pop()) {
+    auto start = chrono::steady_clock::now();
+    JPetData data(*input);
+    if (!stage.task->run(data)) {
+      WARNING(Form("Processing of the time window failed in the %s stage.", stage.extension.c_str()));
+    }
+    auto output = stage.task->getOutputEvents();
+    if (stage.writer) {
+      TraceSpan span("FusedPipeline::write", "io");
+      stage.writer->write(*output);
+    }
+    auto outputCopy = next ? output->Clone() : nullptr;
+    output->Clear();
+    delete input;
+    stage.busyTime += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (next) {
+      TraceSpan span("FusedPipeline::push", "queue");
+      next->push(outputCopy);
+    }
+  }
+  if (next) next->push(nullptr);
+}
+
+/**
+* Bottleneck stage has its input queue full most of the time, so the previous
+* stage waits on push, while the following stages wait on empty queues.
+*/
+void FusedPipeline::reportPipelineStats()
+{
+  int nStages = fStages.size();
+  TH1F* depthHisto = nullptr;
+  TH1F* fullHisto = nullptr;
+  TH1F* emptyHisto = nullptr;
+  TH1F* busyHisto = nullptr;
+  if (fSaveControlHistos) {
+    depthHisto = new TH1F("pipeline_mean_queue_depth", "Mean depth of input queue of the stage", nStages, -0.5, nStages - 0.5);
+    fullHisto = new TH1F("pipeline_full_stall_time", "Time of waiting on full input queue of the stage", nStages, -0.5, nStages - 0.5);
+    emptyHisto = new TH1F("pipeline_empty_stall_time", "Time of stage waiting on its empty input queue", nStages, -0.5, nStages - 0.5);
+    busyHisto = new TH1F("pipeline_busy_time", "Processing time of the stage", nStages, -0.5, nStages - 0.5);
+    for (auto histo : {depthHisto, fullHisto, emptyHisto, busyHisto}) {
+      for (int index = 0; index < nStages; index++) {
+        histo->GetXaxis()->SetBinLabel(index + 1, fStages[index].extension.c_str());
+      }
+      histo->GetYaxis()->SetTitle(histo == depthHisto ? "Windows" : "Time [s]");
+    }
+  }
+  for (int index = 0; index < nStages; index++) {
+    const auto& stage = fStages[index];
+    auto stats = stage.input->getStats();
+    INFO(Form(
+      "Stage %s: busy %.2f s, input queue mean depth %.2f (max %lu of %lu), waiting on full queue %lu times (%.2f s), on empty queue %lu times (%.2f s)",
+      stage.extension.c_str(), stage.busyTime, stats.getMeanDepth(), stats.maxDepth, stage.input->capacity(),
+      stats.fullStalls, stats.fullStallTime, stats.emptyStalls, stats.emptyStallTime
+    ));
+    if (fSaveControlHistos) {
+      depthHisto->SetBinContent(index + 1, stats.getMeanDepth());
+      fullHisto->SetBinContent(index + 1, stats.fullStallTime);
+      emptyHisto->SetBinContent(index + 1, stats.emptyStallTime);
+      busyHisto->SetBinContent(index + 1, stage.busyTime);
+    }
+  }
+  if (fSaveControlHistos) {
+    for (auto histo : {depthHisto, fullHisto, emptyHisto, busyHisto}) {
+      getStatistics().createHistogram(histo);
+    }
+  }
+}
@@ -0,0 +1,108 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file FusedPipeline.h
+ */
+
+#ifndef FUSEDPIPELINE_H
+#define FUSEDPIPELINE_H
+
+#include <JPetTimeWindow/JPetTimeWindow.h>
+#include <JPetUserTask/JPetUserTask.h>
+#include "WindowIndex.h"
+#include "SpscQueue.h"
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+class JPetWriter;
+
+#ifdef __CINT__
+#define override
+#endif
+
+/**
+ * @brief User Task running the whole Large Barrel reconstruction in memory
+ *
+ * Task owns instances of all reconstruction tasks, from TimeWindowCreator
+ * to EventCategorizerMultiStream, and passes each time window from one stage
+ * to the next one directly, with no intermediate files. Output of the last
+ * stage is the output of this task (cat.evt). Outputs of chosen stages can
+ * still be saved, with the same file extensions as in the standard chain,
+ * using the user parameter FusedPipeline_SavedStages_std::string with
+ * a comma separated list of extensions, e.g. "hits,unk.evt".
+ * Control histograms of all stages are saved in the statistics of this task.
+ *
+ * With FusedPipeline_Pipelined_bool set to true, each stage runs in its own
+ * thread and windows are passed between stages through bounded queues,
+ * of size given by FusedPipeline_QueueSize_int. Order of windows is kept.
+ * Since the windows leave the last stage after exec() of this task returns,
+ * the categorized events are then saved by the task itself in the cat.evt file,
+ * and the output of the task should be given a different extension (see main.cpp).
+ * Depth of the queues and time spent by stages waiting on them are reported
+ * at the end, to show which stage is the bottleneck.
+ *
+ * If EventFinder_HitStoreFile_std::string is set, the stages before
+ * EventFinder are skipped and events are built from the hit store,
+ * for fast repeated categorization of the same hits. Windows are then
+ * driven by the store in terminate(), the input of the task is not used,
+ * and the categorized events are saved by the task itself, as in the
+ * pipelined mode, which is not used with the store.
+ * Stages are wrapped for profiling only, windows out of the WindowRange_*
+ * slice are skipped by the wrapper of this task, given to the stages.
+ */
+class FusedPipeline: public JPetUserTask, public WindowFollower
+{
+public:
+  FusedPipeline(const char* name);
+  virtual ~FusedPipeline();
+  virtual bool init() override;
+  virtual bool exec() override;
+  virtual bool terminate() override;
+
+protected:
+  /**
+   * @brief One task of the chain with its optional output file
+   */
+  struct PipelineStage {
+    std::string extension;
+    std::unique_ptr<JPetUserTask> task;
+    JPetWriter* writer = nullptr;
+    /// Input windows of the stage in the pipelined mode, null marks the end of data
+    std::unique_ptr<SpscQueue<TObject*>> input;
+    std::thread thread;
+    double busyTime = 0.0;
+  };
+  const std::string kSavedStagesParamKey = "FusedPipeline_SavedStages_std::string";
+  const std::string kPipelinedParamKey = "FusedPipeline_Pipelined_bool";
+  const std::string kQueueSizeParamKey = "FusedPipeline_QueueSize_int";
+  const std::string kSaveControlHistosParamKey = "Save_Control_Histograms_bool";
+  const std::string kHitStoreFileParamKey = "EventFinder_HitStoreFile_std::string";
+  const std::string kOutputExtension = "cat.evt";
+  std::vector<PipelineStage> fStages;
+  bool fPipelined = false;
+  int fQueueSize = 4;
+  bool fSaveControlHistos = true;
+  bool fHitStoreDriven = false;
+  void addStage(JPetUserTask* task, const std::string& extension);
+  bool openStageFile(PipelineStage& stage);
+  void closeStageFile(PipelineStage& stage);
+  bool runStages(const TObject* input, unsigned firstStage);
+  bool processHitStore();
+  void startPipeline();
+  void stopPipeline();
+  void runStage(unsigned index);
+  void reportPipelineStats();
+};
+
+#endif /* !FUSEDPIPELINE_H */
@@ -0,0 +1,229 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file HistogramHandles.cpp
+ */
+
+#include <JPetOptionsTools/JPetOptionsTools.h>
+#include "JPetLoggerInclude.h"
+#include "HistogramHandles.h"
+#include "Tracing.h"
+#include <TParameter.h>
+#include <TList.h>
+#include <atomic>
+
+using namespace jpet_options_tools;
+using namespace std;
+
+HistoAccumulator::HistoAccumulator(TH1* histo, const bool* active, bool deferred):
+  fHisto(histo), fActive(active), fDeferred(deferred)
+{
+  fDimension = histo->GetDimension();
+  fNumberOfCells = histo->GetNcells();
+  fUseSumw2 = histo->GetSumw2N() > 0;
+}
+
+/**
+ * Each thread gets its own slot number at its first fill. Threads above the
+ * limit share the last slot, that is filled under the lock.
+ */
+unsigned HistoAccumulator::getThreadSlot()
+{
+  static atomic<unsigned> threadCounter(0);
+  thread_local unsigned slot = threadCounter++;
+  return slot < kMaxThreads ? slot : kMaxThreads - 1;
+}
+
+/**
+ * Finding the global bin number with the fixed axes - the axes of the
+ * histogram are only read, so it is safe to use from many threads
+ */
+int HistoAccumulator::findBin(double x, double y) const
+{
+  int binX = fHisto->GetXaxis()->FindFixBin(x);
+  if (fDimension == 1) return binX;
+  int binY = fHisto->GetYaxis()->FindFixBin(y);
+  return binX + (fHisto->GetXaxis()->GetNbins() + 2) * binY;
+}
+
+void HistoAccumulator::addToBins(ThreadSlot& slot, double x, double y, double weight)
+{
+  if (!slot.bins) {
+    int size = fNumberOfCells + 1 + (fUseSumw2 ? fNumberOfCells : 0);
+    slot.bins.reset(new double[size]());
+  }
+  int bin = findBin(x, y);
+  slot.bins[bin] += weight;
+  slot.bins[fNumberOfCells] += 1.0;
+  if (fUseSumw2) slot.bins[fNumberOfCells + 1 + bin] += weight * weight;
+}
+
+void HistoAccumulator::fill(double x, double y, double weight)
+{
+  if (fActive && !*fActive) return;
+  unsigned slotNumber = getThreadSlot();
+  unique_lock<mutex> lock(fOverflowMutex, defer_lock);
+  if (slotNumber == kMaxThreads - 1) lock.lock();
+  auto& slot = fSlots[slotNumber];
+  if (fDeferred) {
+    slot.buffer.push_back(x);
+    slot.buffer.push_back(y);
+    slot.buffer.push_back(weight);
+  } else {
+    addToBins(slot, x, y, weight);
+  }
+}
+
+/**
+ * Filling bins with all values buffered in the deferred mode
+ */
+void HistoAccumulator::flush()
+{
+  for (auto& slot : fSlots) {
+    const auto& buffer = slot.buffer;
+    for (unsigned i = 0; i + 2 < buffer.size(); i += 3) {
+      addToBins(slot, buffer[i], buffer[i + 1], buffer[i + 2]);
+    }
+    slot.buffer.clear();
+  }
+}
+
+/**
+ * Adding the contents of all shadow arrays to the histogram. Statistics
+ * of the histogram are recalculated from the bin contents.
+ */
+void HistoAccumulator::merge()
+{
+  flush();
+  double entries = fHisto->GetEntries();
+  bool modified = false;
+  for (auto& slot : fSlots) {
+    auto& bins = slot.bins;
+    if (!bins) continue;
+    for (int bin = 0; bin < fNumberOfCells; bin++) {
+      if (bins[bin] != 0.0) fHisto->AddBinContent(bin, bins[bin]);
+      if (fUseSumw2) fHisto->GetSumw2()->fArray[bin] += bins[fNumberOfCells + 1 + bin];
+    }
+    entries += bins[fNumberOfCells];
+    bins.reset();
+    modified = true;
+  }
+  if (modified) {
+    fHisto->ResetStats();
+    fHisto->SetEntries(entries);
+  }
+}
+
+HistoHandle HistoHandle::direct(JPetStatistics& stats, const string& name)
+{
+  return HistoHandle(stats.getObject<TH1>(name.c_str()), nullptr);
+}
+
+/**
+ * Reading the sampling policy from the user options. Time budget,
+ * if given, takes precedence over the sampling factor.
+ */
+void HistoRegistry::configure(const map<string, boost::any>& options)
+{
+  if (isOptionSet(options, kSamplingFactorParamKey)) {
+    fSamplingFactor = getOptionAsInt(options, kSamplingFactorParamKey);
+    if (fSamplingFactor < 1) {
+      WARNING(Form("Wrong value of the %s parameter, using every time window for control histograms.",
+        kSamplingFactorParamKey.c_str()));
+      fSamplingFactor = 1;
+    }
+  }
+  if (isOptionSet(options, kTimeBudgetParamKey)) {
+    fTimeBudget = getOptionAsFloat(options, kTimeBudgetParamKey);
+    if (fTimeBudget <= 0.0 || fTimeBudget > 1.0) {
+      WARNING(Form("Value of the %s parameter should be in range (0, 1], time budget is not used.",
+        kTimeBudgetParamKey.c_str()));
+      fTimeBudget = 0.0;
+    }
+  }
+  if (isOptionSet(options, kDeferredParamKey)) {
+    fDeferred = getOptionAsBool(options, kDeferredParamKey);
+  }
+}
+
+HistoHandle HistoRegistry::resolve(JPetStatistics& stats, const string& name)
+{
+  auto histo = stats.getObject<TH1>(name.c_str());
+  if (!histo) {
+    ERROR(Form("Histogram %s does not exist in the statistics, it will not be filled.", name.c_str()));
+    return HistoHandle();
+  }
+  fAccumulators.push_back(unique_ptr<HistoAccumulator>(
+    new HistoAccumulator(histo, &fWindowSampled, fDeferred)
+  ));
+  return HistoHandle(histo, fAccumulators.back().get());
+}
+
+/**
+ * Deciding, if the control histograms are filled for the next time window
+ */
+bool HistoRegistry::beginWindow()
+{
+  auto now = chrono::steady_clock::now();
+  if (fNumberOfWindows == 0) fStartTime = now;
+  if (fTimeBudget > 0.0) {
+    double elapsed = chrono::duration<double>(now - fStartTime).count();
+    fWindowSampled = fSampledTime <= fTimeBudget * elapsed;
+  } else {
+    fWindowSampled = fNumberOfWindows % fSamplingFactor == 0;
+  }
+  fNumberOfWindows++;
+  if (fWindowSampled) fNumberOfSampledWindows++;
+  fWindowStartTime = now;
+  return fWindowSampled;
+}
+
+void HistoRegistry::endWindow()
+{
+  if (!fWindowSampled) return;
+  if (fDeferred) {
+    TraceSpan span("HistoRegistry::flush", "histo");
+    for (auto& accumulator : fAccumulators) accumulator->flush();
+  }
+  fSampledTime += chrono::duration<double>(chrono::steady_clock::now() - fWindowStartTime).count();
+}
+
+double HistoRegistry::getSamplingFactor() const
+{
+  if (fNumberOfSampledWindows == 0) return 0.0;
+  return (double) fNumberOfWindows / fNumberOfSampledWindows;
+}
+
+/**
+ * Adding contents of the accumulators to the histograms. If not all
+ * windows were used, the sampling factor is attached to each histogram
+ * as a parameter and noted in its title.
+ */
+void HistoRegistry::merge()
+{
+  TraceSpan span("HistoRegistry::merge", "histo");
+  for (auto& accumulator : fAccumulators) accumulator->merge();
+  if (fNumberOfSampledWindows == fNumberOfWindows) return;
+  double factor = getSamplingFactor();
+  for (auto& accumulator : fAccumulators) {
+    auto histo = accumulator->getHisto();
+    auto functions = histo->GetListOfFunctions();
+    if (auto parameter = dynamic_cast<TParameter<double>*>(functions->FindObject(kSamplingFactorName.c_str()))) {
+      parameter->SetVal(factor);
+    } else {
+      functions->Add(new TParameter<double>(kSamplingFactorName.c_str(), factor));
+      histo->SetTitle(Form("%s (sampled 1/%.2f)", histo->GetTitle(), factor));
+    }
+  }
+  INFO(Form("Control histograms filled for %lu of %lu time windows, sampling factor %.2f",
+    fNumberOfSampledWindows, fNumberOfWindows, factor));
+}
@@ -0,0 +1,153 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file HistogramHandles.h
+ */
+
+#ifndef HISTOGRAMHANDLES_H
+#define HISTOGRAMHANDLES_H
+
+#include <JPetStatistics/JPetStatistics.h>
+#include <boost/any.hpp>
+#include <TH1.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <map>
+
+/**
+ * @brief Shadow bin arrays of one histogram, separate for each thread
+ *
+ * Filling goes to the bin array of the calling thread, so no locking and
+ * no access to the ROOT object is needed. Arrays of a thread are allocated
+ * at its first fill. Contents of all arrays are added to the histogram by merge(),
+ * that has to be called when no other thread is filling.
+ * In the deferred mode raw values are only stored in a buffer of the thread,
+ * and bins are found for all of them at once in flush(), at the end of the window.
+ * Fills are ignored, when the current window is not sampled.
+ */
+class HistoAccumulator
+{
+public:
+  HistoAccumulator(TH1* histo, const bool* active, bool deferred);
+  void fill(double x, double y, double weight);
+  void flush();
+  void merge();
+  TH1* getHisto() const { return fHisto; }
+  static const unsigned kMaxThreads = 64;
+
+private:
+  struct ThreadSlot {
+    /// Content of the cells, then the number of entries, then sum of squared weights if used
+    std::unique_ptr<double[]> bins;
+    /// Triplets of x, y and weight, waiting for the flush in the deferred mode
+    std::vector<double> buffer;
+  };
+  int findBin(double x, double y) const;
+  void addToBins(ThreadSlot& slot, double x, double y, double weight);
+  static unsigned getThreadSlot();
+  TH1* fHisto = nullptr;
+  const bool* fActive = nullptr;
+  bool fDeferred = false;
+  int fDimension = 1;
+  int fNumberOfCells = 0;
+  bool fUseSumw2 = false;
+  ThreadSlot fSlots[kMaxThreads];
+  std::mutex fOverflowMutex;
+};
+
+/**
+ * @brief Handle to a control histogram, resolved once from its name
+ *
+ * Handle either fills the shadow bins of the accumulator, or directly the
+ * ROOT histogram, if it was created without the accumulator. Default handle
+ * is invalid and filling it does nothing, so the handles of disabled histograms
+ * can be filled without additional checks. Following the ROOT convention, for 1D
+ * histogram the second argument of fill() is the weight, for 2D the y value.
+ */
+class HistoHandle
+{
+public:
+  HistoHandle() {}
+  HistoHandle(TH1* histo, HistoAccumulator* accumulator): fHisto(histo), fAccumulator(accumulator) {}
+  static HistoHandle direct(JPetStatistics& stats, const std::string& name);
+  bool isValid() const { return fHisto != nullptr; }
+  TH1* getHisto() const { return fHisto; }
+
+  void fill(double x) const { fill(x, 1.0); }
+
+  void fill(double x, double yOrWeight) const
+  {
+    if (fAccumulator) {
+      if (fHisto->GetDimension() == 1) fAccumulator->fill(x, 0.0, yOrWeight);
+      else fAccumulator->fill(x, yOrWeight, 1.0);
+    } else if (fHisto) {
+      fHisto->Fill(x, yOrWeight);
+    }
+  }
+
+  void fill(double x, double y, double weight) const
+  {
+    if (fAccumulator) fAccumulator->fill(x, y, weight);
+    else if (fHisto) fHisto->Fill(x, y, weight);
+  }
+
+private:
+  TH1* fHisto = nullptr;
+  HistoAccumulator* fAccumulator = nullptr;
+};
+
+/**
+ * @brief Owner of the accumulators of one task
+ *
+ * Histograms are resolved by name once, usually in init() of the task,
+ * and filled through the returned handles. All accumulated contents are
+ * added to the histograms in JPetStatistics with merge(), in terminate().
+ *
+ * Registry also decides, which time windows are used for the control histograms.
+ * Each exec() of the task is enclosed with beginWindow() and endWindow().
+ * By default all windows are sampled. With the sampling factor N only every N-th
+ * window is used, with the time budget windows are sampled as long as time spent
+ * in the sampled windows does not exceed the given fraction of the processing time.
+ * Effective sampling factor is saved with each histogram at merge().
+ */
+class HistoRegistry
+{
+public:
+  void configure(const std::map<std::string, boost::any>& options);
+  HistoHandle resolve(JPetStatistics& stats, const std::string& name);
+  bool beginWindow();
+  void endWindow();
+  bool isWindowSampled() const { return fWindowSampled; }
+  double getSamplingFactor() const;
+  void merge();
+  const std::string kSamplingFactorParamKey = "Control_Histograms_Sampling_Factor_int";
+  const std::string kTimeBudgetParamKey = "Control_Histograms_Time_Budget_float";
+  const std::string kDeferredParamKey = "Control_Histograms_Deferred_bool";
+  const std::string kSamplingFactorName = "SamplingFactor";
+
+private:
+  std::vector<std::unique_ptr<HistoAccumulator>> fAccumulators;
+  int fSamplingFactor = 1;
+  double fTimeBudget = 0.0;
+  bool fDeferred = false;
+  bool fWindowSampled = true;
+  unsigned long fNumberOfWindows = 0;
+  unsigned long fNumberOfSampledWindows = 0;
+  double fSampledTime = 0.0;
+  std::chrono::steady_clock::time_point fStartTime;
+  std::chrono::steady_clock::time_point fWindowStartTime;
+};
+
+#endif /* !HISTOGRAMHANDLES_H */
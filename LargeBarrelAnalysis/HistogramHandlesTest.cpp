@@ -0,0 +1,180 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file HistogramHandlesTest.cpp
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE HistogramHandlesTest
+
+#include <JPetStatistics/JPetStatistics.h>
+#include <boost/test/unit_test.hpp>
+#include "JPetLoggerInclude.h"
+#include "HistogramHandles.h"
+#include <TH1F.h>
+#include <TH2F.h>
+#include <TParameter.h>
+#include <TList.h>
+#include <thread>
+#include <vector>
+#include <map>
+
+BOOST_AUTO_TEST_SUITE(HistogramHandlesTestSuite)
+
+BOOST_AUTO_TEST_CASE(invalidHandle_test)
+{
+  JPetStatistics stats;
+  HistoRegistry registry;
+  HistoHandle defaultHandle;
+  BOOST_REQUIRE(!defaultHandle.isValid());
+  defaultHandle.fill(1.0);
+  auto missing = registry.resolve(stats, "not_existing");
+  BOOST_REQUIRE(!missing.isValid());
+  missing.fill(1.0, 2.0);
+  registry.merge();
+}
+
+BOOST_AUTO_TEST_CASE(fill1D_test)
+{
+  JPetStatistics stats;
+  stats.createHistogram(new TH1F("direct", "direct", 10, 0.0, 10.0));
+  stats.createHistogram(new TH1F("buffered", "buffered", 10, 0.0, 10.0));
+  HistoRegistry registry;
+  auto direct = HistoHandle::direct(stats, "direct");
+  auto buffered = registry.resolve(stats, "buffered");
+  BOOST_REQUIRE(direct.isValid());
+  BOOST_REQUIRE(buffered.isValid());
+  for (auto value : {0.5, 3.5, 3.5, 9.5, -1.0, 12.0}) {
+    direct.fill(value);
+    buffered.fill(value);
+  }
+  direct.fill(5.5, 2.0);
+  buffered.fill(5.5, 2.0);
+  BOOST_REQUIRE_EQUAL(buffered.getHisto()->GetEntries(), 0.0);
+  registry.merge();
+  auto directHisto = stats.getHisto1D("direct");
+  auto bufferedHisto = stats.getHisto1D("buffered");
+  for (int bin = 0; bin <= 11; bin++) {
+    BOOST_REQUIRE_EQUAL(directHisto->GetBinContent(bin), bufferedHisto->GetBinContent(bin));
+  }
+  BOOST_REQUIRE_EQUAL(directHisto->GetEntries(), bufferedHisto->GetEntries());
+  BOOST_REQUIRE_CLOSE(directHisto->GetMean(), bufferedHisto->GetMean(), 0.001);
+}
+
+BOOST_AUTO_TEST_CASE(fill2D_test)
+{
+  JPetStatistics stats;
+  stats.createHistogram(new TH2F("direct", "direct", 4, 0.0, 4.0, 3, 0.0, 3.0));
+  stats.createHistogram(new TH2F("buffered", "buffered", 4, 0.0, 4.0, 3, 0.0, 3.0));
+  HistoRegistry registry;
+  auto direct = HistoHandle::direct(stats, "direct");
+  auto buffered = registry.resolve(stats, "buffered");
+  direct.fill(1.5, 2.5);
+  buffered.fill(1.5, 2.5);
+  direct.fill(3.5, 0.5);
+  buffered.fill(3.5, 0.5);
+  direct.fill(5.0, -1.0);
+  buffered.fill(5.0, -1.0);
+  registry.merge();
+  auto directHisto = stats.getHisto2D("direct");
+  auto bufferedHisto = stats.getHisto2D("buffered");
+  for (int binX = 0; binX <= 5; binX++) {
+    for (int binY = 0; binY <= 4; binY++) {
+      BOOST_REQUIRE_EQUAL(
+        directHisto->GetBinContent(binX, binY), bufferedHisto->GetBinContent(binX, binY)
+      );
+    }
+  }
+  BOOST_REQUIRE_EQUAL(bufferedHisto->GetEntries(), 3.0);
+}
+
+BOOST_AUTO_TEST_CASE(fillFromThreads_test)
+{
+  JPetStatistics stats;
+  stats.createHistogram(new TH1F("buffered", "buffered", 10, 0.0, 10.0));
+  HistoRegistry registry;
+  auto buffered = registry.resolve(stats, "buffered");
+  const int kThreads = 4;
+  const int kFillsPerThread = 1000;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; i++) {
+    threads.push_back(std::thread([&buffered, i] () {
+      for (int j = 0; j < kFillsPerThread; j++) { buffered.fill(i + 0.5); }
+    }));
+  }
+  for (auto& thread : threads) { thread.join(); }
+  registry.merge();
+  auto histo = stats.getHisto1D("buffered");
+  for (int i = 0; i < kThreads; i++) {
+    BOOST_REQUIRE_EQUAL(histo->GetBinContent(i + 1), kFillsPerThread);
+  }
+  BOOST_REQUIRE_EQUAL(histo->GetEntries(), kThreads * kFillsPerThread);
+}
+
+BOOST_AUTO_TEST_CASE(samplingFactor_test)
+{
+  JPetStatistics stats;
+  stats.createHistogram(new TH1F("sampled", "sampled", 10, 0.0, 10.0));
+  HistoRegistry registry;
+  std::map<std::string, boost::any> options;
+  options[registry.kSamplingFactorParamKey] = 3;
+  registry.configure(options);
+  auto sampled = registry.resolve(stats, "sampled");
+  for (int window = 0; window < 9; window++) {
+    bool isSampled = registry.beginWindow();
+    BOOST_REQUIRE_EQUAL(isSampled, window % 3 == 0);
+    sampled.fill(window + 0.5);
+    registry.endWindow();
+  }
+  registry.merge();
+  auto histo = stats.getHisto1D("sampled");
+  BOOST_REQUIRE_EQUAL(histo->GetEntries(), 3.0);
+  BOOST_REQUIRE_EQUAL(histo->GetBinContent(1), 1.0);
+  BOOST_REQUIRE_EQUAL(histo->GetBinContent(2), 0.0);
+  BOOST_REQUIRE_EQUAL(histo->GetBinContent(4), 1.0);
+  auto factor = dynamic_cast<TParameter<double>*>(
+    histo->GetListOfFunctions()->FindObject(registry.kSamplingFactorName.c_str())
+  );
+  BOOST_REQUIRE(factor);
+  BOOST_REQUIRE_CLOSE(factor->GetVal(), 3.0, 0.001);
+}
+
+BOOST_AUTO_TEST_CASE(deferred_test)
+{
+  JPetStatistics stats;
+  stats.createHistogram(new TH1F("direct", "direct", 10, 0.0, 10.0));
+  stats.createHistogram(new TH1F("deferred", "deferred", 10, 0.0, 10.0));
+  HistoRegistry registry;
+  std::map<std::string, boost::any> options;
+  options[registry.kDeferredParamKey] = true;
+  registry.configure(options);
+  auto direct = HistoHandle::direct(stats, "direct");
+  auto deferred = registry.resolve(stats, "deferred");
+  for (int window = 0; window < 2; window++) {
+    registry.beginWindow();
+    for (auto value : {0.5, 3.5, 3.5, 12.0}) {
+      direct.fill(value + window);
+      deferred.fill(value + window);
+    }
+    registry.endWindow();
+  }
+  registry.merge();
+  auto directHisto = stats.getHisto1D("direct");
+  auto deferredHisto = stats.getHisto1D("deferred");
+  for (int bin = 0; bin <= 11; bin++) {
+    BOOST_REQUIRE_EQUAL(directHisto->GetBinContent(bin), deferredHisto->GetBinContent(bin));
+  }
+  BOOST_REQUIRE_EQUAL(directHisto->GetEntries(), deferredHisto->GetEntries());
+  BOOST_REQUIRE(!deferredHisto->GetListOfFunctions()->FindObject(registry.kSamplingFactorName.c_str()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -22,6 +22,7 @@ using namespace std;
 #include "UniversalFileLoader.h"
 #include "HitFinderTools.h"
 #include "HitFinder.h"
+#include "Tracing.h"
 #include <string>
 #include <vector>
 #include <map>
@@ -72,56 +73,100 @@ bool HitFinder::init()
     fSaveControlHistos = getOptionAsBool(fParams.getOptions(), kSaveControlHistosParamKey);
   }
 
+  // Columnar store of hits
+  if (isOptionSet(fParams.getOptions(), kHitStoreFileParamKey)) {
+    auto hitStoreFile = getOptionAsString(fParams.getOptions(), kHitStoreFileParamKey);
+    if (!hitStoreFile.empty()) {
+      if (!fHitStore.open(hitStoreFile)) return false;
+      INFO(Form("Hits will be saved in the hit store %s", hitStoreFile.c_str()));
+      if (isOptionSet(fParams.getOptions(), kHitStoreOnlyParamKey)) {
+        fHitStoreOnly = getOptionAsBool(fParams.getOptions(), kHitStoreOnlyParamKey);
+      }
+    }
+  }
+
   // Use of velocities file
+  std::string cacheDirectory;
+  if (isOptionSet(fParams.getOptions(), UniversalFileLoader::kCacheDirectoryParamKey)) {
+    cacheDirectory = getOptionAsString(fParams.getOptions(), UniversalFileLoader::kCacheDirectoryParamKey);
+  }
   JPetGeomMapping mapper(getParamBank());
   auto tombMap = mapper.getTOMBMapping();
-  fVelocities = UniversalFileLoader::loadConfigurationParameters(velocitiesFile, tombMap);
-  if (fVelocities.empty())  {
+  if (!fVelocities.load(velocitiesFile, tombMap, getRunNumber(fParams.getOptions()), cacheDirectory))  {
     ERROR("Velocities map seems to be empty");
   }
+  if (fVelocities.isTimeDependent() || fHitStore.isOpen()) fWindowTimes.follow(fParams.getOptions(), fWindowWrapper);
 
   // Control histograms
-  if(fSaveControlHistos) { initialiseHistograms(); }
+  fHistoRegistry.configure(fParams.getOptions());
+  if(fSaveControlHistos) {
+    initialiseHistograms();
+    fHistos = HitFinderTools::getHistos(getStatistics(), &fHistoRegistry);
+    fHitsPerTimeSlot = fHistoRegistry.resolve(getStatistics(), "hits_per_time_slot");
+    fTOTAllHits = fHistoRegistry.resolve(getStatistics(), "TOT_all_hits");
+    fTOTGoodHits = fHistoRegistry.resolve(getStatistics(), "TOT_good_hits");
+    fTOTCorrHits = fHistoRegistry.resolve(getStatistics(), "TOT_corr_hits");
+  }
   return true;
 }
 
 bool HitFinder::exec()
 {
   if (auto& timeWindow = dynamic_cast<const JPetTimeWindow* const>(fEvent)) {
+    // Control histograms are filled only for the sampled windows
+    bool sampled = fHistoRegistry.beginWindow();
+    if (fVelocities.isTimeDependent() || fHitStore.isOpen()) {
+      auto startTime = fWindowTimes.nextProcessedWindow().startTime;
+      if (fVelocities.isTimeDependent()) fVelocities.selectTime(startTime);
+      // Windows skipped by the wrapper are empty in the output, so also in the store
+      if (fHitStore.isOpen()) {
+        while (fHitStore.getNumberOfWindows() < fWindowTimes.getOutputEntry()) fHitStore.endWindow();
+      }
+    }
     auto signalsBySlot = HitFinderTools::getSignalsBySlot(
       timeWindow, fUseCorruptedSignals
     );
     auto allHits = HitFinderTools::matchAllSignals(
-      signalsBySlot, fVelocities, fABTimeDiff, fRefDetScinID, getStatistics(), fSaveControlHistos
+      signalsBySlot, fVelocities.getParameters(), fABTimeDiff, fRefDetScinID,
+      sampled ? fHistos : HitFinderHistos()
     );
-    if (fSaveControlHistos) {
-      getStatistics().getHisto1D("hits_per_time_slot")->Fill(allHits.size());
-    }
+    fHitsPerTimeSlot.fill(allHits.size());
     saveHits(allHits);
+    if (fHitStore.isOpen()) fHitStore.endWindow();
+    fHistoRegistry.endWindow();
   } else return false;
   return true;
 }
 
 bool HitFinder::terminate()
 {
+  fHistoRegistry.merge();
+  if (fHitStore.isOpen()) {
+    auto windows = fHitStore.getNumberOfWindows();
+    auto hits = fHitStore.getNumberOfHits();
+    if (!fHitStore.close()) return false;
+    INFO(Form("Hit store completed, %lu windows with %lu hits", (unsigned long) windows, (unsigned long) hits));
+  }
   INFO("Hit finding ended");
   return true;
 }
 
 void HitFinder::saveHits(const std::vector<JPetHit>& hits)
 {
+  TraceSpan span("HitFinder::saveHits", "output");
   auto sortedHits = JPetAnalysisTools::getHitsOrderedByTime(hits);
   for (const auto& hit : sortedHits) {
-    if (fSaveControlHistos) {
+    if (fSaveControlHistos && fHistoRegistry.isWindowSampled()) {
       auto tot = HitFinderTools::calculateTOT(hit);
-      getStatistics().getHisto1D("TOT_all_hits")->Fill(tot);
+      fTOTAllHits.fill(tot);
       if(hit.getRecoFlag()==JPetHit::Good){
-        getStatistics().getHisto1D("TOT_good_hits")->Fill(tot);
+        fTOTGoodHits.fill(tot);
       } else if(hit.getRecoFlag()==JPetHit::Corrupted){
-        getStatistics().getHisto1D("TOT_corr_hits")->Fill(tot);
+        fTOTCorrHits.fill(tot);
       }
     }
-    fOutputEvents->add<JPetHit>(hit);
+    if (fHitStore.isOpen()) fHitStore.addHit(HitStoreWriter::toRecord(hit));
+    if (!fHitStoreOnly) fOutputEvents->add<JPetHit>(hit);
   }
 }
 
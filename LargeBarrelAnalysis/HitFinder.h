@@ -19,6 +19,11 @@
 #include <JPetRawSignal/JPetRawSignal.h>
 #include <JPetUserTask/JPetUserTask.h>
 #include <JPetHit/JPetHit.h>
+#include "HitFinderTools.h"
+#include "HistogramHandles.h"
+#include "CalibrationStore.h"
+#include "WindowIndex.h"
+#include "HitStore.h"
 #include <vector>
 #include <map>
 
@@ -34,8 +39,13 @@ class JPetWriter;
  * Task pairs Physical Signals and creates Hits, based on time comparison
  * of Signals, time window for hit matching can be specified in user options,
  * default one is provided. Matching method is contained in tools class.
+ * With HitFinder_HitStoreFile_std::string set, hits are also written
+ * to the columnar hit store (see HitStore.h), or only there, if
+ * HitFinder_HitStoreOnly_bool is true.
+ * Velocities may change in time (see CalibrationStore.h), then velocities
+ * valid at the start time of each window are used.
  */
-class HitFinder: public JPetUserTask {
+class HitFinder: public JPetUserTask, public WindowFollower {
 
 public:
   HitFinder(const char* name);
@@ -47,16 +57,27 @@ public:
 protected:
   void saveHits(const std::vector<JPetHit>& hits);
   void initialiseHistograms();
-  std::map<unsigned int, std::vector<double>> fVelocities;
+  CalibrationStore fVelocities;
+  WindowIndexer fWindowTimes;
   const std::string kUseCorruptedSignalsParamKey = "HitFinder_UseCorruptedSignals_bool";
   const std::string kVelocityFileParamKey = "HitFinder_VelocityFile_std::string";
   const std::string kSaveControlHistosParamKey = "Save_Control_Histograms_bool";
   const std::string kRefDetScinIDParamKey = "HitFinder_RefDetScinID_int";
   const std::string kABTimeDiffParamKey = "HitFinder_ABTimeDiff_float";
+  const std::string kHitStoreFileParamKey = "HitFinder_HitStoreFile_std::string";
+  const std::string kHitStoreOnlyParamKey = "HitFinder_HitStoreOnly_bool";
   bool fUseCorruptedSignals = false;
   bool fSaveControlHistos = true;
   double fABTimeDiff = 6000.0;
   int fRefDetScinID = -1;
+  bool fHitStoreOnly = false;
+  HitStoreWriter fHitStore;
+  HistoRegistry fHistoRegistry;
+  HitFinderHistos fHistos;
+  HistoHandle fHitsPerTimeSlot;
+  HistoHandle fTOTAllHits;
+  HistoHandle fTOTGoodHits;
+  HistoHandle fTOTCorrHits;
 };
 
 #endif /* !HITFINDER_H */
@@ -17,11 +17,30 @@ using namespace std;
 
 #include "UniversalFileLoader.h"
 #include "HitFinderTools.h"
+#include "Tracing.h"
 #include <TMath.h>
 #include <vector>
 #include <cmath>
 #include <map>
 
+/**
+ * Resolving handles of the control histograms. Without the registry,
+ * handles fill the histograms directly.
+ */
+HitFinderHistos HitFinderTools::getHistos(JPetStatistics& stats, HistoRegistry* registry)
+{
+  auto resolve = [&stats, registry] (const string& name) {
+    return registry ? registry->resolve(stats, name) : HistoHandle::direct(stats, name);
+  };
+  HitFinderHistos histos;
+  histos.enabled = true;
+  histos.remainSignalsPerScin = resolve("remain_signals_per_scin");
+  histos.goodVsBadHits = resolve("good_vs_bad_hits");
+  histos.timeDiffPerScin = resolve("time_diff_per_scin");
+  histos.hitPosPerScin = resolve("hit_pos_per_scin");
+  return histos;
+}
+
 /**
  * Helper method for sotring signals in vector
  */
@@ -40,6 +59,7 @@ void HitFinderTools::sortByTime(vector<JPetPhysSignal>& sigVec)
 map<int, vector<JPetPhysSignal>> HitFinderTools::getSignalsBySlot(
   const JPetTimeWindow* timeWindow, bool useCorrupts
 ){
+  TraceSpan span("HitFinder::getSignalsBySlot", "bucketing");
   map<int, vector<JPetPhysSignal>> signalSlotMap;
   if (!timeWindow) {
     WARNING("Pointer of Time Window object is not set, returning empty map");
@@ -68,8 +88,9 @@ map<int, vector<JPetPhysSignal>> HitFinderTools::getSignalsBySlot(
 vector<JPetHit> HitFinderTools::matchAllSignals(
   map<int, vector<JPetPhysSignal>>& allSignals,
   const map<unsigned int, vector<double>>& velocitiesMap,
-  double timeDiffAB, int refDetScinId, JPetStatistics& stats, bool saveHistos
+  double timeDiffAB, int refDetScinId, const HitFinderHistos& histos
 ) {
+  TraceSpan span("HitFinder::matchAllSignals", "matching");
   vector<JPetHit> allHits;
   for (auto& slotSigals : allSignals) {
     // Loop for Reference Detector ID
@@ -82,7 +103,7 @@ vector<JPetHit> HitFinderTools::matchAllSignals(
     }
     // Loop for other slots than reference one
     auto slotHits = matchSignals(
-      slotSigals.second, velocitiesMap, timeDiffAB, stats, saveHistos
+      slotSigals.second, velocitiesMap, timeDiffAB, histos
     );
     allHits.insert(allHits.end(), slotHits.begin(), slotHits.end());
   }
@@ -95,7 +116,7 @@ vector<JPetHit> HitFinderTools::matchAllSignals(
 vector<JPetHit> HitFinderTools::matchSignals(
   vector<JPetPhysSignal>& slotSignals,
   const map<unsigned int, vector<double>>& velocitiesMap,
-  double timeDiffAB, JPetStatistics& stats, bool saveHistos
+  double timeDiffAB, const HitFinderHistos& histos
 ) {
   vector<JPetHit> slotHits;
   vector<JPetPhysSignal> remainSignals;
@@ -110,7 +131,7 @@ vector<JPetHit> HitFinderTools::matchSignals(
       if (slotSignals.at(j).getTime() - physSig.getTime() < timeDiffAB) {
         if (physSig.getPM().getSide() != slotSignals.at(j).getPM().getSide()) {
           auto hit = createHit(
-            physSig, slotSignals.at(j), velocitiesMap, stats, saveHistos
+            physSig, slotSignals.at(j), velocitiesMap, histos
           );
           slotHits.push_back(hit);
           slotSignals.erase(slotSignals.begin() + j);
@@ -130,9 +151,8 @@ vector<JPetHit> HitFinderTools::matchSignals(
       }
     }
   }
-  if(remainSignals.size()>0 && saveHistos){
-    stats.getHisto1D("remain_signals_per_scin")
-      ->Fill((float)(remainSignals.at(0).getPM().getScin().getID()), remainSignals.size());
+  if(remainSignals.size()>0 && histos.enabled){
+    histos.remainSignalsPerScin.fill((float)(remainSignals.at(0).getPM().getScin().getID()), remainSignals.size());
   }
   return slotHits;
 }
@@ -143,8 +163,9 @@ vector<JPetHit> HitFinderTools::matchSignals(
 JPetHit HitFinderTools::createHit(
   const JPetPhysSignal& signal1, const JPetPhysSignal& signal2,
   const map<unsigned int, vector<double>>& velocitiesMap,
-  JPetStatistics& stats, bool saveHistos
+  const HitFinderHistos& histos
 ) {
+  bool saveHistos = histos.enabled;
   JPetPhysSignal signalA;
   JPetPhysSignal signalB;
   if (signal1.getPM().getSide() == JPetPM::SideA) {
@@ -180,19 +201,17 @@ JPetHit HitFinderTools::createHit(
     && signalB.getRecoFlag() == JPetBaseSignal::Good) {
       hit.setRecoFlag(JPetHit::Good);
       if(saveHistos) {
-        stats.getHisto1D("good_vs_bad_hits")->Fill(1);
-        stats.getHisto2D("time_diff_per_scin")
-          ->Fill(hit.getTimeDiff(), (float)(hit.getScintillator().getID()));
-        stats.getHisto2D("hit_pos_per_scin")
-          ->Fill(hit.getPosZ(), (float)(hit.getScintillator().getID()));
+        histos.goodVsBadHits.fill(1);
+        histos.timeDiffPerScin.fill(hit.getTimeDiff(), (float)(hit.getScintillator().getID()));
+        histos.hitPosPerScin.fill(hit.getPosZ(), (float)(hit.getScintillator().getID()));
       }
   } else if (signalA.getRecoFlag() == JPetBaseSignal::Corrupted
     || signalB.getRecoFlag() == JPetBaseSignal::Corrupted){
       hit.setRecoFlag(JPetHit::Corrupted);
-      if(saveHistos) { stats.getHisto1D("good_vs_bad_hits")->Fill(2); }
+      if(saveHistos) { histos.goodVsBadHits.fill(2); }
   } else {
     hit.setRecoFlag(JPetHit::Unknown);
-    if(saveHistos) { stats.getHisto1D("good_vs_bad_hits")->Fill(3); }
+    if(saveHistos) { histos.goodVsBadHits.fill(3); }
   }
   return hit;
 }
@@ -19,8 +19,20 @@
 #include <JPetStatistics/JPetStatistics.h>
 #include <JPetTimeWindow/JPetTimeWindow.h>
 #include <JPetHit/JPetHit.h>
+#include "HistogramHandles.h"
 #include <vector>
 
+/**
+ * @brief Handles of the control histograms filled by the Hit Finder tools
+ */
+struct HitFinderHistos {
+  bool enabled = false;
+  HistoHandle remainSignalsPerScin;
+  HistoHandle goodVsBadHits;
+  HistoHandle timeDiffPerScin;
+  HistoHandle hitPosPerScin;
+};
+
 /**
  * @brief Tools set fot HitFinder module
  *
@@ -31,6 +43,7 @@
 class HitFinderTools
 {
 public:
+  static HitFinderHistos getHistos(JPetStatistics& stats, HistoRegistry* registry = nullptr);
   static void sortByTime(std::vector<JPetPhysSignal>& signals);
   static std::map<int, std::vector<JPetPhysSignal>> getSignalsBySlot(
     const JPetTimeWindow* timeWindow, bool useCorrupts
@@ -38,17 +51,17 @@ public:
   static std::vector<JPetHit> matchAllSignals(
     std::map<int, std::vector<JPetPhysSignal>>& allSignals,
     const std::map<unsigned int, std::vector<double>>& velocitiesMap,
-    double timeDiffAB, int refDetScinId, JPetStatistics& stats, bool saveHistos
+    double timeDiffAB, int refDetScinId, const HitFinderHistos& histos
   );
   static std::vector<JPetHit> matchSignals(
     std::vector<JPetPhysSignal>& slotSignals,
     const std::map<unsigned int, std::vector<double>>& velocitiesMap,
-    double timeDiffAB, JPetStatistics& stats, bool saveHistos
+    double timeDiffAB, const HitFinderHistos& histos
   );
   static JPetHit createHit(
     const JPetPhysSignal& signal1, const JPetPhysSignal& signal2,
     const std::map<unsigned int, std::vector<double>>& velocitiesMap,
-    JPetStatistics& stats, bool saveHistos
+    const HitFinderHistos& histos
   );
   static JPetHit createDummyRefDetHit(const JPetPhysSignal& signal);
   static int getProperChannel(const JPetPhysSignal& signal);
@@ -137,15 +137,14 @@ BOOST_AUTO_TEST_CASE(matchAllSignals_test_refDetID)
   std::map<int, std::vector<JPetPhysSignal>> allSignals;
   allSignals.insert(std::make_pair(1, slotSignals));
   allSignals.insert(std::make_pair(193, refSignals));
-  JPetStatistics stats;
   std::map<unsigned int, std::vector<double>> velocitiesMap;
 
   auto result1 = HitFinderTools::matchAllSignals(
-    allSignals, velocitiesMap, 5.0, 193, stats, false
+    allSignals, velocitiesMap, 5.0, 193, HitFinderHistos()
   );
 
   auto result2 = HitFinderTools::matchAllSignals(
-    allSignals, velocitiesMap, 5.0, 1, stats, false
+    allSignals, velocitiesMap, 5.0, 1, HitFinderHistos()
   );
 
   BOOST_REQUIRE_EQUAL(result1.size(), 2);
@@ -174,9 +173,8 @@ BOOST_AUTO_TEST_CASE(matchSignals_test_sameSide)
   slotSignals.push_back(physSig1);
   slotSignals.push_back(physSig2);
   slotSignals.push_back(physSig3);
-  JPetStatistics stats;
   std::map<unsigned int, std::vector<double>> velocitiesMap;
-  auto result = HitFinderTools::matchSignals(slotSignals, velocitiesMap, 5.0, stats, false);
+  auto result = HitFinderTools::matchSignals(slotSignals, velocitiesMap, 5.0, HitFinderHistos());
   BOOST_REQUIRE(result.empty());
 }
 
@@ -270,12 +268,11 @@ BOOST_AUTO_TEST_CASE(matchSignals_test)
   slotSignals.push_back(physSig3A);
   slotSignals.push_back(physSig3B);
 
-  JPetStatistics stats;
   std::map<unsigned int, std::vector<double>> velocitiesMap;
   std::vector<double> velVec = {2.0, 3.4, 4.5, 5.6};
   velocitiesMap.insert(std::make_pair(66, velVec));
   velocitiesMap.insert(std::make_pair(88, velVec));
-  auto result = HitFinderTools::matchSignals(slotSignals, velocitiesMap, 1.0, stats, false);
+  auto result = HitFinderTools::matchSignals(slotSignals, velocitiesMap, 1.0, HitFinderHistos());
   auto epsilon = 0.0001;
 
   BOOST_REQUIRE_EQUAL(result.size(), 3);
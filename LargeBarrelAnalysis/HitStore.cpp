@@ -0,0 +1,451 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file HitStore.cpp
+ */
+
+#include <JPetTimeWindow/JPetTimeWindow.h>
+#include <JPetParamBank/JPetParamBank.h>
+#include "JPetLoggerInclude.h"
+#include <JPetHit/JPetHit.h>
+#include "HitStore.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cstring>
+#include <cstdio>
+#include <limits>
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+const char kHitStoreMagic[8] = {'J', 'P', 'E', 'T', 'H', 'I', 'T', 'S'};
+const uint32_t kHitStoreVersion = 1;
+const uint32_t kHitStoreByteOrder = 0x01020304;
+const size_t kColumnWidths[kNumberOfHitStoreColumns] = {
+  sizeof(double), sizeof(float), sizeof(float), sizeof(float), sizeof(float), sizeof(float),
+  sizeof(int32_t), sizeof(int32_t), sizeof(int32_t), sizeof(int32_t), sizeof(uint8_t),
+  sizeof(float) * 16
+};
+const uint8_t kHasSignalA = 1 << 6;
+const uint8_t kHasSignalB = 1 << 7;
+
+uint64_t alignOffset(uint64_t offset)
+{
+  return (offset + 7) & ~uint64_t(7);
+}
+
+uint8_t encodeFlag(JPetHit::RecoFlag flag)
+{
+  if (flag == JPetHit::Good) return 1;
+  if (flag == JPetHit::Corrupted) return 2;
+  return 0;
+}
+
+uint8_t encodeFlag(JPetBaseSignal::RecoFlag flag)
+{
+  if (flag == JPetBaseSignal::Good) return 1;
+  if (flag == JPetBaseSignal::Corrupted) return 2;
+  return 0;
+}
+
+JPetHit::RecoFlag decodeHitFlag(uint8_t flags)
+{
+  if ((flags & 3) == 1) return JPetHit::Good;
+  if ((flags & 3) == 2) return JPetHit::Corrupted;
+  return JPetHit::Unknown;
+}
+
+JPetBaseSignal::RecoFlag decodeSignalFlag(uint8_t flags)
+{
+  if ((flags & 3) == 1) return JPetBaseSignal::Good;
+  if ((flags & 3) == 2) return JPetBaseSignal::Corrupted;
+  return JPetBaseSignal::Unknown;
+}
+
+/**
+ * Times on thresholds of the signal, returning its TOT summed over
+ * the thresholds as in HitFinderTools::calculateTOT
+ */
+double fillThresholdTimes(const JPetPhysSignal& signal, double hitTime, float times[2][4])
+{
+  const auto& rawSignal = signal.getRecoSignal().getRawSignal();
+  auto leads = rawSignal.getPoints(JPetSigCh::Leading, JPetRawSignal::ByThrNum);
+  auto trails = rawSignal.getPoints(JPetSigCh::Trailing, JPetRawSignal::ByThrNum);
+  for (int edge = 0; edge < 2; edge++) {
+    for (const auto& sigCh : edge == 0 ? leads : trails) {
+      int thr = sigCh.getThresholdNumber();
+      if (thr < 1 || thr > 4) continue;
+      times[edge][thr - 1] = sigCh.getValue() - hitTime;
+    }
+  }
+  double tot = 0.0;
+  for (unsigned i = 0; i < leads.size() && i < trails.size(); i++) {
+    tot += trails.at(i).getValue() - leads.at(i).getValue();
+  }
+  return tot;
+}
+
+/**
+ * Signal of one side, recreated from the times on thresholds as
+ * in SignalTransformer, with the time of the lowest threshold
+ */
+JPetPhysSignal createSignal(
+  const JPetPM& pm, const JPetBarrelSlot& slot, double hitTime, double signalTime,
+  const float times[2][4], JPetBaseSignal::RecoFlag flag
+) {
+  JPetRawSignal rawSignal;
+  rawSignal.setPM(pm);
+  rawSignal.setBarrelSlot(slot);
+  rawSignal.setRecoFlag(flag);
+  for (int edge = 0; edge < 2; edge++) {
+    for (int thr = 0; thr < 4; thr++) {
+      if (std::isnan(times[edge][thr])) continue;
+      JPetSigCh sigCh;
+      sigCh.setType(edge == 0 ? JPetSigCh::Leading : JPetSigCh::Trailing);
+      sigCh.setThresholdNumber(thr + 1);
+      sigCh.setValue(hitTime + times[edge][thr]);
+      sigCh.setPM(pm);
+      rawSignal.addPoint(sigCh);
+    }
+  }
+  JPetRecoSignal recoSignal;
+  recoSignal.setRawSignal(rawSignal);
+  recoSignal.setAmplitude(-1.0);
+  recoSignal.setOffset(-1.0);
+  recoSignal.setCharge(-1.0);
+  recoSignal.setDelay(-1.0);
+  recoSignal.setRecoFlag(flag);
+  JPetPhysSignal physSignal;
+  physSignal.setRecoSignal(recoSignal);
+  physSignal.setPhe(-1.0);
+  physSignal.setQualityOfPhe(0.0);
+  physSignal.setQualityOfTime(0.0);
+  physSignal.setRecoFlag(flag);
+  physSignal.setTime(signalTime);
+  return physSignal;
+}
+}
+
+HitRecord::HitRecord()
+{
+  for (auto& side : thresholdTimes) {
+    for (auto& edge : side) {
+      for (auto& time : edge) time = numeric_limits<float>::quiet_NaN();
+    }
+  }
+}
+
+HitStoreWriter::HitStoreWriter() {}
+
+HitStoreWriter::~HitStoreWriter()
+{
+  if (isOpen()) close();
+}
+
+string HitStoreWriter::getColumnFileName(int column) const
+{
+  return fFileName + ".column" + to_string(column);
+}
+
+bool HitStoreWriter::open(const string& fileName)
+{
+  if (isOpen()) close();
+  fFileName = fileName;
+  fWindowIndex.assign(1, 0);
+  fNumberOfHits = 0;
+  for (int column = 0; column < kNumberOfHitStoreColumns; column++) {
+    fColumnFiles[column].reset(new ofstream(getColumnFileName(column), ios::binary | ios::trunc));
+    if (!fColumnFiles[column]->is_open()) {
+      ERROR(Form("Unable to open temporary file %s of the hit store", getColumnFileName(column).c_str()));
+      for (int opened = 0; opened <= column; opened++) {
+        fColumnFiles[opened].reset();
+        remove(getColumnFileName(opened).c_str());
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+bool HitStoreWriter::isOpen() const
+{
+  return static_cast<bool>(fColumnFiles[0]);
+}
+
+void HitStoreWriter::addHit(const HitRecord& hit)
+{
+  const void* values[kNumberOfHitStoreColumns] = {
+    &hit.time, &hit.timeDiff, &hit.posX, &hit.posY, &hit.posZ, &hit.tot,
+    &hit.scinID, &hit.slotID, &hit.pmAID, &hit.pmBID, &hit.flags, hit.thresholdTimes
+  };
+  for (int column = 0; column < kNumberOfHitStoreColumns; column++) {
+    fColumnFiles[column]->write(static_cast<const char*>(values[column]), kColumnWidths[column]);
+  }
+  fNumberOfHits++;
+}
+
+void HitStoreWriter::endWindow()
+{
+  fWindowIndex.push_back(fNumberOfHits);
+}
+
+uint64_t HitStoreWriter::getNumberOfWindows() const
+{
+  return fWindowIndex.empty() ? 0 : fWindowIndex.size() - 1;
+}
+
+uint64_t HitStoreWriter::getNumberOfHits() const
+{
+  return fNumberOfHits;
+}
+
+/**
+ * Joining the header, the index of windows and the temporary column files
+ * into the store file. Temporary files are removed in any case.
+ */
+bool HitStoreWriter::close()
+{
+  if (!isOpen()) return false;
+  bool result = true;
+  for (auto& columnFile : fColumnFiles) {
+    columnFile->close();
+    if (columnFile->fail()) result = false;
+    columnFile.reset();
+  }
+  if (!result) {
+    ERROR(Form("Writing of temporary files of the hit store %s failed", fFileName.c_str()));
+  }
+  HitStoreHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kHitStoreMagic, sizeof(header.magic));
+  header.version = kHitStoreVersion;
+  header.byteOrder = kHitStoreByteOrder;
+  header.numberOfWindows = getNumberOfWindows();
+  header.numberOfHits = fNumberOfHits;
+  header.windowIndexOffset = alignOffset(sizeof(header));
+  uint64_t offset = alignOffset(header.windowIndexOffset + fWindowIndex.size() * sizeof(uint64_t));
+  for (int column = 0; column < kNumberOfHitStoreColumns; column++) {
+    header.columnOffsets[column] = offset;
+    offset = alignOffset(offset + kColumnWidths[column] * fNumberOfHits);
+  }
+  ofstream store(fFileName, ios::binary | ios::trunc);
+  if (!store.is_open()) {
+    ERROR(Form("Unable to open file %s for the hit store", fFileName.c_str()));
+    result = false;
+  }
+  const char padding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  auto writePadding = [&store, &padding] (uint64_t position) {
+    store.write(padding, position - store.tellp());
+  };
+  if (result) {
+    store.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writePadding(header.windowIndexOffset);
+    store.write(reinterpret_cast<const char*>(fWindowIndex.data()), fWindowIndex.size() * sizeof(uint64_t));
+    vector<char> buffer(1 << 20);
+    for (int column = 0; column < kNumberOfHitStoreColumns; column++) {
+      writePadding(header.columnOffsets[column]);
+      ifstream columnFile(getColumnFileName(column), ios::binary);
+      while (columnFile.read(buffer.data(), buffer.size()) || columnFile.gcount() > 0) {
+        store.write(buffer.data(), columnFile.gcount());
+      }
+    }
+    writePadding(offset);
+    store.close();
+    if (store.fail()) {
+      ERROR(Form("Writing of the hit store %s failed", fFileName.c_str()));
+      result = false;
+    }
+  }
+  for (int column = 0; column < kNumberOfHitStoreColumns; column++) {
+    remove(getColumnFileName(column).c_str());
+  }
+  return result;
+}
+
+/**
+ * Record of the hit with the times on thresholds of both its signals
+ */
+HitRecord HitStoreWriter::toRecord(const JPetHit& hit)
+{
+  HitRecord record;
+  record.time = hit.getTime();
+  record.timeDiff = hit.getTimeDiff();
+  record.posX = hit.getPosX();
+  record.posY = hit.getPosY();
+  record.posZ = hit.getPosZ();
+  record.scinID = hit.getScintillator().getID();
+  record.slotID = hit.getBarrelSlot().getID();
+  record.flags = encodeFlag(hit.getRecoFlag());
+  if (hit.isSignalASet()) {
+    record.pmAID = hit.getSignalA().getPM().getID();
+    record.flags |= kHasSignalA | (encodeFlag(hit.getSignalA().getRecoFlag()) << 2);
+    record.tot += fillThresholdTimes(hit.getSignalA(), hit.getTime(), record.thresholdTimes[0]);
+  }
+  if (hit.isSignalBSet()) {
+    record.pmBID = hit.getSignalB().getPM().getID();
+    record.flags |= kHasSignalB | (encodeFlag(hit.getSignalB().getRecoFlag()) << 4);
+    record.tot += fillThresholdTimes(hit.getSignalB(), hit.getTime(), record.thresholdTimes[1]);
+  }
+  return record;
+}
+
+HitStoreReader::HitStoreReader() {}
+
+HitStoreReader::~HitStoreReader()
+{
+  close();
+}
+
+/**
+ * Mapping the store into memory and checking that the header
+ * and all the columns fit in the file
+ */
+bool HitStoreReader::open(const string& fileName)
+{
+  close();
+  int descriptor = ::open(fileName.c_str(), O_RDONLY);
+  if (descriptor < 0) {
+    ERROR(Form("Unable to open the hit store %s", fileName.c_str()));
+    return false;
+  }
+  struct stat status;
+  if (fstat(descriptor, &status) != 0 || status.st_size < (off_t) sizeof(HitStoreHeader)) {
+    ERROR(Form("File %s is too short for the hit store", fileName.c_str()));
+    ::close(descriptor);
+    return false;
+  }
+  void* data = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+  ::close(descriptor);
+  if (data == MAP_FAILED) {
+    ERROR(Form("Unable to map the hit store %s into memory", fileName.c_str()));
+    return false;
+  }
+  madvise(data, status.st_size, MADV_SEQUENTIAL);
+  fData = static_cast<const char*>(data);
+  fSize = status.st_size;
+  fHeader = reinterpret_cast<const HitStoreHeader*>(fData);
+  bool valid = memcmp(fHeader->magic, kHitStoreMagic, sizeof(kHitStoreMagic)) == 0
+    && fHeader->version == kHitStoreVersion && fHeader->byteOrder == kHitStoreByteOrder
+    && fHeader->windowIndexOffset + (fHeader->numberOfWindows + 1) * sizeof(uint64_t) <= fSize;
+  for (int column = 0; column < kNumberOfHitStoreColumns && valid; column++) {
+    valid = fHeader->columnOffsets[column] % 8 == 0
+      && fHeader->columnOffsets[column] + kColumnWidths[column] * fHeader->numberOfHits <= fSize;
+  }
+  if (!valid) {
+    ERROR(Form("File %s is not a valid hit store of version %u", fileName.c_str(), kHitStoreVersion));
+    close();
+    return false;
+  }
+  fWindowIndex = reinterpret_cast<const uint64_t*>(fData + fHeader->windowIndexOffset);
+  INFO(Form("Hit store %s opened, %lu windows with %lu hits", fileName.c_str(),
+    (unsigned long) fHeader->numberOfWindows, (unsigned long) fHeader->numberOfHits));
+  return true;
+}
+
+void HitStoreReader::close()
+{
+  if (fData) munmap(const_cast<char*>(fData), fSize);
+  fData = nullptr;
+  fSize = 0;
+  fHeader = nullptr;
+  fWindowIndex = nullptr;
+}
+
+bool HitStoreReader::isOpen() const
+{
+  return fData != nullptr;
+}
+
+uint64_t HitStoreReader::getNumberOfWindows() const
+{
+  return fHeader ? fHeader->numberOfWindows : 0;
+}
+
+uint64_t HitStoreReader::getNumberOfHits() const
+{
+  return fHeader ? fHeader->numberOfHits : 0;
+}
+
+/**
+ * Index of the first hit of the window, for the window after the last one
+ * it is the number of all hits
+ */
+uint64_t HitStoreReader::getFirstHit(uint64_t window) const
+{
+  return fWindowIndex[window < getNumberOfWindows() ? window : getNumberOfWindows()];
+}
+
+const void* HitStoreReader::getColumn(HitStoreColumn column) const
+{
+  return fData + fHeader->columnOffsets[column];
+}
+
+HitRecord HitStoreReader::getRecord(uint64_t hit) const
+{
+  HitRecord record;
+  void* values[kNumberOfHitStoreColumns] = {
+    &record.time, &record.timeDiff, &record.posX, &record.posY, &record.posZ, &record.tot,
+    &record.scinID, &record.slotID, &record.pmAID, &record.pmBID, &record.flags, record.thresholdTimes
+  };
+  for (int column = 0; column < kNumberOfHitStoreColumns; column++) {
+    memcpy(values[column], fData + fHeader->columnOffsets[column] + hit * kColumnWidths[column], kColumnWidths[column]);
+  }
+  return record;
+}
+
+/**
+ * Adapter for the tasks using hits: JPetHit objects of the window are added
+ * to the output, with scintillators, slots and photomultipliers taken from
+ * the param bank and with signals holding the times on thresholds.
+ * Energy and qualities are not kept in the store and are set to -1,
+ * as done by HitFinder.
+ */
+bool HitStoreReader::fillTimeWindow(uint64_t window, JPetTimeWindow& output, const JPetParamBank& paramBank) const
+{
+  if (!isOpen() || window >= getNumberOfWindows()) return false;
+  for (uint64_t index = getFirstHit(window); index < getFirstHit(window + 1); index++) {
+    auto record = getRecord(index);
+    auto& slot = paramBank.getBarrelSlot(record.slotID);
+    JPetHit hit;
+    if (record.flags & kHasSignalA) {
+      hit.setSignalA(createSignal(
+        paramBank.getPM(record.pmAID), slot, record.time, record.time - record.timeDiff / 2.0,
+        record.thresholdTimes[0], decodeSignalFlag(record.flags >> 2)
+      ));
+    }
+    if (record.flags & kHasSignalB) {
+      // Reference detector hits have only the signal on side B and no time difference
+      hit.setSignalB(createSignal(
+        paramBank.getPM(record.pmBID), slot, record.time, record.time + record.timeDiff / 2.0,
+        record.thresholdTimes[1], decodeSignalFlag(record.flags >> 4)
+      ));
+    }
+    hit.setTime(record.time);
+    hit.setQualityOfTime(-1.0);
+    hit.setTimeDiff(record.timeDiff);
+    hit.setQualityOfTimeDiff(-1.0);
+    hit.setEnergy(-1.0);
+    hit.setQualityOfEnergy(-1.0);
+    hit.setScintillator(paramBank.getScintillator(record.scinID));
+    hit.setBarrelSlot(slot);
+    hit.setPosX(record.posX);
+    hit.setPosY(record.posY);
+    hit.setPosZ(record.posZ);
+    hit.setRecoFlag(decodeHitFlag(record.flags));
+    output.add<JPetHit>(hit);
+  }
+  return true;
+}
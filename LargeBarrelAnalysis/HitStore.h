@@ -0,0 +1,147 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file HitStore.h
+ */
+
+#ifndef HITSTORE_H
+#define HITSTORE_H
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+class JPetTimeWindow;
+class JPetParamBank;
+class JPetHit;
+
+/**
+ * @brief Columns of the hit store, each one is an array of fixed width values
+ */
+enum HitStoreColumn {
+  kHitTime, kHitTimeDiff, kHitPosX, kHitPosY, kHitPosZ, kHitTOT,
+  kHitScinID, kHitSlotID, kHitPMAID, kHitPMBID, kHitFlags, kHitThresholdTimes,
+  kNumberOfHitStoreColumns
+};
+
+/**
+ * @brief One hit in the row form, as it is written to and read from the store
+ *
+ * Times of the signal channels are given relative to the time of the hit,
+ * indexed by side (A, B), edge (leading, trailing) and threshold number - 1,
+ * with NaN for missing ones. Flags hold the reco flags of the hit and its
+ * signals, 2 bits each, and the bit marking hits with the signal on side A.
+ */
+struct HitRecord {
+  double time = 0.0;
+  float timeDiff = 0.0;
+  float posX = 0.0;
+  float posY = 0.0;
+  float posZ = 0.0;
+  float tot = 0.0;
+  int32_t scinID = 0;
+  int32_t slotID = 0;
+  int32_t pmAID = 0;
+  int32_t pmBID = 0;
+  uint8_t flags = 0;
+  float thresholdTimes[2][2][4];
+  HitRecord();
+};
+
+/**
+ * @brief Header at the beginning of the hit store file
+ *
+ * Header is followed by the index of windows, numberOfWindows + 1 entries
+ * with the number of the first hit of each window, and by the columns,
+ * each starting at the offset given in the header, aligned to 8 bytes.
+ */
+struct HitStoreHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint64_t numberOfWindows;
+  uint64_t numberOfHits;
+  uint64_t windowIndexOffset;
+  uint64_t columnOffsets[kNumberOfHitStoreColumns];
+};
+
+/**
+ * @brief Writer of the columnar binary store of hits
+ *
+ * Hits are added window by window. Until the store is closed, each column
+ * is written to its own temporary file, so memory use does not grow with
+ * the number of hits. On close the header, the index of windows and all
+ * columns are joined into the final file.
+ */
+class HitStoreWriter
+{
+public:
+  HitStoreWriter();
+  ~HitStoreWriter();
+  bool open(const std::string& fileName);
+  void addHit(const HitRecord& hit);
+  void endWindow();
+  bool close();
+  bool isOpen() const;
+  uint64_t getNumberOfWindows() const;
+  uint64_t getNumberOfHits() const;
+  static HitRecord toRecord(const JPetHit& hit);
+
+private:
+  HitStoreWriter(const HitStoreWriter&);
+  void operator=(const HitStoreWriter&);
+  std::string getColumnFileName(int column) const;
+  std::string fFileName;
+  std::unique_ptr<std::ofstream> fColumnFiles[kNumberOfHitStoreColumns];
+  std::vector<uint64_t> fWindowIndex;
+  uint64_t fNumberOfHits = 0;
+};
+
+/**
+ * @brief Reader of the hit store, mapping the whole file into memory
+ *
+ * Columns are used in place, with no parsing, as arrays of numberOfHits
+ * values. Hits of the window are the ones from getFirstHit(window) to
+ * getFirstHit(window + 1). The adapter fillTimeWindow() creates JPetHit
+ * objects of the window, with their signals, for the tasks using hits.
+ */
+class HitStoreReader
+{
+public:
+  HitStoreReader();
+  ~HitStoreReader();
+  bool open(const std::string& fileName);
+  void close();
+  bool isOpen() const;
+  uint64_t getNumberOfWindows() const;
+  uint64_t getNumberOfHits() const;
+  uint64_t getFirstHit(uint64_t window) const;
+  const void* getColumn(HitStoreColumn column) const;
+  const double* getTimes() const { return static_cast<const double*>(getColumn(kHitTime)); }
+  const float* getPosZ() const { return static_cast<const float*>(getColumn(kHitPosZ)); }
+  const int32_t* getScinIDs() const { return static_cast<const int32_t*>(getColumn(kHitScinID)); }
+  const uint8_t* getFlags() const { return static_cast<const uint8_t*>(getColumn(kHitFlags)); }
+  HitRecord getRecord(uint64_t hit) const;
+  bool fillTimeWindow(uint64_t window, JPetTimeWindow& output, const JPetParamBank& paramBank) const;
+
+private:
+  HitStoreReader(const HitStoreReader&);
+  void operator=(const HitStoreReader&);
+  const char* fData = nullptr;
+  size_t fSize = 0;
+  const HitStoreHeader* fHeader = nullptr;
+  const uint64_t* fWindowIndex = nullptr;
+};
+
+#endif /* !HITSTORE_H */
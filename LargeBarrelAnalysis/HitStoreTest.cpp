@@ -0,0 +1,192 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file HitStoreTest.cpp
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE HitStoreTest
+
+#include <boost/test/unit_test.hpp>
+#include "WindowIndex.h"
+#include "HitStore.h"
+#include <fstream>
+#include <cstdio>
+#include <cmath>
+
+HitRecord getTestRecord(int number)
+{
+  HitRecord record;
+  record.time = -1.0e6 + 1000.0 * number;
+  record.timeDiff = 10.0 * number;
+  record.posX = 1.0 * number;
+  record.posY = -1.0 * number;
+  record.posZ = 0.5 * number;
+  record.tot = 100.0 * number;
+  record.scinID = number % 192 + 1;
+  record.slotID = number % 192 + 1;
+  record.pmAID = 2 * number + 1;
+  record.pmBID = 2 * number + 2;
+  record.flags = number % 3;
+  record.thresholdTimes[0][0][0] = -5.0;
+  record.thresholdTimes[1][1][3] = 7.0 + number;
+  return record;
+}
+
+BOOST_AUTO_TEST_SUITE(HitStoreTestSuite)
+
+BOOST_AUTO_TEST_CASE(writeRead_test)
+{
+  const std::string fileName = "HitStoreTest_writeRead.hits.store";
+  // Windows with 3, 0 and 2 hits
+  std::vector<int> hitsInWindows = {3, 0, 2};
+  HitStoreWriter writer;
+  BOOST_REQUIRE(writer.open(fileName));
+  int number = 0;
+  for (auto hits : hitsInWindows) {
+    for (int i = 0; i < hits; i++) writer.addHit(getTestRecord(number++));
+    writer.endWindow();
+  }
+  BOOST_REQUIRE(writer.close());
+  BOOST_REQUIRE(!writer.isOpen());
+  // Temporary column files are removed
+  BOOST_REQUIRE(!std::ifstream(fileName + ".column0").good());
+
+  HitStoreReader reader;
+  BOOST_REQUIRE(reader.open(fileName));
+  BOOST_REQUIRE_EQUAL(reader.getNumberOfWindows(), 3u);
+  BOOST_REQUIRE_EQUAL(reader.getNumberOfHits(), 5u);
+  BOOST_REQUIRE_EQUAL(reader.getFirstHit(0), 0u);
+  BOOST_REQUIRE_EQUAL(reader.getFirstHit(1), 3u);
+  BOOST_REQUIRE_EQUAL(reader.getFirstHit(2), 3u);
+  BOOST_REQUIRE_EQUAL(reader.getFirstHit(3), 5u);
+  for (int hit = 0; hit < 5; hit++) {
+    auto expected = getTestRecord(hit);
+    auto record = reader.getRecord(hit);
+    BOOST_REQUIRE_EQUAL(record.time, expected.time);
+    BOOST_REQUIRE_EQUAL(reader.getTimes()[hit], expected.time);
+    BOOST_REQUIRE_EQUAL(record.timeDiff, expected.timeDiff);
+    BOOST_REQUIRE_EQUAL(record.posX, expected.posX);
+    BOOST_REQUIRE_EQUAL(record.posY, expected.posY);
+    BOOST_REQUIRE_EQUAL(record.posZ, expected.posZ);
+    BOOST_REQUIRE_EQUAL(reader.getPosZ()[hit], expected.posZ);
+    BOOST_REQUIRE_EQUAL(record.tot, expected.tot);
+    BOOST_REQUIRE_EQUAL(record.scinID, expected.scinID);
+    BOOST_REQUIRE_EQUAL(reader.getScinIDs()[hit], expected.scinID);
+    BOOST_REQUIRE_EQUAL(record.slotID, expected.slotID);
+    BOOST_REQUIRE_EQUAL(record.pmAID, expected.pmAID);
+    BOOST_REQUIRE_EQUAL(record.pmBID, expected.pmBID);
+    BOOST_REQUIRE_EQUAL(reader.getFlags()[hit], expected.flags);
+    BOOST_REQUIRE_EQUAL(record.thresholdTimes[0][0][0], -5.0);
+    BOOST_REQUIRE_EQUAL(record.thresholdTimes[1][1][3], 7.0 + hit);
+    BOOST_REQUIRE(std::isnan(record.thresholdTimes[0][1][2]));
+  }
+  // Columns are aligned for the direct use of the mapped memory
+  for (int column = 0; column < kNumberOfHitStoreColumns; column++) {
+    auto address = reinterpret_cast<uintptr_t>(reader.getColumn(static_cast<HitStoreColumn>(column)));
+    BOOST_REQUIRE_EQUAL(address % 8, 0u);
+  }
+  reader.close();
+  std::remove(fileName.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(emptyStore_test)
+{
+  const std::string fileName = "HitStoreTest_empty.hits.store";
+  HitStoreWriter writer;
+  BOOST_REQUIRE(writer.open(fileName));
+  writer.endWindow();
+  BOOST_REQUIRE(writer.close());
+  HitStoreReader reader;
+  BOOST_REQUIRE(reader.open(fileName));
+  BOOST_REQUIRE_EQUAL(reader.getNumberOfWindows(), 1u);
+  BOOST_REQUIRE_EQUAL(reader.getNumberOfHits(), 0u);
+  BOOST_REQUIRE_EQUAL(reader.getFirstHit(1), 0u);
+  reader.close();
+  std::remove(fileName.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(invalidFile_test)
+{
+  const std::string fileName = "HitStoreTest_invalid.hits.store";
+  HitStoreReader reader;
+  BOOST_REQUIRE(!reader.open("HitStoreTest_missing.hits.store"));
+  // Long enough to hold the header, but with no magic
+  std::ofstream(fileName) << std::string(1000, 'x');
+  BOOST_REQUIRE(!reader.open(fileName));
+  BOOST_REQUIRE(!reader.isOpen());
+  // Truncated store, with columns reaching beyond the end of the file
+  HitStoreWriter writer;
+  BOOST_REQUIRE(writer.open(fileName));
+  for (int i = 0; i < 10; i++) writer.addHit(getTestRecord(i));
+  writer.endWindow();
+  BOOST_REQUIRE(writer.close());
+  std::ifstream input(fileName, std::ios::binary);
+  std::string content((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+  std::ofstream(fileName, std::ios::binary | std::ios::trunc) << content.substr(0, content.size() - 100);
+  BOOST_REQUIRE(!reader.open(fileName));
+  std::remove(fileName.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(windowRange_test)
+{
+  const std::string fileName = "HitStoreTest_windowRange.hits.store";
+  std::map<std::string, boost::any> options;
+  options[WindowIndexer::kWindowLengthParamKey] = 1000.0;
+  options[WindowIndexer::kFirstWindowParamKey] = 3;
+  options[WindowIndexer::kLastWindowParamKey] = 5;
+
+  // Hit Finder run on windows 0-7, with one hit of the time of its window
+  // in each window of the range, the others are skipped by the wrapper
+  WindowIndexer hitFinderWrapper;
+  hitFinderWrapper.configure(options);
+  WindowIndexer hitFinderWindows;
+  hitFinderWindows.follow(options, &hitFinderWrapper);
+  HitStoreWriter writer;
+  BOOST_REQUIRE(writer.open(fileName));
+  for (int entry = 0; entry < 8; entry++) {
+    if (!hitFinderWrapper.beginWindow()) continue;
+    auto window = hitFinderWindows.nextProcessedWindow().window;
+    while (writer.getNumberOfWindows() < hitFinderWindows.getOutputEntry()) writer.endWindow();
+    HitRecord hit;
+    hit.time = window;
+    writer.addHit(hit);
+    writer.endWindow();
+  }
+  BOOST_REQUIRE(writer.close());
+
+  // Event Finder run on entries 2-6 of the hits file, with the same range
+  options["firstEvent_int"] = 2;
+  WindowIndexer eventFinderWrapper;
+  eventFinderWrapper.configure(options);
+  WindowIndexer eventFinderWindows;
+  eventFinderWindows.follow(options, &eventFinderWrapper);
+  HitStoreReader reader;
+  BOOST_REQUIRE(reader.open(fileName));
+  BOOST_REQUIRE_EQUAL(reader.getNumberOfWindows(), 6u);
+  std::vector<double> times;
+  for (int entry = 2; entry <= 6; entry++) {
+    if (!eventFinderWrapper.beginWindow()) continue;
+    eventFinderWindows.nextProcessedWindow();
+    auto storeWindow = eventFinderWindows.getInputEntry();
+    BOOST_REQUIRE_EQUAL(reader.getFirstHit(storeWindow + 1) - reader.getFirstHit(storeWindow), 1u);
+    times.push_back(reader.getRecord(reader.getFirstHit(storeWindow)).time);
+  }
+  BOOST_REQUIRE_EQUAL(times.size(), 3u);
+  BOOST_REQUIRE_EQUAL(times[0], 3.0);
+  BOOST_REQUIRE_EQUAL(times[1], 4.0);
+  BOOST_REQUIRE_EQUAL(times[2], 5.0);
+  reader.close();
+  std::remove(fileName.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,106 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file InstrumentedTask.h
+ */
+
+#ifndef INSTRUMENTEDTASK_H
+#define INSTRUMENTEDTASK_H
+
+#include <JPetTimeWindow/JPetTimeWindow.h>
+#include "TaskProfiler.h"
+#include "WindowIndex.h"
+#include "Tracing.h"
+
+#ifdef __CINT__
+#define override
+#endif
+
+/**
+ * @brief User Task wrapper, measuring init, exec and terminate of the task
+ *
+ * Registered in place of the task, e.g.
+ * manager.registerTask<InstrumentedTask<HitFinder>>("HitFinder");
+ * Objects are counted in input and output time windows, other inputs
+ * (e.g. EventIII of the unpacker) are counted as one object.
+ * If tracing is enabled, each call is also recorded as a span of the timeline,
+ * and the timeline is saved at the end of the task.
+ * The wrapper also keeps the index of windows of the output file and skips
+ * windows out of the slice of the run selected with WindowRange_* options,
+ * unless it is created with no indexing, e.g. for the stages of a task
+ * that is itself wrapped.
+ */
+template <class Task>
+class InstrumentedTask: public Task
+{
+public:
+  InstrumentedTask(const char* name, bool indexed = true):
+    Task(name), fProfiler(name), fTraceName(Tracer::internName(name)), fIndexed(indexed) {}
+
+  virtual bool init() override
+  {
+    fProfiler.configure(this->fParams.getOptions());
+    if (fIndexed) fIndexer.configure(this->fParams.getOptions());
+    Tracer::configure(this->fParams.getOptions());
+    TraceSpan span(fTraceName, "init");
+    auto follower = dynamic_cast<WindowFollower*>(static_cast<Task*>(this));
+    if (fIndexed && follower) follower->setWindowWrapper(&fIndexer);
+    if (!fProfiler.isEnabled()) return Task::init();
+    fProfiler.beginInit();
+    bool result = Task::init();
+    fProfiler.endInit();
+    return result;
+  }
+
+  virtual bool exec() override
+  {
+    TraceSpan span(fTraceName, "task");
+    if (fIndexer.isEnabled() && !fIndexer.beginWindow()) {
+      fIndexer.endWindow(0);
+      return true;
+    }
+    if (!fProfiler.isEnabled() && !fIndexer.isEnabled()) return Task::exec();
+    unsigned long objectsIn = 1;
+    if (auto timeWindow = dynamic_cast<const JPetTimeWindow*>(this->fEvent)) {
+      objectsIn = timeWindow->getNumberOfEvents();
+    }
+    unsigned long objectsOutBefore = this->fOutputEvents ? this->fOutputEvents->getNumberOfEvents() : 0;
+    if (fProfiler.isEnabled()) fProfiler.beginWindow();
+    bool result = Task::exec();
+    unsigned long objectsOut = this->fOutputEvents ? this->fOutputEvents->getNumberOfEvents() : 0;
+    if (fProfiler.isEnabled()) fProfiler.endWindow(objectsIn, objectsOut - objectsOutBefore);
+    if (fIndexer.isEnabled()) fIndexer.endWindow(objectsOut - objectsOutBefore);
+    return result;
+  }
+
+  virtual bool terminate() override
+  {
+    bool result = true;
+    {
+      TraceSpan span(fTraceName, "terminate");
+      if (fProfiler.isEnabled()) fProfiler.beginTerminate();
+      result = Task::terminate();
+      if (fProfiler.isEnabled()) fProfiler.endTerminate();
+    }
+    if (!fIndexer.close()) result = false;
+    if (Tracer::isEnabled()) Tracer::dumpConfigured();
+    return result;
+  }
+
+protected:
+  TaskProfiler fProfiler;
+  WindowIndexer fIndexer;
+  const char* fTraceName;
+  bool fIndexed;
+};
+
+#endif /* !INSTRUMENTEDTASK_H */
@@ -0,0 +1,184 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file ParallelFitter.cpp
+ */
+
+#include <JPetOptionsTools/JPetOptionsTools.h>
+#include <Math/MinimizerOptions.h>
+#include "JPetLoggerInclude.h"
+#include "ParallelFitter.h"
+#include <TROOT.h>
+#include <TList.h>
+#include <TF1.h>
+#include <TH1F.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+using namespace jpet_options_tools;
+using namespace std;
+
+const string ParallelFitter::kThreadsParamKey = "ParallelFit_Threads_int";
+
+/// Number of failed fits listed by name in the summary
+static const size_t kMaxListedFailures = 20;
+
+ParallelFitter::ParallelFitter(unsigned threads, PeakEstimator::Method method): fMethod(method)
+{
+  fThreads = threads > 0 ? threads : max(1u, thread::hardware_concurrency());
+}
+
+/**
+ * Adding the fit, returns index of its result
+ */
+size_t ParallelFitter::add(TH1F* histogram, double rangeMin, double rangeMax, const string& label)
+{
+  FitJob job;
+  job.histogram = histogram;
+  job.rangeMin = rangeMin;
+  job.rangeMax = rangeMax;
+  job.label = label;
+  fJobs.push_back(job);
+  return fJobs.size() - 1;
+}
+
+/**
+ * Fitting all added histograms. Functions are created and the thread safety of ROOT
+ * is set up before the threads are started. The default minimizer is not thread
+ * safe, so Minuit2 is used while the threads run and the default is restored after.
+ */
+void ParallelFitter::run()
+{
+  unsigned threads = min<size_t>(fThreads, max<size_t>(fJobs.size(), 1));
+  vector<unique_ptr<TF1>> functions;
+  for (unsigned i = 0; i < threads; i++) {
+    functions.emplace_back(new TF1("gaus", "gaus", 0.0, 1.0, TF1::EAddToList::kNo));
+  }
+  if (threads == 1) {
+    for (auto& job : fJobs) fit(job, *functions[0]);
+    attachEstimates();
+    return;
+  }
+  ROOT::EnableThreadSafety();
+  string minimizerType = ROOT::Math::MinimizerOptions::DefaultMinimizerType();
+  string minimizerAlgorithm = ROOT::Math::MinimizerOptions::DefaultMinimizerAlgo();
+  ROOT::Math::MinimizerOptions::SetDefaultMinimizer("Minuit2");
+  atomic<size_t> next(0);
+  vector<thread> workers;
+  for (unsigned i = 0; i < threads; i++) {
+    TF1* function = functions[i].get();
+    workers.emplace_back([this, &next, function]() {
+      for (size_t job = next++; job < fJobs.size(); job = next++) fit(fJobs[job], *function);
+    });
+  }
+  for (auto& worker : workers) worker.join();
+  ROOT::Math::MinimizerOptions::SetDefaultMinimizer(minimizerType.c_str(), minimizerAlgorithm.c_str());
+  attachEstimates();
+}
+
+size_t ParallelFitter::getNumberOfFailures() const
+{
+  return count_if(fJobs.begin(), fJobs.end(), [](const FitJob& job) { return !job.succeeded; });
+}
+
+/**
+ * One line with the number of fits, and one warning listing the failed ones
+ */
+void ParallelFitter::reportFailures(const string& taskName) const
+{
+  size_t failures = getNumberOfFailures();
+  INFO(Form("%s: %lu histograms %s with %u threads, %lu fits failed", taskName.c_str(),
+    (unsigned long) fJobs.size(), fMethod == PeakEstimator::kMoments || fMethod == PeakEstimator::kLogParabola ?
+    "estimated" : "fitted", fThreads, (unsigned long) failures));
+  if (failures == 0) return;
+  string listed;
+  size_t count = 0;
+  for (const auto& job : fJobs) {
+    if (job.succeeded) continue;
+    if (count++ == kMaxListedFailures) {
+      listed += " ...";
+      break;
+    }
+    listed += " " + job.label + (job.histogram && job.histogram->GetEntries() == 0 ?
+      "(empty)" : Form("(status %d)", job.status));
+  }
+  WARNING(Form("%s: %lu of %lu fits failed:%s", taskName.c_str(),
+    (unsigned long) failures, (unsigned long) fJobs.size(), listed.c_str()));
+}
+
+unsigned ParallelFitter::getNumberOfThreads(const map<string, boost::any>& options)
+{
+  if (isOptionSet(options, kThreadsParamKey)) {
+    return max(0, getOptionAsInt(options, kThreadsParamKey));
+  }
+  return 0;
+}
+
+/**
+ * Initial parameters of "gaus" are estimated by ROOT for each histogram,
+ * so the function of the thread can be reused for all its jobs. Seeded fits
+ * set the initial parameters from the estimate, option B keeps them.
+ */
+void ParallelFitter::fit(FitJob& job, TF1& function) const
+{
+  if (!job.histogram || job.histogram->GetEntries() == 0) return;
+  PeakEstimate estimate = PeakEstimator::estimate(fMethod, *job.histogram, job.rangeMin, job.rangeMax);
+  if (fMethod == PeakEstimator::kMoments || fMethod == PeakEstimator::kLogParabola) {
+    job.status = estimate.valid ? 0 : -1;
+    job.constant = estimate.constant;
+    job.position = estimate.position;
+    job.positionError = estimate.positionError;
+    job.sigma = estimate.sigma;
+    job.chi2 = estimate.chi2;
+    job.ndf = estimate.ndf;
+    job.succeeded = estimate.valid && job.ndf > 0;
+    return;
+  }
+  function.SetRange(job.rangeMin, job.rangeMax);
+  const char* option = "Q";
+  if (fMethod == PeakEstimator::kSeededFit && estimate.valid) {
+    function.SetParameters(estimate.constant, estimate.position, estimate.sigma);
+    option = "QB";
+  }
+  job.status = job.histogram->Fit(&function, option, "", job.rangeMin, job.rangeMax);
+  job.constant = function.GetParameter(0);
+  job.position = function.GetParameter(1);
+  job.positionError = function.GetParError(1);
+  job.sigma = function.GetParameter(2);
+  job.chi2 = function.GetChisquare();
+  job.ndf = function.GetNDF();
+  job.succeeded = job.status == 0 && job.ndf > 0;
+}
+
+/**
+ * Gaussians of the analytic estimates are attached to the histograms in
+ * the calling thread, as the fitted function would be
+ */
+void ParallelFitter::attachEstimates()
+{
+  if (fMethod != PeakEstimator::kMoments && fMethod != PeakEstimator::kLogParabola) return;
+  for (const auto& job : fJobs) {
+    if (!job.succeeded) continue;
+    if (auto previous = job.histogram->GetFunction("gaus")) {
+      job.histogram->GetListOfFunctions()->Remove(previous);
+      delete previous;
+    }
+    auto function = new TF1("gaus", "gaus", job.rangeMin, job.rangeMax, TF1::EAddToList::kNo);
+    function->SetParameters(job.constant, job.position, job.sigma);
+    function->SetParError(1, job.positionError);
+    function->SetChisquare(job.chi2);
+    function->SetNDF(job.ndf);
+    job.histogram->GetListOfFunctions()->Add(function);
+  }
+}
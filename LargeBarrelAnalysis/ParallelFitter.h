@@ -0,0 +1,87 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file ParallelFitter.h
+ */
+
+#ifndef PARALLELFITTER_H
+#define PARALLELFITTER_H
+
+#include <boost/any.hpp>
+#include "PeakEstimator.h"
+#include <string>
+#include <vector>
+#include <map>
+
+class TH1F;
+class TF1;
+
+/**
+ * @brief Gaussian fit of a histogram in a range, with its result
+ *
+ * Fit failed if the histogram is missing or empty, the fit status is not zero
+ * or there are no degrees of freedom. Label is used in the summary of failures.
+ */
+struct FitJob {
+  TH1F* histogram = nullptr;
+  double rangeMin = 0.0;
+  double rangeMax = 0.0;
+  std::string label;
+  bool succeeded = false;
+  int status = -1;
+  double constant = 0.0;
+  double position = 0.0;
+  double positionError = 0.0;
+  double sigma = 0.0;
+  double chi2 = 0.0;
+  int ndf = 0;
+};
+
+/**
+ * @brief Gaussian fits of many histograms run concurrently
+ *
+ * Calibration tasks add all fits of terminate() as jobs, run them at once
+ * and then write the results in their own order, taking them by the index
+ * returned by add(). Each thread fits with its own TF1 named "gaus",
+ * a copy of it is attached to the histogram as by TH1::Fit("gaus").
+ * Number of threads is given with ParallelFit_Threads_int, by default
+ * one for each core; with one thread fits are done in the calling thread.
+ * Fits are quiet, failed ones are listed in a single warning by reportFailures().
+ * With an analytic method of PeakEstimator the peaks are estimated with no fit,
+ * the estimated Gaussian is attached to the histogram instead; with the seeded
+ * method the fit starts from the estimate.
+ */
+class ParallelFitter
+{
+public:
+  explicit ParallelFitter(unsigned threads = 0, PeakEstimator::Method method = PeakEstimator::kFit);
+  size_t add(TH1F* histogram, double rangeMin, double rangeMax, const std::string& label);
+  void run();
+  const FitJob& operator[](size_t job) const { return fJobs[job]; }
+  size_t size() const { return fJobs.size(); }
+  unsigned getNumberOfThreads() const { return fThreads; }
+  PeakEstimator::Method getMethod() const { return fMethod; }
+  size_t getNumberOfFailures() const;
+  void reportFailures(const std::string& taskName) const;
+  static unsigned getNumberOfThreads(const std::map<std::string, boost::any>& options);
+
+  static const std::string kThreadsParamKey;
+
+private:
+  void fit(FitJob& job, TF1& function) const;
+  void attachEstimates();
+  std::vector<FitJob> fJobs;
+  unsigned fThreads = 1;
+  PeakEstimator::Method fMethod = PeakEstimator::kFit;
+};
+
+#endif /* !PARALLELFITTER_H */
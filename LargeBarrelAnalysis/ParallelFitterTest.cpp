@@ -0,0 +1,98 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file ParallelFitterTest.cpp
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE ParallelFitterTest
+
+#include <boost/test/unit_test.hpp>
+#include "ParallelFitter.h"
+#include <TString.h>
+#include <TH1F.h>
+#include <TF1.h>
+#include <memory>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(ParallelFitterTestSuite)
+
+BOOST_AUTO_TEST_CASE(getNumberOfThreads_test)
+{
+  std::map<std::string, boost::any> options;
+  BOOST_REQUIRE_EQUAL(ParallelFitter::getNumberOfThreads(options), 0u);
+  options[ParallelFitter::kThreadsParamKey] = 3;
+  BOOST_REQUIRE_EQUAL(ParallelFitter::getNumberOfThreads(options), 3u);
+  BOOST_REQUIRE_EQUAL(ParallelFitter(3).getNumberOfThreads(), 3u);
+  BOOST_REQUIRE(ParallelFitter(0).getNumberOfThreads() >= 1u);
+}
+
+BOOST_AUTO_TEST_CASE(sequential_and_parallel_test)
+{
+  std::vector<std::unique_ptr<TH1F>> histograms;
+  std::mt19937 generator(2018);
+  for (int i = 0; i < 40; i++) {
+    histograms.emplace_back(new TH1F(Form("ParallelFitterTest_%d", i), "", 200, -10., 10.));
+    histograms.back()->SetDirectory(nullptr);
+    std::normal_distribution<double> gauss(0.1 * i - 2.0, 0.5);
+    // every tenth histogram is left empty
+    if (i % 10 == 5) continue;
+    for (int entry = 0; entry < 5000; entry++) histograms.back()->Fill(gauss(generator));
+  }
+  ParallelFitter sequential(1), parallel(4);
+  for (auto& histogram : histograms) {
+    double highestBin = histogram->GetBinCenter(histogram->GetMaximumBin());
+    sequential.add(histogram.get(), highestBin - 1.0, highestBin + 1.0, histogram->GetName());
+    parallel.add(histogram.get(), highestBin - 1.0, highestBin + 1.0, histogram->GetName());
+  }
+  sequential.run();
+  parallel.run();
+  BOOST_REQUIRE_EQUAL(parallel.size(), histograms.size());
+  BOOST_REQUIRE_EQUAL(parallel.getNumberOfFailures(), 4u);
+  for (size_t i = 0; i < histograms.size(); i++) {
+    BOOST_REQUIRE_EQUAL(parallel[i].histogram, histograms[i].get());
+    BOOST_REQUIRE_EQUAL(parallel[i].succeeded, i % 10 != 5);
+    BOOST_REQUIRE_EQUAL(sequential[i].succeeded, parallel[i].succeeded);
+    if (!parallel[i].succeeded) continue;
+    BOOST_REQUIRE_SMALL(parallel[i].position - (0.1 * i - 2.0), 0.05);
+    // minimizers of the sequential and parallel fits may differ slightly
+    BOOST_REQUIRE_SMALL(parallel[i].position - sequential[i].position, 1.0e-3);
+    BOOST_REQUIRE(parallel[i].positionError > 0.0);
+    BOOST_REQUIRE(histograms[i]->GetFunction("gaus"));
+  }
+  parallel.reportFailures("ParallelFitterTest");
+}
+
+BOOST_AUTO_TEST_CASE(analytic_test)
+{
+  TH1F histogram("ParallelFitterTest_analytic", "", 400, -20., 20.);
+  histogram.SetDirectory(nullptr);
+  std::mt19937 generator(2019);
+  std::normal_distribution<double> gauss(1.5, 0.8);
+  for (int entry = 0; entry < 10000; entry++) histogram.Fill(gauss(generator));
+  for (auto method : {PeakEstimator::kMoments, PeakEstimator::kLogParabola, PeakEstimator::kSeededFit}) {
+    ParallelFitter fitter(2, method);
+    BOOST_REQUIRE_EQUAL(fitter.getMethod(), method);
+    fitter.add(&histogram, -3.5, 6.5, histogram.GetName());
+    fitter.run();
+    BOOST_REQUIRE(fitter[0].succeeded);
+    BOOST_REQUIRE_SMALL(fitter[0].position - 1.5, 0.05);
+    BOOST_REQUIRE(fitter[0].positionError > 0.0);
+    // estimated Gaussian is attached as the fitted one
+    TF1* function = histogram.GetFunction("gaus");
+    BOOST_REQUIRE(function);
+    BOOST_REQUIRE_CLOSE(function->GetParameter(1), fitter[0].position, 1.0e-6);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
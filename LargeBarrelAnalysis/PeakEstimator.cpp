@@ -0,0 +1,239 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file PeakEstimator.cpp
+ */
+
+#include <JPetOptionsTools/JPetOptionsTools.h>
+#include "JPetLoggerInclude.h"
+#include "PeakEstimator.h"
+#include <algorithm>
+#include <cmath>
+#include <TH1.h>
+
+using namespace jpet_options_tools;
+using namespace std;
+
+const string PeakEstimator::kMethodParamKey = "PeakEstimation_Method_std::string";
+const double PeakEstimator::kTruncation = 2.5;
+
+namespace
+{
+/// Maximal number of windows of the moments method
+const int kMaxWindows = 10;
+/// Maximal number of steps of the correction for the truncation in a window
+const int kMaxCorrectionSteps = 50;
+/// Maximal ratio of contents of the side and central groups of bins of the parabola
+const double kParabolaRatio = 0.6;
+
+double normalDensity(double x)
+{
+  return exp(-0.5 * x * x) / sqrt(2.0 * M_PI);
+}
+
+double normalDistribution(double x)
+{
+  return 0.5 * erfc(-x / sqrt(2.0));
+}
+}
+
+/**
+ * Moments of the bins in the window of kTruncation sigmas, repeated until
+ * the window does not change. Mean and variance of a Gaussian truncated to the
+ * window [a, b] are mu + sigma * (phi(alpha) - phi(beta)) / Z and
+ * sigma^2 * (1 + (alpha * phi(alpha) - beta * phi(beta)) / Z - ((phi(alpha) - phi(beta)) / Z)^2),
+ * with alpha, beta the edges in sigmas from mu and Z the probability of the window,
+ * they are solved for mu and sigma by iterations starting from the moments.
+ */
+PeakEstimate PeakEstimator::estimateMoments(const TH1& histogram, double rangeMin, double rangeMax)
+{
+  PeakEstimate estimate;
+  int rangeFirst = max(histogram.FindBin(rangeMin), 1);
+  int rangeLast = min(histogram.FindBin(rangeMax), histogram.GetNbinsX());
+  if (rangeLast - rangeFirst < 2) return estimate;
+  const double width = histogram.GetBinWidth(rangeFirst);
+  int first = rangeFirst, last = rangeLast;
+  double mu = 0.0, sigma = 0.0, sum = 0.0, factor = 1.0, observedVariance = 0.0;
+  for (int window = 0; window < kMaxWindows; window++) {
+    double sumX = 0.0, sumX2 = 0.0;
+    sum = 0.0;
+    int filledBins = 0;
+    for (int bin = first; bin <= last; bin++) {
+      double content = histogram.GetBinContent(bin);
+      if (content <= 0.0) continue;
+      double x = histogram.GetBinCenter(bin);
+      sum += content;
+      sumX += content * x;
+      sumX2 += content * x * x;
+      filledBins++;
+    }
+    if (filledBins < 3 || sum < 3.0) return estimate;
+    double mean = sumX / sum;
+    observedVariance = sumX2 / sum - mean * mean - width * width / 12.0;
+    if (observedVariance <= 0.0) return estimate;
+    // Correction for the truncation by the edges of the window
+    double edgeMin = histogram.GetBinCenter(first) - 0.5 * width;
+    double edgeMax = histogram.GetBinCenter(last) + 0.5 * width;
+    mu = mean;
+    sigma = sqrt(observedVariance);
+    factor = 1.0;
+    for (int step = 0; step < kMaxCorrectionSteps; step++) {
+      double alpha = (edgeMin - mu) / sigma;
+      double beta = (edgeMax - mu) / sigma;
+      double probability = normalDistribution(beta) - normalDistribution(alpha);
+      if (probability < 1.0e-3) return estimate;
+      double shift = (normalDensity(alpha) - normalDensity(beta)) / probability;
+      factor = 1.0 + (alpha * normalDensity(alpha) - beta * normalDensity(beta)) / probability - shift * shift;
+      if (factor <= 0.0) return estimate;
+      double newSigma = sqrt(observedVariance / factor);
+      double newMu = mean - newSigma * shift;
+      bool converged = fabs(newSigma - sigma) < 1.0e-6 * sigma && fabs(newMu - mu) < 1.0e-6 * sigma;
+      sigma = newSigma;
+      mu = newMu;
+      if (converged) break;
+    }
+    // Window too narrow to tell the peak from a flat distribution
+    if (sigma > 10.0 * (edgeMax - edgeMin)) return estimate;
+    int newFirst = max(histogram.FindBin(mu - kTruncation * sigma), rangeFirst);
+    int newLast = min(histogram.FindBin(mu + kTruncation * sigma), rangeLast);
+    if (newLast - newFirst < 2) return estimate;
+    if (newFirst == first && newLast == last) break;
+    first = newFirst;
+    last = newLast;
+  }
+  estimate.valid = true;
+  estimate.position = mu;
+  estimate.sigma = sigma;
+  double alpha = (histogram.GetBinCenter(first) - 0.5 * width - mu) / sigma;
+  double beta = (histogram.GetBinCenter(last) + 0.5 * width - mu) / sigma;
+  double probability = normalDistribution(beta) - normalDistribution(alpha);
+  estimate.constant = sum * width / (sigma * sqrt(2.0 * M_PI) * probability);
+  // Derivative of the truncated mean with respect to mu is the variance factor
+  estimate.positionError = sqrt(observedVariance / sum) / factor;
+  computeChi2(histogram, first, last, estimate);
+  return estimate;
+}
+
+/**
+ * Parabola through logarithms of contents of the highest bin in the range
+ * and its neighbours, a, b, c. Vertex is at delta = (a - c) / (2 * D) bins from
+ * the highest bin and sigma^2 = -width^2 / D, with D = a - 2 * b + c.
+ * Bins narrow in comparison with the peak give a curvature hidden in
+ * fluctuations, so groups of an odd number of bins around the highest bin are
+ * used as the three bins, wider until each neighbour has less than
+ * kParabolaRatio of the central group or the groups fill the range.
+ * Logarithms of contents have errors 1 / sqrt(content).
+ * Chi2 is calculated in the whole range.
+ */
+PeakEstimate PeakEstimator::estimateLogParabola(const TH1& histogram, double rangeMin, double rangeMax)
+{
+  PeakEstimate estimate;
+  int rangeFirst = max(histogram.FindBin(rangeMin), 1);
+  int rangeLast = min(histogram.FindBin(rangeMax), histogram.GetNbinsX());
+  if (rangeLast - rangeFirst < 2) return estimate;
+  int highestBin = rangeFirst;
+  for (int bin = rangeFirst + 1; bin <= rangeLast; bin++) {
+    if (histogram.GetBinContent(bin) > histogram.GetBinContent(highestBin)) highestBin = bin;
+  }
+  auto groupContent = [&histogram](int center, int halfWidth) {
+    double content = 0.0;
+    for (int bin = center - halfWidth; bin <= center + halfWidth; bin++) content += histogram.GetBinContent(bin);
+    return content;
+  };
+  double below = 0.0, highest = 0.0, above = 0.0;
+  int group = 0;
+  for (int halfWidth = 0; ; halfWidth++) {
+    int newGroup = 2 * halfWidth + 1;
+    // the widest groups within the range are used
+    if (highestBin - newGroup - halfWidth < rangeFirst || highestBin + newGroup + halfWidth > rangeLast) break;
+    group = newGroup;
+    below = groupContent(highestBin - group, halfWidth);
+    highest = groupContent(highestBin, halfWidth);
+    above = groupContent(highestBin + group, halfWidth);
+    if (below < kParabolaRatio * highest && above < kParabolaRatio * highest) break;
+  }
+  if (group == 0) return estimate;
+  if (below <= 0.0 || above <= 0.0) return estimate;
+  double a = log(below), b = log(highest), c = log(above);
+  double curvature = a - 2.0 * b + c;
+  if (curvature >= 0.0) return estimate;
+  double delta = 0.5 * (a - c) / curvature;
+  double width = group * histogram.GetBinWidth(highestBin);
+  double curvature2 = curvature * curvature;
+  double deltaVariance = pow(c - b, 2) / (curvature2 * curvature2 * below)
+    + pow(a - c, 2) / (curvature2 * curvature2 * highest)
+    + pow(b - a, 2) / (curvature2 * curvature2 * above);
+  estimate.valid = true;
+  estimate.position = histogram.GetBinCenter(highestBin) + delta * width;
+  estimate.positionError = width * sqrt(deltaVariance);
+  // Variance of the Gaussian integrated in groups is larger by width^2 / 12
+  double groupedSigma = sqrt(-width * width / curvature);
+  estimate.sigma = sqrt(max(groupedSigma * groupedSigma - width * width / 12.0, 0.25 * width * width / group));
+  // Vertex of the parabola, per bin, scaled back from the wider grouped peak of the same area
+  estimate.constant = exp(b - 0.125 * (c - a) * (c - a) / curvature) / group * groupedSigma / estimate.sigma;
+  computeChi2(histogram, rangeFirst, rangeLast, estimate);
+  return estimate;
+}
+
+PeakEstimate PeakEstimator::estimate(Method method, const TH1& histogram, double rangeMin, double rangeMax)
+{
+  switch (method) {
+    case kMoments:
+    case kSeededFit:
+      return estimateMoments(histogram, rangeMin, rangeMax);
+    case kLogParabola:
+      return estimateLogParabola(histogram, rangeMin, rangeMax);
+    default:
+      return PeakEstimate();
+  }
+}
+
+bool PeakEstimator::parseMethod(const string& name, Method& method)
+{
+  if (name == "fit") method = kFit;
+  else if (name == "moments") method = kMoments;
+  else if (name == "parabola") method = kLogParabola;
+  else if (name == "seeded") method = kSeededFit;
+  else return false;
+  return true;
+}
+
+PeakEstimator::Method PeakEstimator::getMethod(const map<string, boost::any>& options)
+{
+  Method method = kFit;
+  if (isOptionSet(options, kMethodParamKey)
+    && !parseMethod(getOptionAsString(options, kMethodParamKey), method)) {
+    WARNING("Unknown method of peak estimation " + getOptionAsString(options, kMethodParamKey)
+      + ", Gaussian fits are used");
+  }
+  return method;
+}
+
+/**
+ * Chi2 of the Gaussian with the errors of bins as in the fit,
+ * empty bins are skipped
+ */
+void PeakEstimator::computeChi2(const TH1& histogram, int firstBin, int lastBin, PeakEstimate& estimate)
+{
+  estimate.chi2 = 0.0;
+  int points = 0;
+  for (int bin = firstBin; bin <= lastBin; bin++) {
+    double content = histogram.GetBinContent(bin);
+    if (content <= 0.0) continue;
+    double x = (histogram.GetBinCenter(bin) - estimate.position) / estimate.sigma;
+    double expected = estimate.constant * exp(-0.5 * x * x);
+    double error = histogram.GetBinError(bin);
+    estimate.chi2 += pow(content - expected, 2) / (error * error);
+    points++;
+  }
+  estimate.ndf = points - 3;
+}
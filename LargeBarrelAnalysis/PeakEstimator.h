@@ -0,0 +1,76 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file PeakEstimator.h
+ */
+
+#ifndef PEAKESTIMATOR_H
+#define PEAKESTIMATOR_H
+
+#include <boost/any.hpp>
+#include <string>
+#include <map>
+
+class TH1;
+
+/**
+ * @brief Parameters of a Gaussian peak estimated without a fit
+ *
+ * Same quantities as given by the "gaus" fit: constant, position, sigma,
+ * uncertainty of the position, and chi2 with the number of degrees
+ * of freedom of the Gaussian in the window of bins used.
+ */
+struct PeakEstimate {
+  bool valid = false;
+  double constant = 0.0;
+  double position = 0.0;
+  double positionError = 0.0;
+  double sigma = 0.0;
+  double chi2 = 0.0;
+  int ndf = 0;
+};
+
+/**
+ * @brief Closed form estimators of the position of a Gaussian peak in a histogram
+ *
+ * Moments: mean and variance of the bins in the range, repeated in the window
+ * of kTruncation sigmas around the mean, within the range. Each step is corrected
+ * for the truncation of the Gaussian by the window and for the bin width.
+ * Log-parabola: parabola through logarithms of the highest bin in the range
+ * and its two neighbours, exact for a Gaussian; for narrow bins groups of bins
+ * as wide as about one sigma are used.
+ * Uncertainty of the position follows from Poisson errors of the bins,
+ * comparable with the error of the position from the fit.
+ * Method of calibration tasks is selected with PeakEstimation_Method_std::string:
+ * "fit" (Gaussian fit, default), "moments", "parabola" or "seeded", a fit with
+ * initial parameters from the moments.
+ */
+class PeakEstimator
+{
+public:
+  enum Method {
+    kFit, kMoments, kLogParabola, kSeededFit
+  };
+  static PeakEstimate estimateMoments(const TH1& histogram, double rangeMin, double rangeMax);
+  static PeakEstimate estimateLogParabola(const TH1& histogram, double rangeMin, double rangeMax);
+  static PeakEstimate estimate(Method method, const TH1& histogram, double rangeMin, double rangeMax);
+  static bool parseMethod(const std::string& name, Method& method);
+  static Method getMethod(const std::map<std::string, boost::any>& options);
+
+  static const std::string kMethodParamKey;
+  static const double kTruncation;
+
+private:
+  static void computeChi2(const TH1& histogram, int firstBin, int lastBin, PeakEstimate& estimate);
+};
+
+#endif /* !PEAKESTIMATOR_H */
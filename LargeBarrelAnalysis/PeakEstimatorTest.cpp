@@ -0,0 +1,141 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file PeakEstimatorTest.cpp
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE PeakEstimatorTest
+
+#include <boost/test/unit_test.hpp>
+#include "PeakEstimator.h"
+#include <TH1F.h>
+#include <cmath>
+#include <random>
+
+/// Histogram with a Gaussian peak on a flat background
+void fillPeak(TH1F& histogram, double mean, double sigma, int entries, int background, unsigned seed)
+{
+  histogram.SetDirectory(nullptr);
+  std::mt19937 generator(seed);
+  std::normal_distribution<double> peak(mean, sigma);
+  std::uniform_real_distribution<double> flat(histogram.GetXaxis()->GetXmin(), histogram.GetXaxis()->GetXmax());
+  for (int i = 0; i < entries; i++) histogram.Fill(peak(generator));
+  for (int i = 0; i < background; i++) histogram.Fill(flat(generator));
+}
+
+BOOST_AUTO_TEST_SUITE(PeakEstimatorTestSuite)
+
+BOOST_AUTO_TEST_CASE(parseMethod_test)
+{
+  PeakEstimator::Method method = PeakEstimator::kFit;
+  BOOST_REQUIRE(PeakEstimator::parseMethod("moments", method));
+  BOOST_REQUIRE_EQUAL(method, PeakEstimator::kMoments);
+  BOOST_REQUIRE(PeakEstimator::parseMethod("parabola", method));
+  BOOST_REQUIRE_EQUAL(method, PeakEstimator::kLogParabola);
+  BOOST_REQUIRE(PeakEstimator::parseMethod("seeded", method));
+  BOOST_REQUIRE_EQUAL(method, PeakEstimator::kSeededFit);
+  BOOST_REQUIRE(PeakEstimator::parseMethod("fit", method));
+  BOOST_REQUIRE_EQUAL(method, PeakEstimator::kFit);
+  BOOST_REQUIRE(!PeakEstimator::parseMethod("gaus", method));
+  std::map<std::string, boost::any> options;
+  BOOST_REQUIRE_EQUAL(PeakEstimator::getMethod(options), PeakEstimator::kFit);
+  options[PeakEstimator::kMethodParamKey] = std::string("moments");
+  BOOST_REQUIRE_EQUAL(PeakEstimator::getMethod(options), PeakEstimator::kMoments);
+}
+
+BOOST_AUTO_TEST_CASE(wideRange_test)
+{
+  TH1F histogram("PeakEstimatorTest_wide", "", 400, -20.0, 20.0);
+  fillPeak(histogram, 1.234, 0.8, 5000, 500, 1);
+  double highestBin = histogram.GetBinCenter(histogram.GetMaximumBin());
+  // statistical uncertainty of the position is about 0.8 / sqrt(5000) = 0.011
+  auto moments = PeakEstimator::estimateMoments(histogram, highestBin - 5.0, highestBin + 5.0);
+  BOOST_REQUIRE(moments.valid);
+  BOOST_REQUIRE_SMALL(moments.position - 1.234, 0.05);
+  BOOST_REQUIRE_SMALL(moments.sigma - 0.8, 0.05);
+  BOOST_REQUIRE(moments.positionError > 0.008 && moments.positionError < 0.02);
+  BOOST_REQUIRE(moments.ndf > 0);
+  auto parabola = PeakEstimator::estimateLogParabola(histogram, highestBin - 5.0, highestBin + 5.0);
+  BOOST_REQUIRE(parabola.valid);
+  BOOST_REQUIRE_SMALL(parabola.position - 1.234, 0.06);
+  BOOST_REQUIRE_SMALL(parabola.sigma - 0.8, 0.1);
+  BOOST_REQUIRE(parabola.positionError > 0.008 && parabola.positionError < 0.03);
+}
+
+BOOST_AUTO_TEST_CASE(narrowRange_test)
+{
+  // range of 2 sigma around the highest bin, as in InterThresholdCalibration
+  TH1F histogram("PeakEstimatorTest_narrow", "", 200, -2.0, 2.0);
+  fillPeak(histogram, 0.1234, 0.1, 5000, 500, 2);
+  double highestBin = histogram.GetBinCenter(histogram.GetMaximumBin());
+  auto moments = PeakEstimator::estimateMoments(histogram, highestBin - 0.2, highestBin + 0.2);
+  BOOST_REQUIRE(moments.valid);
+  BOOST_REQUIRE_SMALL(moments.position - 0.1234, 0.007);
+  BOOST_REQUIRE_SMALL(moments.sigma - 0.1, 0.01);
+  auto parabola = PeakEstimator::estimateLogParabola(histogram, highestBin - 0.2, highestBin + 0.2);
+  BOOST_REQUIRE(parabola.valid);
+  BOOST_REQUIRE_SMALL(parabola.position - 0.1234, 0.008);
+}
+
+/// Histogram with exact contents of a Gaussian peak integrated in bins
+void fillExactPeak(TH1F& histogram, double mean, double sigma, double entries)
+{
+  histogram.SetDirectory(nullptr);
+  for (int bin = 1; bin <= histogram.GetNbinsX(); bin++) {
+    double low = histogram.GetBinLowEdge(bin), high = low + histogram.GetBinWidth(bin);
+    histogram.SetBinContent(bin, 0.5 * entries * (std::erf((high - mean) / (sigma * std::sqrt(2.0)))
+      - std::erf((low - mean) / (sigma * std::sqrt(2.0)))));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(offCentrePeak_test)
+{
+  // Means 0.4 bin off the centre of a bin, peaks wide and narrow in comparison with bins
+  const double entries = 1.e5, binWidth = 0.02, mean = 0.018;
+  for (double sigma : {0.1, 0.014}) {
+    TH1F histogram("PeakEstimatorTest_offCentre", "", 200, -2.0, 2.0);
+    fillExactPeak(histogram, mean, sigma, entries);
+    double constant = entries * binWidth / (std::sqrt(2.0 * M_PI) * sigma);
+    auto moments = PeakEstimator::estimateMoments(histogram, mean - 3.0 * sigma, mean + 3.0 * sigma);
+    auto parabola = PeakEstimator::estimateLogParabola(histogram, mean - 3.0 * sigma, mean + 3.0 * sigma);
+    for (const auto& estimate : {moments, parabola}) {
+      BOOST_REQUIRE(estimate.valid);
+      BOOST_REQUIRE_SMALL(estimate.position - mean, 0.1 * binWidth);
+      BOOST_REQUIRE_CLOSE(estimate.constant, constant, 3.0);
+      BOOST_REQUIRE(estimate.ndf > 0);
+    }
+    if (sigma > binWidth) {
+      BOOST_REQUIRE(moments.chi2 / moments.ndf < 1.0);
+      BOOST_REQUIRE(parabola.chi2 / parabola.ndf < 1.0);
+    } else {
+      // Bin centres of a narrow peak are far from its integrals, the parabola is not worse than moments
+      BOOST_REQUIRE(parabola.chi2 / parabola.ndf < moments.chi2 / moments.ndf);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(invalid_test)
+{
+  TH1F empty("PeakEstimatorTest_empty", "", 100, -5.0, 5.0);
+  empty.SetDirectory(nullptr);
+  BOOST_REQUIRE(!PeakEstimator::estimateMoments(empty, -1.0, 1.0).valid);
+  BOOST_REQUIRE(!PeakEstimator::estimateLogParabola(empty, -1.0, 1.0).valid);
+  TH1F single("PeakEstimatorTest_single", "", 100, -5.0, 5.0);
+  single.SetDirectory(nullptr);
+  single.Fill(0.05, 100.0);
+  BOOST_REQUIRE(!PeakEstimator::estimateMoments(single, -1.0, 1.0).valid);
+  BOOST_REQUIRE(!PeakEstimator::estimateLogParabola(single, -1.0, 1.0).valid);
+  BOOST_REQUIRE(!PeakEstimator::estimate(PeakEstimator::kFit, single, -1.0, 1.0).valid);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,192 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file ShardedRun.cpp
+ */
+
+#include <JPetOptionsTools/JPetOptionsTools.h>
+#include <JPetCommonTools/JPetCommonTools.h>
+#include <JPetStatistics/JPetStatistics.h>
+#include "JPetLoggerInclude.h"
+#include "WindowIndex.h"
+#include "ShardedRun.h"
+#include <TFileMerger.h>
+#include <TDirectory.h>
+#include <TClass.h>
+#include <TFile.h>
+#include <TKey.h>
+#include <TH1.h>
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <set>
+
+using namespace jpet_options_tools;
+using namespace std;
+
+const string ShardedRun::kDeferFitParamKey = "Sharding_DeferFit_bool";
+const string ShardedRun::kMergedDirectoryParamKey = "Sharding_MergedDirectory_std::string";
+
+namespace
+{
+/**
+ * Adding histograms from the directory and its subdirectories to the histograms
+ * of the same names in the statistics, each name is taken only once
+ */
+void addHistograms(TDirectory* directory, JPetStatistics& statistics, set<string>& added)
+{
+  TIter next(directory->GetListOfKeys());
+  while (auto key = static_cast<TKey*>(next())) {
+    auto keyClass = TClass::GetClass(key->GetClassName());
+    if (!keyClass) continue;
+    if (keyClass->InheritsFrom(TDirectory::Class())) {
+      if (auto subdirectory = dynamic_cast<TDirectory*>(key->ReadObj())) {
+        addHistograms(subdirectory, statistics, added);
+      }
+      continue;
+    }
+    if (!keyClass->InheritsFrom(TH1::Class())) continue;
+    auto target = statistics.getObject<TH1>(key->GetName());
+    if (!target) continue;
+    if (added.count(key->GetName())) {
+      WARNING(Form("Histogram %s found more than once in the merged file, the first one is used", key->GetName()));
+      continue;
+    }
+    unique_ptr<TH1> histogram(dynamic_cast<TH1*>(key->ReadObj()));
+    if (!histogram) continue;
+    target->Add(histogram.get());
+    added.insert(key->GetName());
+  }
+}
+}
+
+/**
+ * Splitting the inclusive range of windows into at most the given number
+ * of consecutive ranges of equal length, longer by one for the first ones
+ */
+vector<pair<long, long>> ShardedRun::splitWindows(long firstWindow, long lastWindow, int shards)
+{
+  vector<pair<long, long>> ranges;
+  if (lastWindow < firstWindow || shards < 1) return ranges;
+  long windows = lastWindow - firstWindow + 1;
+  if (shards > windows) shards = windows;
+  long first = firstWindow;
+  for (int shard = 0; shard < shards; shard++) {
+    long length = windows / shards + (shard < windows % shards ? 1 : 0);
+    ranges.push_back(make_pair(first, first + length - 1));
+    first += length;
+  }
+  return ranges;
+}
+
+/**
+ * Narrowing the inclusive range of entries of the input to the windows of the slice.
+ * The range is found in the index of the input, if it exists, otherwise numbers
+ * of windows are the numbers of entries and the time range is left to the tasks.
+ * Returns false if no entries are left.
+ */
+bool ShardedRun::selectEntries(const string& input, const WindowRange& range, long& firstEntry, long& lastEntry)
+{
+  if (!range.isSet()) return firstEntry <= lastEntry;
+  WindowIndex index;
+  auto indexFile = WindowIndex::getFileName(input);
+  if (ifstream(indexFile).good() && index.load(indexFile)) {
+    long first = 0, last = 0;
+    if (!index.findEntryRange(range, first, last)) return false;
+    firstEntry = max(firstEntry, first);
+    lastEntry = min(lastEntry, last);
+  } else {
+    if (range.firstWindow >= 0) firstEntry = max(firstEntry, range.firstWindow);
+    if (range.lastWindow >= 0) lastEntry = min(lastEntry, range.lastWindow);
+  }
+  return firstEntry <= lastEntry;
+}
+
+/**
+ * Trees of the inputs are concatenated in the given order, histograms are
+ * summed, other objects (e.g. the parameter bank) are taken from the first input
+ */
+bool ShardedRun::mergeFiles(const vector<string>& inputs, const string& output)
+{
+  TFileMerger merger(false);
+  if (!merger.OutputFile(output.c_str(), "RECREATE")) {
+    ERROR(Form("Unable to open the merged file %s", output.c_str()));
+    return false;
+  }
+  for (const auto& input : inputs) {
+    if (!merger.AddFile(input.c_str(), false)) {
+      ERROR(Form("Unable to add file %s to the merged file %s", input.c_str(), output.c_str()));
+      return false;
+    }
+  }
+  if (!merger.Merge()) {
+    ERROR(Form("Merging of files into %s failed", output.c_str()));
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Entries of each index are moved by the number of entries of the previous ones,
+ * as their trees follow one another in the merged file
+ */
+bool ShardedRun::mergeIndexes(const vector<string>& inputs, const string& output)
+{
+  WindowIndex merged;
+  uint64_t offset = 0;
+  for (const auto& input : inputs) {
+    WindowIndex index;
+    if (!index.load(input)) return false;
+    if (merged.size() == 0) merged.setWindowLength(index.getWindowLength());
+    for (size_t i = 0; i < index.size(); i++) {
+      WindowIndexEntry entry = index[i];
+      entry.entry += offset;
+      merged.add(entry);
+    }
+    offset += index.size();
+  }
+  return merged.save(output);
+}
+
+bool ShardedRun::isFitDeferred(const map<string, boost::any>& options)
+{
+  return isOptionSet(options, kDeferFitParamKey) && getOptionAsBool(options, kDeferFitParamKey);
+}
+
+bool ShardedRun::hasMergedStatistics(const map<string, boost::any>& options)
+{
+  return isOptionSet(options, kMergedDirectoryParamKey)
+    && !getOptionAsString(options, kMergedDirectoryParamKey).empty();
+}
+
+/**
+ * Histograms of the task, already created in the statistics, are filled
+ * with the contents of the merged output file of the same name
+ */
+bool ShardedRun::loadMergedStatistics(const map<string, boost::any>& options, JPetStatistics& statistics)
+{
+  string fileName = getOptionAsString(options, kMergedDirectoryParamKey) + "/"
+    + JPetCommonTools::extractFileNameFromFullPath(getOutputFile(options));
+  unique_ptr<TFile> file(TFile::Open(fileName.c_str(), "READ"));
+  if (!file || file->IsZombie()) {
+    ERROR(Form("Unable to open the merged file %s", fileName.c_str()));
+    return false;
+  }
+  set<string> added;
+  addHistograms(file.get(), statistics, added);
+  if (added.empty()) {
+    ERROR(Form("No histograms of the task found in the merged file %s", fileName.c_str()));
+    return false;
+  }
+  INFO(Form("%lu histograms loaded from the merged file %s", (unsigned long) added.size(), fileName.c_str()));
+  return true;
+}
@@ -0,0 +1,60 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file ShardedRun.h
+ */
+
+#ifndef SHARDEDRUN_H
+#define SHARDEDRUN_H
+
+#include <boost/any.hpp>
+#include <utility>
+#include <string>
+#include <vector>
+#include <map>
+
+class JPetStatistics;
+struct WindowRange;
+
+/**
+ * @brief Tools for the run split into shards, processed by separate processes
+ *
+ * Each shard is a range of windows of the same input, processed with
+ * -r first last into its own directory. Outputs of the shards are then
+ * merged: trees are concatenated in the order of the shards, so in the order
+ * of windows, histograms of the statistics are summed and indexes of windows
+ * are joined with renumbered entries.
+ * Calibration tasks do not fit their histograms in the shards if
+ * Sharding_DeferFit_bool is set. The fits are done in a separate run of
+ * the task, that reads the summed histograms from the merged output file
+ * of the same name in the directory given with Sharding_MergedDirectory_std::string,
+ * and skips all windows of its input.
+ * A slice of the run selected with WindowRange_* options is turned into
+ * the range of entries of the input before the run, so that windows out
+ * of the slice are not read at all.
+ */
+class ShardedRun
+{
+public:
+  static std::vector<std::pair<long, long>> splitWindows(long firstWindow, long lastWindow, int shards);
+  static bool selectEntries(const std::string& input, const WindowRange& range, long& firstEntry, long& lastEntry);
+  static bool mergeFiles(const std::vector<std::string>& inputs, const std::string& output);
+  static bool mergeIndexes(const std::vector<std::string>& inputs, const std::string& output);
+  static bool isFitDeferred(const std::map<std::string, boost::any>& options);
+  static bool hasMergedStatistics(const std::map<std::string, boost::any>& options);
+  static bool loadMergedStatistics(const std::map<std::string, boost::any>& options, JPetStatistics& statistics);
+
+  static const std::string kDeferFitParamKey;
+  static const std::string kMergedDirectoryParamKey;
+};
+
+#endif /* !SHARDEDRUN_H */
@@ -0,0 +1,142 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file ShardedRunTest.cpp
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE ShardedRunTest
+
+#include <boost/test/unit_test.hpp>
+#include "WindowIndex.h"
+#include "ShardedRun.h"
+#include <cstdio>
+
+BOOST_AUTO_TEST_SUITE(ShardedRunTestSuite)
+
+BOOST_AUTO_TEST_CASE(splitWindows_test)
+{
+  auto ranges = ShardedRun::splitWindows(10, 19, 3);
+  BOOST_REQUIRE_EQUAL(ranges.size(), 3u);
+  BOOST_REQUIRE_EQUAL(ranges[0].first, 10);
+  BOOST_REQUIRE_EQUAL(ranges[0].second, 13);
+  BOOST_REQUIRE_EQUAL(ranges[1].first, 14);
+  BOOST_REQUIRE_EQUAL(ranges[1].second, 16);
+  BOOST_REQUIRE_EQUAL(ranges[2].first, 17);
+  BOOST_REQUIRE_EQUAL(ranges[2].second, 19);
+
+  // No empty shards
+  ranges = ShardedRun::splitWindows(0, 1, 4);
+  BOOST_REQUIRE_EQUAL(ranges.size(), 2u);
+  BOOST_REQUIRE_EQUAL(ranges[1].first, 1);
+  BOOST_REQUIRE_EQUAL(ranges[1].second, 1);
+
+  BOOST_REQUIRE(ShardedRun::splitWindows(5, 4, 2).empty());
+  BOOST_REQUIRE(ShardedRun::splitWindows(0, 4, 0).empty());
+}
+
+BOOST_AUTO_TEST_CASE(mergeIndexes_test)
+{
+  std::vector<std::string> fileNames = {"ShardedRunTest_0.index", "ShardedRunTest_1.index"};
+  for (int shard = 0; shard < 2; shard++) {
+    WindowIndex index;
+    index.setWindowLength(1000.0);
+    for (int i = 0; i < 3; i++) {
+      WindowIndexEntry entry;
+      entry.window = shard * 3 + i;
+      entry.startTime = entry.window * 1000.0;
+      entry.entry = i;
+      entry.objects = 1;
+      index.add(entry);
+    }
+    BOOST_REQUIRE(index.save(fileNames[shard]));
+  }
+  const std::string mergedName = "ShardedRunTest_merged.index";
+  BOOST_REQUIRE(ShardedRun::mergeIndexes(fileNames, mergedName));
+  WindowIndex merged;
+  BOOST_REQUIRE(merged.load(mergedName));
+  BOOST_REQUIRE_EQUAL(merged.size(), 6u);
+  BOOST_REQUIRE_EQUAL(merged.getWindowLength(), 1000.0);
+  for (size_t i = 0; i < merged.size(); i++) {
+    BOOST_REQUIRE_EQUAL(merged[i].window, i);
+    BOOST_REQUIRE_EQUAL(merged[i].entry, i);
+  }
+  WindowRange range;
+  range.firstWindow = 4;
+  long first = -1, last = -1;
+  BOOST_REQUIRE(merged.findEntryRange(range, first, last));
+  BOOST_REQUIRE_EQUAL(first, 4);
+  BOOST_REQUIRE_EQUAL(last, 5);
+
+  fileNames.push_back("ShardedRunTest_missing.index");
+  BOOST_REQUIRE(!ShardedRun::mergeIndexes(fileNames, mergedName));
+  std::remove(fileNames[0].c_str());
+  std::remove(fileNames[1].c_str());
+  std::remove(mergedName.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(selectEntries_test)
+{
+  const std::string input = "ShardedRunTest_select.hits.root";
+  const std::string indexName = "ShardedRunTest_select.hits.index";
+  std::remove(indexName.c_str());
+
+  // No index, numbers of windows are numbers of entries
+  WindowRange range;
+  long first = 0, last = 99;
+  BOOST_REQUIRE(ShardedRun::selectEntries(input, range, first, last));
+  BOOST_REQUIRE_EQUAL(first, 0);
+  BOOST_REQUIRE_EQUAL(last, 99);
+  range.firstWindow = 10;
+  range.lastWindow = 200;
+  BOOST_REQUIRE(ShardedRun::selectEntries(input, range, first, last));
+  BOOST_REQUIRE_EQUAL(first, 10);
+  BOOST_REQUIRE_EQUAL(last, 99);
+
+  // Input of a part of the run, starting at window 100
+  WindowIndex index;
+  index.setWindowLength(1000.0);
+  for (int i = 0; i < 50; i++) {
+    WindowIndexEntry entry;
+    entry.window = 100 + i;
+    entry.startTime = entry.window * 1000.0;
+    entry.entry = i;
+    index.add(entry);
+  }
+  BOOST_REQUIRE(index.save(indexName));
+  range = WindowRange();
+  range.hasTimeRange = true;
+  range.startTime = 120000.0;
+  range.endTime = 129500.0;
+  first = 0;
+  last = 49;
+  BOOST_REQUIRE(ShardedRun::selectEntries(input, range, first, last));
+  BOOST_REQUIRE_EQUAL(first, 20);
+  BOOST_REQUIRE_EQUAL(last, 29);
+
+  // Range given with -r is narrowed, not widened
+  first = 25;
+  last = 49;
+  BOOST_REQUIRE(ShardedRun::selectEntries(input, range, first, last));
+  BOOST_REQUIRE_EQUAL(first, 25);
+  BOOST_REQUIRE_EQUAL(last, 29);
+
+  range = WindowRange();
+  range.firstWindow = 10;
+  range.lastWindow = 20;
+  first = 0;
+  last = 49;
+  BOOST_REQUIRE(!ShardedRun::selectEntries(input, range, first, last));
+  std::remove(indexName.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
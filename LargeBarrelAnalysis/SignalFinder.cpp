@@ -20,6 +20,7 @@ using namespace std;
 #include <JPetWriter/JPetWriter.h>
 #include "SignalFinderTools.h"
 #include "SignalFinder.h"
+#include "Tracing.h"
 #include <utility>
 #include <string>
 #include <vector>
@@ -71,7 +72,11 @@ bool SignalFinder::init()
   }
 
   // Creating control histograms
-  if(fSaveControlHistos) { initialiseHistograms(); }
+  fHistoRegistry.configure(fParams.getOptions());
+  if(fSaveControlHistos) {
+    initialiseHistograms();
+    fHistos = SignalFinderTools::getHistos(getStatistics(), &fHistoRegistry);
+  }
   return true;
 }
 
@@ -81,11 +86,12 @@ bool SignalFinder::exec()
   if(auto timeWindow = dynamic_cast<const JPetTimeWindow* const>(fEvent)) {
     // Distribute signal channels by PM IDs and filter out Corrupted SigChs if requested
     auto& sigChByPM = SignalFinderTools::getSigChByPM(timeWindow, fUseCorruptedSigCh);
-    // Building signals
+    // Building signals, control histograms are filled only for the sampled windows
     auto allSignals = SignalFinderTools::buildAllSignals(
       sigChByPM, kNumOfThresholds, fSigChEdgeMaxTime, fSigChLeadTrailMaxTime,
-      getStatistics(), fSaveControlHistos
+      fHistoRegistry.beginWindow() ? fHistos : SignalFinderHistos()
     );
+    fHistoRegistry.endWindow();
     // Saving method invocation
     saveRawSignals(allSignals);
   } else { return false; }
@@ -94,12 +100,14 @@ bool SignalFinder::exec()
 
 bool SignalFinder::terminate()
 {
+  fHistoRegistry.merge();
   INFO("Signal finding ended.");
   return true;
 }
 
 void SignalFinder::saveRawSignals(const vector<JPetRawSignal>& rawSigVec)
 {
+  TraceSpan span("SignalFinder::saveRawSignals", "output");
   for (auto & rawSig : rawSigVec) { fOutputEvents->add<JPetRawSignal>(rawSig); }
 }
 
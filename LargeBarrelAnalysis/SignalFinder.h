@@ -18,6 +18,8 @@
 
 #include <JPetRawSignal/JPetRawSignal.h>
 #include <JPetUserTask/JPetUserTask.h>
+#include "SignalFinderTools.h"
+#include "HistogramHandles.h"
 #include <vector>
 
 class JPetWriter;
@@ -53,6 +55,8 @@ protected:
   double fSigChEdgeMaxTime = 5000.0;
   bool fUseCorruptedSigCh = false;
   bool fSaveControlHistos = true;
+  HistoRegistry fHistoRegistry;
+  SignalFinderHistos fHistos;
   void initialiseHistograms();
 };
 
@@ -14,14 +14,38 @@
  */
 
 #include "SignalFinderTools.h"
+#include "Tracing.h"
 using namespace std;
 
+/**
+ * Resolving handles of the control histograms. Without the registry,
+ * handles fill the histograms directly.
+ */
+SignalFinderHistos SignalFinderTools::getHistos(JPetStatistics& stats, HistoRegistry* registry)
+{
+  auto resolve = [&stats, registry] (const string& name) {
+    return registry ? registry->resolve(stats, name) : HistoHandle::direct(stats, name);
+  };
+  SignalFinderHistos histos;
+  histos.enabled = true;
+  for (int thr = 1; thr <= 4; thr++) {
+    histos.leadTrailDiff[thr-1] = resolve(Form("lead_trail_thr%d_diff", thr));
+    if (thr > 1) { histos.leadThr1Diff[thr-1] = resolve(Form("lead_thr1_thr%d_diff", thr)); }
+  }
+  histos.goodVsBadRawSigs = resolve("good_v_bad_raw_sigs");
+  histos.unusedSigChAll = resolve("unused_sigch_all");
+  histos.unusedSigChGood = resolve("unused_sigch_good");
+  histos.unusedSigChCorr = resolve("unused_sigch_corr");
+  return histos;
+}
+
 /**
  * Method returns a map of vectors of JPetSigCh ordered by photomultiplier ID
  */
 const map<int, vector<JPetSigCh>> SignalFinderTools::getSigChByPM(
   const JPetTimeWindow* timeWindow, bool useCorrupts
 ){
+  TraceSpan span("SignalFinder::getSigChByPM", "bucketing");
   map<int, vector<JPetSigCh>> sigChsPMMap;
   if (!timeWindow) {
     WARNING("Pointer of Time Window object is not set, returning empty map");
@@ -52,13 +76,14 @@ const map<int, vector<JPetSigCh>> SignalFinderTools::getSigChByPM(
 vector<JPetRawSignal> SignalFinderTools::buildAllSignals(
    const map<int, vector<JPetSigCh>>& sigChByPM, unsigned int numOfThresholds,
    double sigChEdgeMaxTime, double sigChLeadTrailMaxTime,
-   JPetStatistics& stats, bool saveHistos
+   const SignalFinderHistos& histos
 ) {
+  TraceSpan span("SignalFinder::buildAllSignals", "matching");
   vector<JPetRawSignal> allSignals;
   for (auto& sigChPair : sigChByPM) {
     auto signals = buildRawSignals(
       sigChPair.second, numOfThresholds, sigChEdgeMaxTime,
-      sigChLeadTrailMaxTime, stats, saveHistos
+      sigChLeadTrailMaxTime, histos
     );
     allSignals.insert(allSignals.end(), signals.begin(), signals.end());
   }
@@ -75,8 +100,9 @@ vector<JPetRawSignal> SignalFinderTools::buildAllSignals(
  vector<JPetRawSignal> SignalFinderTools::buildRawSignals(
    const vector<JPetSigCh>& sigChByPM, unsigned int numOfThresholds,
    double sigChEdgeMaxTime, double sigChLeadTrailMaxTime,
-   JPetStatistics& stats, bool saveHistos
+   const SignalFinderHistos& histos
  ) {
+  bool saveHistos = histos.enabled;
   vector<JPetRawSignal> rawSigVec;
   // Threshold number check - fixed number equal 4
   if (numOfThresholds != 4) {
@@ -115,7 +141,7 @@ vector<JPetRawSignal> SignalFinderTools::buildAllSignals(
         rawSig.setRecoFlag(JPetBaseSignal::Corrupted);
       }
       if(saveHistos){
-        stats.getHisto1D("lead_trail_thr1_diff")->Fill(
+        histos.leadTrailDiff[0].fill(
           thrTrailingSigCh.at(0).at(closestTrailingSigCh).getValue()-thrLeadingSigCh.at(0).at(0).getValue()
         );
       }
@@ -138,7 +164,7 @@ vector<JPetRawSignal> SignalFinderTools::buildAllSignals(
             rawSig.setRecoFlag(JPetBaseSignal::Corrupted);
           }
           if(saveHistos){
-            stats.getHisto1D(Form("lead_trail_thr%d_diff", kk+1))->Fill(
+            histos.leadTrailDiff[kk].fill(
               thrTrailingSigCh.at(kk).at(closestTrailingSigCh).getValue()
                 -thrLeadingSigCh.at(kk).at(nextThrSigChIndex).getValue()
             );
@@ -150,7 +176,7 @@ vector<JPetRawSignal> SignalFinderTools::buildAllSignals(
           rawSig.setRecoFlag(JPetBaseSignal::Corrupted);
         }
         if(saveHistos){
-          stats.getHisto1D(Form("lead_thr1_thr%d_diff", kk+1))->Fill(
+          histos.leadThr1Diff[kk].fill(
             thrLeadingSigCh.at(kk).at(nextThrSigChIndex).getValue()-thrLeadingSigCh.at(0).at(0).getValue()
           );
         }
@@ -159,11 +185,11 @@ vector<JPetRawSignal> SignalFinderTools::buildAllSignals(
     }
     if(saveHistos){
       if(rawSig.getRecoFlag()==JPetBaseSignal::Good){
-        stats.getHisto1D("good_v_bad_raw_sigs")->Fill(1);
+        histos.goodVsBadRawSigs.fill(1);
       } else if(rawSig.getRecoFlag()==JPetBaseSignal::Corrupted){
-        stats.getHisto1D("good_v_bad_raw_sigs")->Fill(2);
+        histos.goodVsBadRawSigs.fill(2);
       } else if(rawSig.getRecoFlag()==JPetBaseSignal::Unknown){
-        stats.getHisto1D("good_v_bad_raw_sigs")->Fill(3);
+        histos.goodVsBadRawSigs.fill(3);
       }
     }
     // Adding created Raw Signal to vector
@@ -174,19 +200,19 @@ vector<JPetRawSignal> SignalFinderTools::buildAllSignals(
   if(saveHistos){
     for(unsigned int jj=0;jj<numOfThresholds;jj++){
       for(auto sigCh : thrLeadingSigCh.at(jj)){
-        stats.getHisto1D("unused_sigch_all")->Fill(2*sigCh.getThresholdNumber()-1);
+        histos.unusedSigChAll.fill(2*sigCh.getThresholdNumber()-1);
         if(sigCh.getRecoFlag()==JPetSigCh::Good){
-          stats.getHisto1D("unused_sigch_good")->Fill(2*sigCh.getThresholdNumber()-1);
+          histos.unusedSigChGood.fill(2*sigCh.getThresholdNumber()-1);
         } else if(sigCh.getRecoFlag()==JPetSigCh::Corrupted){
-          stats.getHisto1D("unused_sigch_corr")->Fill(2*sigCh.getThresholdNumber()-1);
+          histos.unusedSigChCorr.fill(2*sigCh.getThresholdNumber()-1);
         }
       }
       for(auto sigCh : thrTrailingSigCh.at(jj)){
-        stats.getHisto1D("unused_sigch_all")->Fill(2*sigCh.getThresholdNumber());
+        histos.unusedSigChAll.fill(2*sigCh.getThresholdNumber());
         if(sigCh.getRecoFlag()==JPetSigCh::Good){
-          stats.getHisto1D("unused_sigch_good")->Fill(2*sigCh.getThresholdNumber());
+          histos.unusedSigChGood.fill(2*sigCh.getThresholdNumber());
         } else if(sigCh.getRecoFlag()==JPetSigCh::Corrupted){
-          stats.getHisto1D("unused_sigch_corr")->Fill(2*sigCh.getThresholdNumber());
+          histos.unusedSigChCorr.fill(2*sigCh.getThresholdNumber());
         }
       }
     }
@@ -27,24 +27,39 @@
 #include <JPetRawSignal/JPetRawSignal.h>
 #include <JPetParamBank/JPetParamBank.h>
 #include <JPetSigCh/JPetSigCh.h>
+#include "HistogramHandles.h"
 #include <utility>
 #include <vector>
 
+/**
+ * @brief Handles of the control histograms filled by the Signal Finder tools
+ */
+struct SignalFinderHistos {
+  bool enabled = false;
+  HistoHandle leadTrailDiff[4];
+  HistoHandle leadThr1Diff[4];
+  HistoHandle goodVsBadRawSigs;
+  HistoHandle unusedSigChAll;
+  HistoHandle unusedSigChGood;
+  HistoHandle unusedSigChCorr;
+};
+
 class SignalFinderTools
 {
 public:
+  static SignalFinderHistos getHistos(JPetStatistics& stats, HistoRegistry* registry = nullptr);
   static const std::map<int, std::vector<JPetSigCh>> getSigChByPM(
     const JPetTimeWindow* timeWindow, bool useCorrupts
   );
   static std::vector<JPetRawSignal> buildAllSignals(
     const std::map<int, std::vector<JPetSigCh>>& sigChByPM, unsigned int numOfThresholds,
     double sigChEdgeMaxTime, double sigChLeadTrailMaxTime,
-    JPetStatistics& stats, bool saveHistos
+    const SignalFinderHistos& histos
   );
   static std::vector<JPetRawSignal> buildRawSignals(
     const std::vector<JPetSigCh>& sigChByPM, unsigned int numOfThresholds,
     double sigChEdgeMaxTime, double sigChLeadTrailMaxTime,
-    JPetStatistics& stats, bool saveHistos
+    const SignalFinderHistos& histos
   );
   static int findSigChOnNextThr(
     double sigChValue, double sigChEdgeMaxTime,
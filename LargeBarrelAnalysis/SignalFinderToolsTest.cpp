@@ -84,10 +84,9 @@ BOOST_AUTO_TEST_CASE(getSigChByPM_Test)
 
 BOOST_AUTO_TEST_CASE(buildRawSignals_empty)
 {
-  JPetStatistics stats;
   std::vector<JPetSigCh> sigChByPM;
   auto results = SignalFinderTools::buildRawSignals(
-    sigChByPM, 1, 5.0, 5.0, stats, false
+    sigChByPM, 1, 5.0, 5.0, SignalFinderHistos()
   );
   BOOST_REQUIRE(results.empty());
 }
@@ -100,16 +99,14 @@ BOOST_AUTO_TEST_CASE(buildRawSignals_wrong_one_signal_NumOfThresholdsNot4)
   std::vector<JPetSigCh> sigChVec;
   sigChVec.push_back(sigCh1);
   auto numOfThresholds = 1;
-  JPetStatistics stats;
   auto results = SignalFinderTools::buildRawSignals(
-    sigChVec, numOfThresholds, 5.0, 5.0, stats, false
+    sigChVec, numOfThresholds, 5.0, 5.0, SignalFinderHistos()
   );
   BOOST_REQUIRE(results.empty());
 }
 
 BOOST_AUTO_TEST_CASE(buildRawSignals_one_signal)
 {
-  JPetStatistics stats;
   JPetBarrelSlot bs1(1, true, "some_slot", 57.7, 123);
   JPetPM pm1(1, "first");
   pm1.setBarrelSlot(bs1);
@@ -122,7 +119,7 @@ BOOST_AUTO_TEST_CASE(buildRawSignals_one_signal)
   double sigChEdgeMaxTime = 5.0;
   double sigChLeadTrailMaxTime = 5.0;
   auto results = SignalFinderTools::buildRawSignals(
-    sigChVec, numOfThresholds, sigChEdgeMaxTime, sigChLeadTrailMaxTime, stats, false
+    sigChVec, numOfThresholds, sigChEdgeMaxTime, sigChLeadTrailMaxTime, SignalFinderHistos()
   );
   auto points_trail = results.at(0).getPoints(JPetSigCh::Trailing);
   auto points_lead = results.at(0).getPoints(JPetSigCh::Leading);
@@ -154,9 +151,8 @@ BOOST_AUTO_TEST_CASE(buildRawSignals_2)
   auto numOfThresholds = 4;
   double sigChEdgeMaxTime = 5.;
   double sigChLeadTrailMaxTime = 10.;
-  JPetStatistics stats;
   auto results =  SignalFinderTools::buildRawSignals(
-    sigChFromSamePM, numOfThresholds, sigChEdgeMaxTime , sigChLeadTrailMaxTime, stats, false
+    sigChFromSamePM, numOfThresholds, sigChEdgeMaxTime , sigChLeadTrailMaxTime, SignalFinderHistos()
   );
   BOOST_REQUIRE_EQUAL(results.size(), 1);
   auto points_trail = results.at(0).getPoints(JPetSigCh::Trailing);
@@ -254,9 +250,8 @@ BOOST_AUTO_TEST_CASE(buildRawSignals_test_flag_inherit)
   auto numOfThresholds = 4;
   double sigChEdgeMaxTime = 5.0;
   double sigChLeadTrailMaxTime = 12.0;
-  JPetStatistics stats;
   auto results = SignalFinderTools::buildRawSignals(
-    sigChFromSamePM, numOfThresholds, sigChEdgeMaxTime, sigChLeadTrailMaxTime, stats, false
+    sigChFromSamePM, numOfThresholds, sigChEdgeMaxTime, sigChLeadTrailMaxTime, SignalFinderHistos()
   );
   BOOST_REQUIRE_EQUAL(results.size(), 2);
   BOOST_REQUIRE_EQUAL(results.at(0).getRecoFlag(), JPetBaseSignal::Good);
@@ -459,9 +454,8 @@ BOOST_AUTO_TEST_CASE(buildRawSignals_realdata_flag_test)
   auto numOfThresholds = 4;
   double sigChEdgeMaxTime = 0.0005;
   double sigChLeadTrailMaxTime = 0.0023;
-  JPetStatistics stats;
   auto results = SignalFinderTools::buildRawSignals(
-    sigChFromSamePM, numOfThresholds, sigChEdgeMaxTime, sigChLeadTrailMaxTime, stats, false
+    sigChFromSamePM, numOfThresholds, sigChEdgeMaxTime, sigChLeadTrailMaxTime, SignalFinderHistos()
   );
   BOOST_REQUIRE_EQUAL(results.size(), 3);
   BOOST_REQUIRE_EQUAL(results.at(0).getRecoFlag(), JPetBaseSignal::Corrupted);
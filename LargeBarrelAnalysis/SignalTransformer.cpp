@@ -43,56 +43,67 @@ bool SignalTransformer::init()
   }
 
   // Control histograms
-  if(fSaveControlHistos) { initialiseHistograms(); }
+  fHistoRegistry.configure(fParams.getOptions());
+  if(fSaveControlHistos) {
+    initialiseHistograms();
+    fRawSigsMulti = fHistoRegistry.resolve(getStatistics(), "raw_sigs_multi");
+    fRawSigsMultiGood = fHistoRegistry.resolve(getStatistics(), "raw_sigs_multi_good");
+    fRawSigsMultiCorr = fHistoRegistry.resolve(getStatistics(), "raw_sigs_multi_corr");
+    fRawSigsMultiCorrSigChGood = fHistoRegistry.resolve(getStatistics(), "raw_sigs_multi_corr_sigch_good");
+    fRawSigsMultiCorrSigChCorr = fHistoRegistry.resolve(getStatistics(), "raw_sigs_multi_corr_sigch_corr");
+    fGoodVsBadSignals = fHistoRegistry.resolve(getStatistics(), "good_vs_bad_signals");
+  }
   return true;
 }
 
 bool SignalTransformer::exec()
 {
   if(auto & timeWindow = dynamic_cast<const JPetTimeWindow* const>(fEvent)) {
+    // Control histograms are filled only for the sampled windows
+    bool saveHistos = fHistoRegistry.beginWindow() && fSaveControlHistos;
     uint n = timeWindow->getNumberOfEvents();
     for(uint i=0;i<n;++i){
       auto& rawSignal = dynamic_cast<const JPetRawSignal&>(timeWindow->operator[](i));
       if(!fUseCorruptedSignals && rawSignal.getRecoFlag()==JPetBaseSignal::Corrupted) {
         continue;
       }
-      if(fSaveControlHistos) {
+      if(saveHistos) {
         auto leads = rawSignal.getPoints(JPetSigCh::Leading, JPetRawSignal::ByThrNum);
         auto trails = rawSignal.getPoints(JPetSigCh::Trailing, JPetRawSignal::ByThrNum);
         for(unsigned int i=0;i<leads.size();i++){
-          getStatistics().getHisto1D("raw_sigs_multi")->Fill(2*i+1);
+          fRawSigsMulti.fill(2*i+1);
         }
         for(unsigned int i=0;i<trails.size();i++){
-          getStatistics().getHisto1D("raw_sigs_multi")->Fill(2*(i+1));
+          fRawSigsMulti.fill(2*(i+1));
         }
         if(rawSignal.getRecoFlag()==JPetBaseSignal::Good){
-          getStatistics().getHisto1D("good_vs_bad_signals")->Fill(1);
+          fGoodVsBadSignals.fill(1);
           for(unsigned int i=0;i<leads.size();i++){
-            getStatistics().getHisto1D("raw_sigs_multi_good")->Fill(2*i+1);
+            fRawSigsMultiGood.fill(2*i+1);
           }
           for(unsigned int i=0;i<trails.size();i++){
-            getStatistics().getHisto1D("raw_sigs_multi_good")->Fill(2*(i+1));
+            fRawSigsMultiGood.fill(2*(i+1));
           }
         } else if(rawSignal.getRecoFlag()==JPetBaseSignal::Corrupted){
-          getStatistics().getHisto1D("good_vs_bad_signals")->Fill(2);
+          fGoodVsBadSignals.fill(2);
           for(unsigned int i=0;i<leads.size();i++){
-            getStatistics().getHisto1D("raw_sigs_multi_corr")->Fill(2*i+1);
+            fRawSigsMultiCorr.fill(2*i+1);
             if(leads.at(i).getRecoFlag()==JPetSigCh::Good){
-              getStatistics().getHisto1D("raw_sigs_multi_corr_sigch_good")->Fill(2*i+1);
+              fRawSigsMultiCorrSigChGood.fill(2*i+1);
             } else if(leads.at(i).getRecoFlag()==JPetSigCh::Corrupted){
-              getStatistics().getHisto1D("raw_sigs_multi_corr_sigch_corr")->Fill(2*i+1);
+              fRawSigsMultiCorrSigChCorr.fill(2*i+1);
             }
           }
           for(unsigned int i=0;i<trails.size();i++){
-            getStatistics().getHisto1D("raw_sigs_multi_corr")->Fill(2*(i+1));
+            fRawSigsMultiCorr.fill(2*(i+1));
             if(trails.at(i).getRecoFlag()==JPetSigCh::Good){
-              getStatistics().getHisto1D("raw_sigs_multi_corr_sigch_good")->Fill(2*(i+1));
+              fRawSigsMultiCorrSigChGood.fill(2*(i+1));
             } else if(trails.at(i).getRecoFlag()==JPetSigCh::Corrupted){
-              getStatistics().getHisto1D("raw_sigs_multi_corr_sigch_corr")->Fill(2*(i+1));
+              fRawSigsMultiCorrSigChCorr.fill(2*(i+1));
             }
           }
         } else if(rawSignal.getRecoFlag()==JPetBaseSignal::Unknown){
-          getStatistics().getHisto1D("good_vs_bad_signals")->Fill(3);
+          fGoodVsBadSignals.fill(3);
         }
       }
       // Make Reco Signal from Raw Signal
@@ -101,6 +112,7 @@ bool SignalTransformer::exec()
       auto physSignal = createPhysSignal(recoSignal);
       fOutputEvents->add<JPetPhysSignal>(physSignal);
     }
+    fHistoRegistry.endWindow();
   } else {
     return false;
   }
@@ -109,6 +121,7 @@ bool SignalTransformer::exec()
 
 bool SignalTransformer::terminate()
 {
+  fHistoRegistry.merge();
   INFO("Signal transforming finished");
   return true;
 }
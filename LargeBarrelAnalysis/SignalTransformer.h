@@ -18,6 +18,7 @@
 
 #include "JPetRecoSignal/JPetRecoSignal.h"
 #include "JPetUserTask/JPetUserTask.h"
+#include "HistogramHandles.h"
 
 #ifdef __CINT__
 #define override
@@ -49,5 +50,12 @@ protected:
 	const std::string kSaveControlHistosParamKey = "Save_Control_Histograms_bool";
 	bool fUseCorruptedSignals = false;
 	bool fSaveControlHistos = true;
+	HistoRegistry fHistoRegistry;
+	HistoHandle fRawSigsMulti;
+	HistoHandle fRawSigsMultiGood;
+	HistoHandle fRawSigsMultiCorr;
+	HistoHandle fRawSigsMultiCorrSigChGood;
+	HistoHandle fRawSigsMultiCorrSigChCorr;
+	HistoHandle fGoodVsBadSignals;
 };
 #endif /* !SIGNALTRANSFORMER_H */
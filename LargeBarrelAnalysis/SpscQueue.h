@@ -0,0 +1,141 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file SpscQueue.h
+ */
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Statistics of the queue, collected by its producer and consumer
+ */
+struct QueueStats
+{
+  unsigned long pushes = 0;
+  unsigned long fullStalls = 0;
+  unsigned long emptyStalls = 0;
+  unsigned long maxDepth = 0;
+  double depthSum = 0.0;
+  double fullStallTime = 0.0;
+  double emptyStallTime = 0.0;
+
+  double getMeanDepth() const { return pushes > 0 ? depthSum / pushes : 0.0; }
+};
+
+/**
+ * @brief Bounded lock-free queue for one producer and one consumer thread
+ *
+ * Ring buffer with one empty slot, indices are synchronized with acquire and release
+ * operations only. Blocking push() waits while the queue is full, so a slow consumer
+ * holds back the producer. Both sides record how often and how long they had to wait,
+ * each side writes only its own counters. Statistics should be read after both threads
+ * are finished.
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+  explicit SpscQueue(std::size_t capacity): fBuffer(std::max<std::size_t>(capacity, 1) + 1) {}
+
+  std::size_t capacity() const { return fBuffer.size() - 1; }
+
+  std::size_t size() const
+  {
+    std::size_t head = fHead.load(std::memory_order_acquire);
+    std::size_t tail = fTail.load(std::memory_order_acquire);
+    return tail >= head ? tail - head : tail + fBuffer.size() - head;
+  }
+
+  bool tryPush(const T& item)
+  {
+    std::size_t tail = fTail.load(std::memory_order_relaxed);
+    std::size_t next = increment(tail);
+    if (next == fHead.load(std::memory_order_acquire)) return false;
+    fBuffer[tail] = item;
+    fTail.store(next, std::memory_order_release);
+    return true;
+  }
+
+  bool tryPop(T& item)
+  {
+    std::size_t head = fHead.load(std::memory_order_relaxed);
+    if (head == fTail.load(std::memory_order_acquire)) return false;
+    item = fBuffer[head];
+    fHead.store(increment(head), std::memory_order_release);
+    return true;
+  }
+
+  void push(const T& item)
+  {
+    std::size_t depth = size();
+    fStats.depthSum += depth;
+    fStats.maxDepth = std::max<unsigned long>(fStats.maxDepth, depth);
+    fStats.pushes++;
+    if (tryPush(item)) return;
+    fStats.fullStalls++;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned attempt = 0; !tryPush(item); attempt++) wait(attempt);
+    fStats.fullStallTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  T pop()
+  {
+    T item;
+    if (tryPop(item)) return item;
+    fConsumerStats.emptyStalls++;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned attempt = 0; !tryPop(item); attempt++) wait(attempt);
+    fConsumerStats.emptyStallTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return item;
+  }
+
+  QueueStats getStats() const
+  {
+    QueueStats stats = fStats;
+    stats.emptyStalls = fConsumerStats.emptyStalls;
+    stats.emptyStallTime = fConsumerStats.emptyStallTime;
+    return stats;
+  }
+
+private:
+  std::size_t increment(std::size_t index) const { return index + 1 == fBuffer.size() ? 0 : index + 1; }
+
+  /// Spinning for a short time, then giving the core to other threads
+  static void wait(unsigned attempt)
+  {
+    if (attempt < 64) std::this_thread::yield();
+    else std::this_thread::sleep_for(std::chrono::microseconds(50));
+  }
+
+  /// Padding keeps the indices used by the two threads in separate cache lines
+  static const std::size_t kCacheLine = 64;
+  std::vector<T> fBuffer;
+  char fPadding1[kCacheLine];
+  std::atomic<std::size_t> fHead{0};
+  char fPadding2[kCacheLine];
+  std::atomic<std::size_t> fTail{0};
+  char fPadding3[kCacheLine];
+  /// Written by the producer only
+  QueueStats fStats;
+  char fPadding4[kCacheLine];
+  /// Written by the consumer only
+  QueueStats fConsumerStats;
+};
+
+#endif /* !SPSCQUEUE_H */
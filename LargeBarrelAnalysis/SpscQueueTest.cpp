@@ -0,0 +1,86 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file SpscQueueTest.cpp
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE SpscQueueTest
+
+#include <boost/test/unit_test.hpp>
+#include "SpscQueue.h"
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE(SpscQueueTestSuite)
+
+BOOST_AUTO_TEST_CASE(capacity_test)
+{
+  SpscQueue<int> queue(3);
+  BOOST_REQUIRE_EQUAL(queue.capacity(), 3u);
+  BOOST_REQUIRE_EQUAL(queue.size(), 0u);
+  int item = 0;
+  BOOST_REQUIRE(!queue.tryPop(item));
+  BOOST_REQUIRE(queue.tryPush(1));
+  BOOST_REQUIRE(queue.tryPush(2));
+  BOOST_REQUIRE(queue.tryPush(3));
+  BOOST_REQUIRE(!queue.tryPush(4));
+  BOOST_REQUIRE_EQUAL(queue.size(), 3u);
+  BOOST_REQUIRE(queue.tryPop(item));
+  BOOST_REQUIRE_EQUAL(item, 1);
+  BOOST_REQUIRE(queue.tryPush(4));
+  for (int expected : {2, 3, 4}) {
+    BOOST_REQUIRE(queue.tryPop(item));
+    BOOST_REQUIRE_EQUAL(item, expected);
+  }
+  BOOST_REQUIRE_EQUAL(queue.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(orderFromThreads_test)
+{
+  const int kItems = 100000;
+  SpscQueue<int> queue(4);
+  std::thread producer([&queue] () {
+    for (int i = 1; i <= kItems; i++) { queue.push(i); }
+    queue.push(0);
+  });
+  int expected = 1;
+  bool ordered = true;
+  while (int item = queue.pop()) {
+    if (item != expected) ordered = false;
+    expected++;
+  }
+  producer.join();
+  BOOST_REQUIRE(ordered);
+  BOOST_REQUIRE_EQUAL(expected, kItems + 1);
+  auto stats = queue.getStats();
+  BOOST_REQUIRE_EQUAL(stats.pushes, kItems + 1ul);
+  BOOST_REQUIRE(stats.maxDepth <= queue.capacity());
+  BOOST_REQUIRE(stats.getMeanDepth() <= queue.capacity());
+}
+
+BOOST_AUTO_TEST_CASE(backpressure_test)
+{
+  SpscQueue<int> queue(1);
+  queue.push(1);
+  std::thread consumer([&queue] () {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    queue.pop();
+    queue.pop();
+  });
+  queue.push(2);
+  consumer.join();
+  auto stats = queue.getStats();
+  BOOST_REQUIRE_EQUAL(stats.fullStalls, 1u);
+  BOOST_REQUIRE(stats.fullStallTime > 0.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,372 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file SyntheticDataGenerator.cpp
+ */
+
+#include <JPetParamGetterAscii/JPetParamGetterAscii.h>
+#include <JPetParamManager/JPetParamManager.h>
+#include <JPetOptionsTools/JPetOptionsTools.h>
+#include <JPetGeomMapping/JPetGeomMapping.h>
+#include <JPetParamBank/JPetParamBank.h>
+#include <Unpacker2/Unpacker2/EventIII.h>
+#include <JPetWriter/JPetWriter.h>
+#include "JPetLoggerInclude.h"
+#include "SyntheticDataGenerator.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace jpet_options_tools;
+using namespace std;
+
+namespace
+{
+const string kSeedParamKey = "SyntheticData_Seed_int";
+const string kWindowLengthParamKey = "SyntheticData_WindowLength_float";
+const string kAnnihilationRateParamKey = "SyntheticData_AnnihilationRate_float";
+const string kRandomRateParamKey = "SyntheticData_RandomRate_float";
+const string kDarkNoiseRateParamKey = "SyntheticData_DarkNoiseRate_float";
+const string kCorruptedEdgeProbabilityParamKey = "SyntheticData_CorruptedEdgeProbability_float";
+const string kEffectiveVelocityParamKey = "SyntheticData_EffectiveVelocity_float";
+const string kTimeResolutionParamKey = "SyntheticData_TimeResolution_float";
+/// Speed of light in cm/ns
+const double kSpeedOfLight = 29.9792458;
+const double kPi = 3.14159265358979323846;
+}
+
+SyntheticDataGenerator::SyntheticDataGenerator(
+  const vector<SyntheticStrip>& strips, const SyntheticDataConfig& config
+): fStrips(strips), fConfig(config), fEngine(config.seed)
+{
+  // Strips grouped in layers, ordered by radius, as crossed by the photons
+  map<double, vector<unsigned>> layers;
+  for (unsigned i = 0; i < fStrips.size(); i++) {
+    if (fStrips[i].radius > 0.0) layers[fStrips[i].radius].push_back(i);
+  }
+  for (auto& layer : layers) fStripsPerLayer.push_back(layer.second);
+}
+
+double SyntheticDataGenerator::uniform(double min, double max)
+{
+  return uniform_real_distribution<double>(min, max)(fEngine);
+}
+
+/**
+ * Generating edges of all channels in one window. Window covers times
+ * from minus its length to zero.
+ */
+map<int, SyntheticChannelEdges> SyntheticDataGenerator::generateWindow()
+{
+  map<int, SyntheticChannelEdges> edges;
+  double lengthInSeconds = fConfig.windowLength * 1.0e-9;
+  if (fConfig.annihilationRate > 0.0) {
+    unsigned long annihilations = poisson_distribution<unsigned long>(
+      fConfig.annihilationRate * lengthInSeconds)(fEngine);
+    for (unsigned long i = 0; i < annihilations; i++) {
+      addAnnihilation(uniform(-fConfig.windowLength, 0.0), edges);
+    }
+    fSummary.annihilations += annihilations;
+  }
+  if (fConfig.randomRate > 0.0) {
+    unsigned long randoms = poisson_distribution<unsigned long>(
+      fConfig.randomRate * lengthInSeconds)(fEngine);
+    for (unsigned long i = 0; i < randoms; i++) {
+      addRandom(uniform(-fConfig.windowLength, 0.0), edges);
+    }
+    fSummary.randoms += randoms;
+  }
+  addDarkNoise(edges);
+  // TDC registers only the edges inside of the window
+  for (auto& channel : edges) {
+    for (auto times : {&channel.second.leads, &channel.second.trails}) {
+      times->erase(remove_if(times->begin(), times->end(), [this] (double time) {
+        return time < -fConfig.windowLength || time > 0.0;
+      }), times->end());
+      sort(times->begin(), times->end());
+      fSummary.edges += times->size();
+    }
+  }
+  fSummary.windows++;
+  return edges;
+}
+
+/**
+ * Filling the Unpacker event with the next generated window
+ */
+void SyntheticDataGenerator::fillEvent(EventIII& event)
+{
+  auto edges = generateWindow();
+  for (const auto& channel : edges) {
+    if (channel.second.leads.empty() && channel.second.trails.empty()) continue;
+    auto tdcChannel = event.AddTDCChannel(channel.first);
+    for (auto lead : channel.second.leads) tdcChannel->AddLead(lead);
+    for (auto trail : channel.second.trails) tdcChannel->AddTrail(trail);
+  }
+}
+
+/**
+ * Two back-to-back photons from a point in the source volume
+ */
+void SyntheticDataGenerator::addAnnihilation(double time, map<int, SyntheticChannelEdges>& edges)
+{
+  double radius = fConfig.sourceRadius * sqrt(uniform(0.0, 1.0));
+  double phi = uniform(0.0, 2.0 * kPi);
+  double x = radius * cos(phi);
+  double y = radius * sin(phi);
+  double z = uniform(-fConfig.stripLength / 4.0, fConfig.stripLength / 4.0);
+  double cosTheta = uniform(-1.0, 1.0);
+  double sinTheta = sqrt(1.0 - cosTheta * cosTheta);
+  double dirPhi = uniform(0.0, 2.0 * kPi);
+  double dirX = sinTheta * cos(dirPhi);
+  double dirY = sinTheta * sin(dirPhi);
+  addPhoton(time, x, y, z, dirX, dirY, cosTheta, edges);
+  addPhoton(time, x, y, z, -dirX, -dirY, -cosTheta, edges);
+}
+
+/**
+ * Single photon, not correlated with any other
+ */
+void SyntheticDataGenerator::addRandom(double time, map<int, SyntheticChannelEdges>& edges)
+{
+  double radius = fConfig.sourceRadius * sqrt(uniform(0.0, 1.0));
+  double phi = uniform(0.0, 2.0 * kPi);
+  double cosTheta = uniform(-1.0, 1.0);
+  double sinTheta = sqrt(1.0 - cosTheta * cosTheta);
+  double dirPhi = uniform(0.0, 2.0 * kPi);
+  addPhoton(
+    time, radius * cos(phi), radius * sin(phi),
+    uniform(-fConfig.stripLength / 4.0, fConfig.stripLength / 4.0),
+    sinTheta * cos(dirPhi), sinTheta * sin(dirPhi), cosTheta, edges
+  );
+}
+
+/**
+ * Tracking the photon through the layers, from the innermost one. In each layer
+ * the photon may hit the closest strip, if it passes within its width.
+ * Returns true if the photon interacted.
+ */
+bool SyntheticDataGenerator::addPhoton(
+  double time, double x, double y, double z, double dirX, double dirY, double dirZ,
+  map<int, SyntheticChannelEdges>& edges
+) {
+  double a = dirX * dirX + dirY * dirY;
+  if (a <= 0.0) return false;
+  double b = 2.0 * (x * dirX + y * dirY);
+  for (const auto& layer : fStripsPerLayer) {
+    double radius = fStrips[layer.front()].radius;
+    double c = x * x + y * y - radius * radius;
+    double path = (-b + sqrt(b * b - 4.0 * a * c)) / (2.0 * a);
+    double hitZ = z + path * dirZ;
+    if (fabs(hitZ) > fConfig.stripLength / 2.0) return false;
+    double hitPhi = atan2(y + path * dirY, x + path * dirX) * 180.0 / kPi;
+    const SyntheticStrip* closest = nullptr;
+    double closestDistance = 360.0;
+    for (auto index : layer) {
+      double distance = fabs(fmod(hitPhi - fStrips[index].theta + 540.0, 360.0) - 180.0);
+      if (distance < closestDistance) {
+        closestDistance = distance;
+        closest = &fStrips[index];
+      }
+    }
+    if (radius * closestDistance * kPi / 180.0 > fConfig.stripWidth / 2.0) continue;
+    if (uniform(0.0, 1.0) >= fConfig.interactionProbability) continue;
+    double length = path * sqrt(a + dirZ * dirZ);
+    addHit(*closest, time + length / kSpeedOfLight, hitZ, edges);
+    return true;
+  }
+  return false;
+}
+
+/**
+ * Signals on both sides of the strip, delayed by the propagation of light
+ * to the photomultipliers. Side A is at the positive end of the strip,
+ * consistently with the position reconstructed by the Hit Finder.
+ */
+void SyntheticDataGenerator::addHit(
+  const SyntheticStrip& strip, double time, double z, map<int, SyntheticChannelEdges>& edges
+) {
+  fSummary.hits++;
+  normal_distribution<double> resolution(0.0, fConfig.timeResolution);
+  double amplitude = uniform(0.0, fConfig.maxAmplitude);
+  double timeA = time + (fConfig.stripLength / 2.0 - z) / fConfig.effectiveVelocity;
+  double timeB = time + (fConfig.stripLength / 2.0 + z) / fConfig.effectiveVelocity;
+  addSignal(strip, 0, timeA + resolution(fEngine), amplitude, edges);
+  addSignal(strip, 1, timeB + resolution(fEngine), amplitude, edges);
+}
+
+/**
+ * Edges of the pulse on the thresholds it crosses. Pulse rises linearly
+ * to the amplitude and decays exponentially, so the time over threshold is
+ * riseTime * (1 - thr/amplitude) + decayTime * ln(amplitude/thr).
+ * Dropping of one edge makes a repeated edge type on the channel.
+ */
+void SyntheticDataGenerator::addSignal(
+  const SyntheticStrip& strip, int side, double time, double amplitude,
+  map<int, SyntheticChannelEdges>& edges
+) {
+  for (int thr = 0; thr < 4; thr++) {
+    int channel = strip.channels[side][thr];
+    double threshold = fConfig.thresholds[thr];
+    if (channel <= 0 || amplitude <= threshold) continue;
+    double lead = time + fConfig.riseTime * threshold / amplitude;
+    double trail = time + fConfig.riseTime + fConfig.decayTime * log(amplitude / threshold);
+    bool saveLead = true;
+    bool saveTrail = true;
+    if (uniform(0.0, 1.0) < fConfig.corruptedEdgeProbability) {
+      fSummary.corruptedEdges++;
+      if (uniform(0.0, 1.0) < 0.5) saveLead = false;
+      else saveTrail = false;
+    }
+    auto& channelEdges = edges[channel];
+    if (saveLead) channelEdges.leads.push_back(lead);
+    if (saveTrail) channelEdges.trails.push_back(trail);
+  }
+}
+
+/**
+ * Dark noise pulses of each photomultiplier, with exponential distribution
+ * of the amplitude, so mostly only the lowest thresholds are crossed.
+ */
+void SyntheticDataGenerator::addDarkNoise(map<int, SyntheticChannelEdges>& edges)
+{
+  if (fConfig.darkNoiseRate <= 0.0) return;
+  poisson_distribution<unsigned long> pulses(fConfig.darkNoiseRate * fConfig.windowLength * 1.0e-9);
+  exponential_distribution<double> amplitude(1.0 / fConfig.darkNoiseAmplitude);
+  for (const auto& strip : fStrips) {
+    for (int side = 0; side < 2; side++) {
+      unsigned long numberOfPulses = pulses(fEngine);
+      for (unsigned long i = 0; i < numberOfPulses; i++) {
+        addSignal(strip, side, uniform(-fConfig.windowLength, 0.0), amplitude(fEngine), edges);
+      }
+      fSummary.darkNoisePulses += numberOfPulses;
+    }
+  }
+}
+
+/**
+ * Strips of the barrel with channels from the TOMB mapping,
+ * trigger channels are not included.
+ */
+vector<SyntheticStrip> SyntheticDataGenerator::getStrips(const JPetParamBank& paramBank)
+{
+  vector<SyntheticStrip> strips;
+  JPetGeomMapping mapper(paramBank);
+  for (const auto& slotPair : paramBank.getBarrelSlots()) {
+    const auto& slot = *slotPair.second;
+    SyntheticStrip strip;
+    strip.layer = mapper.getLayerNumber(slot.getLayer());
+    strip.slot = mapper.getSlotNumber(slot);
+    strip.radius = slot.getLayer().getRadius();
+    strip.theta = slot.getTheta();
+    for (int thr = 1; thr <= 4; thr++) {
+      int channelA = mapper.getTOMB(strip.layer, strip.slot, JPetPM::SideA, thr);
+      int channelB = mapper.getTOMB(strip.layer, strip.slot, JPetPM::SideB, thr);
+      strip.channels[0][thr-1] = channelA % 65 == 0 ? 0 : channelA;
+      strip.channels[1][thr-1] = channelB % 65 == 0 ? 0 : channelB;
+    }
+    strips.push_back(strip);
+  }
+  return strips;
+}
+
+/**
+ * Configuration from the user options, not given values are default
+ */
+SyntheticDataConfig SyntheticDataGenerator::loadConfig(const map<string, boost::any>& options)
+{
+  SyntheticDataConfig config;
+  if (isOptionSet(options, kSeedParamKey)) {
+    config.seed = getOptionAsInt(options, kSeedParamKey);
+  }
+  if (isOptionSet(options, kWindowLengthParamKey)) {
+    config.windowLength = getOptionAsFloat(options, kWindowLengthParamKey);
+  }
+  if (isOptionSet(options, kAnnihilationRateParamKey)) {
+    config.annihilationRate = getOptionAsFloat(options, kAnnihilationRateParamKey);
+  }
+  if (isOptionSet(options, kRandomRateParamKey)) {
+    config.randomRate = getOptionAsFloat(options, kRandomRateParamKey);
+  }
+  if (isOptionSet(options, kDarkNoiseRateParamKey)) {
+    config.darkNoiseRate = getOptionAsFloat(options, kDarkNoiseRateParamKey);
+  }
+  if (isOptionSet(options, kCorruptedEdgeProbabilityParamKey)) {
+    config.corruptedEdgeProbability = getOptionAsFloat(options, kCorruptedEdgeProbabilityParamKey);
+  }
+  if (isOptionSet(options, kEffectiveVelocityParamKey)) {
+    config.effectiveVelocity = getOptionAsFloat(options, kEffectiveVelocityParamKey);
+  }
+  if (isOptionSet(options, kTimeResolutionParamKey)) {
+    config.timeResolution = getOptionAsFloat(options, kTimeResolutionParamKey);
+  }
+  return config;
+}
+
+/**
+ * Options from the JSON tree of the same format as the user parameters file;
+ * type of each value is taken from the suffix of its name.
+ */
+map<string, boost::any> SyntheticDataGenerator::getOptions(const boost::property_tree::ptree& tree)
+{
+  map<string, boost::any> options;
+  auto endsWith = [] (const string& key, const string& suffix) {
+    return key.size() >= suffix.size()
+      && key.compare(key.size() - suffix.size(), suffix.size(), suffix) == 0;
+  };
+  for (const auto& entry : tree) {
+    const auto& key = entry.first;
+    if (endsWith(key, "_int")) {
+      options[key] = entry.second.get_value<int>();
+    } else if (endsWith(key, "_float")) {
+      options[key] = entry.second.get_value<float>();
+    } else if (endsWith(key, "_bool")) {
+      options[key] = entry.second.get_value<bool>();
+    } else {
+      options[key] = entry.second.get_value<string>();
+    }
+  }
+  return options;
+}
+
+/**
+ * Writing generated windows as Unpacker events to the ROOT file, together
+ * with the param bank of the run, so it can be analysed with -t root
+ * in place of the file unpacked from HLD.
+ */
+bool SyntheticDataGenerator::generateFile(
+  const string& localDB, int runId, long numberOfWindows,
+  const string& outputFile, const SyntheticDataConfig& config,
+  SyntheticDataSummary* summary
+) {
+  JPetParamManager paramManager(new JPetParamGetterAscii(localDB));
+  if (!paramManager.fillParameterBank(runId)) {
+    ERROR(Form("Unable to read the setup of run %d from %s", runId, localDB.c_str()));
+    return false;
+  }
+  const auto& paramBank = paramManager.getParamBank();
+  SyntheticDataGenerator generator(getStrips(paramBank), config);
+  JPetWriter writer(outputFile.c_str());
+  if (!writer.isOpen()) {
+    ERROR(Form("Unable to open the output file %s", outputFile.c_str()));
+    return false;
+  }
+  EventIII event;
+  for (long i = 0; i < numberOfWindows; i++) {
+    event.Clear();
+    generator.fillEvent(event);
+    writer.write(event);
+  }
+  writer.writeObject(&paramBank, "ParamBank");
+  writer.closeFile();
+  if (summary) *summary = generator.getSummary();
+  return true;
+}
@@ -0,0 +1,135 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file SyntheticDataGenerator.h
+ */
+
+#ifndef SYNTHETICDATAGENERATOR_H
+#define SYNTHETICDATAGENERATOR_H
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/any.hpp>
+#include <random>
+#include <vector>
+#include <string>
+#include <map>
+
+class JPetParamBank;
+class EventIII;
+
+/**
+ * @brief Scintillator strip of the barrel, as seen by the generator
+ *
+ * Radius in cm, theta in degrees, TOMB channels of side A and B
+ * for 4 thresholds; channels equal to 0 are not generated.
+ */
+struct SyntheticStrip {
+  int layer = 0;
+  int slot = 0;
+  double radius = 0.0;
+  double theta = 0.0;
+  int channels[2][4] = {{0, 0, 0, 0}, {0, 0, 0, 0}};
+};
+
+/**
+ * @brief Parameters of the generated data, rates in Hz, times in ns and lengths in cm
+ */
+struct SyntheticDataConfig {
+  unsigned long seed = 1;
+  double windowLength = 20000.0;
+  double annihilationRate = 1.0e5;
+  double randomRate = 1.0e5;
+  double darkNoiseRate = 1.0e3;
+  double corruptedEdgeProbability = 0.01;
+  double sourceRadius = 10.0;
+  double stripLength = 50.0;
+  double stripWidth = 0.7;
+  double interactionProbability = 0.2;
+  double effectiveVelocity = 12.0;
+  double timeResolution = 0.1;
+  double riseTime = 1.0;
+  double decayTime = 20.0;
+  double maxAmplitude = 800.0;
+  double darkNoiseAmplitude = 100.0;
+  double thresholds[4] = {80.0, 160.0, 240.0, 320.0};
+};
+
+/**
+ * @brief Edges of one TOMB channel in a generated window, in ns, sorted in time
+ */
+struct SyntheticChannelEdges {
+  std::vector<double> leads;
+  std::vector<double> trails;
+};
+
+/**
+ * @brief Counts of the simulated sources of signals in the generated windows
+ */
+struct SyntheticDataSummary {
+  unsigned long windows = 0;
+  unsigned long annihilations = 0;
+  unsigned long randoms = 0;
+  unsigned long hits = 0;
+  unsigned long darkNoisePulses = 0;
+  unsigned long corruptedEdges = 0;
+  unsigned long edges = 0;
+};
+
+/**
+ * @brief Generator of synthetic TDC data of the barrel, in the format of the Unpacker
+ *
+ * Back-to-back photons from annihilations in the source volume and single photons
+ * of uncorrelated random hits interact in the strips, giving signals on both sides
+ * delayed by the propagation along the strip. Each signal crosses the thresholds
+ * below its amplitude, with leading and trailing edges of the simplified pulse shape
+ * (linear rise, exponential decay), so the time over threshold decreases with
+ * the threshold. Dark noise pulses of the photomultipliers are added, and some edges
+ * are dropped, giving LL and TT patterns. Times in the window are negative, as in
+ * the Unpacker output. For the same seed and configuration the same windows are
+ * generated by the same build.
+ */
+class SyntheticDataGenerator
+{
+public:
+  SyntheticDataGenerator(const std::vector<SyntheticStrip>& strips, const SyntheticDataConfig& config);
+  std::map<int, SyntheticChannelEdges> generateWindow();
+  void fillEvent(EventIII& event);
+  const SyntheticDataSummary& getSummary() const { return fSummary; }
+  const SyntheticDataConfig& getConfig() const { return fConfig; }
+  static std::vector<SyntheticStrip> getStrips(const JPetParamBank& paramBank);
+  static SyntheticDataConfig loadConfig(const std::map<std::string, boost::any>& options);
+  static std::map<std::string, boost::any> getOptions(const boost::property_tree::ptree& tree);
+  static bool generateFile(
+    const std::string& localDB, int runId, long numberOfWindows,
+    const std::string& outputFile, const SyntheticDataConfig& config,
+    SyntheticDataSummary* summary = nullptr
+  );
+
+private:
+  void addAnnihilation(double time, std::map<int, SyntheticChannelEdges>& edges);
+  void addRandom(double time, std::map<int, SyntheticChannelEdges>& edges);
+  bool addPhoton(double time, double x, double y, double z,
+    double dirX, double dirY, double dirZ, std::map<int, SyntheticChannelEdges>& edges);
+  void addHit(const SyntheticStrip& strip, double time, double z, std::map<int, SyntheticChannelEdges>& edges);
+  void addSignal(const SyntheticStrip& strip, int side, double time, double amplitude,
+    std::map<int, SyntheticChannelEdges>& edges);
+  void addDarkNoise(std::map<int, SyntheticChannelEdges>& edges);
+  double uniform(double min, double max);
+
+  std::vector<SyntheticStrip> fStrips;
+  std::vector<std::vector<unsigned>> fStripsPerLayer;
+  SyntheticDataConfig fConfig;
+  SyntheticDataSummary fSummary;
+  std::mt19937_64 fEngine;
+};
+
+#endif /* !SYNTHETICDATAGENERATOR_H */
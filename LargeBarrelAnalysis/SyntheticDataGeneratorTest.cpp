@@ -0,0 +1,184 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file SyntheticDataGeneratorTest.cpp
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE SyntheticDataGeneratorTest
+
+#include <boost/test/unit_test.hpp>
+#include "SyntheticDataGenerator.h"
+#include <cmath>
+
+/// One layer of 48 strips, covering the whole circumference
+std::vector<SyntheticStrip> getTestStrips()
+{
+  std::vector<SyntheticStrip> strips;
+  for (int slot = 1; slot <= 48; slot++) {
+    SyntheticStrip strip;
+    strip.layer = 1;
+    strip.slot = slot;
+    strip.radius = 42.5;
+    strip.theta = (slot - 1) * 7.5;
+    for (int side = 0; side < 2; side++) {
+      for (int thr = 0; thr < 4; thr++) {
+        strip.channels[side][thr] = slot * 8 + side * 4 + thr + 1;
+      }
+    }
+    strips.push_back(strip);
+  }
+  return strips;
+}
+
+SyntheticDataConfig getTestConfig()
+{
+  SyntheticDataConfig config;
+  config.randomRate = 0.0;
+  config.darkNoiseRate = 0.0;
+  config.corruptedEdgeProbability = 0.0;
+  config.timeResolution = 0.0;
+  config.stripWidth = 2.0 * 3.14159265 * 42.5 / 48.0;
+  config.interactionProbability = 1.0;
+  return config;
+}
+
+BOOST_AUTO_TEST_SUITE(SyntheticDataGeneratorTestSuite)
+
+BOOST_AUTO_TEST_CASE(seed_test)
+{
+  auto config = getTestConfig();
+  config.randomRate = 1.0e6;
+  config.darkNoiseRate = 1.0e4;
+  config.corruptedEdgeProbability = 0.1;
+  SyntheticDataGenerator generator1(getTestStrips(), config);
+  SyntheticDataGenerator generator2(getTestStrips(), config);
+  config.seed = 2;
+  SyntheticDataGenerator generator3(getTestStrips(), config);
+  bool differentSeedDiffers = false;
+  for (int window = 0; window < 10; window++) {
+    auto edges1 = generator1.generateWindow();
+    auto edges2 = generator2.generateWindow();
+    auto edges3 = generator3.generateWindow();
+    BOOST_REQUIRE_EQUAL(edges1.size(), edges2.size());
+    for (const auto& channel : edges1) {
+      BOOST_REQUIRE(edges2.count(channel.first) == 1);
+      BOOST_REQUIRE(channel.second.leads == edges2[channel.first].leads);
+      BOOST_REQUIRE(channel.second.trails == edges2[channel.first].trails);
+      if (edges3.count(channel.first) == 0 || channel.second.leads != edges3[channel.first].leads) {
+        differentSeedDiffers = true;
+      }
+    }
+  }
+  BOOST_REQUIRE(differentSeedDiffers);
+  BOOST_REQUIRE_EQUAL(generator1.getSummary().edges, generator2.getSummary().edges);
+  BOOST_REQUIRE(generator1.getSummary().randoms > 0);
+}
+
+BOOST_AUTO_TEST_CASE(thresholds_test)
+{
+  auto config = getTestConfig();
+  config.annihilationRate = 5.0e4;
+  SyntheticDataGenerator generator(getTestStrips(), config);
+  unsigned long edgesOnThreshold[4] = {0, 0, 0, 0};
+  int checkedSignals = 0;
+  for (int window = 0; window < 200; window++) {
+    auto edges = generator.generateWindow();
+    for (const auto& channel : edges) {
+      edgesOnThreshold[(channel.first - 1) % 4] += channel.second.leads.size();
+    }
+    // Only channels with single signal in the window are compared
+    for (int slot = 1; slot <= 48; slot++) {
+      for (int side = 0; side < 2; side++) {
+        int firstChannel = slot * 8 + side * 4 + 1;
+        for (int thr = 1; thr < 4; thr++) {
+          auto lower = edges.find(firstChannel + thr - 1);
+          auto higher = edges.find(firstChannel + thr);
+          if (lower == edges.end() || higher == edges.end()) continue;
+          if (lower->second.leads.size() != 1 || lower->second.trails.size() != 1) continue;
+          if (higher->second.leads.size() != 1 || higher->second.trails.size() != 1) continue;
+          BOOST_REQUIRE(lower->second.leads[0] < higher->second.leads[0]);
+          BOOST_REQUIRE(lower->second.trails[0] > higher->second.trails[0]);
+          BOOST_REQUIRE(lower->second.trails[0] - lower->second.leads[0] > 0.0);
+          checkedSignals++;
+        }
+      }
+    }
+  }
+  BOOST_REQUIRE(checkedSignals > 0);
+  BOOST_REQUIRE(edgesOnThreshold[0] > edgesOnThreshold[1]);
+  BOOST_REQUIRE(edgesOnThreshold[1] > edgesOnThreshold[2]);
+  BOOST_REQUIRE(edgesOnThreshold[2] > edgesOnThreshold[3]);
+}
+
+BOOST_AUTO_TEST_CASE(sidesDelay_test)
+{
+  auto config = getTestConfig();
+  config.annihilationRate = 5.0e4;
+  SyntheticDataGenerator generator(getTestStrips(), config);
+  // Difference of times of the sides is limited by the length of the strip
+  double maxDelay = config.stripLength / config.effectiveVelocity + 1.0e-9;
+  int checkedHits = 0;
+  for (int window = 0; window < 200; window++) {
+    auto edges = generator.generateWindow();
+    for (int slot = 1; slot <= 48; slot++) {
+      auto sideA = edges.find(slot * 8 + 1);
+      auto sideB = edges.find(slot * 8 + 5);
+      if (sideA == edges.end() || sideB == edges.end()) continue;
+      if (sideA->second.leads.size() != 1 || sideB->second.leads.size() != 1) continue;
+      BOOST_REQUIRE(std::fabs(sideB->second.leads[0] - sideA->second.leads[0]) <= maxDelay);
+      checkedHits++;
+    }
+  }
+  BOOST_REQUIRE(checkedHits > 0);
+  BOOST_REQUIRE(generator.getSummary().hits > 0);
+  BOOST_REQUIRE(generator.getSummary().hits <= 2 * generator.getSummary().annihilations);
+}
+
+BOOST_AUTO_TEST_CASE(corruptedEdges_test)
+{
+  auto config = getTestConfig();
+  config.corruptedEdgeProbability = 1.0;
+  SyntheticDataGenerator generator(getTestStrips(), config);
+  int repeatedEdges = 0;
+  for (int window = 0; window < 20; window++) {
+    for (const auto& channel : generator.generateWindow()) {
+      if (channel.second.leads.size() > 1 || channel.second.trails.size() > 1) repeatedEdges++;
+    }
+  }
+  // Each signal lost one of its edges
+  const auto& summary = generator.getSummary();
+  BOOST_REQUIRE(summary.corruptedEdges > 0);
+  BOOST_REQUIRE(summary.edges <= summary.corruptedEdges);
+  BOOST_REQUIRE(repeatedEdges > 0);
+}
+
+BOOST_AUTO_TEST_CASE(darkNoise_test)
+{
+  auto config = getTestConfig();
+  config.annihilationRate = 0.0;
+  config.darkNoiseRate = 1.0e5;
+  SyntheticDataGenerator generator(getTestStrips(), config);
+  unsigned long lowestThreshold = 0;
+  unsigned long otherThresholds = 0;
+  for (int window = 0; window < 10; window++) {
+    for (const auto& channel : generator.generateWindow()) {
+      if ((channel.first - 1) % 4 == 0) lowestThreshold += channel.second.leads.size();
+      else otherThresholds += channel.second.leads.size();
+    }
+  }
+  BOOST_REQUIRE(generator.getSummary().darkNoisePulses > 0);
+  BOOST_REQUIRE_EQUAL(generator.getSummary().hits, 0u);
+  BOOST_REQUIRE(lowestThreshold > otherThresholds);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
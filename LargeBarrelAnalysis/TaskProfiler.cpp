@@ -0,0 +1,300 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file TaskProfiler.cpp
+ */
+
+#include <JPetOptionsTools/JPetOptionsTools.h>
+#include "JPetLoggerInclude.h"
+#include "TaskProfiler.h"
+#include <sys/resource.h>
+#include <algorithm>
+#include <unistd.h>
+#include <time.h>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <cmath>
+#include <mutex>
+#include <TFile.h>
+#include <TTree.h>
+
+using namespace jpet_options_tools;
+using namespace std;
+
+TaskProfiler::TaskProfiler(const string& taskName):
+  fTaskName(taskName), fLatencyBins(kNumberOfDecades * kBinsPerDecade + 2, 0) {}
+
+void TaskProfiler::configure(const map<string, boost::any>& options)
+{
+  if (isOptionSet(options, kEnabledParamKey)) {
+    fEnabled = getOptionAsBool(options, kEnabledParamKey);
+  }
+  if (isOptionSet(options, kSummaryFileParamKey)) {
+    fSummaryFile = getOptionAsString(options, kSummaryFileParamKey);
+  }
+  if (isOptionSet(options, kProgressIntervalParamKey)) {
+    fProgressInterval = getOptionAsFloat(options, kProgressIntervalParamKey);
+  }
+  if (fEnabled && fProgressInterval > 0.0) {
+    fExpectedWindows = countInputWindows(options);
+  }
+}
+
+double TaskProfiler::secondsSince(const Clock::time_point& start)
+{
+  return chrono::duration<double>(Clock::now() - start).count();
+}
+
+void TaskProfiler::beginInit()
+{
+  fStartTime = Clock::now();
+  fPhaseStart = fStartTime;
+  fLastProgress = fStartTime;
+  fStartRSS = getCurrentRSS();
+  fPeakRSS = fStartRSS;
+  getIOBytes(fStartReadBytes, fStartWrittenBytes);
+  fPhaseCPUStart = getThreadCPUTime();
+}
+
+void TaskProfiler::endInit()
+{
+  fInitTime = secondsSince(fPhaseStart);
+  fCPUTime += getThreadCPUTime() - fPhaseCPUStart;
+  sampleRSS();
+}
+
+void TaskProfiler::beginWindow()
+{
+  fPhaseStart = Clock::now();
+  fPhaseCPUStart = getThreadCPUTime();
+}
+
+void TaskProfiler::endWindow(unsigned long objectsIn, unsigned long objectsOut)
+{
+  auto now = Clock::now();
+  fCPUTime += getThreadCPUTime() - fPhaseCPUStart;
+  recordWindow(chrono::duration<double>(now - fPhaseStart).count(), objectsIn, objectsOut);
+  if (fNumberOfWindows % kRSSSampleInterval == 0) sampleRSS();
+  if (fProgressInterval > 0.0
+      && chrono::duration<double>(now - fLastProgress).count() >= fProgressInterval) {
+    fLastProgress = now;
+    double elapsed = chrono::duration<double>(now - fStartTime).count();
+    double rate = elapsed > 0.0 ? fNumberOfWindows / elapsed : 0.0;
+    if (fExpectedWindows > 0 && rate > 0.0) {
+      double remaining = max(0.0, (fExpectedWindows - (double) fNumberOfWindows) / rate);
+      INFO(Form("%s: %lu of %ld windows (%.1f%%), %.1f windows/s, ETA %.0f s",
+        fTaskName.c_str(), fNumberOfWindows, fExpectedWindows,
+        100.0 * fNumberOfWindows / fExpectedWindows, rate, remaining));
+    } else {
+      INFO(Form("%s: %lu windows, %.1f windows/s", fTaskName.c_str(), fNumberOfWindows, rate));
+    }
+  }
+}
+
+void TaskProfiler::recordWindow(double latency, unsigned long objectsIn, unsigned long objectsOut)
+{
+  fExecTime += latency;
+  fMaxLatency = max(fMaxLatency, latency);
+  int bin = 0;
+  if (latency > 0.0) {
+    bin = (int) floor((log10(latency) - kMinLatencyExponent) * kBinsPerDecade) + 1;
+    bin = min(max(bin, 0), (int) fLatencyBins.size() - 1);
+  }
+  fLatencyBins[bin]++;
+  fNumberOfWindows++;
+  fObjectsIn += objectsIn;
+  fObjectsOut += objectsOut;
+  fMaxObjectsIn = max(fMaxObjectsIn, objectsIn);
+  fMaxObjectsOut = max(fMaxObjectsOut, objectsOut);
+}
+
+void TaskProfiler::beginTerminate()
+{
+  sampleRSS();
+  fPhaseStart = Clock::now();
+  fPhaseCPUStart = getThreadCPUTime();
+}
+
+void TaskProfiler::endTerminate()
+{
+  fTerminateTime = secondsSince(fPhaseStart);
+  fWallTime = secondsSince(fStartTime);
+  fCPUTime += getThreadCPUTime() - fPhaseCPUStart;
+  unsigned long readBytes = 0, writtenBytes = 0;
+  if (getIOBytes(readBytes, writtenBytes)) {
+    fReadBytes = readBytes - fStartReadBytes;
+    fWrittenBytes = writtenBytes - fStartWrittenBytes;
+  }
+  fEndRSS = getCurrentRSS();
+  fPeakRSS = max(fPeakRSS, fEndRSS);
+  fProcessPeakRSS = getPeakRSS();
+  logSummary();
+  if (!fSummaryFile.empty()) addToSummary(fSummaryFile, toJSON());
+}
+
+/**
+* Upper edge of the bin, in which the quantile falls, limited by the longest latency
+*/
+double TaskProfiler::getLatencyQuantile(double quantile) const
+{
+  if (fNumberOfWindows == 0) return 0.0;
+  double target = quantile * fNumberOfWindows;
+  unsigned long cumulative = 0;
+  for (unsigned bin = 0; bin < fLatencyBins.size(); bin++) {
+    cumulative += fLatencyBins[bin];
+    if (cumulative >= target && cumulative > 0) {
+      double upperEdge = pow(10.0, kMinLatencyExponent + (double) bin / kBinsPerDecade);
+      return min(upperEdge, fMaxLatency);
+    }
+  }
+  return fMaxLatency;
+}
+
+string TaskProfiler::toJSON() const
+{
+  double meanLatency = fNumberOfWindows > 0 ? fExecTime / fNumberOfWindows : 0.0;
+  double windowsPerWall = fWallTime > 0.0 ? fNumberOfWindows / fWallTime : 0.0;
+  double windowsPerExec = fExecTime > 0.0 ? fNumberOfWindows / fExecTime : 0.0;
+  double inPerWindow = fNumberOfWindows > 0 ? (double) fObjectsIn / fNumberOfWindows : 0.0;
+  double outPerWindow = fNumberOfWindows > 0 ? (double) fObjectsOut / fNumberOfWindows : 0.0;
+  ostringstream json;
+  json << "{\"task\": \"" << fTaskName << "\", "
+    << "\"windows\": " << fNumberOfWindows << ", "
+    << "\"initTime\": " << fInitTime << ", "
+    << "\"execTime\": " << fExecTime << ", "
+    << "\"terminateTime\": " << fTerminateTime << ", "
+    << "\"wallTime\": " << fWallTime << ", "
+    << "\"cpuTime\": " << fCPUTime << ", "
+    << "\"windowsPerSecond\": " << windowsPerWall << ", "
+    << "\"execWindowsPerSecond\": " << windowsPerExec << ", "
+    << "\"latency\": {\"mean\": " << meanLatency
+    << ", \"p50\": " << getLatencyQuantile(0.5)
+    << ", \"p99\": " << getLatencyQuantile(0.99)
+    << ", \"max\": " << fMaxLatency << "}, "
+    << "\"objectsIn\": {\"total\": " << fObjectsIn
+    << ", \"perWindow\": " << inPerWindow << ", \"max\": " << fMaxObjectsIn << "}, "
+    << "\"objectsOut\": {\"total\": " << fObjectsOut
+    << ", \"perWindow\": " << outPerWindow << ", \"max\": " << fMaxObjectsOut << "}, "
+    << "\"rssStartKB\": " << fStartRSS << ", "
+    << "\"rssEndKB\": " << fEndRSS << ", "
+    << "\"peakRSSKB\": " << fPeakRSS << ", "
+    << "\"processPeakRSSKB\": " << fProcessPeakRSS << ", "
+    << "\"readBytes\": " << fReadBytes << ", "
+    << "\"writtenBytes\": " << fWrittenBytes << "}";
+  return json.str();
+}
+
+void TaskProfiler::logSummary() const
+{
+  INFO(Form(
+    "%s: %lu windows in %.2f s (%.1f windows/s), exec latency p50 %.3g s p99 %.3g s, objects in/out per window %.1f/%.1f, peak RSS %ld kB",
+    fTaskName.c_str(), fNumberOfWindows, fWallTime, fWallTime > 0.0 ? fNumberOfWindows / fWallTime : 0.0,
+    getLatencyQuantile(0.5), getLatencyQuantile(0.99),
+    fNumberOfWindows > 0 ? (double) fObjectsIn / fNumberOfWindows : 0.0,
+    fNumberOfWindows > 0 ? (double) fObjectsOut / fNumberOfWindows : 0.0, fPeakRSS
+  ));
+}
+
+/**
+* Peak resident memory of the process so far, in kB
+*/
+long TaskProfiler::getPeakRSS()
+{
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+  return usage.ru_maxrss;
+}
+
+/**
+* Current resident memory of the process, in kB
+*/
+long TaskProfiler::getCurrentRSS()
+{
+  ifstream statm("/proc/self/statm");
+  long pages = 0, residentPages = 0;
+  if (!(statm >> pages >> residentPages)) return 0;
+  return residentPages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/**
+* CPU time used so far by the calling thread, in seconds
+*/
+double TaskProfiler::getThreadCPUTime()
+{
+  struct timespec time;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) return 0.0;
+  return time.tv_sec + time.tv_nsec * 1.0e-9;
+}
+
+/**
+* Bytes read and written by the process so far, including the ones served
+* from the page cache. Returns false, if /proc/self/io is not available.
+*/
+bool TaskProfiler::getIOBytes(unsigned long& readBytes, unsigned long& writtenBytes)
+{
+  ifstream io("/proc/self/io");
+  string key;
+  unsigned long value = 0;
+  bool found = false;
+  while (io >> key >> value) {
+    if (key == "rchar:") { readBytes = value; found = true; }
+    else if (key == "wchar:") writtenBytes = value;
+  }
+  return found;
+}
+
+/**
+* Summaries of the finished tasks are kept for the whole run,
+* the file is rewritten with all of them.
+*/
+void TaskProfiler::addToSummary(const string& fileName, const string& taskJSON)
+{
+  static mutex summaryMutex;
+  static vector<string> summaries;
+  lock_guard<mutex> lock(summaryMutex);
+  summaries.push_back(taskJSON);
+  ofstream summaryFile(fileName);
+  if (!summaryFile.is_open()) {
+    ERROR(Form("Unable to open file %s for the profiling summary", fileName.c_str()));
+    return;
+  }
+  summaryFile << "{\"tasks\": [" << endl;
+  for (unsigned i = 0; i < summaries.size(); i++) {
+    summaryFile << "  " << summaries[i] << (i + 1 < summaries.size() ? "," : "") << endl;
+  }
+  summaryFile << "]}" << endl;
+}
+
+/**
+* Number of windows to process, used for the estimated time to the end.
+* Taken from the range of events given by the user, or from the input file.
+* Unpacked HLD input is read from the file with the additional root extension.
+* Returns -1 if the number is not known.
+*/
+long TaskProfiler::countInputWindows(const map<string, boost::any>& options)
+{
+  long firstEvent = getFirstEvent(options);
+  long lastEvent = getLastEvent(options);
+  if (firstEvent >= 0 && lastEvent >= firstEvent) return lastEvent - firstEvent + 1;
+  string fileName = getInputFile(options);
+  if (fileName.size() < 5 || fileName.compare(fileName.size() - 5, 5, ".root") != 0) {
+    fileName += ".root";
+  }
+  unique_ptr<TFile> file(TFile::Open(fileName.c_str(), "READ"));
+  if (!file || file->IsZombie()) return -1;
+  auto tree = dynamic_cast<TTree*>(file->Get("T"));
+  if (!tree) return -1;
+  long entries = tree->GetEntries();
+  if (firstEvent > 0) entries -= firstEvent;
+  return entries;
+}
@@ -0,0 +1,113 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file TaskProfiler.h
+ */
+
+#ifndef TASKPROFILER_H
+#define TASKPROFILER_H
+
+#include <boost/any.hpp>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <map>
+
+/**
+ * @brief Measurements of time and memory used by one task
+ *
+ * Profiler records duration of init, of each exec call (one time window)
+ * and of terminate, together with numbers of objects in the input and output
+ * windows. Latencies of windows are kept in a histogram with logarithmic bins,
+ * quantiles are estimated from it. Summaries of all finished tasks are written
+ * as JSON to the file given with Profiling_SummaryFile_std::string, each time
+ * a task finishes, so after the last task the file contains the whole run.
+ * Optionally a progress line with throughput and estimated time to the end
+ * is logged every Profiling_ProgressInterval_float seconds. CPU time is measured
+ * for the thread calling the task; bytes read and written are counted for
+ * the whole process, so they overlap for the tasks running at the same time.
+ * Peak memory of the task is the largest resident memory sampled at the ends
+ * of its phases and after every kRSSSampleInterval windows, so a short peak
+ * within the windows can be missed. The peak of the whole process is given separately.
+ */
+class TaskProfiler
+{
+public:
+  explicit TaskProfiler(const std::string& taskName);
+  void configure(const std::map<std::string, boost::any>& options);
+  bool isEnabled() const { return fEnabled; }
+  void beginInit();
+  void endInit();
+  void beginWindow();
+  void endWindow(unsigned long objectsIn, unsigned long objectsOut);
+  void recordWindow(double latency, unsigned long objectsIn, unsigned long objectsOut);
+  void beginTerminate();
+  void endTerminate();
+  void setExpectedWindows(long windows) { fExpectedWindows = windows; }
+  unsigned long getNumberOfWindows() const { return fNumberOfWindows; }
+  double getLatencyQuantile(double quantile) const;
+  std::string toJSON() const;
+  void logSummary() const;
+  static long getPeakRSS();
+  static long getCurrentRSS();
+  static double getThreadCPUTime();
+  static bool getIOBytes(unsigned long& readBytes, unsigned long& writtenBytes);
+  static void addToSummary(const std::string& fileName, const std::string& taskJSON);
+  static long countInputWindows(const std::map<std::string, boost::any>& options);
+
+  const std::string kEnabledParamKey = "Profiling_Enabled_bool";
+  const std::string kSummaryFileParamKey = "Profiling_SummaryFile_std::string";
+  const std::string kProgressIntervalParamKey = "Profiling_ProgressInterval_float";
+  /// Latency histogram covers 100 ns to 1000 s
+  static const int kBinsPerDecade = 20;
+  static const int kMinLatencyExponent = -7;
+  static const int kNumberOfDecades = 10;
+  /// Resident memory is read from /proc, so it is not sampled after each window
+  static const unsigned long kRSSSampleInterval = 64;
+
+private:
+  typedef std::chrono::steady_clock Clock;
+  static double secondsSince(const Clock::time_point& start);
+  void sampleRSS() { fPeakRSS = std::max(fPeakRSS, getCurrentRSS()); }
+  std::string fTaskName;
+  bool fEnabled = true;
+  std::string fSummaryFile = "taskProfile.json";
+  double fProgressInterval = 0.0;
+  long fExpectedWindows = -1;
+  Clock::time_point fStartTime;
+  Clock::time_point fPhaseStart;
+  Clock::time_point fLastProgress;
+  double fInitTime = 0.0;
+  double fExecTime = 0.0;
+  double fTerminateTime = 0.0;
+  double fWallTime = 0.0;
+  double fPhaseCPUStart = 0.0;
+  double fCPUTime = 0.0;
+  double fMaxLatency = 0.0;
+  unsigned long fNumberOfWindows = 0;
+  unsigned long fObjectsIn = 0;
+  unsigned long fObjectsOut = 0;
+  unsigned long fMaxObjectsIn = 0;
+  unsigned long fMaxObjectsOut = 0;
+  long fStartRSS = 0;
+  long fEndRSS = 0;
+  long fPeakRSS = 0; //peak of the task, sampled
+  long fProcessPeakRSS = 0; //peak of the process, including the earlier tasks
+  unsigned long fStartReadBytes = 0;
+  unsigned long fStartWrittenBytes = 0;
+  unsigned long fReadBytes = 0;
+  unsigned long fWrittenBytes = 0;
+  std::vector<unsigned long> fLatencyBins;
+};
+
+#endif /* !TASKPROFILER_H */
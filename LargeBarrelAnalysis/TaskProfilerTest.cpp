@@ -0,0 +1,98 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file TaskProfilerTest.cpp
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE TaskProfilerTest
+
+#include <boost/test/unit_test.hpp>
+#include "TaskProfiler.h"
+#include <cmath>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(TaskProfilerTestSuite)
+
+BOOST_AUTO_TEST_CASE(emptyProfiler_test)
+{
+  TaskProfiler profiler("EmptyTask");
+  BOOST_REQUIRE_EQUAL(profiler.getNumberOfWindows(), 0u);
+  BOOST_REQUIRE_EQUAL(profiler.getLatencyQuantile(0.5), 0.0);
+  BOOST_REQUIRE(profiler.toJSON().find("\"windows\": 0") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(latencyQuantiles_test)
+{
+  TaskProfiler profiler("TestTask");
+  for (int i = 0; i < 99; i++) { profiler.recordWindow(0.001, 10, 5); }
+  profiler.recordWindow(1.0, 20, 0);
+  BOOST_REQUIRE_EQUAL(profiler.getNumberOfWindows(), 100u);
+  // Quantiles are known up to the width of the logarithmic bin
+  double binWidth = std::pow(10.0, 1.0 / TaskProfiler::kBinsPerDecade);
+  BOOST_REQUIRE(profiler.getLatencyQuantile(0.5) >= 0.001);
+  BOOST_REQUIRE(profiler.getLatencyQuantile(0.5) <= 0.001 * binWidth);
+  BOOST_REQUIRE(profiler.getLatencyQuantile(0.99) <= 0.001 * binWidth);
+  BOOST_REQUIRE_CLOSE(profiler.getLatencyQuantile(1.0), 1.0, 0.001);
+  auto json = profiler.toJSON();
+  BOOST_REQUIRE(json.find("\"task\": \"TestTask\"") != std::string::npos);
+  BOOST_REQUIRE(json.find("\"objectsIn\": {\"total\": 1010") != std::string::npos);
+  BOOST_REQUIRE(json.find("\"objectsOut\": {\"total\": 495") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(memory_test)
+{
+  BOOST_REQUIRE(TaskProfiler::getPeakRSS() > 0);
+  BOOST_REQUIRE(TaskProfiler::getCurrentRSS() > 0);
+  // Kernel updates the two counters in batches, so they can differ by a few hundred kB
+  BOOST_REQUIRE(TaskProfiler::getCurrentRSS() <= TaskProfiler::getPeakRSS() + 1024);
+}
+
+BOOST_AUTO_TEST_CASE(taskPeakRSS_test)
+{
+  // Large allocation of an earlier stage raises the peak of the process only
+  {
+    std::vector<char> earlierStage(256 * 1024 * 1024, 1);
+    BOOST_REQUIRE(earlierStage.back() == 1);
+  }
+  std::map<std::string, boost::any> options;
+  TaskProfiler profiler("SmallTask");
+  options[profiler.kSummaryFileParamKey] = std::string("");
+  profiler.configure(options);
+  profiler.beginInit();
+  profiler.endInit();
+  profiler.beginWindow();
+  profiler.endWindow(1, 1);
+  profiler.beginTerminate();
+  profiler.endTerminate();
+  auto json = profiler.toJSON();
+  auto readValue = [&json](const std::string& key) {
+    return std::stol(json.substr(json.find("\"" + key + "\": ") + key.size() + 4));
+  };
+  long taskPeak = readValue("peakRSSKB");
+  long processPeak = readValue("processPeakRSSKB");
+  BOOST_REQUIRE(taskPeak > 0);
+  BOOST_REQUIRE(taskPeak >= readValue("rssEndKB"));
+  BOOST_REQUIRE(processPeak - taskPeak > 128 * 1024);
+}
+
+BOOST_AUTO_TEST_CASE(cpuTime_test)
+{
+  double start = TaskProfiler::getThreadCPUTime();
+  volatile double sum = 0.0;
+  for (int i = 0; i < 1000000; i++) { sum += std::sqrt((double) i); }
+  BOOST_REQUIRE(TaskProfiler::getThreadCPUTime() > start);
+  TaskProfiler profiler("CPUTask");
+  BOOST_REQUIRE(profiler.toJSON().find("\"cpuTime\": 0") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
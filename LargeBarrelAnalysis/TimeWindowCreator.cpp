@@ -73,17 +73,24 @@ bool TimeWindowCreator::init()
   if (isOptionSet(fParams.getOptions(), kSaveControlHistosParamKey)) {
     fSaveControlHistos = getOptionAsBool(fParams.getOptions(), kSaveControlHistosParamKey);
   }
+  // Directory of the binary cache of calibrations
+  std::string cacheDirectory;
+  if (isOptionSet(fParams.getOptions(), UniversalFileLoader::kCacheDirectoryParamKey)) {
+    cacheDirectory = getOptionAsString(fParams.getOptions(), UniversalFileLoader::kCacheDirectoryParamKey);
+  }
   // Use of Time Calibratin and Thresholds files
   JPetGeomMapping mapper(getParamBank());
   auto tombMap = mapper.getTOMBMapping();
-  fTimeCalibration = UniversalFileLoader::loadConfigurationParameters(calibFile, tombMap);
-  if (fTimeCalibration.empty()) {
+  auto run = getRunNumber(fParams.getOptions());
+  if (!fTimeCalibration.load(calibFile, tombMap, run, cacheDirectory)) {
     ERROR("Time Calibration seems to be empty");
   }
-  fThresholds = UniversalFileLoader::loadConfigurationParameters(thresholdFile, tombMap);
-  if (fThresholds.empty()) {
+  if (!fThresholds.load(thresholdFile, tombMap, run, cacheDirectory)) {
     ERROR("Thresholds values seem to be empty");
   }
+  // Times of windows are followed only for calibrations changing in time
+  fTimeDependentCalibration = fTimeCalibration.isTimeDependent() || fThresholds.isTimeDependent();
+  if (fTimeDependentCalibration) fWindowTimes.follow(fParams.getOptions(), fWindowWrapper);
 
   // Reference Detector
   // Take coordinates of the main (irradiated strip) from user parameters
@@ -116,17 +123,29 @@ bool TimeWindowCreator::init()
   }
 
   // Control histograms
-  if (fSaveControlHistos) { initialiseHistograms(); }
+  fHistoRegistry.configure(fParams.getOptions());
+  if (fSaveControlHistos) {
+    initialiseHistograms();
+    fHistos = TimeWindowCreatorTools::getHistos(getStatistics(), &fHistoRegistry);
+    fSigChPerTimeSlot = fHistoRegistry.resolve(getStatistics(), "sig_ch_per_time_slot");
+  }
   return true;
 }
 
 bool TimeWindowCreator::exec()
 {
   if (auto event = dynamic_cast<EventIII* const> (fEvent)) {
-    int kTDCChannels = event->GetTotalNTDCChannels();
-    if (fSaveControlHistos){
-      getStatistics().getHisto1D("sig_ch_per_time_slot")->Fill(kTDCChannels);
+    // Control histograms are filled only for the sampled windows
+    auto histos = fHistoRegistry.beginWindow() ? fHistos : TimeWindowCreatorHistos();
+    if (fTimeDependentCalibration) {
+      auto startTime = fWindowTimes.nextProcessedWindow().startTime;
+      fTimeCalibration.selectTime(startTime);
+      fThresholds.selectTime(startTime);
     }
+    const auto& timeCalibration = fTimeCalibration.getParameters();
+    const auto& thresholds = fThresholds.getParameters();
+    int kTDCChannels = event->GetTotalNTDCChannels();
+    fSigChPerTimeSlot.fill(kTDCChannels);
     // Loop over all TDC channels in file
     auto tdcChannels = event->GetTDCChannelsArray();
     for (int i = 0; i < kTDCChannels; ++i) {
@@ -150,27 +169,28 @@ bool TimeWindowCreator::exec()
 
       // Building Signal Channels for this TOMB Channel
       auto allSigChs = TimeWindowCreatorTools::buildSigChs(
-        tdcChannel, tombChannel, fTimeCalibration, fThresholds,
-        fMaxTime, fMinTime, fSetTHRValuesFromChannels,
-        getStatistics(), fSaveControlHistos
+        tdcChannel, tombChannel, timeCalibration, thresholds,
+        fMaxTime, fMinTime, fSetTHRValuesFromChannels, histos
       );
 
       // Sort Signal Channels in time
       TimeWindowCreatorTools::sortByValue(allSigChs);
 
       // Flag with Good or Corrupted
-      TimeWindowCreatorTools::flagSigChs(allSigChs, getStatistics(), fSaveControlHistos);
+      TimeWindowCreatorTools::flagSigChs(allSigChs, histos);
 
       // Save result
       saveSigChs(allSigChs);
     }
     fCurrEventNumber++;
+    fHistoRegistry.endWindow();
   } else { return false; }
   return true;
 }
 
 bool TimeWindowCreator::terminate()
 {
+  fHistoRegistry.merge();
   INFO("TimeSlot Creation Ended");
   return true;
 }
@@ -19,6 +19,10 @@
 #include <JPetTOMBChannel/JPetTOMBChannel.h>
 #include <JPetTimeWindow/JPetTimeWindow.h>
 #include <JPetUserTask/JPetUserTask.h>
+#include "TimeWindowCreatorTools.h"
+#include "HistogramHandles.h"
+#include "CalibrationStore.h"
+#include "WindowIndex.h"
 #include <map>
 #include <set>
 
@@ -36,8 +40,10 @@ class JPetWriter;
  * provided. Moreover time calibration and threshold values injection can be
  * performed, if ASCII files of standard format were provided. In case of errors,
  * creation of Time Windows continues without this additional information.
+ * Calibrations may change in time (see CalibrationStore.h), then parameters
+ * valid at the start time of each window are used.
  */
-class TimeWindowCreator: public JPetUserTask
+class TimeWindowCreator: public JPetUserTask, public WindowFollower
 {
 public:
 	TimeWindowCreator(const char* name);
@@ -57,8 +63,10 @@ protected:
 	const std::string kMinTimeParamKey = "TimeWindowCreator_MinTime_float";
 	const std::string kMainStripKey = "TimeWindowCreator_MainStrip_int";
 	const int kNumOfThresholds = 4;
-	std::map<unsigned int, std::vector<double>> fTimeCalibration;
-	std::map<unsigned int, std::vector<double>> fThresholds;
+	CalibrationStore fTimeCalibration;
+	CalibrationStore fThresholds;
+	bool fTimeDependentCalibration = false;
+	WindowIndexer fWindowTimes;
 	bool fSetTHRValuesFromChannels = false;
 	long long int fCurrEventNumber = 0;
 	std::set<int> fAllowedChannels;
@@ -67,6 +75,9 @@ protected:
 	bool fMainStripSet = false;
 	double fMinTime = -1.e6;
 	double fMaxTime = 0.;
+	HistoRegistry fHistoRegistry;
+	TimeWindowCreatorHistos fHistos;
+	HistoHandle fSigChPerTimeSlot;
 };
 
 #endif /* !TIMEWINDOWCREATOR_H */
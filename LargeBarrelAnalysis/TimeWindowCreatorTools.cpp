@@ -18,6 +18,32 @@
 
 using namespace std;
 
+/**
+ * Resolving handles of the control histograms. Without the registry,
+ * handles fill the histograms directly.
+ */
+TimeWindowCreatorHistos TimeWindowCreatorTools::getHistos(
+  JPetStatistics& stats, HistoRegistry* registry
+) {
+  auto resolve = [&stats, registry] (const string& name) {
+    return registry ? registry->resolve(stats, name) : HistoHandle::direct(stats, name);
+  };
+  TimeWindowCreatorHistos histos;
+  histos.enabled = true;
+  for (int thr = 1; thr <= 4; thr++) {
+    histos.pmOccupation[thr-1] = resolve(Form("pm_occupation_thr%d", thr));
+  }
+  histos.goodVsBadSigCh = resolve("good_vs_bad_sigch");
+  histos.ltTimeDiff = resolve("LT_time_diff");
+  histos.llPerPM = resolve("LL_per_PM");
+  histos.llPerTHR = resolve("LL_per_THR");
+  histos.llTimeDiff = resolve("LL_time_diff");
+  histos.ttPerPM = resolve("TT_per_PM");
+  histos.ttPerTHR = resolve("TT_per_THR");
+  histos.ttTimeDiff = resolve("TT_time_diff");
+  return histos;
+}
+
 /**
  * Sorting method for Signal Channels by time value
  */
@@ -35,12 +61,17 @@ using namespace std;
  */
 vector<JPetSigCh> TimeWindowCreatorTools::buildSigChs(
   TDCChannel* tdcChannel, const JPetTOMBChannel& tombChannel,
-  map<unsigned int, vector<double>>& timeCalibrationMap,
-  map<unsigned int, vector<double>>& thresholdsMap,
+  const map<unsigned int, vector<double>>& timeCalibrationMap,
+  const map<unsigned int, vector<double>>& thresholdsMap,
   double maxTime, double minTime, bool setTHRValuesFromChannels,
-  JPetStatistics& stats, bool saveHistos
+  const TimeWindowCreatorHistos& histos
 ){
   vector<JPetSigCh> allTDCSigChs;
+  const HistoHandle* occupation = nullptr;
+  int thrNumber = tombChannel.getLocalChannelNumber();
+  if (histos.enabled && thrNumber >= 1 && thrNumber <= 4) {
+    occupation = &histos.pmOccupation[thrNumber-1];
+  }
   // Loop over all entries on leading edge in current TOMBChannel and create SigCh
   for (int j = 0; j < tdcChannel->GetLeadHitsNum(); j++) {
     auto leadTime = tdcChannel->GetLeadTime(j);
@@ -50,10 +81,7 @@ vector<JPetSigCh> TimeWindowCreatorTools::buildSigChs(
       JPetSigCh::Leading, setTHRValuesFromChannels
     );
     allTDCSigChs.push_back(leadSigCh);
-    if (saveHistos){
-      stats.getHisto1D(Form("pm_occupation_thr%d", tombChannel.getLocalChannelNumber()))
-        ->Fill(tombChannel.getPM().getID());
-    }
+    if (occupation) { occupation->fill(tombChannel.getPM().getID()); }
   }
   // Loop over all entries on trailing edge in current TOMBChannel and create SigCh
   for (int j = 0; j < tdcChannel->GetTrailHitsNum(); j++) {
@@ -64,10 +92,7 @@ vector<JPetSigCh> TimeWindowCreatorTools::buildSigChs(
       JPetSigCh::Trailing, setTHRValuesFromChannels
     );
     allTDCSigChs.push_back(trailSigCh);
-    if (saveHistos){
-      stats.getHisto1D(Form("pm_occupation_thr%d", tombChannel.getLocalChannelNumber()))
-        ->Fill(tombChannel.getPM().getID());
-    }
+    if (occupation) { occupation->fill(tombChannel.getPM().getID()); }
   }
   return allTDCSigChs;
 }
@@ -81,12 +106,13 @@ vector<JPetSigCh> TimeWindowCreatorTools::buildSigChs(
  * flag      -> GGGGGG  CGG  CGGC  CCCGGCCC  CGGCGGGGCCCCCGGC
  */
 void TimeWindowCreatorTools::flagSigChs(
-  vector<JPetSigCh>& inputSigChs, JPetStatistics& stats, bool saveHistos
+  vector<JPetSigCh>& inputSigChs, const TimeWindowCreatorHistos& histos
 ) {
+  bool saveHistos = histos.enabled;
   for(unsigned int i=0; i<inputSigChs.size(); i++) {
     if(i == inputSigChs.size()-1) {
       inputSigChs.at(i).setRecoFlag(JPetSigCh::Good);
-      if(saveHistos){ stats.getHisto1D("good_vs_bad_sigch")->Fill(1); }
+      if(saveHistos){ histos.goodVsBadSigCh.fill(1); }
       break;
     }
     auto& sigCh1 = inputSigChs.at(i);
@@ -96,21 +122,21 @@ void TimeWindowCreatorTools::flagSigChs(
       sigCh1.setRecoFlag(JPetSigCh::Good);
       sigCh2.setRecoFlag(JPetSigCh::Good);
       if(saveHistos){
-        stats.getHisto1D("LT_time_diff")->Fill(sigCh2.getValue()-sigCh1.getValue());
-        stats.getHisto1D("good_vs_bad_sigch")->Fill(1, 2);
+        histos.ltTimeDiff.fill(sigCh2.getValue()-sigCh1.getValue());
+        histos.goodVsBadSigCh.fill(1, 2);
       }
     } else if (sigCh1.getType() == JPetSigCh::Trailing && sigCh2.getType() == JPetSigCh::Leading) {
       sigCh1.setRecoFlag(JPetSigCh::Good);
       if(saveHistos){
-        stats.getHisto1D("good_vs_bad_sigch")->Fill(1);
+        histos.goodVsBadSigCh.fill(1);
       }
     } else if (sigCh1.getType() == JPetSigCh::Leading && sigCh2.getType() == JPetSigCh::Leading) {
       sigCh1.setRecoFlag(JPetSigCh::Corrupted);
       if(saveHistos){
-        stats.getHisto1D("good_vs_bad_sigch")->Fill(2);
-        stats.getHisto1D("LL_per_PM")->Fill(sigCh1.getPM().getID());
-        stats.getHisto1D("LL_per_THR")->Fill(sigCh1.getThresholdNumber());
-        stats.getHisto1D("LL_time_diff")->Fill(sigCh2.getValue()-sigCh1.getValue());
+        histos.goodVsBadSigCh.fill(2);
+        histos.llPerPM.fill(sigCh1.getPM().getID());
+        histos.llPerTHR.fill(sigCh1.getThresholdNumber());
+        histos.llTimeDiff.fill(sigCh2.getValue()-sigCh1.getValue());
       }
     } else if (sigCh1.getType() == JPetSigCh::Trailing && sigCh2.getType() == JPetSigCh::Trailing){
       if(sigCh1.getRecoFlag() == JPetSigCh::Unknown) {
@@ -118,14 +144,14 @@ void TimeWindowCreatorTools::flagSigChs(
       }
       sigCh2.setRecoFlag(JPetSigCh::Corrupted);
       if(saveHistos){
-        stats.getHisto1D("good_vs_bad_sigch")->Fill(2);
-        stats.getHisto1D("TT_per_PM")->Fill(sigCh1.getPM().getID());
-        stats.getHisto1D("TT_per_THR")->Fill(sigCh1.getThresholdNumber());
-        stats.getHisto1D("TT_time_diff")->Fill(sigCh2.getValue()-sigCh1.getValue());
+        histos.goodVsBadSigCh.fill(2);
+        histos.ttPerPM.fill(sigCh1.getPM().getID());
+        histos.ttPerTHR.fill(sigCh1.getThresholdNumber());
+        histos.ttTimeDiff.fill(sigCh2.getValue()-sigCh1.getValue());
       }
     }
     if(sigCh1.getRecoFlag() == JPetSigCh::Unknown && saveHistos){
-      stats.getHisto1D("good_vs_bad_sigch")->Fill(3);
+      histos.goodVsBadSigCh.fill(3);
     }
   }
 }
@@ -135,8 +161,8 @@ void TimeWindowCreatorTools::flagSigChs(
 */
 JPetSigCh TimeWindowCreatorTools::generateSigCh(
   double tdcChannelTime, const JPetTOMBChannel& channel,
-  map<unsigned int, vector<double>>& timeCalibrationMap,
-  map<unsigned int, vector<double>>& thresholdsMap,
+  const map<unsigned int, vector<double>>& timeCalibrationMap,
+  const map<unsigned int, vector<double>>& thresholdsMap,
   JPetSigCh::EdgeType edge, bool setTHRValuesFromChannels
 ) {
   JPetSigCh sigCh;
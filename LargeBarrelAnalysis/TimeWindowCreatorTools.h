@@ -21,8 +21,25 @@
 #include <JPetStatistics/JPetStatistics.h>
 #include <JPetParamBank/JPetParamBank.h>
 #include <JPetSigCh/JPetSigCh.h>
+#include "HistogramHandles.h"
 #include <vector>
 
+/**
+* @brief Handles of the control histograms filled by the Time Window Creator tools
+*/
+struct TimeWindowCreatorHistos {
+  bool enabled = false;
+  HistoHandle pmOccupation[4];
+  HistoHandle goodVsBadSigCh;
+  HistoHandle ltTimeDiff;
+  HistoHandle llPerPM;
+  HistoHandle llPerTHR;
+  HistoHandle llTimeDiff;
+  HistoHandle ttPerPM;
+  HistoHandle ttPerTHR;
+  HistoHandle ttTimeDiff;
+};
+
 /**
 * @brief Set of tools for Time Window Creator task
 *
@@ -31,21 +48,22 @@
 class TimeWindowCreatorTools
 {
 public:
+  static TimeWindowCreatorHistos getHistos(JPetStatistics& stats, HistoRegistry* registry = nullptr);
   static void sortByValue(std::vector<JPetSigCh>& input);
   static std::vector<JPetSigCh> buildSigChs(
     TDCChannel* tdcChannel, const JPetTOMBChannel& channel,
-    std::map<unsigned int, std::vector<double>>& timeCalibrationMap,
-    std::map<unsigned int, std::vector<double>>& thresholdsMap,
+    const std::map<unsigned int, std::vector<double>>& timeCalibrationMap,
+    const std::map<unsigned int, std::vector<double>>& thresholdsMap,
     double maxTime, double minTime, bool setTHRValuesFromChannels,
-    JPetStatistics& stats, bool saveHistos
+    const TimeWindowCreatorHistos& histos
   );
   static void flagSigChs(
-    std::vector<JPetSigCh>& inputSigChs, JPetStatistics& stats, bool saveHistos
+    std::vector<JPetSigCh>& inputSigChs, const TimeWindowCreatorHistos& histos
   );
   static JPetSigCh generateSigCh(
     double tdcChannelTime, const JPetTOMBChannel& channel,
-    std::map<unsigned int, std::vector<double>>& timeCalibrationMap,
-    std::map<unsigned int, std::vector<double>>& thresholdsMap,
+    const std::map<unsigned int, std::vector<double>>& timeCalibrationMap,
+    const std::map<unsigned int, std::vector<double>>& thresholdsMap,
     JPetSigCh::EdgeType edge, bool setTHRValuesFromChannels
   );
 };
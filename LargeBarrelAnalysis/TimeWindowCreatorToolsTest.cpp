@@ -201,8 +201,7 @@ BOOST_AUTO_TEST_CASE(flagSigChs_test)
   thrSigCh.push_back(sigCh27);
   thrSigCh.push_back(sigCh28);
 
-  JPetStatistics stats;
-  TimeWindowCreatorTools::flagSigChs(thrSigCh, stats, false);
+  TimeWindowCreatorTools::flagSigChs(thrSigCh, TimeWindowCreatorHistos());
   BOOST_REQUIRE_EQUAL(thrSigCh.at(0).getRecoFlag(), JPetSigCh::Good);
   BOOST_REQUIRE_EQUAL(thrSigCh.at(1).getRecoFlag(), JPetSigCh::Good);
 
@@ -0,0 +1,203 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file Tracing.cpp
+ */
+
+#include <JPetOptionsTools/JPetOptionsTools.h>
+#include "JPetLoggerInclude.h"
+#include "Tracing.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <set>
+
+using namespace jpet_options_tools;
+using namespace std;
+
+namespace
+{
+const string kFileParamKey = "Tracing_File_std::string";
+const string kBufferSizeParamKey = "Tracing_BufferSize_int";
+
+struct Span {
+  const char* name;
+  const char* category;
+  uint64_t start;
+  uint64_t end;
+};
+
+/// Ring buffer of one thread, written only by this thread
+struct ThreadBuffer {
+  unsigned threadId = 0;
+  vector<Span> spans;
+  size_t next = 0;
+  size_t count = 0;
+};
+
+mutex gRegistryMutex;
+vector<unique_ptr<ThreadBuffer>> gBuffers;
+set<string> gNames;
+size_t gBufferSize = Tracer::kDefaultBufferSize;
+string gTraceFile;
+/// Changed by clear(), so that threads register new buffers
+atomic<unsigned> gGeneration(0);
+const chrono::steady_clock::time_point gEpoch = chrono::steady_clock::now();
+
+ThreadBuffer* getThreadBuffer()
+{
+  thread_local ThreadBuffer* buffer = nullptr;
+  thread_local unsigned generation = 0;
+  unsigned currentGeneration = gGeneration.load(memory_order_acquire);
+  if (!buffer || generation != currentGeneration) {
+    lock_guard<mutex> lock(gRegistryMutex);
+    gBuffers.push_back(unique_ptr<ThreadBuffer>(new ThreadBuffer()));
+    buffer = gBuffers.back().get();
+    buffer->threadId = gBuffers.size();
+    buffer->spans.resize(gBufferSize);
+    generation = currentGeneration;
+  }
+  return buffer;
+}
+
+void writeEscaped(ostream& stream, const char* text)
+{
+  for (; *text; text++) {
+    if (*text == '"' || *text == '\\') stream << '\\';
+    stream << *text;
+  }
+}
+}
+
+atomic<bool> Tracer::fgEnabled(false);
+
+void Tracer::configure(const map<string, boost::any>& options)
+{
+  if (!isOptionSet(options, kFileParamKey)) return;
+  string fileName = getOptionAsString(options, kFileParamKey);
+  if (fileName.empty() || isEnabled()) return;
+  size_t bufferSize = kDefaultBufferSize;
+  if (isOptionSet(options, kBufferSizeParamKey)) {
+    int size = getOptionAsInt(options, kBufferSizeParamKey);
+    if (size > 0) bufferSize = size;
+    else WARNING(Form("Wrong value of the %s parameter, using default size.", kBufferSizeParamKey.c_str()));
+  }
+  {
+    lock_guard<mutex> lock(gRegistryMutex);
+    gTraceFile = fileName;
+  }
+  enable(bufferSize);
+  INFO(Form("Tracing enabled, timeline will be saved in %s", fileName.c_str()));
+}
+
+void Tracer::enable(size_t bufferSize)
+{
+  {
+    lock_guard<mutex> lock(gRegistryMutex);
+    gBufferSize = max<size_t>(bufferSize, 1);
+  }
+  fgEnabled.store(true, memory_order_relaxed);
+}
+
+void Tracer::disable()
+{
+  fgEnabled.store(false, memory_order_relaxed);
+}
+
+/**
+* Removing all recorded spans, has to be called when no other thread is recording
+*/
+void Tracer::clear()
+{
+  lock_guard<mutex> lock(gRegistryMutex);
+  gBuffers.clear();
+  gGeneration++;
+}
+
+/**
+* Nanoseconds since the start of the program, always greater than zero
+*/
+uint64_t Tracer::now()
+{
+  return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - gEpoch).count() + 1;
+}
+
+void Tracer::record(const char* name, const char* category, uint64_t start, uint64_t end)
+{
+  auto buffer = getThreadBuffer();
+  buffer->spans[buffer->next] = Span{name, category, start, end};
+  buffer->next = (buffer->next + 1) % buffer->spans.size();
+  buffer->count = min(buffer->count + 1, buffer->spans.size());
+}
+
+const char* Tracer::internName(const string& name)
+{
+  lock_guard<mutex> lock(gRegistryMutex);
+  return gNames.insert(name).first->c_str();
+}
+
+size_t Tracer::getNumberOfSpans()
+{
+  lock_guard<mutex> lock(gRegistryMutex);
+  size_t spans = 0;
+  for (const auto& buffer : gBuffers) spans += buffer->count;
+  return spans;
+}
+
+/**
+* Saving all spans as complete events of the Chrome trace format, in microseconds.
+* Has to be called when no other thread is recording.
+*/
+bool Tracer::dump(const string& fileName)
+{
+  lock_guard<mutex> lock(gRegistryMutex);
+  ofstream traceFile(fileName);
+  if (!traceFile.is_open()) {
+    ERROR(Form("Unable to open file %s for the trace", fileName.c_str()));
+    return false;
+  }
+  traceFile << fixed << setprecision(3);
+  traceFile << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+  bool first = true;
+  for (const auto& buffer : gBuffers) {
+    size_t size = buffer->spans.size();
+    size_t oldest = (buffer->next + size - buffer->count) % size;
+    for (size_t i = 0; i < buffer->count; i++) {
+      const auto& span = buffer->spans[(oldest + i) % size];
+      traceFile << (first ? "\n" : ",\n") << "{\"name\": \"";
+      writeEscaped(traceFile, span.name);
+      traceFile << "\", \"cat\": \"";
+      writeEscaped(traceFile, span.category);
+      traceFile << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->threadId
+        << ", \"ts\": " << span.start / 1000.0
+        << ", \"dur\": " << (span.end - span.start) / 1000.0 << "}";
+      first = false;
+    }
+  }
+  traceFile << "\n]}" << endl;
+  return true;
+}
+
+bool Tracer::dumpConfigured()
+{
+  string fileName;
+  {
+    lock_guard<mutex> lock(gRegistryMutex);
+    fileName = gTraceFile;
+  }
+  if (fileName.empty()) return true;
+  return dump(fileName);
+}
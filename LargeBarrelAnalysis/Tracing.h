@@ -0,0 +1,80 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file Tracing.h
+ */
+
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <boost/any.hpp>
+#include <cstdint>
+#include <atomic>
+#include <string>
+#include <map>
+
+/**
+ * @brief Recorder of time spans for the timeline of the run
+ *
+ * Spans are stored in a ring buffer of the thread that recorded them, so only
+ * the oldest spans are lost, if the buffer is too small. When tracing is disabled,
+ * a span costs one check of the flag. Recorded spans are saved as Chrome trace
+ * JSON, that can be opened with about:tracing or Perfetto. Tracing is enabled
+ * by giving the name of the file with Tracing_File_std::string; the file is
+ * rewritten at the end of each task, so after the last one it holds the whole run.
+ * Names and categories have to live until the dump - string literals,
+ * or names returned by internName().
+ */
+class Tracer
+{
+public:
+  static void configure(const std::map<std::string, boost::any>& options);
+  static bool isEnabled() { return fgEnabled.load(std::memory_order_relaxed); }
+  static void enable(std::size_t bufferSize = kDefaultBufferSize);
+  static void disable();
+  static void clear();
+  static uint64_t now();
+  static void record(const char* name, const char* category, uint64_t start, uint64_t end);
+  static const char* internName(const std::string& name);
+  static std::size_t getNumberOfSpans();
+  static bool dump(const std::string& fileName);
+  static bool dumpConfigured();
+
+  static const std::size_t kDefaultBufferSize = 1 << 16;
+
+private:
+  static std::atomic<bool> fgEnabled;
+};
+
+/**
+ * @brief Span recorded from its construction to the end of the scope
+ */
+class TraceSpan
+{
+public:
+  TraceSpan(const char* name, const char* category = "task"): fName(name), fCategory(category)
+  {
+    if (Tracer::isEnabled()) fStart = Tracer::now();
+  }
+
+  ~TraceSpan()
+  {
+    if (fStart) Tracer::record(fName, fCategory, fStart, Tracer::now());
+  }
+
+private:
+  const char* fName;
+  const char* fCategory;
+  uint64_t fStart = 0;
+};
+
+#endif /* !TRACING_H */
@@ -0,0 +1,78 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file TracingTest.cpp
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE TracingTest
+
+#include <boost/test/unit_test.hpp>
+#include "Tracing.h"
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE(TracingTestSuite)
+
+BOOST_AUTO_TEST_CASE(disabled_test)
+{
+  Tracer::disable();
+  Tracer::clear();
+  { TraceSpan span("disabled"); }
+  BOOST_REQUIRE_EQUAL(Tracer::getNumberOfSpans(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(spansFromThreads_test)
+{
+  Tracer::clear();
+  Tracer::enable(16);
+  { TraceSpan span("main", "test"); }
+  std::thread worker([]() {
+    for (int i = 0; i < 3; i++) { TraceSpan span("worker", "test"); }
+  });
+  worker.join();
+  Tracer::disable();
+  BOOST_REQUIRE_EQUAL(Tracer::getNumberOfSpans(), 4u);
+}
+
+BOOST_AUTO_TEST_CASE(ringBuffer_test)
+{
+  Tracer::clear();
+  Tracer::enable(8);
+  for (int i = 0; i < 20; i++) { TraceSpan span("overwritten", "test"); }
+  Tracer::disable();
+  BOOST_REQUIRE_EQUAL(Tracer::getNumberOfSpans(), 8u);
+}
+
+BOOST_AUTO_TEST_CASE(dump_test)
+{
+  Tracer::clear();
+  Tracer::enable(16);
+  const char* name = Tracer::internName(std::string("Task\"Name"));
+  BOOST_REQUIRE_EQUAL(name, Tracer::internName("Task\"Name"));
+  Tracer::record(name, "task", 1000, 3500);
+  Tracer::disable();
+  std::string fileName = "tracingTest.json";
+  BOOST_REQUIRE(Tracer::dump(fileName));
+  std::ifstream traceFile(fileName);
+  std::stringstream content;
+  content << traceFile.rdbuf();
+  std::remove(fileName.c_str());
+  auto trace = content.str();
+  BOOST_REQUIRE(trace.find("\"traceEvents\"") != std::string::npos);
+  BOOST_REQUIRE(trace.find("\"name\": \"Task\\\"Name\"") != std::string::npos);
+  BOOST_REQUIRE(trace.find("\"ts\": 1.000, \"dur\": 2.500") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
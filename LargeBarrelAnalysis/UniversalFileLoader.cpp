@@ -13,13 +13,105 @@
  *  @file UniversalFileLoader.cpp
  */
 
-#include <boost/algorithm/string/predicate.hpp>
 #include <boost/filesystem.hpp>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <algorithm>
-#include <sstream>
+#include <unistd.h>
+#include <fcntl.h>
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <cstdio>
 #include "UniversalFileLoader.h"
 #include "JPetLoggerInclude.h"
 
+namespace
+{
+const char kCacheMagic[8] = {'J', 'P', 'E', 'T', 'C', 'C', 'A', 'L'};
+const uint32_t kCacheVersion = 1;
+const uint32_t kCacheByteOrder = 0x01020304;
+const size_t kNumberOfParameters = 8;
+
+struct CacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint64_t key;
+  uint64_t numberOfRecords;
+};
+
+struct CacheRecord {
+  uint32_t channel;
+  uint32_t numberOfParameters;
+  double parameters[kNumberOfParameters];
+};
+
+/**
+ * FNV-1a hash of the bytes, continuing from the given hash
+ */
+uint64_t hashBytes(const void* data, size_t size, uint64_t hash)
+{
+  auto bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+bool readFile(const std::string& fileName, std::string& contents)
+{
+  std::ifstream file(fileName, std::ios::binary);
+  if (!file) return false;
+  file.seekg(0, std::ios::end);
+  contents.resize(static_cast<size_t>(file.tellg()));
+  file.seekg(0);
+  return static_cast<bool>(file.read(&contents[0], contents.size()));
+}
+
+/**
+ * Parsing of one line, from begin to end, with the same rules as reading
+ * the fields with a stream: side is the first character after the slot,
+ * fields after the 12th one are ignored. Numbers are read in place, the text
+ * after the end of the line is never taken, as it is checked after each field.
+ */
+bool parseLine(const char* begin, const char* end, ConfRecord& record)
+{
+  const char* cursor = begin;
+  long fields[3] = {-1, -1, -1};
+  double parameters[kNumberOfParameters];
+  char side = 'A';
+  for (int field = 0; field < 3; field++) {
+    char* next = nullptr;
+    fields[field] = strtol(cursor, &next, 10);
+    if (next == cursor || next > end) return false;
+    cursor = next;
+    if (field == 1) {
+      while (cursor < end && isspace(static_cast<unsigned char>(*cursor))) cursor++;
+      if (cursor == end) return false;
+      side = *cursor++;
+    }
+  }
+  for (size_t i = 0; i < kNumberOfParameters; i++) {
+    char* next = nullptr;
+    parameters[i] = strtod(cursor, &next);
+    if (next == cursor || next > end) return false;
+    cursor = next;
+  }
+  if (side != 'A' && side != 'B') return false;
+  record.layer = fields[0];
+  record.slot = fields[1];
+  record.side = side == 'A' ? JPetPM::SideA : JPetPM::SideB;
+  record.thresholdNumber = fields[2];
+  record.parameters.assign(parameters, parameters + kNumberOfParameters);
+  return true;
+}
+}
+
+const std::string UniversalFileLoader::kCacheDirectoryParamKey = "CalibrationCache_Directory_std::string";
+
 /**
  * Method returns a patameter for given TOMB channel
  */
@@ -38,20 +130,38 @@ double UniversalFileLoader::getConfigurationParameter(
 /**
  * Method loading parameters from ASCII file
  * Arguments: file name string, TOMBChMap object containing the dependency
- * between layer, barrel slot, PM side, threshold and TOMB channel number.
+ * between layer, barrel slot, PM side, threshold and TOMB channel number,
+ * and the directory of the binary cache. If the directory is given, parameters
+ * are taken from the cache made for the same contents of the file and the same
+ * TOMB mapping, with no parsing, or the cache is written after parsing.
  */
 UniversalFileLoader::TOMBChToParameter UniversalFileLoader::loadConfigurationParameters(
   const std::string& confFile,
-  const UniversalFileLoader::TOMBChMap& tombMap)
+  const UniversalFileLoader::TOMBChMap& tombMap,
+  const std::string& cacheDirectory)
 {
   INFO("Loading parameters from file: " + confFile);
-  if (!boost::filesystem::exists(confFile)) {
+  TOMBChToParameter configurationParameters;
+  std::string contents;
+  if (!boost::filesystem::exists(confFile) || !readFile(confFile, contents)) {
     ERROR("Configuration file does not exist: " + confFile + " Returning empty configuration.");
-    TOMBChToParameter cofigurationParamteres;
-    return cofigurationParamteres;
+    return configurationParameters;
+  }
+  std::string cacheFile;
+  uint64_t key = 0;
+  if (!cacheDirectory.empty()) {
+    key = getCacheKey(contents, tombMap);
+    cacheFile = getCacheFileName(confFile, cacheDirectory, key);
+    if (loadCache(cacheFile, key, configurationParameters)) {
+      INFO("Parameters taken from the cache: " + cacheFile);
+      return configurationParameters;
+    }
+  }
+  configurationParameters = generateConfigurationParameters(parseConfigurationParameters(contents), tombMap);
+  if (!cacheFile.empty() && !configurationParameters.empty()) {
+    saveCache(cacheFile, key, configurationParameters);
   }
-  auto confRecords = readConfigurationParametersFromFile(confFile);
-  return generateConfigurationParameters(confRecords, tombMap);
+  return configurationParameters;
 }
 
 /**
@@ -74,10 +184,9 @@ UniversalFileLoader::TOMBChToParameter UniversalFileLoader::generateConfiguratio
         configurationParamteres.begin()),
         [&tombMap] (const ConfRecord & confRecord) {
           auto key = std::make_tuple(confRecord.layer, confRecord.slot, confRecord.side, confRecord.thresholdNumber);
-          auto parameters = confRecord.parameters;
-          if (tombMap.find(key) != tombMap.end()) {
-            auto tombCh = tombMap.at(key);
-            return std::make_pair(tombCh, parameters);
+          auto tombCh = tombMap.find(key);
+          if (tombCh != tombMap.end()) {
+            return std::make_pair(tombCh->second, confRecord.parameters);
           } else {
             ERROR("No TOMB channel number in TOMB MAP for the configuration: layer = "
               + std::to_string(confRecord.layer)
@@ -102,20 +211,30 @@ UniversalFileLoader::TOMBChToParameter UniversalFileLoader::generateConfiguratio
 std::vector<ConfRecord> UniversalFileLoader::readConfigurationParametersFromFile(
   const std::string& confFile)
 {
-  using namespace std;
-  namespace ba = boost::algorithm;
-
-  vector<ConfRecord> confRecords;
-  string inputLine;
-  vector<double> inputParameters;
-  ConfRecord confRecord = { -1, -1, JPetPM::SideA, -1, inputParameters};
-  ifstream inputFile(confFile);
-  while (getline(inputFile, inputLine)) {
-    if (ba::starts_with(inputLine, "#")) continue;
-    else {
-      if (fillConfRecord(inputLine, confRecord)) confRecords.push_back(confRecord);
-      else ERROR("Line from the configuration file seems to be incorrect:" + inputLine);
+  std::string contents;
+  if (!readFile(confFile, contents)) return std::vector<ConfRecord>();
+  return parseConfigurationParameters(contents);
+}
+
+/**
+ * Method generates a vector of ConfRecords from the whole contents
+ * of the file, line by line, in place in the buffer.
+ */
+std::vector<ConfRecord> UniversalFileLoader::parseConfigurationParameters(
+  const std::string& contents)
+{
+  std::vector<ConfRecord> confRecords;
+  ConfRecord confRecord = { -1, -1, JPetPM::SideA, -1, std::vector<double>()};
+  const char* data = contents.c_str();
+  size_t position = 0;
+  while (position < contents.size()) {
+    size_t lineEnd = contents.find('\n', position);
+    if (lineEnd == std::string::npos) lineEnd = contents.size();
+    if (data[position] != '#') {
+      if (parseLine(data + position, data + lineEnd, confRecord)) confRecords.push_back(confRecord);
+      else ERROR("Line from the configuration file seems to be incorrect:" + contents.substr(position, lineEnd - position));
     }
+    position = lineEnd + 1;
   }
   return confRecords;
 }
@@ -157,25 +276,119 @@ bool UniversalFileLoader::fillConfRecord(
   const std::string& input,
   ConfRecord& outRecord)
 {
-  using namespace std;
-  int layer = -1;
-  int slot = -1;
-  char side = 'A';
-  int thr = -1;
-  vector<double> inputParameters = {0.0,0.0,0.0,0.0,0.0,0.0,0.0,0.0};
-  istringstream stream(input);
-  stream >> layer >> slot >> side >> thr
-  >> inputParameters.at(0) >> inputParameters.at(1) >> inputParameters.at(2)
-  >> inputParameters.at(3) >> inputParameters.at(4) >> inputParameters.at(5)
-  >> inputParameters.at(6) >> inputParameters.at(7);
-  if (stream.fail() || (side != 'A' && side != 'B')) return false;
-  else {
-    outRecord.layer = layer;
-    outRecord.slot = slot;
-    if (side == 'A') outRecord.side = JPetPM::SideA;
-    else outRecord.side = JPetPM::SideB;
-    outRecord.thresholdNumber = thr;
-    outRecord.parameters = inputParameters;
-    return true;
+  return parseLine(input.c_str(), input.c_str() + input.size(), outRecord);
+}
+
+/**
+ * Key of the cache: hash of the version of the cache, contents of the file
+ * and all entries of the TOMB mapping
+ */
+uint64_t UniversalFileLoader::getCacheKey(
+  const std::string& contents,
+  const UniversalFileLoader::TOMBChMap& tombMap)
+{
+  uint64_t hash = hashBytes(&kCacheVersion, sizeof(kCacheVersion), 14695981039346656037ull);
+  hash = hashBytes(contents.data(), contents.size(), hash);
+  for (const auto& entry : tombMap) {
+    int32_t fields[5] = {
+      std::get<0>(entry.first), std::get<1>(entry.first), std::get<2>(entry.first),
+      std::get<3>(entry.first), entry.second
+    };
+    hash = hashBytes(fields, sizeof(fields), hash);
+  }
+  return hash;
+}
+
+/**
+ * Cache of calib.txt is saved as calib.txt.<key>.cache in the cache directory
+ */
+std::string UniversalFileLoader::getCacheFileName(
+  const std::string& confFile,
+  const std::string& cacheDirectory,
+  uint64_t key)
+{
+  char keyText[17];
+  snprintf(keyText, sizeof(keyText), "%016llx", static_cast<unsigned long long>(key));
+  return cacheDirectory + "/" + boost::filesystem::path(confFile).filename().string() + "." + keyText + ".cache";
+}
+
+/**
+ * Method reads the parameters from the cache mapped into memory.
+ * Returns false if there is no cache or it was made for other key.
+ */
+bool UniversalFileLoader::loadCache(
+  const std::string& cacheFile,
+  uint64_t key,
+  UniversalFileLoader::TOMBChToParameter& parameters)
+{
+  int descriptor = open(cacheFile.c_str(), O_RDONLY);
+  if (descriptor < 0) return false;
+  struct stat status;
+  if (fstat(descriptor, &status) != 0 || status.st_size < (off_t) sizeof(CacheHeader)) {
+    close(descriptor);
+    return false;
+  }
+  void* data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  close(descriptor);
+  if (data == MAP_FAILED) return false;
+  auto header = static_cast<const CacheHeader*>(data);
+  bool valid = memcmp(header->magic, kCacheMagic, sizeof(kCacheMagic)) == 0
+    && header->version == kCacheVersion && header->byteOrder == kCacheByteOrder && header->key == key
+    && sizeof(CacheHeader) + header->numberOfRecords * sizeof(CacheRecord) == (size_t) status.st_size;
+  if (valid) {
+    parameters.clear();
+    auto records = reinterpret_cast<const CacheRecord*>(header + 1);
+    // Records are sorted by channels, as they were saved from the map
+    for (uint64_t i = 0; i < header->numberOfRecords; i++) {
+      auto count = std::min<size_t>(records[i].numberOfParameters, kNumberOfParameters);
+      parameters.emplace_hint(parameters.end(), records[i].channel,
+        std::vector<double>(records[i].parameters, records[i].parameters + count));
+    }
+  } else {
+    WARNING("Cache of configuration parameters is not valid, it will be written again: " + cacheFile);
+  }
+  munmap(data, status.st_size);
+  return valid;
+}
+
+/**
+ * Method writes the cache to a temporary file, renamed when complete,
+ * so processes starting at the same time never read a partial cache
+ */
+bool UniversalFileLoader::saveCache(
+  const std::string& cacheFile,
+  uint64_t key,
+  const UniversalFileLoader::TOMBChToParameter& parameters)
+{
+  boost::system::error_code error;
+  boost::filesystem::create_directories(boost::filesystem::path(cacheFile).parent_path(), error);
+  std::string temporary = cacheFile + "." + std::to_string(getpid()) + ".tmp";
+  std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    WARNING("Unable to write the cache of configuration parameters: " + cacheFile);
+    return false;
+  }
+  CacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kCacheMagic, sizeof(header.magic));
+  header.version = kCacheVersion;
+  header.byteOrder = kCacheByteOrder;
+  header.key = key;
+  header.numberOfRecords = parameters.size();
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  for (const auto& entry : parameters) {
+    CacheRecord record;
+    memset(&record, 0, sizeof(record));
+    record.channel = entry.first;
+    record.numberOfParameters = std::min(entry.second.size(), kNumberOfParameters);
+    std::copy(entry.second.begin(), entry.second.begin() + record.numberOfParameters, record.parameters);
+    file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+  }
+  file.close();
+  if (file.fail() || rename(temporary.c_str(), cacheFile.c_str()) != 0) {
+    std::remove(temporary.c_str());
+    WARNING("Unable to write the cache of configuration parameters: " + cacheFile);
+    return false;
   }
+  return true;
 }
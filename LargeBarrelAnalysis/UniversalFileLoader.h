@@ -22,8 +22,14 @@
  * that is in standard format of Layer-Slot-Side-Threshold
  * Contains of structure of records that has to be initialized by user,
  * and methods of reading and validating constatns.
+ * Files are parsed from one buffer with no streams. Parameters mapped
+ * to TOMB channels can be saved in a binary cache, keyed by the hash of the
+ * contents of the file and of the TOMB mapping, and read back with mmap.
  */
 
+#include <cstdint>
+#include <vector>
+#include <tuple>
 #include <map>
 #include <string>
 #include "JPetPM/JPetPM.h"
@@ -49,11 +55,19 @@ public:
   typedef std::map<unsigned int, std::vector<double>> TOMBChToParameter;
   typedef std::map<std::tuple<int, int, JPetPM::Side, int>, int> TOMBChMap;
   static double getConfigurationParameter(const TOMBChToParameter& confParameters, const unsigned int channel);
-  static TOMBChToParameter loadConfigurationParameters(const std::string& confFile, const TOMBChMap& tombMap);
+  static TOMBChToParameter loadConfigurationParameters(const std::string& confFile, const TOMBChMap& tombMap,
+      const std::string& cacheDirectory = "");
   static TOMBChToParameter generateConfigurationParameters(const std::vector<ConfRecord>& confRecords,  const TOMBChMap& tombMap);
   static std::vector<ConfRecord> readConfigurationParametersFromFile(const std::string& confFile);
+  static std::vector<ConfRecord> parseConfigurationParameters(const std::string& contents);
   static bool fillConfRecord(const std::string& input, ConfRecord& outRecord);
   static bool areConfRecordsValid(const std::vector<ConfRecord>& records);
+  static uint64_t getCacheKey(const std::string& contents, const TOMBChMap& tombMap);
+  static std::string getCacheFileName(const std::string& confFile, const std::string& cacheDirectory, uint64_t key);
+  static bool loadCache(const std::string& cacheFile, uint64_t key, TOMBChToParameter& parameters);
+  static bool saveCache(const std::string& cacheFile, uint64_t key, const TOMBChToParameter& parameters);
+
+  static const std::string kCacheDirectoryParamKey;
 
 private:
   UniversalFileLoader(const UniversalFileLoader&);
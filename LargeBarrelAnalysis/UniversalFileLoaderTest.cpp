@@ -3,6 +3,7 @@
 
 #include <boost/test/unit_test.hpp>
 #include "UniversalFileLoader.h"
+#include <cstdio>
 
 struct myFixtures {
   std::vector<ConfRecord> fCorrectRecords = {
@@ -265,4 +266,47 @@ BOOST_FIXTURE_TEST_CASE (generateConfigurationParameters, myFixtures)
   BOOST_REQUIRE_CLOSE(configuration.at(73).at(0), -3, epsilon);
 }
 
+BOOST_FIXTURE_TEST_CASE (parseConfigurationParameters, myFixtures)
+{
+  std::string contents =
+    "# layer slot side threshold parameters\n"
+    "1 1 A 1 7.0 0.1 0.0 0.5 0.0 6.1 0.0 2.1\n"
+    "3 2 B 4 5.0 0.3 0.0 0.3 0.0 9.1 0.0 3.1\n"
+    "1 2 C 4 0.0 1.1 2.2 3.3 4.4 5.5 6.6 7.7\n"
+    "1 2 B 4 4.3\n"
+    "2 90\tB 2 -3.0 0.2 4.0 0.3 0.0 2.1 0.0 4.5";
+  auto records = UniversalFileLoader::parseConfigurationParameters(contents);
+  BOOST_REQUIRE_EQUAL(records.size(), fCorrectRecords.size());
+  auto epsilon = 0.00001;
+  for (size_t i = 0; i < records.size(); i++) {
+    BOOST_REQUIRE_EQUAL(records[i].layer, fCorrectRecords[i].layer);
+    BOOST_REQUIRE_EQUAL(records[i].slot, fCorrectRecords[i].slot);
+    BOOST_REQUIRE_EQUAL(records[i].side, fCorrectRecords[i].side);
+    BOOST_REQUIRE_EQUAL(records[i].thresholdNumber, fCorrectRecords[i].thresholdNumber);
+    BOOST_REQUIRE_EQUAL(records[i].parameters.size(), 8);
+    for (size_t j = 0; j < records[i].parameters.size(); j++) {
+      BOOST_REQUIRE_CLOSE(records[i].parameters[j], fCorrectRecords[i].parameters[j], epsilon);
+    }
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE (saveCache_loadCache, myFixtures)
+{
+  auto configuration = UniversalFileLoader::generateConfigurationParameters(fCorrectRecords, fCorrectTombMap);
+  auto key = UniversalFileLoader::getCacheKey("contents", fCorrectTombMap);
+  auto otherTombMap = fCorrectTombMap;
+  otherTombMap.begin()->second = 23;
+  BOOST_REQUIRE(key != UniversalFileLoader::getCacheKey("contents", otherTombMap));
+  BOOST_REQUIRE(key != UniversalFileLoader::getCacheKey("contents2", fCorrectTombMap));
+
+  auto cacheFile = UniversalFileLoader::getCacheFileName("../calib.txt", ".", key);
+  BOOST_REQUIRE(UniversalFileLoader::saveCache(cacheFile, key, configuration));
+  UniversalFileLoader::TOMBChToParameter loaded;
+  BOOST_REQUIRE(!UniversalFileLoader::loadCache(cacheFile, key + 1, loaded));
+  BOOST_REQUIRE(UniversalFileLoader::loadCache(cacheFile, key, loaded));
+  BOOST_REQUIRE(loaded == configuration);
+  std::remove(cacheFile.c_str());
+  BOOST_REQUIRE(!UniversalFileLoader::loadCache(cacheFile, key, loaded));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,90 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file Vec3.h
+ */
+
+#ifndef VEC3_H
+#define VEC3_H
+
+#include <TVector3.h>
+#include <cmath>
+
+/**
+ * @brief Lightweight 3D vector of doubles, used for geometry calculations
+ *
+ * Plain value type without virtual methods, all operations are inlined.
+ * Conversion to and from TVector3 is provided for the existing code.
+ */
+struct Vec3
+{
+  double x;
+  double y;
+  double z;
+
+  constexpr Vec3(): x(0.0), y(0.0), z(0.0) {}
+  constexpr Vec3(double x, double y, double z): x(x), y(y), z(z) {}
+  explicit Vec3(const TVector3& vec): x(vec.X()), y(vec.Y()), z(vec.Z()) {}
+
+  TVector3 toTVector3() const { return TVector3(x, y, z); }
+
+  constexpr Vec3 operator+(const Vec3& other) const
+  {
+    return Vec3(x + other.x, y + other.y, z + other.z);
+  }
+
+  constexpr Vec3 operator-(const Vec3& other) const
+  {
+    return Vec3(x - other.x, y - other.y, z - other.z);
+  }
+
+  constexpr Vec3 operator*(double factor) const
+  {
+    return Vec3(factor * x, factor * y, factor * z);
+  }
+
+  constexpr double dot(const Vec3& other) const
+  {
+    return x * other.x + y * other.y + z * other.z;
+  }
+
+  constexpr Vec3 cross(const Vec3& other) const
+  {
+    return Vec3(y * other.z - z * other.y, z * other.x - x * other.z, x * other.y - y * other.x);
+  }
+
+  constexpr double norm2() const { return dot(*this); }
+
+  double norm() const { return std::sqrt(norm2()); }
+
+  /// Same as TVector3::Unit(), zero vector is returned unchanged
+  Vec3 unit() const
+  {
+    double length = norm();
+    return length > 0.0 ? (*this) * (1.0 / length) : *this;
+  }
+
+  /// Same as TVector3::Angle(), in radians, 0 if one of the vectors has zero length
+  double angle(const Vec3& other) const
+  {
+    double normProduct = std::sqrt(norm2() * other.norm2());
+    if (normProduct <= 0.0) return 0.0;
+    double cosine = dot(other) / normProduct;
+    if (cosine > 1.0) cosine = 1.0;
+    if (cosine < -1.0) cosine = -1.0;
+    return std::acos(cosine);
+  }
+};
+
+constexpr Vec3 operator*(double factor, const Vec3& vec) { return vec * factor; }
+
+#endif /* !VEC3_H */
@@ -0,0 +1,287 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file WindowIndex.cpp
+ */
+
+#include <JPetOptionsTools/JPetOptionsTools.h>
+#include "JPetLoggerInclude.h"
+#include "WindowIndex.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+using namespace jpet_options_tools;
+using namespace std;
+
+namespace
+{
+const char kWindowIndexMagic[8] = {'J', 'P', 'E', 'T', 'W', 'I', 'D', 'X'};
+const uint32_t kWindowIndexVersion = 1;
+const uint32_t kWindowIndexByteOrder = 0x01020304;
+
+struct WindowIndexHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  double windowLength;
+};
+
+const string kMinTimeParamKey = "TimeWindowCreator_MinTime_float";
+const string kMaxTimeParamKey = "TimeWindowCreator_MaxTime_float";
+const double kDefaultMinTime = -1.e6;
+const double kDefaultMaxTime = 0.0;
+}
+
+const string WindowIndexer::kEnabledParamKey = "WindowIndex_Enabled_bool";
+const string WindowIndexer::kWindowLengthParamKey = "WindowIndex_WindowLength_double";
+const string WindowIndexer::kFirstWindowParamKey = "WindowRange_FirstWindow_int";
+const string WindowIndexer::kLastWindowParamKey = "WindowRange_LastWindow_int";
+const string WindowIndexer::kStartTimeParamKey = "WindowRange_StartTime_double";
+const string WindowIndexer::kEndTimeParamKey = "WindowRange_EndTime_double";
+
+bool WindowRange::isSet() const
+{
+  return firstWindow >= 0 || lastWindow >= 0 || hasTimeRange;
+}
+
+bool WindowRange::contains(uint64_t window, double time) const
+{
+  if (firstWindow >= 0 && window < static_cast<uint64_t>(firstWindow)) return false;
+  if (lastWindow >= 0 && window > static_cast<uint64_t>(lastWindow)) return false;
+  return !hasTimeRange || (time >= startTime && time <= endTime);
+}
+
+/**
+ * Index of the file run.hits.root is saved as run.hits.index
+ */
+string WindowIndex::getFileName(const string& dataFile)
+{
+  const string extension = ".root";
+  string fileName = dataFile;
+  if (fileName.size() >= extension.size()
+      && fileName.compare(fileName.size() - extension.size(), extension.size(), extension) == 0) {
+    fileName.erase(fileName.size() - extension.size());
+  }
+  return fileName + ".index";
+}
+
+bool WindowIndex::load(const string& fileName)
+{
+  fEntries.clear();
+  ifstream file(fileName, ios::binary);
+  WindowIndexHeader header;
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+      || memcmp(header.magic, kWindowIndexMagic, sizeof(kWindowIndexMagic)) != 0
+      || header.version != kWindowIndexVersion || header.byteOrder != kWindowIndexByteOrder) {
+    ERROR(Form("File %s is not a valid window index of version %u", fileName.c_str(), kWindowIndexVersion));
+    return false;
+  }
+  fWindowLength = header.windowLength;
+  file.seekg(0, ios::end);
+  auto size = static_cast<size_t>(file.tellg()) - sizeof(header);
+  fEntries.resize(size / sizeof(WindowIndexEntry));
+  file.seekg(sizeof(header));
+  if (!file.read(reinterpret_cast<char*>(fEntries.data()), fEntries.size() * sizeof(WindowIndexEntry))) {
+    ERROR(Form("Reading of the window index %s failed", fileName.c_str()));
+    fEntries.clear();
+    return false;
+  }
+  return true;
+}
+
+bool WindowIndex::save(const string& fileName) const
+{
+  WindowIndexWriter writer;
+  if (!writer.open(fileName, fWindowLength)) return false;
+  for (const auto& entry : fEntries) writer.add(entry);
+  return writer.close();
+}
+
+/**
+ * Window numbers and start times grow with the entries, so the bounds
+ * of the range are found by binary search
+ */
+bool WindowIndex::findEntryRange(const WindowRange& range, long& firstEntry, long& lastEntry) const
+{
+  auto beforeRange = [&range] (const WindowIndexEntry& entry) {
+    return (range.firstWindow >= 0 && entry.window < static_cast<uint64_t>(range.firstWindow))
+      || (range.hasTimeRange && entry.startTime < range.startTime);
+  };
+  auto afterRange = [&range] (const WindowIndexEntry& entry) {
+    return (range.lastWindow >= 0 && entry.window > static_cast<uint64_t>(range.lastWindow))
+      || (range.hasTimeRange && entry.startTime > range.endTime);
+  };
+  auto first = partition_point(fEntries.begin(), fEntries.end(), beforeRange);
+  auto last = partition_point(first, fEntries.end(), [&afterRange] (const WindowIndexEntry& entry) {
+    return !afterRange(entry);
+  });
+  if (first == last) return false;
+  firstEntry = first->entry;
+  lastEntry = (last - 1)->entry;
+  return true;
+}
+
+bool WindowIndexWriter::open(const string& fileName, double windowLength)
+{
+  if (isOpen()) close();
+  fFileName = fileName;
+  fFile.open(fFileName, ios::binary | ios::trunc);
+  if (!fFile.is_open()) {
+    ERROR(Form("Unable to open file %s for the window index", fFileName.c_str()));
+    return false;
+  }
+  WindowIndexHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kWindowIndexMagic, sizeof(header.magic));
+  header.version = kWindowIndexVersion;
+  header.byteOrder = kWindowIndexByteOrder;
+  header.windowLength = windowLength;
+  fFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  return true;
+}
+
+void WindowIndexWriter::add(const WindowIndexEntry& entry)
+{
+  fFile.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+}
+
+bool WindowIndexWriter::close()
+{
+  if (!isOpen()) return false;
+  fFile.close();
+  if (fFile.fail()) {
+    ERROR(Form("Writing of the window index %s failed", fFileName.c_str()));
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Length of windows [ps] is taken from WindowIndex_WindowLength_double,
+ * or from the range of times of Time Window Creator
+ */
+double WindowIndexer::getWindowLength(const map<string, boost::any>& options)
+{
+  if (isOptionSet(options, kWindowLengthParamKey)) {
+    return getOptionAsDouble(options, kWindowLengthParamKey);
+  }
+  double minTime = kDefaultMinTime;
+  double maxTime = kDefaultMaxTime;
+  if (isOptionSet(options, kMinTimeParamKey)) minTime = getOptionAsFloat(options, kMinTimeParamKey);
+  if (isOptionSet(options, kMaxTimeParamKey)) maxTime = getOptionAsFloat(options, kMaxTimeParamKey);
+  return maxTime - minTime;
+}
+
+WindowRange WindowIndexer::getRange(const map<string, boost::any>& options)
+{
+  WindowRange range;
+  if (isOptionSet(options, kFirstWindowParamKey)) {
+    range.firstWindow = getOptionAsInt(options, kFirstWindowParamKey);
+  }
+  if (isOptionSet(options, kLastWindowParamKey)) {
+    range.lastWindow = getOptionAsInt(options, kLastWindowParamKey);
+  }
+  if (isOptionSet(options, kStartTimeParamKey) || isOptionSet(options, kEndTimeParamKey)) {
+    range.hasTimeRange = true;
+    range.startTime = isOptionSet(options, kStartTimeParamKey) ?
+      getOptionAsDouble(options, kStartTimeParamKey) : -numeric_limits<double>::max();
+    range.endTime = isOptionSet(options, kEndTimeParamKey) ?
+      getOptionAsDouble(options, kEndTimeParamKey) : numeric_limits<double>::max();
+  }
+  return range;
+}
+
+void WindowIndexer::reset(const map<string, boost::any>& options)
+{
+  fRange = getRange(options);
+  fWindowLength = getWindowLength(options);
+  auto firstEvent = getFirstEvent(options);
+  fFirstInputEntry = firstEvent > 0 ? firstEvent : 0;
+  fNextInputEntry = fFirstInputEntry;
+  fNextOutputEntry = 0;
+}
+
+void WindowIndexer::configure(const map<string, boost::any>& options)
+{
+  reset(options);
+  bool enabled = isOptionSet(options, kEnabledParamKey) && getOptionAsBool(options, kEnabledParamKey);
+  if (!enabled && !fRange.isSet()) return;
+  auto inputIndexFile = WindowIndex::getFileName(getInputFile(options));
+  if (ifstream(inputIndexFile).good() && fInputIndex.load(inputIndexFile)) {
+    INFO(Form("Numbers and times of windows are taken from the index %s", inputIndexFile.c_str()));
+  }
+  if (enabled) {
+    fWriter.open(WindowIndex::getFileName(getOutputFile(options)), fWindowLength);
+  }
+}
+
+/**
+ * Moving to the next window of the input, returns false if it is out of the slice
+ */
+bool WindowIndexer::beginWindow()
+{
+  auto entry = fNextInputEntry++;
+  if (entry < fInputIndex.size()) {
+    fCurrent.window = fInputIndex[entry].window;
+    fCurrent.startTime = fInputIndex[entry].startTime;
+  } else {
+    fCurrent.window = entry;
+    fCurrent.startTime = entry * fWindowLength;
+  }
+  return !fRange.isSet() || fRange.contains(fCurrent.window, fCurrent.startTime);
+}
+
+/**
+ * Following the windows passed to the task, with the same numbers and start
+ * times as seen by its wrapper, and with no index written. Wrapper is null
+ * for a task registered with no InstrumentedTask.
+ */
+void WindowIndexer::follow(const map<string, boost::any>& options, const WindowIndexer* wrapper)
+{
+  reset(options);
+  fFollowsWrapper = wrapper && wrapper->fRange.isSet();
+  auto inputIndexFile = WindowIndex::getFileName(getInputFile(options));
+  if (ifstream(inputIndexFile).good()) fInputIndex.load(inputIndexFile);
+}
+
+/**
+ * Windows out of the slice are not passed to a wrapped task, so they are passed
+ * over here, up to the next window of the slice. A task with no wrapper gets
+ * all windows.
+ */
+const WindowIndexEntry& WindowIndexer::nextProcessedWindow()
+{
+  if (!fFollowsWrapper) {
+    beginWindow();
+    return fCurrent;
+  }
+  while (!beginWindow()) {
+    bool pastRange = fNextInputEntry >= fInputIndex.size()
+      && ((fRange.lastWindow >= 0 && fCurrent.window > (uint64_t) fRange.lastWindow)
+      || (fRange.hasTimeRange && fCurrent.startTime > fRange.endTime));
+    if (pastRange) break;
+  }
+  return fCurrent;
+}
+
+void WindowIndexer::endWindow(unsigned long objects)
+{
+  fCurrent.entry = fNextOutputEntry++;
+  fCurrent.objects = objects;
+  if (fWriter.isOpen()) fWriter.add(fCurrent);
+}
+
+bool WindowIndexer::close()
+{
+  return fWriter.isOpen() ? fWriter.close() : true;
+}
@@ -0,0 +1,163 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file WindowIndex.h
+ */
+
+#ifndef WINDOWINDEX_H
+#define WINDOWINDEX_H
+
+#include <boost/any.hpp>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+
+/**
+ * @brief One time window of the output file, as recorded in its index
+ *
+ * Window number is the number of the window in the whole run, start time
+ * is given in ps from the start of the run, entry is the number of the entry
+ * of the window in the output file.
+ */
+struct WindowIndexEntry {
+  uint64_t window = 0;
+  double startTime = 0.0;
+  uint64_t entry = 0;
+  uint32_t objects = 0;
+  uint32_t reserved = 0;
+};
+
+/**
+ * @brief Slice of the run given by the range of window numbers and/or the range of times
+ *
+ * Bounds of both ranges are inclusive, unset ones do not limit the slice.
+ */
+struct WindowRange {
+  long firstWindow = -1;
+  long lastWindow = -1;
+  double startTime = 0.0;
+  double endTime = 0.0;
+  bool hasTimeRange = false;
+  bool isSet() const;
+  bool contains(uint64_t window, double startTime) const;
+};
+
+/**
+ * @brief Index of time windows of the output file of a task, saved next to it
+ *
+ * The index is a binary file with a short header followed by fixed width
+ * entries, one for each entry of the output file, in the same order.
+ */
+class WindowIndex
+{
+public:
+  static std::string getFileName(const std::string& dataFile);
+  bool load(const std::string& fileName);
+  bool save(const std::string& fileName) const;
+  void add(const WindowIndexEntry& entry) { fEntries.push_back(entry); }
+  size_t size() const { return fEntries.size(); }
+  const WindowIndexEntry& operator[](size_t entry) const { return fEntries[entry]; }
+  double getWindowLength() const { return fWindowLength; }
+  void setWindowLength(double length) { fWindowLength = length; }
+  bool findEntryRange(const WindowRange& range, long& firstEntry, long& lastEntry) const;
+
+private:
+  std::vector<WindowIndexEntry> fEntries;
+  double fWindowLength = 0.0;
+};
+
+/**
+ * @brief Writer of the index, adding entries to the file one by one
+ */
+class WindowIndexWriter
+{
+public:
+  bool open(const std::string& fileName, double windowLength);
+  void add(const WindowIndexEntry& entry);
+  bool close();
+  bool isOpen() const { return fFile.is_open(); }
+
+private:
+  std::string fFileName;
+  std::ofstream fFile;
+};
+
+/**
+ * @brief Window bookkeeping of a task: its index and the slice of the run to process
+ *
+ * Number and start time of each input window are taken from the index of the
+ * input file if it exists, otherwise they are calculated from the number of
+ * the entry and the length of windows. Windows out of the slice given with
+ * WindowRange_* options are skipped, they are left empty in the output.
+ * If WindowIndex_Enabled_bool is set, the index of the output file is written.
+ * A task can follow times of its own windows with an indexer set by follow().
+ * Windows out of the slice are skipped by InstrumentedTask, so the indexer
+ * of the wrapper is given to follow(), an indexer of a task with no wrapper
+ * does not skip them.
+ * Entries of the current window in the input and output files of the task
+ * differ by the first entry given with -r.
+ */
+class WindowIndexer
+{
+public:
+  void configure(const std::map<std::string, boost::any>& options);
+  void follow(const std::map<std::string, boost::any>& options, const WindowIndexer* wrapper);
+  bool isEnabled() const { return fRange.isSet() || fWriter.isOpen(); }
+  bool beginWindow();
+  const WindowIndexEntry& nextProcessedWindow();
+  void endWindow(unsigned long objects);
+  bool close();
+  const WindowIndexEntry& getCurrentWindow() const { return fCurrent; }
+  uint64_t getInputEntry() const { return fNextInputEntry - 1; }
+  uint64_t getOutputEntry() const { return fNextInputEntry - 1 - fFirstInputEntry; }
+  static double getWindowLength(const std::map<std::string, boost::any>& options);
+  static WindowRange getRange(const std::map<std::string, boost::any>& options);
+
+  static const std::string kEnabledParamKey;
+  static const std::string kWindowLengthParamKey;
+  static const std::string kFirstWindowParamKey;
+  static const std::string kLastWindowParamKey;
+  static const std::string kStartTimeParamKey;
+  static const std::string kEndTimeParamKey;
+
+private:
+  void reset(const std::map<std::string, boost::any>& options);
+  WindowRange fRange;
+  WindowIndex fInputIndex;
+  WindowIndexWriter fWriter;
+  WindowIndexEntry fCurrent;
+  uint64_t fFirstInputEntry = 0;
+  uint64_t fNextInputEntry = 0;
+  uint64_t fNextOutputEntry = 0;
+  double fWindowLength = 0.0;
+  bool fFollowsWrapper = false;
+};
+
+/**
+ * @brief Base of tasks following their windows with a WindowIndexer
+ *
+ * InstrumentedTask gives its indexer to the task before init(),
+ * so that the task can pass it to WindowIndexer::follow().
+ */
+class WindowFollower
+{
+public:
+  virtual ~WindowFollower() {}
+  void setWindowWrapper(const WindowIndexer* wrapper) { fWindowWrapper = wrapper; }
+
+protected:
+  const WindowIndexer* fWindowWrapper = nullptr;
+};
+
+#endif /* !WINDOWINDEX_H */
@@ -0,0 +1,158 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file WindowIndexTest.cpp
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE WindowIndexTest
+
+#include <boost/test/unit_test.hpp>
+#include "WindowIndex.h"
+#include <cstdio>
+
+/**
+ * Index of windows 100-109 of 1000 ps, saved as entries 0-9
+ */
+WindowIndex getTestIndex()
+{
+  WindowIndex index;
+  index.setWindowLength(1000.0);
+  for (int i = 0; i < 10; i++) {
+    WindowIndexEntry entry;
+    entry.window = 100 + i;
+    entry.startTime = (100 + i) * 1000.0;
+    entry.entry = i;
+    entry.objects = i % 3;
+    index.add(entry);
+  }
+  return index;
+}
+
+BOOST_AUTO_TEST_SUITE(WindowIndexTestSuite)
+
+BOOST_AUTO_TEST_CASE(getFileName_test)
+{
+  BOOST_REQUIRE_EQUAL(WindowIndex::getFileName("run.hits.root"), "run.hits.index");
+  BOOST_REQUIRE_EQUAL(WindowIndex::getFileName("run.hld"), "run.hld.index");
+}
+
+BOOST_AUTO_TEST_CASE(saveLoad_test)
+{
+  const std::string fileName = "WindowIndexTest_saveLoad.index";
+  BOOST_REQUIRE(getTestIndex().save(fileName));
+  WindowIndex index;
+  BOOST_REQUIRE(index.load(fileName));
+  BOOST_REQUIRE_EQUAL(index.size(), 10u);
+  BOOST_REQUIRE_EQUAL(index.getWindowLength(), 1000.0);
+  BOOST_REQUIRE_EQUAL(index[3].window, 103u);
+  BOOST_REQUIRE_EQUAL(index[3].startTime, 103000.0);
+  BOOST_REQUIRE_EQUAL(index[3].entry, 3u);
+  BOOST_REQUIRE_EQUAL(index[5].objects, 2u);
+  std::remove(fileName.c_str());
+  BOOST_REQUIRE(!index.load(fileName));
+}
+
+BOOST_AUTO_TEST_CASE(findEntryRange_test)
+{
+  auto index = getTestIndex();
+  long first = -1, last = -1;
+  WindowRange range;
+  BOOST_REQUIRE(index.findEntryRange(range, first, last));
+  BOOST_REQUIRE_EQUAL(first, 0);
+  BOOST_REQUIRE_EQUAL(last, 9);
+
+  range.firstWindow = 103;
+  range.lastWindow = 105;
+  BOOST_REQUIRE(index.findEntryRange(range, first, last));
+  BOOST_REQUIRE_EQUAL(first, 3);
+  BOOST_REQUIRE_EQUAL(last, 5);
+
+  range.hasTimeRange = true;
+  range.startTime = 104500.0;
+  range.endTime = 1.e9;
+  BOOST_REQUIRE(index.findEntryRange(range, first, last));
+  BOOST_REQUIRE_EQUAL(first, 5);
+  BOOST_REQUIRE_EQUAL(last, 5);
+
+  range.firstWindow = 200;
+  range.lastWindow = -1;
+  BOOST_REQUIRE(!index.findEntryRange(range, first, last));
+}
+
+BOOST_AUTO_TEST_CASE(contains_test)
+{
+  WindowRange range;
+  BOOST_REQUIRE(!range.isSet());
+  BOOST_REQUIRE(range.contains(0, 0.0));
+  range.lastWindow = 10;
+  BOOST_REQUIRE(range.isSet());
+  BOOST_REQUIRE(range.contains(10, 0.0));
+  BOOST_REQUIRE(!range.contains(11, 0.0));
+  range.hasTimeRange = true;
+  range.startTime = -5.0;
+  range.endTime = 5.0;
+  BOOST_REQUIRE(range.contains(1, 5.0));
+  BOOST_REQUIRE(!range.contains(1, 6.0));
+}
+
+BOOST_AUTO_TEST_CASE(indexer_test)
+{
+  std::map<std::string, boost::any> options;
+  options[WindowIndexer::kWindowLengthParamKey] = 1000.0;
+  options[WindowIndexer::kStartTimeParamKey] = 2000.0;
+  options[WindowIndexer::kEndTimeParamKey] = 3000.0;
+  BOOST_REQUIRE_EQUAL(WindowIndexer::getWindowLength(options), 1000.0);
+  WindowIndexer indexer;
+  indexer.configure(options);
+  BOOST_REQUIRE(indexer.isEnabled());
+  std::vector<bool> selected;
+  for (int i = 0; i < 5; i++) {
+    selected.push_back(indexer.beginWindow());
+    indexer.endWindow(1);
+  }
+  BOOST_REQUIRE(!selected[0] && !selected[1] && selected[2] && selected[3] && !selected[4]);
+  BOOST_REQUIRE_EQUAL(indexer.getCurrentWindow().window, 4u);
+  BOOST_REQUIRE_EQUAL(indexer.getCurrentWindow().entry, 4u);
+  BOOST_REQUIRE(indexer.close());
+
+  // Length of windows from the times of Time Window Creator
+  std::map<std::string, boost::any> timeOptions;
+  timeOptions["TimeWindowCreator_MinTime_float"] = -5.e4f;
+  BOOST_REQUIRE_EQUAL(WindowIndexer::getWindowLength(timeOptions), 5.e4);
+}
+
+BOOST_AUTO_TEST_CASE(follow_test)
+{
+  std::map<std::string, boost::any> options;
+  options[WindowIndexer::kWindowLengthParamKey] = 1000.0;
+  options[WindowIndexer::kStartTimeParamKey] = 2000.0;
+  options[WindowIndexer::kEndTimeParamKey] = 3000.0;
+  WindowIndexer wrapper;
+  wrapper.configure(options);
+  WindowIndexer follower;
+  follower.follow(options, &wrapper);
+  // Windows 0 and 1 are never passed to the task
+  BOOST_REQUIRE_EQUAL(follower.nextProcessedWindow().window, 2u);
+  BOOST_REQUIRE_EQUAL(follower.nextProcessedWindow().startTime, 3000.0);
+  // Past the slice
+  BOOST_REQUIRE_EQUAL(follower.nextProcessedWindow().window, 4u);
+
+  // Task with no wrapper gets all windows
+  WindowIndexer unwrapped;
+  unwrapped.follow(options, nullptr);
+  BOOST_REQUIRE_EQUAL(unwrapped.nextProcessedWindow().window, 0u);
+  BOOST_REQUIRE_EQUAL(unwrapped.nextProcessedWindow().startTime, 1000.0);
+  BOOST_REQUIRE_EQUAL(unwrapped.nextProcessedWindow().window, 2u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
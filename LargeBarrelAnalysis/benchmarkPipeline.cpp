@@ -0,0 +1,447 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file benchmarkPipeline.cpp
+ */
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <JPetManager/JPetManager.h>
+#include "EventCategorizerMultiStream.h"
+#include "SyntheticDataGenerator.h"
+#include "TimeWindowCreator.h"
+#include "SignalTransformer.h"
+#include "InstrumentedTask.h"
+#include "FusedPipeline.h"
+#include "SignalFinder.h"
+#include "EventFinder.h"
+#include "HitFinder.h"
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <unistd.h>
+#include <dirent.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <climits>
+#include <cerrno>
+#include <cstdlib>
+#include <chrono>
+
+using namespace std;
+namespace pt = boost::property_tree;
+
+/**
+ * Measurements of one task, from the profiling summary of the run
+ */
+struct StageMeasurement {
+  string task;
+  unsigned long windows = 0;
+  double wallTime = 0.0;
+  double cpuTime = 0.0;
+  long peakRSS = 0;
+  unsigned long readBytes = 0;
+  unsigned long writtenBytes = 0;
+};
+
+/**
+ * Measurements of one run of the configuration, for all its processes
+ */
+struct RunMeasurement {
+  bool succeeded = true;
+  double wallTime = 0.0;
+  double cpuTime = 0.0;
+  long peakRSS = 0;
+  unsigned long diskReadBytes = 0;
+  unsigned long diskWrittenBytes = 0;
+  unsigned long outputBytes = 0;
+  vector<StageMeasurement> stages;
+};
+
+struct BenchmarkConfiguration {
+  string name;
+  string mode = "tasks";
+  int processes = 1;
+  double windowLength = 0.0;
+  pt::ptree userParams;
+};
+
+/**
+ * Running the analysis chain in this process, as the Large Barrel executable does.
+ * Mode "tasks" runs the tasks one after another with intermediate files,
+ * "fused" runs them in memory in the FusedPipeline task, and "pipelined"
+ * in the FusedPipeline task with a thread per task.
+ */
+int runChain(const string& mode, int argc, const char* argv[])
+{
+  try {
+    JPetManager& manager = JPetManager::getManager();
+    manager.registerTask<InstrumentedTask<TimeWindowCreator>>("TimeWindowCreator");
+    manager.registerTask<InstrumentedTask<SignalFinder>>("SignalFinder");
+    manager.registerTask<InstrumentedTask<SignalTransformer>>("SignalTransformer");
+    manager.registerTask<InstrumentedTask<HitFinder>>("HitFinder");
+    manager.registerTask<InstrumentedTask<EventFinder>>("EventFinder");
+    manager.registerTask<InstrumentedTask<EventCategorizerMultiStream>>("EventCategorizerMultiStream");
+    manager.registerTask<InstrumentedTask<FusedPipeline>>("FusedPipeline");
+    if (mode == "tasks") {
+      manager.useTask("TimeWindowCreator", "hld", "tslot.calib");
+      manager.useTask("SignalFinder", "tslot.calib", "raw.sig");
+      manager.useTask("SignalTransformer", "raw.sig", "phys.sig");
+      manager.useTask("HitFinder", "phys.sig", "hits");
+      manager.useTask("EventFinder", "hits", "unk.evt");
+      manager.useTask("EventCategorizerMultiStream", "unk.evt", "cat.evt");
+    } else if (mode == "fused") {
+      manager.useTask("FusedPipeline", "hld", "cat.evt");
+    } else if (mode == "pipelined") {
+      manager.useTask("FusedPipeline", "hld", "pipeline");
+    } else {
+      cerr << "Unknown mode of the chain: " << mode << endl;
+      return EXIT_FAILURE;
+    }
+    manager.run(argc, argv);
+  } catch (const std::exception& except) {
+    cerr << "Unrecoverable error occured:" << except.what() << "Exiting the program!" << endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+bool makeDirectory(const string& path)
+{
+  for (size_t position = path.find('/', 1); ; position = path.find('/', position + 1)) {
+    string directory = path.substr(0, position);
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) return false;
+    if (position == string::npos) return true;
+  }
+}
+
+string getAbsolutePath(const string& path)
+{
+  char resolved[PATH_MAX];
+  if (realpath(path.c_str(), resolved)) return resolved;
+  return path;
+}
+
+unsigned long getDirectorySize(const string& path)
+{
+  unsigned long size = 0;
+  DIR* directory = opendir(path.c_str());
+  if (!directory) return 0;
+  while (auto entry = readdir(directory)) {
+    string name = entry->d_name;
+    if (name.size() < 5 || name.compare(name.size() - 5, 5, ".root") != 0) continue;
+    struct stat status;
+    if (stat((path + "/" + name).c_str(), &status) == 0) size += status.st_size;
+  }
+  closedir(directory);
+  return size;
+}
+
+vector<StageMeasurement> readStages(const string& profileFile)
+{
+  vector<StageMeasurement> stages;
+  pt::ptree profile;
+  try {
+    pt::read_json(profileFile, profile);
+  } catch (const pt::json_parser_error&) {
+    return stages;
+  }
+  for (const auto& entry : profile.get_child("tasks", pt::ptree())) {
+    StageMeasurement stage;
+    stage.task = entry.second.get<string>("task", "");
+    stage.windows = entry.second.get<unsigned long>("windows", 0);
+    stage.wallTime = entry.second.get<double>("wallTime", 0.0);
+    stage.cpuTime = entry.second.get<double>("cpuTime", 0.0);
+    stage.peakRSS = entry.second.get<long>("peakRSSKB", 0);
+    stage.readBytes = entry.second.get<unsigned long>("readBytes", 0);
+    stage.writtenBytes = entry.second.get<unsigned long>("writtenBytes", 0);
+    stages.push_back(stage);
+  }
+  return stages;
+}
+
+/**
+ * Running all processes of the configuration at the same time, each in its
+ * own directory, and collecting their resource usage
+ */
+RunMeasurement runConfiguration(
+  const BenchmarkConfiguration& configuration, const pt::ptree& commonParams,
+  const string& input, const string& localDB, int runId, long windows,
+  bool limitWindows, const string& runDirectory
+) {
+  RunMeasurement measurement;
+  vector<pid_t> children;
+  vector<string> directories;
+  auto start = chrono::steady_clock::now();
+  for (int process = 0; process < configuration.processes; process++) {
+    string directory = runDirectory + "/process" + to_string(process);
+    if (!makeDirectory(directory)) {
+      cerr << "Unable to create directory " << directory << endl;
+      measurement.succeeded = false;
+      break;
+    }
+    directory = getAbsolutePath(directory);
+    directories.push_back(directory);
+    pt::ptree params = commonParams;
+    for (const auto& entry : configuration.userParams) params.put_child(pt::ptree::path_type(entry.first, '\0'), entry.second);
+    // Processes run in their own directories, so paths to existing files are made absolute
+    for (auto& entry : params) {
+      const string suffix = "_std::string";
+      if (entry.first.size() < suffix.size()
+        || entry.first.compare(entry.first.size() - suffix.size(), suffix.size(), suffix) != 0) continue;
+      string value = entry.second.get_value<string>();
+      if (!value.empty() && access(value.c_str(), F_OK) == 0) entry.second.put_value(getAbsolutePath(value));
+    }
+    params.put(pt::ptree::path_type("Profiling_Enabled_bool", '\0'), true);
+    params.put(pt::ptree::path_type("Profiling_SummaryFile_std::string", '\0'), directory + "/taskProfile.json");
+    if (configuration.mode == "pipelined") {
+      params.put(pt::ptree::path_type("FusedPipeline_Pipelined_bool", '\0'), true);
+    }
+    string paramsFile = directory + "/userParams.json";
+    pt::write_json(paramsFile, params);
+    vector<string> arguments = {
+      "/proc/self/exe", "--run-chain", configuration.mode, "-t", "root", "-f", input,
+      "-l", localDB, "-i", to_string(runId), "-u", paramsFile, "-o", directory
+    };
+    if (limitWindows) {
+      arguments.insert(arguments.end(), {"-r", "0", to_string(windows - 1)});
+    }
+    pid_t child = fork();
+    if (child == 0) {
+      // Log of the framework is written to the current directory
+      if (chdir(directory.c_str()) != 0) _exit(EXIT_FAILURE);
+      vector<char*> argv;
+      for (auto& argument : arguments) argv.push_back(&argument[0]);
+      argv.push_back(nullptr);
+      execv(argv[0], argv.data());
+      _exit(EXIT_FAILURE);
+    } else if (child < 0) {
+      cerr << "Unable to start the process of configuration " << configuration.name << endl;
+      measurement.succeeded = false;
+      break;
+    }
+    children.push_back(child);
+  }
+  for (auto child : children) {
+    int status = 0;
+    struct rusage usage;
+    if (wait4(child, &status, 0, &usage) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      measurement.succeeded = false;
+    }
+    measurement.cpuTime += usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1.0e-6
+      + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1.0e-6;
+    measurement.peakRSS = max(measurement.peakRSS, (long) usage.ru_maxrss);
+    measurement.diskReadBytes += usage.ru_inblock * 512ul;
+    measurement.diskWrittenBytes += usage.ru_oublock * 512ul;
+  }
+  measurement.wallTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  for (const auto& directory : directories) {
+    measurement.outputBytes += getDirectorySize(directory);
+    // Stages of all processes are summed, peak memory is the largest one
+    auto stages = readStages(directory + "/taskProfile.json");
+    for (const auto& stage : stages) {
+      auto found = find_if(measurement.stages.begin(), measurement.stages.end(),
+        [&stage] (const StageMeasurement& other) { return other.task == stage.task; });
+      if (found == measurement.stages.end()) {
+        measurement.stages.push_back(stage);
+        continue;
+      }
+      found->windows += stage.windows;
+      found->wallTime = max(found->wallTime, stage.wallTime);
+      found->cpuTime += stage.cpuTime;
+      found->peakRSS = max(found->peakRSS, stage.peakRSS);
+      found->readBytes += stage.readBytes;
+      found->writtenBytes += stage.writtenBytes;
+    }
+  }
+  return measurement;
+}
+
+/**
+ * Run with the median wall time of the repetitions
+ */
+RunMeasurement getMedian(vector<RunMeasurement> runs)
+{
+  sort(runs.begin(), runs.end(), [] (const RunMeasurement& first, const RunMeasurement& second) {
+    return first.wallTime < second.wallTime;
+  });
+  return runs.at(runs.size() / 2);
+}
+
+/**
+ * End-to-end benchmark of the reconstruction chain. Configurations listed in
+ * the JSON file (see benchmarkPipeline.json) are run on the same input,
+ * synthetic by default, and a scaling table with wall time, CPU time, memory
+ * and bytes read and written per configuration and per task is produced, e.g.
+ * ./benchmarkPipeline benchmarkPipeline.json
+ */
+int main(int argc, const char* argv[])
+{
+  if (argc >= 3 && string(argv[1]) == "--run-chain") {
+    // Arguments of the framework follow the mode
+    vector<const char*> chainArguments = {argv[0]};
+    for (int i = 3; i < argc; i++) chainArguments.push_back(argv[i]);
+    return runChain(argv[2], chainArguments.size(), chainArguments.data());
+  }
+  if (argc != 2) {
+    cerr << "Usage: " << argv[0] << " <benchmark configuration json>" << endl;
+    return EXIT_FAILURE;
+  }
+  pt::ptree config;
+  try {
+    pt::read_json(argv[1], config);
+  } catch (const pt::json_parser_error& error) {
+    cerr << "Unable to read the configuration: " << error.what() << endl;
+    return EXIT_FAILURE;
+  }
+  string workDirectory = config.get<string>("workDirectory", "pipelineBenchmark");
+  string localDB = getAbsolutePath(config.get<string>("localDB"));
+  int runId = config.get<int>("runId", 1);
+  long windows = config.get<long>("windows", 1000);
+  int repetitions = max(config.get<int>("repetitions", 1), 1);
+  string referenceInput = config.get<string>("input", "");
+  string resultsFile = config.get<string>("resultsFile", workDirectory + "/pipelineBenchmark.json");
+  pt::ptree commonParams = config.get_child("userParams", pt::ptree());
+  auto syntheticOptions = SyntheticDataGenerator::getOptions(config.get_child("synthetic", pt::ptree()));
+  auto syntheticConfig = SyntheticDataGenerator::loadConfig(syntheticOptions);
+  if (!makeDirectory(workDirectory)) {
+    cerr << "Unable to create directory " << workDirectory << endl;
+    return EXIT_FAILURE;
+  }
+
+  vector<BenchmarkConfiguration> configurations;
+  for (const auto& entry : config.get_child("configurations", pt::ptree())) {
+    BenchmarkConfiguration configuration;
+    configuration.name = entry.second.get<string>("name");
+    configuration.mode = entry.second.get<string>("mode", "tasks");
+    configuration.processes = max(entry.second.get<int>("processes", 1), 1);
+    configuration.windowLength = entry.second.get<double>("windowLength", syntheticConfig.windowLength);
+    configuration.userParams = entry.second.get_child("userParams", pt::ptree());
+    configurations.push_back(configuration);
+  }
+  if (configurations.empty()) {
+    cerr << "No configurations to run in " << argv[1] << endl;
+    return EXIT_FAILURE;
+  }
+
+  pt::ptree results;
+  pt::ptree resultsList;
+  ostringstream table;
+  table << "| configuration | mode | processes | window [ns] | wall [s] | CPU [s] | windows/s"
+    << " | speedup | peak RSS [MB] | disk read [MB] | disk written [MB] | output [MB] |" << endl
+    << "|---|---|---|---|---|---|---|---|---|---|---|---|" << endl;
+  ostringstream stageTable;
+  stageTable << "| configuration | task | windows | wall [s] | CPU [s] | peak RSS [MB]"
+    << " | read [MB] | written [MB] |" << endl << "|---|---|---|---|---|---|---|---|" << endl;
+  double referenceThroughput = 0.0;
+  map<double, string> syntheticInputs;
+  for (const auto& configuration : configurations) {
+    // Synthetic input is generated once for each window length
+    string input = referenceInput;
+    if (input.empty()) {
+      auto found = syntheticInputs.find(configuration.windowLength);
+      if (found == syntheticInputs.end()) {
+        input = getAbsolutePath(workDirectory) + "/synthetic_"
+          + to_string((long) configuration.windowLength) + ".hld.root";
+        auto windowConfig = syntheticConfig;
+        windowConfig.windowLength = configuration.windowLength;
+        cout << "Generating " << windows << " synthetic windows of " << configuration.windowLength
+          << " ns in " << input << endl;
+        if (!SyntheticDataGenerator::generateFile(localDB, runId, windows, input, windowConfig)) {
+          cerr << "Generation of the input failed" << endl;
+          return EXIT_FAILURE;
+        }
+        syntheticInputs[configuration.windowLength] = input;
+      } else {
+        input = found->second;
+      }
+    } else {
+      input = getAbsolutePath(input);
+    }
+    vector<RunMeasurement> runs;
+    for (int repetition = 0; repetition < repetitions; repetition++) {
+      cout << "Running " << configuration.name << ", repetition " << repetition + 1
+        << " of " << repetitions << endl;
+      runs.push_back(runConfiguration(
+        configuration, commonParams, input, localDB, runId, windows, !referenceInput.empty(),
+        workDirectory + "/" + configuration.name + "/repetition" + to_string(repetition)
+      ));
+      if (!runs.back().succeeded) {
+        cerr << "Configuration " << configuration.name << " failed, see logs in " << workDirectory
+          << "/" << configuration.name << endl;
+      }
+    }
+    auto median = getMedian(runs);
+    double throughput = median.wallTime > 0.0
+      ? (double) windows * configuration.processes / median.wallTime : 0.0;
+    if (referenceThroughput <= 0.0) referenceThroughput = throughput;
+    bool histograms = configuration.userParams.get<bool>(
+      pt::ptree::path_type("Save_Control_Histograms_bool", '\0'),
+      commonParams.get<bool>(pt::ptree::path_type("Save_Control_Histograms_bool", '\0'), true)
+    );
+    table << fixed << setprecision(2) << "| " << configuration.name << (median.succeeded ? "" : " (failed)")
+      << " | " << configuration.mode << " | " << configuration.processes
+      << " | " << (referenceInput.empty() ? to_string((long) configuration.windowLength) : "reference")
+      << " | " << median.wallTime << " | " << median.cpuTime << " | " << throughput
+      << " | " << (referenceThroughput > 0.0 ? throughput / referenceThroughput : 0.0)
+      << " | " << median.peakRSS / 1024.0 << " | " << median.diskReadBytes / 1048576.0
+      << " | " << median.diskWrittenBytes / 1048576.0 << " | " << median.outputBytes / 1048576.0
+      << " |" << endl;
+
+    pt::ptree result;
+    result.put("name", configuration.name);
+    result.put("mode", configuration.mode);
+    result.put("processes", configuration.processes);
+    result.put("windowLength", configuration.windowLength);
+    result.put("controlHistograms", histograms);
+    result.put("succeeded", median.succeeded);
+    result.put("wallTime", median.wallTime);
+    result.put("cpuTime", median.cpuTime);
+    result.put("windowsPerSecond", throughput);
+    result.put("peakRSSKB", median.peakRSS);
+    result.put("diskReadBytes", median.diskReadBytes);
+    result.put("diskWrittenBytes", median.diskWrittenBytes);
+    result.put("outputBytes", median.outputBytes);
+    pt::ptree stages;
+    for (const auto& stage : median.stages) {
+      stageTable << fixed << setprecision(2) << "| " << configuration.name << " | " << stage.task
+        << " | " << stage.windows << " | " << stage.wallTime << " | " << stage.cpuTime
+        << " | " << stage.peakRSS / 1024.0 << " | " << stage.readBytes / 1048576.0
+        << " | " << stage.writtenBytes / 1048576.0 << " |" << endl;
+      pt::ptree stageResult;
+      stageResult.put("task", stage.task);
+      stageResult.put("windows", stage.windows);
+      stageResult.put("wallTime", stage.wallTime);
+      stageResult.put("cpuTime", stage.cpuTime);
+      stageResult.put("peakRSSKB", stage.peakRSS);
+      stageResult.put("readBytes", stage.readBytes);
+      stageResult.put("writtenBytes", stage.writtenBytes);
+      stages.push_back(make_pair("", stageResult));
+    }
+    result.add_child("stages", stages);
+    resultsList.push_back(make_pair("", result));
+  }
+  results.put("windows", windows);
+  results.put("repetitions", repetitions);
+  results.put("input", referenceInput.empty() ? "synthetic" : referenceInput);
+  results.add_child("configurations", resultsList);
+  pt::write_json(resultsFile, results);
+
+  cout << endl << table.str() << endl << stageTable.str();
+  ofstream tableFile(workDirectory + "/scalingTable.md");
+  tableFile << table.str() << endl << stageTable.str();
+  cout << endl << "Results saved in " << resultsFile << " and " << workDirectory << "/scalingTable.md" << endl;
+  return EXIT_SUCCESS;
+}
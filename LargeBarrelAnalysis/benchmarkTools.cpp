@@ -0,0 +1,577 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file benchmarkTools.cpp
+ */
+
+#include <Unpacker2/Unpacker2/TDCChannel.h>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <JPetRecoSignal/JPetRecoSignal.h>
+#include <JPetPhysSignal/JPetPhysSignal.h>
+#include <JPetRawSignal/JPetRawSignal.h>
+#include "TimeWindowCreatorTools.h"
+#include "EventCategorizerTools.h"
+#include "SignalFinderTools.h"
+#include "HitFinderTools.h"
+#include "ParallelFitter.h"
+#include <TH1F.h>
+#include <functional>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <memory>
+#include <cstdlib>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <deque>
+#include <new>
+
+using namespace std;
+
+/// Number of allocations made by the whole program
+static atomic<unsigned long> gAllocations(0);
+/// Results of the measured calls are added here, so they are not optimized away
+static volatile unsigned long gSink = 0;
+
+void* operator new(size_t size)
+{
+  gAllocations.fetch_add(1, memory_order_relaxed);
+  if (void* pointer = malloc(size ? size : 1)) return pointer;
+  throw bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+  free(pointer);
+}
+
+/**
+ * Timer of the measured part of one iteration. Preparation of the input
+ * (e.g. copy of the vector sorted in place) is left out of start()/stop().
+ */
+class BenchmarkTimer
+{
+public:
+  void start()
+  {
+    fAllocationsAtStart = gAllocations.load(memory_order_relaxed);
+    fStart = chrono::steady_clock::now();
+  }
+
+  void stop()
+  {
+    auto end = chrono::steady_clock::now();
+    fAllocations += gAllocations.load(memory_order_relaxed) - fAllocationsAtStart;
+    fNanoseconds += chrono::duration<double, nano>(end - fStart).count();
+  }
+
+  double fNanoseconds = 0.0;
+  unsigned long fAllocations = 0;
+
+private:
+  chrono::steady_clock::time_point fStart;
+  unsigned long fAllocationsAtStart = 0;
+};
+
+struct BenchmarkResult {
+  string name;
+  vector<pair<string, long>> params;
+  unsigned long iterations = 0;
+  unsigned long objects = 0;
+  double nsPerObject = 0.0;
+  double allocationsPerObject = 0.0;
+
+  string getKey() const
+  {
+    ostringstream key;
+    key << name;
+    for (const auto& param : params) key << " " << param.first << "=" << param.second;
+    return key.str();
+  }
+};
+
+/**
+ * Repeating each case until the minimal time is measured
+ */
+class BenchmarkRunner
+{
+public:
+  BenchmarkRunner(double minTime, const string& filter): fMinTime(minTime), fFilter(filter) {}
+
+  void run(
+    const string& name, const vector<pair<string, long>>& params,
+    unsigned long objectsPerIteration, const function<void(BenchmarkTimer&)>& body
+  ) {
+    BenchmarkResult result;
+    result.name = name;
+    result.params = params;
+    if (!fFilter.empty() && result.getKey().find(fFilter) == string::npos) return;
+    // One iteration not measured, for the caches and lazy initializations
+    BenchmarkTimer warmUp;
+    body(warmUp);
+    BenchmarkTimer timer;
+    while (timer.fNanoseconds < fMinTime * 1.0e9 || result.iterations < 3) {
+      body(timer);
+      result.iterations++;
+    }
+    result.objects = result.iterations * objectsPerIteration;
+    result.nsPerObject = timer.fNanoseconds / max(result.objects, 1ul);
+    result.allocationsPerObject = (double) timer.fAllocations / max(result.objects, 1ul);
+    cout << left << setw(64) << result.getKey() << right << fixed << setprecision(1)
+      << setw(12) << result.nsPerObject << " ns/obj" << setprecision(2)
+      << setw(10) << result.allocationsPerObject << " alloc/obj" << endl;
+    fResults.push_back(result);
+  }
+
+  bool writeJSON(const string& fileName) const
+  {
+    ofstream file(fileName);
+    if (!file.is_open()) return false;
+    file << "{\"build\": {\"compiler\": \"" << __VERSION__ << "\", \"date\": \""
+      << __DATE__ << " " << __TIME__ << "\"}," << endl << "\"results\": [" << endl;
+    for (unsigned i = 0; i < fResults.size(); i++) {
+      const auto& result = fResults[i];
+      file << "  {\"name\": \"" << result.name << "\", \"key\": \"" << result.getKey()
+        << "\", \"params\": {";
+      for (unsigned j = 0; j < result.params.size(); j++) {
+        file << (j > 0 ? ", " : "") << "\"" << result.params[j].first << "\": " << result.params[j].second;
+      }
+      file << "}, \"iterations\": " << result.iterations << ", \"objects\": " << result.objects
+        << ", \"nsPerObject\": " << result.nsPerObject
+        << ", \"allocationsPerObject\": " << result.allocationsPerObject << "}"
+        << (i + 1 < fResults.size() ? "," : "") << endl;
+    }
+    file << "]}" << endl;
+    return true;
+  }
+
+  /**
+   * Printing ratios of times to the results of other build, matched by the key of the case
+   */
+  void compare(const string& fileName) const
+  {
+    boost::property_tree::ptree baseline;
+    boost::property_tree::read_json(fileName, baseline);
+    map<string, pair<double, double>> baselineResults;
+    for (const auto& entry : baseline.get_child("results")) {
+      baselineResults[entry.second.get<string>("key")] = make_pair(
+        entry.second.get<double>("nsPerObject"), entry.second.get<double>("allocationsPerObject")
+      );
+    }
+    cout << endl << "Comparison with " << fileName << " (time ratio, allocations before -> now):" << endl;
+    for (const auto& result : fResults) {
+      auto found = baselineResults.find(result.getKey());
+      if (found == baselineResults.end()) continue;
+      cout << left << setw(64) << result.getKey() << right << fixed << setprecision(3)
+        << setw(10) << (found->second.first > 0.0 ? result.nsPerObject / found->second.first : 0.0)
+        << setprecision(2) << setw(10) << found->second.second << " -> " << result.allocationsPerObject << endl;
+    }
+  }
+
+private:
+  double fMinTime;
+  string fFilter;
+  vector<BenchmarkResult> fResults;
+};
+
+/**
+ * Barrel with one layer of slots, each with a scintillator, two photomultipliers
+ * and 4 TOMB channels for each of them. Containers keep addresses of the objects,
+ * so the references between them stay valid.
+ */
+struct BenchmarkDetector {
+  static const int kSlots = 192;
+  deque<JPetLayer> layers;
+  deque<JPetBarrelSlot> slots;
+  deque<JPetScin> scins;
+  deque<JPetPM> pms;
+  deque<JPetFEB> febs;
+  deque<JPetTRB> trbs;
+  deque<JPetTOMBChannel> channels;
+  map<unsigned int, vector<double>> velocities;
+  map<unsigned int, vector<double>> emptyCalibration;
+
+  BenchmarkDetector()
+  {
+    layers.emplace_back(1, true, "layer", 42.5);
+    febs.emplace_back(1, true, "feb", "benchmark front-end board", 1, 1, 4, 4);
+    trbs.emplace_back(1, 1, 1);
+    for (int slot = 0; slot < kSlots; slot++) {
+      slots.emplace_back(slot + 1, true, "slot", slot * 360.0 / kSlots, slot + 1);
+      slots.back().setLayer(layers.front());
+      scins.emplace_back(slot + 1);
+      scins.back().setBarrelSlot(slots.back());
+      for (int side = 0; side < 2; side++) {
+        pms.emplace_back(2 * slot + side + 1, "pm");
+        auto& pm = pms.back();
+        pm.setSide(side == 0 ? JPetPM::SideA : JPetPM::SideB);
+        pm.setBarrelSlot(slots.back());
+        pm.setScin(scins.back());
+        for (int thr = 1; thr <= 4; thr++) {
+          int channelNumber = 8 * slot + 4 * side + thr;
+          channels.emplace_back(channelNumber);
+          auto& channel = channels.back();
+          channel.setPM(pm);
+          channel.setFEB(febs.front());
+          channel.setTRB(trbs.front());
+          channel.setLocalChannelNumber(thr);
+          channel.setThreshold(80.0 * thr);
+          velocities[channelNumber] = {12.0, 0.0, 0.0, 0.0};
+        }
+      }
+    }
+  }
+
+  const JPetPM& getPM(int slot, int side) const { return pms.at(2 * slot + side); }
+  const JPetTOMBChannel& getChannel(int slot, int side, int thr) const
+  {
+    return channels.at(8 * slot + 4 * side + thr - 1);
+  }
+};
+
+/**
+ * Signal Channels of one signal on all thresholds, times in ps
+ */
+void addSignalSigChs(
+  const BenchmarkDetector& detector, int slot, int side, double time, vector<JPetSigCh>& sigChs
+) {
+  for (int thr = 1; thr <= 4; thr++) {
+    const auto& channel = detector.getChannel(slot, side, thr);
+    for (auto type : {JPetSigCh::Leading, JPetSigCh::Trailing}) {
+      double value = type == JPetSigCh::Leading ? time + 200.0 * thr : time + 40000.0 - 5000.0 * thr;
+      JPetSigCh sigCh(type, value);
+      sigCh.setTOMBChannel(channel);
+      sigCh.setPM(channel.getPM());
+      sigCh.setThresholdNumber(thr);
+      sigCh.setRecoFlag(JPetSigCh::Good);
+      sigChs.push_back(sigCh);
+    }
+  }
+}
+
+JPetPhysSignal makePhysSignal(const BenchmarkDetector& detector, int slot, int side, double time)
+{
+  vector<JPetSigCh> sigChs;
+  addSignalSigChs(detector, slot, side, time, sigChs);
+  JPetRawSignal raw;
+  for (const auto& sigCh : sigChs) raw.addPoint(sigCh);
+  raw.setPM(detector.getPM(slot, side));
+  raw.setBarrelSlot(detector.slots.at(slot));
+  JPetRecoSignal reco;
+  reco.setRawSignal(raw);
+  reco.setBarrelSlot(detector.slots.at(slot));
+  JPetPhysSignal phys;
+  phys.setRecoSignal(reco);
+  phys.setPM(detector.getPM(slot, side));
+  phys.setBarrelSlot(detector.slots.at(slot));
+  phys.setTime(time);
+  phys.setRecoFlag(JPetBaseSignal::Good);
+  return phys;
+}
+
+void benchmarkTimeWindowCreatorTools(BenchmarkRunner& runner, const BenchmarkDetector& detector)
+{
+  mt19937 engine(1);
+  auto thresholds = map<unsigned int, vector<double>>();
+  auto calibration = detector.emptyCalibration;
+  TimeWindowCreatorHistos noHistos;
+  for (long multiplicity : {1, 4, 16}) {
+    TDCChannel tdcChannel;
+    tdcChannel.SetChannel(detector.getChannel(0, 0, 1).getChannel());
+    uniform_real_distribution<double> time(-20000.0, -100.0);
+    vector<double> leads;
+    for (long i = 0; i < multiplicity; i++) leads.push_back(time(engine));
+    sort(leads.begin(), leads.end());
+    for (auto lead : leads) tdcChannel.AddLead(lead);
+    for (auto lead : leads) tdcChannel.AddTrail(lead + 30.0);
+    runner.run("TimeWindowCreatorTools::buildSigChs", {{"multiplicity", multiplicity}}, 2 * multiplicity,
+      [&] (BenchmarkTimer& timer) {
+        timer.start();
+        auto sigChs = TimeWindowCreatorTools::buildSigChs(
+          &tdcChannel, detector.getChannel(0, 0, 1), calibration, thresholds,
+          0.0, -1.0e6, true, noHistos
+        );
+        timer.stop();
+        gSink += sigChs.size();
+      }
+    );
+  }
+  for (long occupancy : {64, 1024, 16384}) {
+    vector<JPetSigCh> sigChs;
+    uniform_real_distribution<double> time(0.0, 2.0e7);
+    for (long i = 0; i < occupancy; i++) {
+      JPetSigCh sigCh(i % 2 == 0 ? JPetSigCh::Leading : JPetSigCh::Trailing, time(engine));
+      sigCh.setPM(detector.getPM(0, 0));
+      sigChs.push_back(sigCh);
+    }
+    runner.run("TimeWindowCreatorTools::sortByValue", {{"occupancy", occupancy}}, occupancy,
+      [&] (BenchmarkTimer& timer) {
+        auto copy = sigChs;
+        timer.start();
+        TimeWindowCreatorTools::sortByValue(copy);
+        timer.stop();
+        gSink += copy.size();
+      }
+    );
+  }
+  for (long multiplicity : {4, 16, 64}) {
+    for (long corruptedPercent : {0, 10}) {
+      vector<JPetSigCh> sigChs;
+      uniform_int_distribution<int> percent(0, 99);
+      for (long i = 0; i < multiplicity; i++) {
+        bool dropTrailing = percent(engine) < corruptedPercent;
+        JPetSigCh lead(JPetSigCh::Leading, 100000.0 * i);
+        lead.setPM(detector.getPM(0, 0));
+        sigChs.push_back(lead);
+        if (dropTrailing) continue;
+        JPetSigCh trail(JPetSigCh::Trailing, 100000.0 * i + 30000.0);
+        trail.setPM(detector.getPM(0, 0));
+        sigChs.push_back(trail);
+      }
+      runner.run("TimeWindowCreatorTools::flagSigChs",
+        {{"multiplicity", multiplicity}, {"corruptedPercent", corruptedPercent}}, sigChs.size(),
+        [&] (BenchmarkTimer& timer) {
+          auto copy = sigChs;
+          timer.start();
+          TimeWindowCreatorTools::flagSigChs(copy, noHistos);
+          timer.stop();
+          gSink += copy.size();
+        }
+      );
+    }
+  }
+}
+
+void benchmarkSignalFinderTools(BenchmarkRunner& runner, const BenchmarkDetector& detector)
+{
+  mt19937 engine(2);
+  SignalFinderHistos noHistos;
+  for (long occupancy : {256, 4096, 32768}) {
+    JPetTimeWindow window("JPetSigCh");
+    uniform_int_distribution<int> slot(0, BenchmarkDetector::kSlots - 1);
+    uniform_real_distribution<double> time(-2.0e7, 0.0);
+    vector<JPetSigCh> sigChs;
+    while ((long) sigChs.size() < occupancy) {
+      addSignalSigChs(detector, slot(engine), engine() % 2, time(engine), sigChs);
+    }
+    for (const auto& sigCh : sigChs) window.add<JPetSigCh>(sigCh);
+    runner.run("SignalFinderTools::getSigChByPM", {{"occupancy", (long) sigChs.size()}}, sigChs.size(),
+      [&] (BenchmarkTimer& timer) {
+        timer.start();
+        auto sigChByPM = SignalFinderTools::getSigChByPM(&window, false);
+        timer.stop();
+        gSink += sigChByPM.size();
+      }
+    );
+  }
+  for (long multiplicity : {1, 4, 16}) {
+    vector<JPetSigCh> sigChs;
+    for (long i = 0; i < multiplicity; i++) {
+      addSignalSigChs(detector, 0, 0, 100000.0 * i, sigChs);
+    }
+    shuffle(sigChs.begin(), sigChs.end(), engine);
+    runner.run("SignalFinderTools::buildRawSignals", {{"multiplicity", multiplicity}}, sigChs.size(),
+      [&] (BenchmarkTimer& timer) {
+        timer.start();
+        auto rawSignals = SignalFinderTools::buildRawSignals(sigChs, 4, 5000.0, 23000.0, noHistos);
+        timer.stop();
+        gSink += rawSignals.size();
+      }
+    );
+  }
+}
+
+void benchmarkHitFinderTools(BenchmarkRunner& runner, const BenchmarkDetector& detector)
+{
+  mt19937 engine(3);
+  HitFinderHistos noHistos;
+  uniform_real_distribution<double> delay(-4000.0, 4000.0);
+  for (long multiplicity : {1, 4, 16, 64}) {
+    vector<JPetPhysSignal> signals;
+    for (long i = 0; i < multiplicity; i++) {
+      double time = 100000.0 * i;
+      signals.push_back(makePhysSignal(detector, 0, 0, time));
+      signals.push_back(makePhysSignal(detector, 0, 1, time + delay(engine)));
+    }
+    shuffle(signals.begin(), signals.end(), engine);
+    runner.run("HitFinderTools::matchSignals", {{"multiplicity", multiplicity}}, signals.size(),
+      [&] (BenchmarkTimer& timer) {
+        auto copy = signals;
+        timer.start();
+        auto hits = HitFinderTools::matchSignals(copy, detector.velocities, 6000.0, noHistos);
+        timer.stop();
+        gSink += hits.size();
+      }
+    );
+  }
+  auto signalA = makePhysSignal(detector, 0, 0, 1000.0);
+  auto signalB = makePhysSignal(detector, 0, 1, 2500.0);
+  runner.run("HitFinderTools::createHit", {}, 1,
+    [&] (BenchmarkTimer& timer) {
+      timer.start();
+      auto hit = HitFinderTools::createHit(signalA, signalB, detector.velocities, noHistos);
+      timer.stop();
+      gSink += hit.getPosZ() > 0.0;
+    }
+  );
+  auto hit = HitFinderTools::createHit(signalA, signalB, detector.velocities, noHistos);
+  runner.run("HitFinderTools::calculateTOT", {}, 1,
+    [&] (BenchmarkTimer& timer) {
+      timer.start();
+      double tot = HitFinderTools::calculateTOT(hit);
+      timer.stop();
+      gSink += tot > 0.0;
+    }
+  );
+}
+
+void benchmarkEventCategorizerTools(BenchmarkRunner& runner, const BenchmarkDetector& detector)
+{
+  mt19937 engine(4);
+  EventCategorizerHistos noHistos;
+  EventStreamHistos noStreamHistos;
+  uniform_int_distribution<int> slot(0, BenchmarkDetector::kSlots - 1);
+  uniform_real_distribution<double> time(0.0, 5000.0);
+  uniform_real_distribution<double> z(-25.0, 25.0);
+  const long kEvents = 256;
+  for (long multiplicity : {2, 3, 5, 8}) {
+    vector<JPetEvent> events(kEvents);
+    for (auto& event : events) {
+      for (long i = 0; i < multiplicity; i++) {
+        int hitSlot = slot(engine);
+        auto hit = HitFinderTools::createHit(
+          makePhysSignal(detector, hitSlot, 0, time(engine)),
+          makePhysSignal(detector, hitSlot, 1, time(engine)),
+          detector.velocities, HitFinderHistos()
+        );
+        hit.setPosZ(z(engine));
+        event.addHit(hit);
+      }
+    }
+    vector<pair<string, function<bool(const JPetEvent&)>>> checks = {
+      {"EventCategorizerTools::checkFor2Gamma", [&] (const JPetEvent& event) {
+        return EventCategorizerTools::checkFor2Gamma(event, noHistos, 3.0);
+      }},
+      {"EventCategorizerTools::checkFor3Gamma", [&] (const JPetEvent& event) {
+        return EventCategorizerTools::checkFor3Gamma(event, noHistos);
+      }},
+      {"EventCategorizerTools::checkForPrompt", [&] (const JPetEvent& event) {
+        return EventCategorizerTools::checkForPrompt(event, noHistos, 30000.0, 50000.0);
+      }},
+      {"EventCategorizerTools::checkForScatter", [&] (const JPetEvent& event) {
+        return EventCategorizerTools::checkForScatter(event, noHistos, 2000.0);
+      }},
+      {"EventCategorizerTools::stream2Gamma", [&] (const JPetEvent& event) {
+        return EventCategorizerTools::stream2Gamma(event, noStreamHistos, 3.0, 2000.0);
+      }},
+      {"EventCategorizerTools::stream3Gamma", [&] (const JPetEvent& event) {
+        return EventCategorizerTools::stream3Gamma(event, noStreamHistos, 190.0, 5000.0, 5.0);
+      }}
+    };
+    for (const auto& check : checks) {
+      runner.run(check.first, {{"multiplicity", multiplicity}}, kEvents,
+        [&] (BenchmarkTimer& timer) {
+          unsigned long accepted = 0;
+          timer.start();
+          for (const auto& event : events) accepted += check.second(event);
+          timer.stop();
+          gSink += accepted;
+        }
+      );
+    }
+  }
+}
+
+/**
+ * Microbenchmarks of the tools classes, with the input of different occupancy
+ * of the window or multiplicity of signals per channel, photomultiplier or event, e.g.
+ * ./benchmarkTools -t 0.5 -f HitFinder -o toolsBenchmark.json -c previousBuild.json
+ */
+/**
+ * Peaks of calibration histograms found by each method of ParallelFitter
+ * in one thread, with a range of numbers of entries
+ */
+void benchmarkPeakEstimation(BenchmarkRunner& runner)
+{
+  mt19937 engine(5);
+  const long kHistograms = 16;
+  vector<pair<string, PeakEstimator::Method>> methods = {
+    {"fit", PeakEstimator::kFit}, {"moments", PeakEstimator::kMoments},
+    {"parabola", PeakEstimator::kLogParabola}, {"seeded", PeakEstimator::kSeededFit}
+  };
+  for (long entries : {1000, 10000, 100000}) {
+    vector<unique_ptr<TH1F>> histograms;
+    normal_distribution<double> peak(1.5, 0.8);
+    for (long i = 0; i < kHistograms; i++) {
+      histograms.emplace_back(new TH1F(Form("benchmarkPeak_%ld_%ld", entries, i), "", 400, -20.0, 20.0));
+      histograms.back()->SetDirectory(nullptr);
+      for (long entry = 0; entry < entries; entry++) histograms.back()->Fill(peak(engine));
+    }
+    for (const auto& method : methods) {
+      runner.run("ParallelFitter::" + method.first, {{"entries", entries}}, kHistograms,
+        [&] (BenchmarkTimer& timer) {
+          ParallelFitter fitter(1, method.second);
+          for (const auto& histogram : histograms) {
+            double highestBin = histogram->GetBinCenter(histogram->GetMaximumBin());
+            fitter.add(histogram.get(), highestBin - 5.0, highestBin + 5.0, histogram->GetName());
+          }
+          timer.start();
+          fitter.run();
+          timer.stop();
+          gSink += fitter.getNumberOfFailures();
+        }
+      );
+    }
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  double minTime = 0.2;
+  string filter;
+  string outputFile = "toolsBenchmark.json";
+  string baselineFile;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    string flag = argv[i];
+    if (flag == "-t") minTime = atof(argv[i+1]);
+    else if (flag == "-f") filter = argv[i+1];
+    else if (flag == "-o") outputFile = argv[i+1];
+    else if (flag == "-c") baselineFile = argv[i+1];
+    else {
+      cerr << "Usage: " << argv[0]
+        << " [-t <min time per case in s>] [-f <case filter>] [-o <results json>] [-c <baseline json>]" << endl;
+      return EXIT_FAILURE;
+    }
+  }
+  try {
+    BenchmarkDetector detector;
+    BenchmarkRunner runner(minTime, filter);
+    benchmarkTimeWindowCreatorTools(runner, detector);
+    benchmarkSignalFinderTools(runner, detector);
+    benchmarkHitFinderTools(runner, detector);
+    benchmarkEventCategorizerTools(runner, detector);
+    benchmarkPeakEstimation(runner);
+    if (!runner.writeJSON(outputFile)) {
+      cerr << "Unable to write results to " << outputFile << endl;
+      return EXIT_FAILURE;
+    }
+    if (!baselineFile.empty()) runner.compare(baselineFile);
+  } catch (const std::exception& except) {
+    cerr << "Unrecoverable error occured:" << except.what() << "Exiting the program!" << endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,78 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file generateSyntheticData.cpp
+ */
+
+#include <boost/property_tree/json_parser.hpp>
+#include "SyntheticDataGenerator.h"
+#include <iostream>
+#include <cstdlib>
+
+using namespace std;
+
+/**
+ * Writing synthetic Unpacker events to a ROOT file, that can be analysed
+ * with -t root in place of the file unpacked from HLD, e.g.
+ * ./generateSyntheticData -l detectorSetupRun1.json -i 1 -n 1000 -o synthetic.hld.root -u userParams.json
+ */
+int main(int argc, char* argv[])
+{
+  string localDB;
+  string outputFile = "synthetic.hld.root";
+  string userParams;
+  int runId = 1;
+  long numberOfWindows = 1000;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    string flag = argv[i];
+    if (flag == "-l") localDB = argv[i+1];
+    else if (flag == "-i") runId = atoi(argv[i+1]);
+    else if (flag == "-o") outputFile = argv[i+1];
+    else if (flag == "-u") userParams = argv[i+1];
+    else if (flag == "-n") numberOfWindows = atol(argv[i+1]);
+    else {
+      cerr << "Unknown option " << flag << endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (localDB.empty() || numberOfWindows <= 0) {
+    cerr << "Usage: " << argv[0]
+      << " -l <detector setup json> [-i <run id>] [-n <number of windows>]"
+      << " [-o <output file>] [-u <user params json>]" << endl;
+    return EXIT_FAILURE;
+  }
+  try {
+    map<string, boost::any> options;
+    if (!userParams.empty()) {
+      boost::property_tree::ptree tree;
+      boost::property_tree::read_json(userParams, tree);
+      options = SyntheticDataGenerator::getOptions(tree);
+    }
+    SyntheticDataSummary summary;
+    if (!SyntheticDataGenerator::generateFile(
+      localDB, runId, numberOfWindows, outputFile,
+      SyntheticDataGenerator::loadConfig(options), &summary
+    )) {
+      cerr << "Generation of synthetic data failed, see the log for details" << endl;
+      return EXIT_FAILURE;
+    }
+    cout << "Generated " << summary.windows << " windows with " << summary.annihilations
+      << " annihilations, " << summary.randoms << " random photons, " << summary.hits
+      << " hits, " << summary.darkNoisePulses << " dark noise pulses and "
+      << summary.corruptedEdges << " corrupted edges, " << summary.edges
+      << " edges in total" << endl;
+  } catch (const std::exception& except) {
+    cerr << "Unrecoverable error occured:" << except.what() << "Exiting the program!" << endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -16,7 +16,10 @@
 #include <JPetManager/JPetManager.h>
 #include "TimeWindowCreator.h"
 #include "SignalTransformer.h"
-#include "EventCategorizer.h"
+#include "EventCategorizerMultiStream.h"
+#include "EventCategorizerSweep.h"
+#include "InstrumentedTask.h"
+#include "FusedPipeline.h"
 #include "SignalFinder.h"
 #include "EventFinder.h"
 #include "HitFinder.h"
@@ -27,19 +30,30 @@ int main(int argc, const char* argv[]) {
   try {
     JPetManager& manager = JPetManager::getManager();
 
-    manager.registerTask<TimeWindowCreator>("TimeWindowCreator");
-    manager.registerTask<SignalFinder>("SignalFinder");
-    manager.registerTask<SignalTransformer>("SignalTransformer");
-    manager.registerTask<HitFinder>("HitFinder");
-    manager.registerTask<EventFinder>("EventFinder");
-    manager.registerTask<EventCategorizer>("EventCategorizer");
+    manager.registerTask<InstrumentedTask<TimeWindowCreator>>("TimeWindowCreator");
+    manager.registerTask<InstrumentedTask<SignalFinder>>("SignalFinder");
+    manager.registerTask<InstrumentedTask<SignalTransformer>>("SignalTransformer");
+    manager.registerTask<InstrumentedTask<HitFinder>>("HitFinder");
+    manager.registerTask<InstrumentedTask<EventFinder>>("EventFinder");
+    manager.registerTask<InstrumentedTask<EventCategorizerMultiStream>>("EventCategorizerMultiStream");
+    manager.registerTask<InstrumentedTask<EventCategorizerSweep>>("EventCategorizerSweep");
+    manager.registerTask<InstrumentedTask<FusedPipeline>>("FusedPipeline");
 
     manager.useTask("TimeWindowCreator", "hld", "tslot.calib");
     manager.useTask("SignalFinder", "tslot.calib", "raw.sig");
     manager.useTask("SignalTransformer", "raw.sig", "phys.sig");
     manager.useTask("HitFinder", "phys.sig", "hits");
     manager.useTask("EventFinder", "hits", "unk.evt");
-    manager.useTask("EventCategorizer", "unk.evt", "cat.evt");
+    manager.useTask("EventCategorizerMultiStream", "unk.evt", "cat.evt");
+    // For tuning of the categorization cuts replace the task above with:
+    // manager.useTask("EventCategorizerSweep", "unk.evt", "sweep");
+    // For processing in memory, without intermediate files, replace all tasks above with:
+    // manager.useTask("FusedPipeline", "hld", "cat.evt");
+    // or, with FusedPipeline_Pipelined_bool set to true, where events are saved by the task itself:
+    // manager.useTask("FusedPipeline", "hld", "pipeline");
+    // With hits read from the hit store (EventFinder_HitStoreFile_std::string), events are saved
+    // by EventFinder in unk.evt, or by FusedPipeline in cat.evt, and the output needs another extension:
+    // manager.useTask("EventFinder", "hits", "store");
 
     manager.run(argc, argv);
   } catch (const std::exception& except) {
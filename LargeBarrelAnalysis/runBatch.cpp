@@ -0,0 +1,496 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file runBatch.cpp
+ */
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <TFile.h>
+#include <TTree.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <climits>
+#include <csignal>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <deque>
+#include <map>
+#include <ctime>
+
+using namespace std;
+namespace pt = boost::property_tree;
+
+/**
+ * State of one input file of the batch, kept in the state file between runs
+ */
+struct BatchFile {
+  string path;
+  string status = "pending";
+  int attempts = 0;
+  int exitCode = 0;
+  double wallTime = 0.0;
+  string finished;
+};
+
+struct BatchConfiguration {
+  string executable;
+  vector<string> arguments;
+  string runList;
+  string directory;
+  string suffix = ".hld";
+  bool watch = false;
+  int watchInterval = 30;
+  string outputDirectory = "batch";
+  vector<string> expectedOutputs;
+  int maxProcesses = 0;
+  long memoryPerProcess = 2048;
+  int retries = 2;
+  string stateFile;
+  string summaryFile;
+};
+
+volatile sig_atomic_t gStopRequested = 0;
+
+void requestStop(int)
+{
+  gStopRequested = 1;
+}
+
+bool makeDirectory(const string& path)
+{
+  for (size_t position = path.find('/', 1); ; position = path.find('/', position + 1)) {
+    string directory = path.substr(0, position);
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) return false;
+    if (position == string::npos) return true;
+  }
+}
+
+string getAbsolutePath(const string& path)
+{
+  char resolved[PATH_MAX];
+  if (realpath(path.c_str(), resolved)) return resolved;
+  return path;
+}
+
+bool hasSuffix(const string& name, const string& suffix)
+{
+  return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+string getCurrentTime()
+{
+  time_t now = time(nullptr);
+  char buffer[32];
+  strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", localtime(&now));
+  return buffer;
+}
+
+/**
+ * Name of the input file without the directory and the extensions of data files,
+ * outputs of the framework for run.hld or run.hld.root are named run.*.root
+ */
+string getStem(const string& path)
+{
+  string name = path.substr(path.find_last_of('/') + 1);
+  for (const string& extension : {string(".root"), string(".hld")}) {
+    if (hasSuffix(name, extension)) name.erase(name.size() - extension.size());
+  }
+  return name;
+}
+
+/**
+ * Number of processes allowed by the cores and by the memory available
+ * at the start, with the memory needed by one process given in MB
+ */
+int getNumberOfWorkers(int maxProcesses, long memoryPerProcess)
+{
+  int workers = max(1u, thread::hardware_concurrency());
+  if (maxProcesses > 0) workers = min(workers, maxProcesses);
+  ifstream meminfo("/proc/meminfo");
+  string key;
+  long value = 0;
+  string unit;
+  while (meminfo >> key >> value >> unit) {
+    if (key != "MemAvailable:") continue;
+    if (memoryPerProcess > 0) workers = min<long>(workers, max(1l, value / 1024 / memoryPerProcess));
+    break;
+  }
+  return workers;
+}
+
+string getOutputDirectory(const BatchConfiguration& config, const string& input)
+{
+  return config.outputDirectory + "/" + getStem(input);
+}
+
+/**
+ * Outputs are complete if all expected files exist and are closed ROOT files
+ * not recovered after a crash, with the tree of time windows in them
+ */
+bool hasValidOutputs(const BatchConfiguration& config, const string& input)
+{
+  if (config.expectedOutputs.empty()) return false;
+  for (const auto& suffix : config.expectedOutputs) {
+    string fileName = getOutputDirectory(config, input) + "/" + getStem(input) + suffix;
+    struct stat status;
+    if (stat(fileName.c_str(), &status) != 0 || status.st_size == 0) return false;
+    if (!hasSuffix(fileName, ".root")) continue;
+    unique_ptr<TFile> file(TFile::Open(fileName.c_str(), "READ"));
+    if (!file || file->IsZombie() || file->TestBit(TFile::kRecovered)) return false;
+    if (!dynamic_cast<TTree*>(file->Get("T"))) return false;
+  }
+  return true;
+}
+
+/**
+ * Input files of the run list, one path in each line, lines starting with # are skipped
+ */
+vector<string> readRunList(const string& fileName)
+{
+  vector<string> files;
+  ifstream runList(fileName);
+  string line;
+  while (getline(runList, line)) {
+    line.erase(0, line.find_first_not_of(" \t"));
+    line.erase(line.find_last_not_of(" \t\r") + 1);
+    if (line.empty() || line[0] == '#') continue;
+    files.push_back(getAbsolutePath(line));
+  }
+  return files;
+}
+
+/**
+ * Files of the directory with the given suffix, with their sizes
+ */
+map<string, long> listDirectory(const string& path, const string& suffix)
+{
+  map<string, long> files;
+  DIR* directory = opendir(path.c_str());
+  if (!directory) return files;
+  while (auto entry = readdir(directory)) {
+    string name = entry->d_name;
+    if (!hasSuffix(name, suffix)) continue;
+    struct stat status;
+    string fileName = getAbsolutePath(path + "/" + name);
+    if (stat(fileName.c_str(), &status) == 0 && S_ISREG(status.st_mode)) files[fileName] = status.st_size;
+  }
+  closedir(directory);
+  return files;
+}
+
+void loadState(const string& fileName, map<string, BatchFile>& files)
+{
+  pt::ptree state;
+  try {
+    pt::read_json(fileName, state);
+  } catch (const pt::json_parser_error&) {
+    return;
+  }
+  for (const auto& entry : state.get_child("files", pt::ptree())) {
+    BatchFile file;
+    file.path = entry.second.get<string>("path", "");
+    file.status = entry.second.get<string>("status", "pending");
+    file.attempts = entry.second.get<int>("attempts", 0);
+    file.exitCode = entry.second.get<int>("exitCode", 0);
+    file.wallTime = entry.second.get<double>("wallTime", 0.0);
+    file.finished = entry.second.get<string>("finished", "");
+    if (!file.path.empty()) files[file.path] = file;
+  }
+}
+
+/**
+ * State is written to a temporary file and renamed, so a crash of the scheduler
+ * never leaves a partially written state
+ */
+void saveState(const string& fileName, const map<string, BatchFile>& files)
+{
+  pt::ptree state;
+  pt::ptree list;
+  for (const auto& entry : files) {
+    const auto& file = entry.second;
+    pt::ptree item;
+    item.put("path", file.path);
+    item.put("status", file.status);
+    item.put("attempts", file.attempts);
+    item.put("exitCode", file.exitCode);
+    item.put("wallTime", file.wallTime);
+    item.put("finished", file.finished);
+    list.push_back(make_pair("", item));
+  }
+  state.put("updated", getCurrentTime());
+  state.add_child("files", list);
+  string temporary = fileName + ".tmp";
+  pt::write_json(temporary, state);
+  rename(temporary.c_str(), fileName.c_str());
+}
+
+pid_t startProcess(const BatchConfiguration& config, const string& input, const string& directory)
+{
+  vector<string> arguments = {config.executable};
+  arguments.insert(arguments.end(), config.arguments.begin(), config.arguments.end());
+  arguments.insert(arguments.end(), {"-f", input, "-o", directory});
+  pid_t child = fork();
+  if (child == 0) {
+    // Log of the framework is written to the current directory
+    if (chdir(directory.c_str()) != 0) _exit(EXIT_FAILURE);
+    int output = open("batch.log", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (output >= 0) {
+      dup2(output, STDOUT_FILENO);
+      dup2(output, STDERR_FILENO);
+      close(output);
+    }
+    vector<char*> argv;
+    for (auto& argument : arguments) argv.push_back(&argument[0]);
+    argv.push_back(nullptr);
+    execv(argv[0], argv.data());
+    _exit(EXIT_FAILURE);
+  }
+  return child;
+}
+
+void writeSummary(const BatchConfiguration& config, const map<string, BatchFile>& files, double wallTime)
+{
+  map<string, int> counts;
+  double processingTime = 0.0;
+  pt::ptree summary;
+  pt::ptree failed;
+  for (const auto& entry : files) {
+    counts[entry.second.status]++;
+    processingTime += entry.second.wallTime;
+    if (entry.second.status == "failed") {
+      pt::ptree item;
+      item.put("path", entry.second.path);
+      item.put("attempts", entry.second.attempts);
+      item.put("exitCode", entry.second.exitCode);
+      failed.push_back(make_pair("", item));
+    }
+  }
+  summary.put("finished", getCurrentTime());
+  summary.put("files", files.size());
+  summary.put("done", counts["done"]);
+  summary.put("skipped", counts["skipped"]);
+  summary.put("failed", counts["failed"]);
+  summary.put("pending", counts["pending"] + counts["running"]);
+  summary.put("wallTime", wallTime);
+  summary.put("processingTime", processingTime);
+  summary.add_child("failedFiles", failed);
+  pt::write_json(config.summaryFile, summary);
+
+  cout << endl << "| files | done | skipped | failed | pending | wall [s] | processing [s] |" << endl
+       << "|---|---|---|---|---|---|---|" << endl << fixed << setprecision(1)
+       << "| " << files.size() << " | " << counts["done"] << " | " << counts["skipped"] << " | " << counts["failed"]
+       << " | " << counts["pending"] + counts["running"] << " | " << wallTime << " | " << processingTime << " |" << endl;
+  for (const auto& entry : files) {
+    if (entry.second.status == "failed") {
+      cout << "Failed after " << entry.second.attempts << " attempts: " << entry.second.path << endl;
+    }
+  }
+  cout << "Summary saved in " << config.summaryFile << ", state in " << config.stateFile << endl;
+}
+
+BatchConfiguration readConfiguration(const pt::ptree& tree)
+{
+  BatchConfiguration config;
+  config.executable = getAbsolutePath(tree.get<string>("executable"));
+  for (const auto& entry : tree.get_child("arguments", pt::ptree())) {
+    string argument = entry.second.get_value<string>();
+    // Processes run in the directories of the files, so paths to existing files are made absolute
+    if (argument[0] != '-' && access(argument.c_str(), F_OK) == 0) argument = getAbsolutePath(argument);
+    config.arguments.push_back(argument);
+  }
+  config.runList = tree.get<string>("runList", "");
+  config.directory = tree.get<string>("directory", "");
+  config.suffix = tree.get<string>("suffix", config.suffix);
+  config.watch = tree.get<bool>("watch", config.watch);
+  config.watchInterval = max(tree.get<int>("watchInterval", config.watchInterval), 1);
+  config.outputDirectory = tree.get<string>("outputDirectory", config.outputDirectory);
+  for (const auto& entry : tree.get_child("expectedOutputs", pt::ptree())) {
+    config.expectedOutputs.push_back(entry.second.get_value<string>());
+  }
+  config.maxProcesses = tree.get<int>("maxProcesses", config.maxProcesses);
+  config.memoryPerProcess = tree.get<long>("memoryPerProcessMB", config.memoryPerProcess);
+  config.retries = max(tree.get<int>("retries", config.retries), 0);
+  config.stateFile = tree.get<string>("stateFile", config.outputDirectory + "/batchState.json");
+  config.summaryFile = tree.get<string>("summaryFile", config.outputDirectory + "/batchSummary.json");
+  return config;
+}
+
+/**
+ * Batch processing of many input files with a pool of processes of the analysis,
+ * configured with a JSON file (see runBatch.json), e.g.
+ * ./runBatch runBatch.json
+ * Files are taken from the run list and/or the directory, that can be watched
+ * for new files. Each file is processed in its own directory in the output
+ * directory. Files with complete outputs are skipped, failed ones are retried.
+ * The state of all files is kept in the state file, so an interrupted batch
+ * continues where it stopped when started again.
+ */
+int main(int argc, const char* argv[])
+{
+  if (argc != 2) {
+    cerr << "Usage: " << argv[0] << " <batch configuration json>" << endl;
+    return EXIT_FAILURE;
+  }
+  BatchConfiguration config;
+  try {
+    pt::ptree tree;
+    pt::read_json(argv[1], tree);
+    config = readConfiguration(tree);
+  } catch (const pt::ptree_error& error) {
+    cerr << "Unable to read the configuration: " << error.what() << endl;
+    return EXIT_FAILURE;
+  }
+  if (config.runList.empty() && config.directory.empty()) {
+    cerr << "Neither runList nor directory is given in " << argv[1] << endl;
+    return EXIT_FAILURE;
+  }
+  if (!makeDirectory(config.outputDirectory)) {
+    cerr << "Unable to create directory " << config.outputDirectory << endl;
+    return EXIT_FAILURE;
+  }
+  config.outputDirectory = getAbsolutePath(config.outputDirectory);
+  // Waiting for the processes is interrupted by the signals
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = requestStop;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+
+  map<string, BatchFile> files;
+  loadState(config.stateFile, files);
+  for (auto& entry : files) {
+    auto& file = entry.second;
+    // Failed files of the previous batch get new attempts, outputs of finished ones are checked again
+    bool finished = file.status == "done" || file.status == "skipped";
+    if (file.status == "failed" || (finished && !hasValidOutputs(config, file.path))) {
+      file.status = "pending";
+      file.attempts = 0;
+    }
+  }
+  int workers = getNumberOfWorkers(config.maxProcesses, config.memoryPerProcess);
+  cout << "Running up to " << workers << " processes at the same time" << endl;
+
+  deque<string> queue;
+  map<pid_t, pair<string, chrono::steady_clock::time_point>> running;
+  map<string, long> lastSizes;
+  auto addFile = [&] (const string& path) {
+    auto& file = files[path];
+    if (file.path.empty()) file.path = path;
+    if (find(queue.begin(), queue.end(), path) != queue.end()) return;
+    for (const auto& process : running) if (process.second.first == path) return;
+    if (file.status == "done" || file.status == "skipped" || file.status == "failed") return;
+    file.status = "pending";
+    queue.push_back(path);
+  };
+  for (const auto& path : readRunList(config.runList)) addFile(path);
+
+  auto start = chrono::steady_clock::now();
+  auto lastScan = chrono::steady_clock::time_point();
+  while (!gStopRequested) {
+    // Files still written to the watched directory are taken when their size stops changing
+    if (!config.directory.empty() && chrono::steady_clock::now() - lastScan >= chrono::seconds(config.watchInterval)) {
+      lastScan = chrono::steady_clock::now();
+      for (const auto& entry : listDirectory(config.directory, config.suffix)) {
+        auto previous = lastSizes.find(entry.first);
+        bool stable = !config.watch || (previous != lastSizes.end() && previous->second == entry.second);
+        lastSizes[entry.first] = entry.second;
+        if (stable) addFile(entry.first);
+      }
+    }
+    while ((int) running.size() < workers && !queue.empty()) {
+      string path = queue.front();
+      queue.pop_front();
+      auto& file = files[path];
+      string directory = getOutputDirectory(config, path);
+      // Outputs of a failed attempt are not trusted
+      if (file.attempts == 0 && hasValidOutputs(config, path)) {
+        file.status = "skipped";
+        cout << getCurrentTime() << " skipped " << path << ", outputs are complete" << endl;
+        saveState(config.stateFile, files);
+        continue;
+      }
+      if (!makeDirectory(directory)) {
+        cerr << "Unable to create directory " << directory << endl;
+        file.status = "failed";
+        continue;
+      }
+      pid_t child = startProcess(config, path, directory);
+      if (child < 0) {
+        cerr << "Unable to start the process for " << path << endl;
+        queue.push_front(path);
+        break;
+      }
+      file.status = "running";
+      file.attempts++;
+      running[child] = make_pair(path, chrono::steady_clock::now());
+      cout << getCurrentTime() << " started " << path << " (attempt " << file.attempts << ")" << endl;
+      saveState(config.stateFile, files);
+    }
+    if (running.empty() && queue.empty() && !config.watch) break;
+
+    int status = 0;
+    pid_t child = waitpid(-1, &status, config.watch || running.empty() ? WNOHANG : 0);
+    if (child <= 0) {
+      this_thread::sleep_for(chrono::seconds(1));
+      continue;
+    }
+    auto process = running.find(child);
+    if (process == running.end()) continue;
+    auto& file = files[process->second.first];
+    file.wallTime += chrono::duration<double>(chrono::steady_clock::now() - process->second.second).count();
+    file.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    file.finished = getCurrentTime();
+    string directory = getOutputDirectory(config, file.path);
+    bool succeeded = file.exitCode == 0 && (config.expectedOutputs.empty() || hasValidOutputs(config, file.path));
+    if (succeeded) {
+      file.status = "done";
+      cout << file.finished << " finished " << file.path << endl;
+    } else if (file.attempts <= config.retries) {
+      file.status = "pending";
+      queue.push_back(file.path);
+      cerr << file.finished << " failed " << file.path << ", see " << directory << "/batch.log, retrying" << endl;
+    } else {
+      file.status = "failed";
+      cerr << file.finished << " failed " << file.path << ", see " << directory << "/batch.log" << endl;
+    }
+    running.erase(process);
+    saveState(config.stateFile, files);
+  }
+
+  if (gStopRequested) {
+    cout << "Stopping, waiting for " << running.size() << " running processes" << endl;
+    for (const auto& process : running) {
+      int status = 0;
+      waitpid(process.first, &status, 0);
+      auto& file = files[process.second.first];
+      file.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+      file.status = file.exitCode == 0 ? "done" : "pending";
+    }
+  }
+  saveState(config.stateFile, files);
+  writeSummary(config, files, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+  for (const auto& entry : files) if (entry.second.status == "failed") return EXIT_FAILURE;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,367 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  @file runSharded.cpp
+ */
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include "WindowIndex.h"
+#include "ShardedRun.h"
+#include <TFile.h>
+#include <TTree.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <iostream>
+#include <climits>
+#include <limits>
+#include <cerrno>
+#include <cstdlib>
+#include <memory>
+#include <chrono>
+
+using namespace std;
+namespace pt = boost::property_tree;
+
+bool makeDirectory(const string& path)
+{
+  for (size_t position = path.find('/', 1); ; position = path.find('/', position + 1)) {
+    string directory = path.substr(0, position);
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) return false;
+    if (position == string::npos) return true;
+  }
+}
+
+string getAbsolutePath(const string& path)
+{
+  char resolved[PATH_MAX];
+  if (realpath(path.c_str(), resolved)) return resolved;
+  return path;
+}
+
+bool hasSuffix(const string& name, const string& suffix)
+{
+  return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+vector<string> listFiles(const string& path, const string& suffix)
+{
+  vector<string> names;
+  DIR* directory = opendir(path.c_str());
+  if (!directory) return names;
+  while (auto entry = readdir(directory)) {
+    string name = entry->d_name;
+    if (hasSuffix(name, suffix)) names.push_back(name);
+  }
+  closedir(directory);
+  return names;
+}
+
+/**
+ * Number of windows of the input, unpacked HLD input is read
+ * from the file with the additional root extension
+ */
+long countWindows(string fileName)
+{
+  if (!hasSuffix(fileName, ".root")) fileName += ".root";
+  unique_ptr<TFile> file(TFile::Open(fileName.c_str(), "READ"));
+  if (!file || file->IsZombie()) return -1;
+  auto tree = dynamic_cast<TTree*>(file->Get("T"));
+  return tree ? tree->GetEntries() : -1;
+}
+
+/**
+ * Slice of the run given with WindowRange_* user parameters
+ */
+WindowRange readRange(const pt::ptree& params)
+{
+  auto get = [&params] (const string& key) {
+    return params.get_optional<double>(pt::ptree::path_type(key, '\0'));
+  };
+  WindowRange range;
+  if (auto first = get(WindowIndexer::kFirstWindowParamKey)) range.firstWindow = *first;
+  if (auto last = get(WindowIndexer::kLastWindowParamKey)) range.lastWindow = *last;
+  auto startTime = get(WindowIndexer::kStartTimeParamKey);
+  auto endTime = get(WindowIndexer::kEndTimeParamKey);
+  if (startTime || endTime) {
+    range.hasTimeRange = true;
+    range.startTime = startTime ? *startTime : -numeric_limits<double>::max();
+    range.endTime = endTime ? *endTime : numeric_limits<double>::max();
+  }
+  return range;
+}
+
+/**
+ * Arguments of the framework given to the driver, with the paths made absolute
+ * and the options set separately for each process taken out
+ */
+struct AnalysisArguments {
+  vector<string> common;
+  string input;
+  string userParams;
+  string outputDirectory;
+  long firstWindow = -1;
+  long lastWindow = -1;
+};
+
+bool parseAnalysisArguments(const vector<string>& arguments, AnalysisArguments& analysis)
+{
+  for (size_t i = 0; i < arguments.size(); i++) {
+    const string& argument = arguments[i];
+    bool hasValue = i + 1 < arguments.size();
+    if (argument == "-r" && i + 2 < arguments.size()) {
+      analysis.firstWindow = stol(arguments[i + 1]);
+      analysis.lastWindow = stol(arguments[i + 2]);
+      i += 2;
+    } else if ((argument == "-u" || argument == "-o") && hasValue) {
+      (argument == "-u" ? analysis.userParams : analysis.outputDirectory) = getAbsolutePath(arguments[++i]);
+    } else if ((argument == "-f" || argument == "-l") && hasValue) {
+      if (argument == "-f") analysis.input = getAbsolutePath(arguments[i + 1]);
+      analysis.common.push_back(argument);
+      analysis.common.push_back(getAbsolutePath(arguments[++i]));
+    } else {
+      analysis.common.push_back(argument);
+    }
+  }
+  return !analysis.input.empty();
+}
+
+/**
+ * Starting the analysis in a new process, in the given directory
+ * if it is not empty
+ */
+pid_t startProcess(vector<string> arguments, const string& directory)
+{
+  pid_t child = fork();
+  if (child == 0) {
+    // Log of the framework is written to the current directory
+    if (!directory.empty() && chdir(directory.c_str()) != 0) _exit(EXIT_FAILURE);
+    vector<char*> argv;
+    for (auto& argument : arguments) argv.push_back(&argument[0]);
+    argv.push_back(nullptr);
+    execv(argv[0], argv.data());
+    _exit(EXIT_FAILURE);
+  }
+  return child;
+}
+
+bool waitForProcess(pid_t child)
+{
+  int status = 0;
+  return waitpid(child, &status, 0) >= 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/**
+ * Joining ROOT files and indexes of the same names from directories of all
+ * shards, in the order of the shards
+ */
+bool mergeShards(const vector<string>& shardDirectories, const string& mergedDirectory)
+{
+  bool merged = true;
+  for (const string& suffix : {string(".root"), string(".index")}) {
+    for (const auto& name : listFiles(shardDirectories.front(), suffix)) {
+      vector<string> inputs;
+      for (const auto& directory : shardDirectories) {
+        string input = directory + "/" + name;
+        if (access(input.c_str(), R_OK) != 0) {
+          cerr << "File " << name << " is missing in " << directory << endl;
+          merged = false;
+          break;
+        }
+        inputs.push_back(input);
+      }
+      if (inputs.size() != shardDirectories.size()) continue;
+      cout << "Merging " << name << endl;
+      string output = mergedDirectory + "/" + name;
+      if (suffix == ".root" ? !ShardedRun::mergeFiles(inputs, output) : !ShardedRun::mergeIndexes(inputs, output)) {
+        merged = false;
+      }
+    }
+  }
+  return merged;
+}
+
+void printUsage(const char* program)
+{
+  cerr << "Usage: " << program << " -n <processes> [-w <windows>] [-d <work directory>] [--fit]"
+       << " <analysis executable> <options of the analysis>" << endl;
+}
+
+/**
+ * Analysis of one input split into shards of windows, processed at the same time
+ * by separate processes of the analysis executable, e.g.
+ * ./runSharded -n 16 --fit ../TimeCalibration/TimeCalibration.x -t root -f data.hld.root -l setup.json -i 4 -u userParams.json
+ * Each process runs in its own directory in the work directory, with the range
+ * of windows given with -r and the fits of calibration tasks deferred.
+ * A slice given with WindowRange_* parameters is found in the index of the input,
+ * so only its entries are split between the processes.
+ * Outputs of the processes are merged into the output directory given with -o,
+ * or into the merged directory of the work directory. With --fit the analysis
+ * is run once more, in the current directory, on one window, to fit
+ * the histograms of calibration tasks summed over all shards.
+ */
+int main(int argc, const char* argv[])
+{
+  int processes = 0;
+  long windows = -1;
+  bool fit = false;
+  string workDirectory = "shardedRun";
+  int argument = 1;
+  for (; argument < argc && argv[argument][0] == '-'; argument++) {
+    string option = argv[argument];
+    if (option == "--fit") {
+      fit = true;
+    } else if (option == "-n" && argument + 1 < argc) {
+      processes = atoi(argv[++argument]);
+    } else if (option == "-w" && argument + 1 < argc) {
+      windows = atol(argv[++argument]);
+    } else if (option == "-d" && argument + 1 < argc) {
+      workDirectory = argv[++argument];
+    } else {
+      printUsage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (processes < 1 || argument >= argc) {
+    printUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  string executable = getAbsolutePath(argv[argument++]);
+  AnalysisArguments analysis;
+  if (!parseAnalysisArguments(vector<string>(argv + argument, argv + argc), analysis)) {
+    cerr << "Input file of the analysis is not given with -f" << endl;
+    return EXIT_FAILURE;
+  }
+
+  pt::ptree commonParams;
+  if (!analysis.userParams.empty()) {
+    try {
+      pt::read_json(analysis.userParams, commonParams);
+    } catch (const pt::json_parser_error& error) {
+      cerr << "Unable to read the user parameters: " << error.what() << endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (analysis.firstWindow < 0) {
+    if (windows < 0) windows = countWindows(analysis.input);
+    if (windows <= 0) {
+      cerr << "Unable to read the number of windows of " << analysis.input << ", give it with -w" << endl;
+      return EXIT_FAILURE;
+    }
+    analysis.firstWindow = 0;
+    analysis.lastWindow = windows - 1;
+  }
+  auto slice = readRange(commonParams);
+  if (!ShardedRun::selectEntries(analysis.input, slice, analysis.firstWindow, analysis.lastWindow)) {
+    cerr << "No windows of " << analysis.input << " in the slice given with WindowRange_* parameters" << endl;
+    return EXIT_FAILURE;
+  }
+  auto ranges = ShardedRun::splitWindows(analysis.firstWindow, analysis.lastWindow, processes);
+  if (ranges.empty()) {
+    cerr << "Empty range of windows " << analysis.firstWindow << "-" << analysis.lastWindow << endl;
+    return EXIT_FAILURE;
+  }
+
+  // Processes run in their own directories, so paths to existing files are made absolute
+  for (auto& entry : commonParams) {
+    if (!hasSuffix(entry.first, "_std::string")) continue;
+    string value = entry.second.get_value<string>();
+    if (!value.empty() && access(value.c_str(), F_OK) == 0) entry.second.put_value(getAbsolutePath(value));
+  }
+  if (!makeDirectory(workDirectory)) {
+    cerr << "Unable to create directory " << workDirectory << endl;
+    return EXIT_FAILURE;
+  }
+  workDirectory = getAbsolutePath(workDirectory);
+  string mergedDirectory = analysis.outputDirectory.empty() ? workDirectory + "/merged" : analysis.outputDirectory;
+  if (!makeDirectory(mergedDirectory)) {
+    cerr << "Unable to create directory " << mergedDirectory << endl;
+    return EXIT_FAILURE;
+  }
+
+  auto start = chrono::steady_clock::now();
+  vector<pid_t> children;
+  vector<string> shardDirectories;
+  for (size_t shard = 0; shard < ranges.size(); shard++) {
+    string directory = workDirectory + "/shard" + to_string(shard);
+    if (!makeDirectory(directory)) {
+      cerr << "Unable to create directory " << directory << endl;
+      break;
+    }
+    pt::ptree params = commonParams;
+    // Indexes keep the numbers of windows in the whole run for the following tasks
+    params.put(pt::ptree::path_type(WindowIndexer::kEnabledParamKey, '\0'), true);
+    params.put(pt::ptree::path_type(ShardedRun::kDeferFitParamKey, '\0'), true);
+    string paramsFile = directory + "/userParams.json";
+    pt::write_json(paramsFile, params);
+    vector<string> arguments = {executable};
+    arguments.insert(arguments.end(), analysis.common.begin(), analysis.common.end());
+    arguments.insert(arguments.end(), {
+      "-u", paramsFile, "-o", directory,
+      "-r", to_string(ranges[shard].first), to_string(ranges[shard].second)
+    });
+    pid_t child = startProcess(arguments, directory);
+    if (child < 0) {
+      cerr << "Unable to start the process of shard " << shard << endl;
+      break;
+    }
+    cout << "Shard " << shard << ": windows " << ranges[shard].first << "-" << ranges[shard].second
+         << " in " << directory << endl;
+    children.push_back(child);
+    shardDirectories.push_back(directory);
+  }
+  bool succeeded = children.size() == ranges.size();
+  for (size_t shard = 0; shard < children.size(); shard++) {
+    if (!waitForProcess(children[shard])) {
+      cerr << "Shard " << shard << " failed, see the log in " << shardDirectories[shard] << endl;
+      succeeded = false;
+    }
+  }
+  if (!succeeded) return EXIT_FAILURE;
+  cout << "All shards finished in " << chrono::duration<double>(chrono::steady_clock::now() - start).count()
+       << " s" << endl;
+
+  if (!mergeShards(shardDirectories, mergedDirectory)) {
+    cerr << "Merging of the shards failed" << endl;
+    return EXIT_FAILURE;
+  }
+  cout << "Outputs merged in " << mergedDirectory << endl;
+
+  if (fit) {
+    string fitDirectory = workDirectory + "/fit";
+    if (!makeDirectory(fitDirectory)) {
+      cerr << "Unable to create directory " << fitDirectory << endl;
+      return EXIT_FAILURE;
+    }
+    pt::ptree params = commonParams;
+    params.put(pt::ptree::path_type(ShardedRun::kMergedDirectoryParamKey, '\0'), mergedDirectory);
+    string paramsFile = fitDirectory + "/userParams.json";
+    pt::write_json(paramsFile, params);
+    vector<string> arguments = {executable};
+    arguments.insert(arguments.end(), analysis.common.begin(), analysis.common.end());
+    arguments.insert(arguments.end(), {
+      "-u", paramsFile, "-o", fitDirectory,
+      "-r", to_string(ranges.front().first), to_string(ranges.front().first)
+    });
+    // Calibration results are written to the current directory, as in a run without shards
+    pid_t child = startProcess(arguments, "");
+    if (child < 0 || !waitForProcess(child)) {
+      cerr << "Fitting of the merged histograms failed" << endl;
+      return EXIT_FAILURE;
+    }
+    cout << "Merged histograms fitted" << endl;
+  }
+  return EXIT_SUCCESS;
+}
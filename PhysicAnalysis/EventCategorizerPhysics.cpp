@@ -77,6 +77,7 @@ bool EventCategorizerPhysics::init()
     WARNING(Form("No value of the %s parameter provided by the user. Using default value of %lf.", kDecayInto3MinAngleParamKey.c_str(), fDecayInto3MinAngle));
   }
 
+  fHistoRegistry.configure(fParams.getOptions());
   if (fSaveControlHistos) {
     getStatistics().createHistogram(
       new TH1F("AllHitTOT", "TOT of all Hits in physics stream", 200, 0.0, 100.0)
@@ -181,6 +182,7 @@ bool EventCategorizerPhysics::init()
     );
     getStatistics().getHisto1D("3AnnihTimeDiff")->SetXTitle("Time difference [ns]");
     getStatistics().getHisto1D("3AnnihTimeDiff")->SetYTitle("Counts");
+    fStreamHistos = EventCategorizerTools::getStreamHistos(getStatistics(), &fHistoRegistry);
   }
   return true;
 }
@@ -189,6 +191,7 @@ bool EventCategorizerPhysics::exec()
 {
   vector<JPetEvent> events;
   if (auto timeWindow = dynamic_cast<const JPetTimeWindow* const>(fEvent)) {
+    fHistoRegistry.beginWindow();
     uint n = timeWindow->getNumberOfEvents();
     for (uint i = 0; i < n; ++i) {
       const auto& event = dynamic_cast<const JPetEvent&>(timeWindow->operator[](i));
@@ -196,6 +199,7 @@ bool EventCategorizerPhysics::exec()
       JPetEvent physicEvent = physicsAnalysis(hits);
       if (physicEvent.getHits().size()) { events.push_back(physicEvent); }
     }
+    fHistoRegistry.endWindow();
   } else {
     return false;
   }
@@ -206,6 +210,7 @@ bool EventCategorizerPhysics::exec()
 
 bool EventCategorizerPhysics::terminate()
 {
+  fHistoRegistry.merge();
   INFO("Physics streaming ended.");
   return true;
 }
@@ -255,8 +260,9 @@ JPetEvent EventCategorizerPhysics::physicsAnalysis(vector<JPetHit> hits)
       );
     }
   }
+  auto streamHistos = fHistoRegistry.isWindowSampled() ? fStreamHistos : EventStreamHistos();
   if (EventCategorizerTools::stream2Gamma(
-    annihilationHits, getStatistics(), fSaveControlHistos,
+    annihilationHits, streamHistos,
     fBackToBackAngleWindow, fMaxTimeDiff)
   ) {
     if (physicEvent.isOnlyTypeOf(JPetEventType::kUnknown)) {
@@ -266,7 +272,7 @@ JPetEvent EventCategorizerPhysics::physicsAnalysis(vector<JPetHit> hits)
     }
   }
   if (EventCategorizerTools::stream3Gamma(
-    annihilationHits, getStatistics(), fSaveControlHistos,
+    annihilationHits, streamHistos,
     fDecayInto3MinAngle, fMaxTimeDiff, fMaxDistOfDecayPlaneFromCenter)
   ) {
     if (physicEvent.isOnlyTypeOf(JPetEventType::kUnknown)){
@@ -21,6 +21,8 @@
 #include <JPetEventType/JPetEventType.h>
 #include <JPetEvent/JPetEvent.h>
 #include <JPetHit/JPetHit.h>
+#include "../LargeBarrelAnalysis/EventCategorizerTools.h"
+#include "../LargeBarrelAnalysis/HistogramHandles.h"
 #include <vector>
 #include <map>
 
@@ -59,6 +61,8 @@ protected:
 	double fMaxTimeDiff = 1000.;
 	double fMaxZPos = 23.;
 	bool fSaveControlHistos = true;
+	HistoRegistry fHistoRegistry;
+	EventStreamHistos fStreamHistos;
 	void saveEvents(const std::vector<JPetEvent>& event);
 };
 
@@ -20,14 +20,18 @@
 #include <sstream>
 #include <cctype>
 #include "TimeCalibration.h"
+#include "TimeCalibrationTools.h"
 #include "TF1.h"
 #include "TString.h"
 #include <TDirectory.h>
 #include <vector>
+#include <map>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 #include <JPetOptionsTools/JPetOptionsTools.h>
+#include "../LargeBarrelAnalysis/ParallelFitter.h"
+#include "../LargeBarrelAnalysis/ShardedRun.h"
 
 using namespace jpet_options_tools;
 using namespace std;
@@ -69,45 +73,55 @@ bool TimeCalibration::init()
     StripToCalib = code % 100; // strip number
   }
 
-  INFO(Form("Calibrating scintillator %d from layer %d.", StripToCalib, LayerToCalib));
+  fAllStrips = isOptionSet(fParams.getOptions(), kAllStripsKey) && getOptionAsBool(fParams.getOptions(), kAllStripsKey);
+  fFitThreads = ParallelFitter::getNumberOfThreads(fParams.getOptions());
+  fPeakMethod = PeakEstimator::getMethod(fParams.getOptions());
+  if (fAllStrips) {
+    INFO("Calibrating all scintillators of the barrel.");
+  } else {
+    INFO(Form("Calibrating scintillator %d from layer %d.", StripToCalib, LayerToCalib));
+  }
+
+  fDeferFit = ShardedRun::isFitDeferred(fParams.getOptions());
 
   time(&local_time); //get the local time at which we start calibration
   //
-  std::ofstream output;
-
-  output.open(OutputFile, std::ios::app); //open the final output file in append mode
-  if (output.tellp() == 0) {             //if the file is empty/new write the header
-    output << "# Time calibration constants" << std::endl;
-    output << "# For side A we apply only the correction from refference detector, for side B the correction is equal to the sum of the A-B" << std::endl;
-    output << "# correction and offset with respect to the refference detector. For side A we report the sigmas and chi2/ndf for fit to the time difference spectra with refference detector" << std::endl;
-    output << "# while the same quality variables for fits to the A-B time difference are given for B side section" << std::endl;
-    output << "# Description of the parameters: layer(1-3) | slot(1-48/96) | side(A-B) | threshold(1-4) | offset_value_leading | offset_uncertainty_leading | offset_value_trailing | offset_uncertainty_trailing | sigma_offset_leading | sigma_offset_trailing | (chi2/ndf)_leading | (chi2/ndf)_trailing" << std::endl;
-    output << "# Calibration started on " << ctime(&local_time);
-  } else {
-    output << "# Calibration started on " << ctime(&local_time); //if the file was already on disk write only the time at which the calibration started
-    output.close();
+  //results are written only by the run fitting the merged histograms of the shards
+  if (!fDeferFit) {
+    std::ofstream output;
+
+    output.open(OutputFile, std::ios::app); //open the final output file in append mode
+    if (output.tellp() == 0) {             //if the file is empty/new write the header
+      output << "# Time calibration constants" << std::endl;
+      output << "# For side A we apply only the correction from refference detector, for side B the correction is equal to the sum of the A-B" << std::endl;
+      output << "# correction and offset with respect to the refference detector. For side A we report the sigmas and chi2/ndf for fit to the time difference spectra with refference detector" << std::endl;
+      output << "# while the same quality variables for fits to the A-B time difference are given for B side section" << std::endl;
+      output << "# Description of the parameters: layer(1-3) | slot(1-48/96) | side(A-B) | threshold(1-4) | offset_value_leading | offset_uncertainty_leading | offset_value_trailing | offset_uncertainty_trailing | sigma_offset_leading | sigma_offset_trailing | (chi2/ndf)_leading | (chi2/ndf)_trailing" << std::endl;
+      output << "# Calibration started on " << ctime(&local_time);
+    } else {
+      output << "# Calibration started on " << ctime(&local_time); //if the file was already on disk write only the time at which the calibration started
+      output.close();
+    }
   }
   //
-  for (int thr = 1; thr <= 4; thr++) { // loop over thresholds
-
-//histos for leading edge
-//		  const char * histo_name_l = formatUniqueSlotDescription(scin.at()->getBarrelSlot(), thr, "timeDiffAB_leading_");
-//
-    const char* histo_name_l = Form("%slayer_%d_slot_%d_thr_%d", "timeDiffAB_leading_", LayerToCalib, StripToCalib, thr);
-    getStatistics().createHistogram( new TH1F(histo_name_l, histo_name_l, 400, -20., 20.) );
-    //
-//histograms for leading edge refference detector time difference
-    const char* histo_name_Ref_l = Form("%slayer_%d_slot_%d_thr_%d", "timeDiffRef_leading_", LayerToCalib, StripToCalib, thr);
-    getStatistics().createHistogram( new TH1F(histo_name_Ref_l, histo_name_Ref_l, 800, -80., 80.) );
-    //
-//histos for trailing edge
-    const char* histo_name_t = Form("%slayer_%d_slot_%d_thr_%d", "timeDiffAB_trailing_", LayerToCalib, StripToCalib, thr);
-    getStatistics().createHistogram( new TH1F(histo_name_t, histo_name_t, 400, -20., 20.) );
-    //
-//histograms for leading edge refference detector time difference
-    const char* histo_name_Ref_t = Form("%slayer_%d_slot_%d_thr_%d", "timeDiffRef_trailing_", LayerToCalib, StripToCalib, thr);
-    getStatistics().createHistogram( new TH1F(histo_name_Ref_t, histo_name_Ref_t, 1000, -100., 100.) );
-    //
+  //strips of the barrel with IDs of their slots, ordered by layer and slot
+  std::map<std::pair<int, int>, std::vector<int>> strips;
+  for (auto& slot : getParamBank().getBarrelSlots()) {
+    int layer = fBarrelMap->getLayerNumber(slot.second->getLayer());
+    int strip = fBarrelMap->getSlotNumber(*slot.second);
+    strips[std::make_pair(layer, strip)].push_back(slot.first);
+  }
+  if (fAllStrips) {
+    for (auto& strip : strips) {
+      createStripHistos(strip.first.first, strip.first.second, strip.second);
+    }
+  } else {
+    createStripHistos(LayerToCalib, StripToCalib, strips[std::make_pair(LayerToCalib, StripToCalib)]);
+  }
+  //histograms summed over the shards of the run are only fitted
+  if (ShardedRun::hasMergedStatistics(fParams.getOptions())) {
+    if (!ShardedRun::loadMergedStatistics(fParams.getOptions(), getStatistics())) return false;
+    fFitOnly = true;
   }
   INFO("#############");
   INFO("CALIB_INIT: INITIALIZATION DONE!");
@@ -121,6 +135,7 @@ bool TimeCalibration::init()
 
 bool TimeCalibration::exec()
 {
+  if (fFitOnly) return true;
   double RefTimeLead[4] = { -1.e43, -1.e43, -1.e43, -1.e43};
   double RefTimeTrail[4] = { -1.e43, -1.e43, -1.e43, -1.e43};
   std::vector <JPetHit> fhitsCalib;
@@ -159,7 +174,9 @@ bool TimeCalibration::exec()
         fhitsCalib.push_back(hit);
       }
     }
-    //
+    //sorted once, nearest reference time of each hit is found with binary search
+    TimeCalibrationTools::sortReferenceTimes(fRefTimesL);
+    TimeCalibrationTools::sortReferenceTimes(fRefTimesT);
     for (auto i = fhitsCalib.begin(); i != fhitsCalib.end(); i++) {
       fillHistosForHit(*i, fRefTimesL, fRefTimesT);
     }
@@ -177,155 +194,184 @@ bool TimeCalibration::exec()
 
 bool TimeCalibration::terminate()
 {
+  if (fDeferFit) {
+    INFO("CALIB_INFO: Fits deferred to the merge of the shards of the run");
+    return true;
+  }
 
+  //
+  //all histograms are fitted at once, results are written in the order of strips and thresholds
+  //
+  ParallelFitter fitter(fFitThreads, fPeakMethod);
+  std::vector<TimeCalibrationFits> fits;
+  int emptyStrips = 0;
+  for (const auto& histos : fStripHistos) {
+    //strips with no hits at all are not reported one by one in the calibration of all strips
+    if (fAllStrips) {
+      bool empty = true;
+      for (int thr = 0; thr < 4; thr++) {
+        empty = empty && histos.timeDiffABLeading[thr]->GetEntries() == 0 && histos.timeDiffABTrailing[thr]->GetEntries() == 0;
+      }
+      if (empty) {
+        emptyStrips++;
+        continue;
+      }
+    }
+    addStripFits(histos, fitter, fits);
+  }
+  if (emptyStrips > 0) {
+    WARNING(Form("%d of %lu strips had no hits, they are not calibrated", emptyStrips, (unsigned long) fStripHistos.size()));
+  }
+  fitter.run();
+  fitter.reportFailures("TimeCalibration");
   //
   //create output txt file with calibration parameters
   //
   std::ofstream results_fit;
   results_fit.open(OutputFile, std::ios::app);
-  //
+  for (const auto& thresholdFits : fits) {
+    writeFits(thresholdFits, fitter, results_fit);
+  }
+  results_fit.close();
+
+  return true;
+}
+
+//////////////////////////////////
+
+void TimeCalibration::addStripFits(const TimeCalibrationHistos& histos, ParallelFitter& fitter, std::vector<TimeCalibrationFits>& fits)
+{
+  //fit in the range of 5 ns around the highest bin
+  auto addFit = [&fitter](TH1F* histo) {
+    int highestBin = histo->GetBinCenter(histo->GetMaximumBin());
+    return fitter.add(histo, highestBin - 5, highestBin + 5, histo->GetName());
+  };
   for (int thr = 1; thr <= 4; thr++) {
+    if (histos.timeDiffABLeading[thr - 1]->GetEntries() != 0 && histos.timeDiffABTrailing[thr - 1]->GetEntries() != 0
+        && histos.timeDiffRefLeading[thr - 1]->GetEntries() != 0 && histos.timeDiffRefTrailing[thr - 1]->GetEntries() != 0) {
+      TimeCalibrationFits thresholdFits;
+      thresholdFits.histos = &histos;
+      thresholdFits.thr = thr;
+      thresholdFits.leading = addFit(histos.timeDiffABLeading[thr - 1]);
+      thresholdFits.trailing = addFit(histos.timeDiffABTrailing[thr - 1]);
+      thresholdFits.refLeading = addFit(histos.timeDiffRefLeading[thr - 1]);
+      thresholdFits.refTrailing = addFit(histos.timeDiffRefTrailing[thr - 1]);
+      fits.push_back(thresholdFits);
+    } else {
+      ERROR(": ONE OF THE HISTOGRAMS FOR THRESHOLD " + std::to_string(thr) + " LAYER " + std::to_string(histos.layer) + " SLOT " + std::to_string(histos.slot) +
+            " IS EMPTY, WE CANNOT CALIBRATE IT");
+    }
+  }
+}
+
+//////////////////////////////////
+
+void TimeCalibration::writeFits(const TimeCalibrationFits& fits, const ParallelFitter& fitter, std::ofstream& results_fit)
+{
+  const int layer = fits.histos->layer;
+  const int slot = fits.histos->slot;
+  const int thr = fits.thr;
+  const FitJob& fit_l = fitter[fits.leading];
+  const FitJob& fit_t = fitter[fits.trailing];
+  const FitJob& fit_Ref_l = fitter[fits.refLeading];
+  const FitJob& fit_Ref_t = fitter[fits.refTrailing];
 //scintillators
 //
-    const char* histo_name_l = Form("%slayer_%d_slot_%d_thr_%d", "timeDiffAB_leading_", LayerToCalib, StripToCalib, thr);
-    //double mean_l = getStatistics().getHisto1D(histo_name_l).GetMean();
-    TH1F* histoToSave_leading = getStatistics().getHisto1D(histo_name_l);
-    //
-    const char* histo_name_t = Form("%slayer_%d_slot_%d_thr_%d", "timeDiffAB_trailing_", LayerToCalib, StripToCalib, thr);
-    //double mean_t = getStatistics().getHisto1D(histo_name_t).GetMean();
-
-    TH1F* histoToSave_trailing = getStatistics().getHisto1D(histo_name_t);
+  TH1F* histoToSave_leading = fit_l.histogram;
+  TH1F* histoToSave_trailing = fit_t.histogram;
 //reference detector
-    //
-    const char* histo_name_Ref_l = Form("%slayer_%d_slot_%d_thr_%d", "timeDiffRef_leading_", LayerToCalib, StripToCalib, thr);
-    //double mean_Ref_l = getStatistics().getHisto1D(histo_name_Ref_l).GetMean();
-    TH1F* histoToSave_Ref_leading = getStatistics().getHisto1D(histo_name_Ref_l);
-    //
-    const char* histo_name_Ref_t = Form("%slayer_%d_slot_%d_thr_%d", "timeDiffRef_trailing_", LayerToCalib, StripToCalib, thr);
-    //double mean_Ref_t = getStatistics().getHisto1D(histo_name_Ref_t).GetMean();
-    TH1F* histoToSave_Ref_trailing = getStatistics().getHisto1D(histo_name_Ref_t);
+  //
+  TH1F* histoToSave_Ref_leading = fit_Ref_l.histogram;
+  //
+  TH1F* histoToSave_Ref_trailing = fit_Ref_t.histogram;
 //
-    //
-    if (histoToSave_leading->GetEntries() != 0 && histoToSave_trailing->GetEntries() != 0
-        && histoToSave_Ref_leading->GetEntries() != 0 && histoToSave_Ref_trailing->GetEntries() != 0) {
-      INFO("#############");
-      INFO("CALIB_INFO: Fitting histogams for layer= " + std::to_string(LayerToCalib) + ", slot= " + std::to_string(StripToCalib) + ", threshold= " + std::to_string(thr));
-      INFO("#############");
-      if (histoToSave_Ref_leading->GetEntries() <= min_ev) {
-        results_fit << "#WARNING: Statistics used to determine the leading edge calibration constant with respect to the refference detector was less than " << min_ev << " events!" << endl;
-        WARNING(": Statistics used to determine the leading edge calibration constant with respect to the refference detector was less than " + std::to_string(min_ev) + " events!");
-      }
-      if (histoToSave_Ref_trailing->GetEntries() <= min_ev) {
-        results_fit << "#WARNING: Statistics used to determine the trailing edge calibration constant with respect to the refference detector was less than " << min_ev << " events!" << endl;
-        WARNING(": Statistics used to determine the trailing edge calibration constant with respect to the refference detector was less than " + std::to_string(min_ev) + " events!");
-      }
-      if (histoToSave_leading->GetEntries() <= min_ev) {
-        results_fit << "#WARNING: Statistics used to determine the leading edge A-B calibration constant was less than " << min_ev << " events!" << endl;
-        WARNING(": Statistics used to determine the leading edge A-B calibration constant was less than" + std::to_string(min_ev) + " events!");
-      }
-      if (histoToSave_trailing->GetEntries() <= min_ev) {
-        results_fit << "#WARNING: Statistics used to determine the trailing edge A-B calibration constant was less than " << min_ev << " events!" << endl;
-        WARNING(": Statistics used to determine the trailing edge A-B calibration constant was less than" + std::to_string(min_ev) + " events!");
-      }
+  if (histoToSave_Ref_leading->GetEntries() <= min_ev) {
+    results_fit << "#WARNING: Statistics used to determine the leading edge calibration constant with respect to the refference detector was less than " << min_ev << " events!" << endl;
+    WARNING(": Statistics used to determine the leading edge calibration constant with respect to the refference detector was less than " + std::to_string(min_ev) + " events!");
+  }
+  if (histoToSave_Ref_trailing->GetEntries() <= min_ev) {
+    results_fit << "#WARNING: Statistics used to determine the trailing edge calibration constant with respect to the refference detector was less than " << min_ev << " events!" << endl;
+    WARNING(": Statistics used to determine the trailing edge calibration constant with respect to the refference detector was less than " + std::to_string(min_ev) + " events!");
+  }
+  if (histoToSave_leading->GetEntries() <= min_ev) {
+    results_fit << "#WARNING: Statistics used to determine the leading edge A-B calibration constant was less than " << min_ev << " events!" << endl;
+    WARNING(": Statistics used to determine the leading edge A-B calibration constant was less than" + std::to_string(min_ev) + " events!");
+  }
+  if (histoToSave_trailing->GetEntries() <= min_ev) {
+    results_fit << "#WARNING: Statistics used to determine the trailing edge A-B calibration constant was less than " << min_ev << " events!" << endl;
+    WARNING(": Statistics used to determine the trailing edge A-B calibration constant was less than" + std::to_string(min_ev) + " events!");
+  }
+  if (!fit_l.succeeded || !fit_t.succeeded || !fit_Ref_l.succeeded || !fit_Ref_t.succeeded) {
+    results_fit << "#WFIT: Fit failed for layer " << layer << " slot " << slot << " threshold " << thr << ", not calibrated!" << endl;
+    return;
+  }
 //fit scintilators
-      int highestBin_l = histoToSave_leading->GetBinCenter(histoToSave_leading->GetMaximumBin());
-      histoToSave_leading->Fit("gaus", "", "", highestBin_l - 5, highestBin_l + 5);
-      histoToSave_leading->Draw();
-
-      int highestBin_t = histoToSave_trailing->GetBinCenter(histoToSave_trailing->GetMaximumBin());
-      histoToSave_trailing->Fit("gaus", "", "", highestBin_t - 5, highestBin_t + 5);
-      histoToSave_trailing->Draw();
-
-
-      TF1* fit_l = histoToSave_leading->GetFunction("gaus");
-      TF1* fit_t = histoToSave_trailing->GetFunction("gaus");
-
-      double position_peak_l = fit_l->GetParameter(1);
-      double position_peak_error_l = fit_l->GetParError(1);
-      double sigma_peak_l = fit_l->GetParameter(2);
-      double chi2_ndf_l = fit_l->GetChisquare() / fit_l->GetNDF();
-
-      double position_peak_t = fit_t->GetParameter(1);
-      double position_peak_error_t = fit_t->GetParError(1);
-      double sigma_peak_t = fit_t->GetParameter(2);
-      double chi2_ndf_t = fit_t->GetChisquare() / fit_t->GetNDF();
-
-      if ((position_peak_error_l / position_peak_l) >= frac_err) {
-        results_fit << "#WFIT: Large uncertainty on the calibration constant!" << endl;
-      }
+  double position_peak_l = fit_l.position;
+  double position_peak_error_l = fit_l.positionError;
+  double sigma_peak_l = fit_l.sigma;
+  double chi2_ndf_l = fit_l.chi2 / fit_l.ndf;
+
+  double position_peak_t = fit_t.position;
+  double position_peak_error_t = fit_t.positionError;
+  double sigma_peak_t = fit_t.sigma;
+  double chi2_ndf_t = fit_t.chi2 / fit_t.ndf;
+
+  if ((position_peak_error_l / position_peak_l) >= frac_err) {
+    results_fit << "#WFIT: Large uncertainty on the calibration constant!" << endl;
+  }
 
-      if ((position_peak_error_t / position_peak_t) >= frac_err) {
-        results_fit << "#WFIT: Large uncertainty on the calibration constant!" << endl;
-      }
+  if ((position_peak_error_t / position_peak_t) >= frac_err) {
+    results_fit << "#WFIT: Large uncertainty on the calibration constant!" << endl;
+  }
 
 //fit reference detector
+  //range to draw gaus function
+  histoToSave_Ref_leading->GetFunction("gaus")->SetRange(fit_Ref_l.rangeMin - 15, fit_Ref_l.rangeMax + 15);
+  histoToSave_Ref_trailing->GetFunction("gaus")->SetRange(fit_Ref_t.rangeMin - 15, fit_Ref_t.rangeMax + 15);
+
+  double position_peak_Ref_l = fit_Ref_l.position;
+  double position_peak_error_Ref_l = fit_Ref_l.positionError;
+  double sigma_peak_Ref_l = fit_Ref_l.sigma;
+  double chi2_ndf_Ref_l = fit_Ref_l.chi2 / fit_Ref_l.ndf;
+
+  double position_peak_Ref_t = fit_Ref_t.position;
+  double position_peak_error_Ref_t = fit_Ref_t.positionError;
+  double sigma_peak_Ref_t = fit_Ref_t.sigma;
+  double chi2_ndf_Ref_t = fit_Ref_t.chi2 / fit_Ref_t.ndf;
+
+  if ((position_peak_error_Ref_l / position_peak_Ref_l) >= frac_err) {
+    results_fit << "#WFIT: Large uncertainty on the calibration constant!" << endl;
+  }
 
-      int highestBin_Ref_l = histoToSave_Ref_leading->GetBinCenter(histoToSave_Ref_leading->GetMaximumBin());
-      histoToSave_Ref_leading->Fit("gaus", "", "", highestBin_Ref_l - 5, highestBin_Ref_l + 5); //range for fit
-      TF1* fit_Ref_l = histoToSave_Ref_leading->GetFunction("gaus");
-      fit_Ref_l->SetRange(highestBin_Ref_l - 20, highestBin_Ref_l + 20); //range to draw gaus function
-      histoToSave_Ref_leading->Draw();
-
-
-      int highestBin_Ref_t = histoToSave_Ref_trailing->GetBinCenter(histoToSave_Ref_trailing->GetMaximumBin());
-      histoToSave_Ref_trailing->Fit("gaus", "", "", highestBin_Ref_t - 5, highestBin_Ref_t + 5); //range for fit
-      TF1* fit_Ref_t = histoToSave_Ref_trailing->GetFunction("gaus");
-      fit_Ref_t->SetRange(highestBin_Ref_t - 20, highestBin_Ref_t + 20); //range to draw gaus function
-      histoToSave_Ref_trailing->Draw();
-
-
-      double position_peak_Ref_l = fit_Ref_l->GetParameter(1);
-      double position_peak_error_Ref_l = fit_Ref_l->GetParError(1);
-      double sigma_peak_Ref_l = fit_Ref_l->GetParameter(2);
-      double chi2_ndf_Ref_l = fit_Ref_l->GetChisquare() / fit_Ref_l->GetNDF();
-
-      double position_peak_Ref_t = fit_Ref_t->GetParameter(1);
-      double position_peak_error_Ref_t = fit_Ref_t->GetParError(1);
-      double sigma_peak_Ref_t = fit_Ref_t->GetParameter(2);
-      double chi2_ndf_Ref_t = fit_Ref_t->GetChisquare() / fit_Ref_t->GetNDF();
-
-      if ((position_peak_error_Ref_l / position_peak_Ref_l) >= frac_err) {
-        results_fit << "#WFIT: Large uncertainty on the calibration constant!" << endl;
-      }
-
-      if ((position_peak_error_Ref_t / position_peak_Ref_t) >= frac_err) {
-        results_fit << "#WFIT: Large uncertainty on the calibration constant!" << endl;
-      }
+  if ((position_peak_error_Ref_t / position_peak_Ref_t) >= frac_err) {
+    results_fit << "#WFIT: Large uncertainty on the calibration constant!" << endl;
+  }
 
-      //
+  //
 // writing to apropriate format (txt file)
 //We assume that all the corrections will be ADDED to the times of channels
 //side A
 //C2 = C2 - Cl(warstwa-1) (we correct the correction with respect to ref. detector only for L2 and L3
 //offset = -C2 (ref. det) + C1/2 (AB calib)
 
-      float CAl = -(position_peak_Ref_l - Cl[LayerToCalib - 1]) + position_peak_l / 2.;
-      float SigCAl = sqrt(pow(position_peak_error_Ref_l / 2., 2) + pow(position_peak_error_l, 2) + pow(SigCl[LayerToCalib - 1], 2));
-      float CAt = -(position_peak_Ref_t - Cl[LayerToCalib - 1]) + position_peak_t / 2.;
-      float SigCAt = sqrt(pow(position_peak_error_Ref_t / 2., 2) + pow(position_peak_error_t, 2) + pow(SigCl[LayerToCalib - 1], 2));
-      //
+  float CAl = -(position_peak_Ref_l - Cl[layer - 1]) + position_peak_l / 2.;
+  float SigCAl = sqrt(pow(position_peak_error_Ref_l / 2., 2) + pow(position_peak_error_l, 2) + pow(SigCl[layer - 1], 2));
+  float CAt = -(position_peak_Ref_t - Cl[layer - 1]) + position_peak_t / 2.;
+  float SigCAt = sqrt(pow(position_peak_error_Ref_t / 2., 2) + pow(position_peak_error_t, 2) + pow(SigCl[layer - 1], 2));
+  //
 //side B
 //C2 = C2 - Cl(warstwa-1) (we correct the correction with respect to ref. detector only for L2 and L3
 //offset = -C2 (ref. det) -C1/2 (AB calib)
-      float CBl = -(position_peak_Ref_l - Cl[LayerToCalib - 1]) - position_peak_l / 2.;
-      float SigCBl = SigCAl;
-      float CBt = -(position_peak_Ref_t - Cl[LayerToCalib - 1]) - position_peak_t / 2.;
-      float SigCBt = SigCAt;
-      //
-      results_fit << LayerToCalib << "\t" << StripToCalib << "\t" << "A" << "\t" << thr << "\t" << CAl << "\t" << SigCAl << "\t" << CAt << "\t" << SigCAt << "\t" << sigma_peak_Ref_l
-                  << "\t" << sigma_peak_Ref_t << "\t"  << chi2_ndf_Ref_l << "\t" << chi2_ndf_Ref_t << endl;
-      //
-      results_fit << LayerToCalib << "\t" << StripToCalib << "\t" << "B" << "\t" << thr << "\t" << CBl << "\t" << SigCBl << "\t" << CBt << "\t" << SigCBt << "\t" << sigma_peak_l
-                  << "\t" << sigma_peak_t << "\t" << chi2_ndf_l << "\t" << chi2_ndf_t << endl;
-    } else {
-      ERROR(": ONE OF THE HISTOGRAMS FOR THRESHOLD " + std::to_string(thr) + " LAYER " + std::to_string(LayerToCalib) + " SLOT " + std::to_string(StripToCalib) +
-            " IS EMPTY, WE CANNOT CALIBRATE IT");
-    }
-
-  }
-  results_fit.close();
-
-  return true;
+  float CBl = -(position_peak_Ref_l - Cl[layer - 1]) - position_peak_l / 2.;
+  float SigCBl = SigCAl;
+  float CBt = -(position_peak_Ref_t - Cl[layer - 1]) - position_peak_t / 2.;
+  float SigCBt = SigCAt;
+  //
+  results_fit << layer << "\t" << slot << "\t" << "A" << "\t" << thr << "\t" << CAl << "\t" << SigCAl << "\t" << CAt << "\t" << SigCAt << "\t" << sigma_peak_Ref_l
+              << "\t" << sigma_peak_Ref_t << "\t"  << chi2_ndf_Ref_l << "\t" << chi2_ndf_Ref_t << endl;
+  //
+  results_fit << layer << "\t" << slot << "\t" << "B" << "\t" << thr << "\t" << CBl << "\t" << SigCBl << "\t" << CBt << "\t" << SigCBt << "\t" << sigma_peak_l
+              << "\t" << sigma_peak_t << "\t" << chi2_ndf_l << "\t" << chi2_ndf_t << endl;
 }
 
 //////////////////////////////////
@@ -333,6 +379,11 @@ bool TimeCalibration::terminate()
 void TimeCalibration::fillHistosForHit(const JPetHit& hit, const std::vector<double>&   fRefTimesL, const std::vector<double>& fRefTimesT)
 {
 
+  //histograms of the strip of the hit, hits of strips not calibrated are skipped
+  int slotID = hit.getBarrelSlot().getID();
+  if (slotID < 0 || slotID >= (int) fSlotToStrip.size() || fSlotToStrip[slotID] < 0) return;
+  const auto& histos = fStripHistos[fSlotToStrip[slotID]];
+
   auto lead_times_A = hit.getSignalA().getRecoSignal().getRawSignal().getTimesVsThresholdNumber(JPetSigCh::Leading);
   auto trail_times_A = hit.getSignalA().getRecoSignal().getRawSignal().getTimesVsThresholdNumber(JPetSigCh::Trailing);
 
@@ -374,28 +425,22 @@ void TimeCalibration::fillHistosForHit(const JPetHit& hit, const std::vector<dou
       //**		const char * histo_name_l = Form("%slayer_%d_slot_%d_thr_%d","timeDiffAB_leading_",LayerToCalib,StripToCalib,thr);
       //**const char * histo_name_Ref_l = Form("%slayer_%d_slot_%d_thr_%d","timeDiffRef_leading_",LayerToCalib,StripToCalib,thr);
       //**std::cout << histo_name_l<<" "<<histo_name_l<< std::endl;
+      if (thr < 1 || thr > 4) continue;
       if ( lead_times_B.count(thr) > 0 ) { // if there was leading time at the same threshold at opposite side
         double timeDiffAB_l = lead_times_B[thr] - lead_times_A[thr];
         timeDiffAB_l /= 1000.; // we want the plots in ns instead of ps
 
         // fill the appropriate histogram
-        const char* histo_name_l = formatUniqueSlotDescription(hit.getBarrelSlot(), thr, "timeDiffAB_leading_");
-        //**const char * histo_name_l = Form("%slayer_%d_slot_%d_thr_%d","timeDiffAB_leading_",LayerToCalib,StripToCalib,thr);
-        getStatistics().getHisto1D(histo_name_l)->Fill( timeDiffAB_l);
+        histos.timeDiffABLeading[thr - 1]->Fill( timeDiffAB_l);
 //
 //take minimum time difference between Ref and Scint
-        timeDiffLmin = 10000000000000.;
-        for (unsigned int i = 0; i < fRefTimesL.size(); i++) {
-          double timeDiffHit_L = (lead_times_A[thr] + lead_times_B[thr]) / 2. - fRefTimesL[i];
-          timeDiffHit_L = timeDiffHit_L / 1000.; //ps -> ns
-          if (fabs(timeDiffHit_L) < timeDiffLmin) {
-            timeDiffLmin = timeDiffHit_L;
-          }
-        }
+        double timeDiffHit_L = 0.;
+        if (!TimeCalibrationTools::findNearestDifference(
+          fRefTimesL, (lead_times_A[thr] + lead_times_B[thr]) / 2., timeDiffHit_L)) continue;
+        timeDiffLmin = timeDiffHit_L / 1000.; //ps -> ns
         //**			const char * histo_name_Ref_l = Form("%slayer_%d_slot_%d_thr_%d","timeDiffRef_leading_",LayerToCalib,StripToCalib,thr);
-        const char* histo_name_Ref_l = formatUniqueSlotDescription(hit.getBarrelSlot(), thr, "timeDiffRef_leading_");
-        if (timeDiffTmin < 100.) {
-          getStatistics().getHisto1D(histo_name_Ref_l)->Fill(timeDiffLmin);
+        if (fabs(timeDiffLmin) < 100.) {
+          histos.timeDiffRefLeading[thr - 1]->Fill(timeDiffLmin);
         }
       }
     }
@@ -408,42 +453,59 @@ void TimeCalibration::fillHistosForHit(const JPetHit& hit, const std::vector<dou
       //**const char * histo_name_t = Form("%slayer_%d_slot_%d_thr_%d","timeDiffAB_trailing_",LayerToCalib,StripToCalib,thr);
       //**const char* histo_name_Ref_t = Form("%slayer_%d_slot_%d_thr_%d","timeDiffRef_trailing_",LayerToCalib,StripToCalib,thr);
 
+      if (thr < 1 || thr > 4) continue;
       if ( trail_times_B.count(thr) > 0 ) { // if there was trailing time at the same threshold at opposite side
 
         double timeDiffAB_t = trail_times_B[thr] - trail_times_A[thr];
         timeDiffAB_t /= 1000.; // we want the plots in ns instead of ps
 
         //fill the appropriate histogram
-        const char* histo_name_t = formatUniqueSlotDescription(hit.getBarrelSlot(), thr, "timeDiffAB_trailing_");
-        //**const char * histo_name_t = Form("%slayer_%d_slot_%d_thr_%d","timeDiffAB_trailing_",LayerToCalib,StripToCalib,thr);
-        getStatistics().getHisto1D(histo_name_t)->Fill( timeDiffAB_t);
+        histos.timeDiffABTrailing[thr - 1]->Fill( timeDiffAB_t);
 //
 //taken minimal time difference between Ref and Scint
-        timeDiffTmin = 10000000000000.;
-        for (unsigned int i = 0; i < fRefTimesT.size(); i++) {
-          double timeDiffHit_T = (trail_times_A[thr] + trail_times_B[thr]) / 2. - fRefTimesT[i];
-          timeDiffHit_T = timeDiffHit_T / 1000.; //ps->ns
-          if (fabs(timeDiffHit_T) < timeDiffTmin) {
-            timeDiffTmin = timeDiffHit_T;
-          }
-        }
+        double timeDiffHit_T = 0.;
+        if (!TimeCalibrationTools::findNearestDifference(
+          fRefTimesT, (trail_times_A[thr] + trail_times_B[thr]) / 2., timeDiffHit_T)) continue;
+        timeDiffTmin = timeDiffHit_T / 1000.; //ps->ns
         //**const char* histo_name_Ref_t = Form("%slayer_%d_slot_%d_thr_%d","timeDiffRef_trailing_",LayerToCalib,StripToCalib,thr);
-        const char* histo_name_Ref_t = formatUniqueSlotDescription(hit.getBarrelSlot(), thr, "timeDiffRef_trailing_");
-        if (timeDiffTmin < 100.) {
-          getStatistics().getHisto1D(histo_name_Ref_t)->Fill(timeDiffTmin);
+        if (fabs(timeDiffTmin) < 100.) {
+          histos.timeDiffRefTrailing[thr - 1]->Fill(timeDiffTmin);
         }
       }
     }
   }//end of the if for TOT cut
 }
 
-
-const char* TimeCalibration::formatUniqueSlotDescription(const JPetBarrelSlot& slot, int threshold, const char* prefix = "")
+void TimeCalibration::createStripHistos(int layer, int slot, const std::vector<int>& slotIDs)
 {
-
-  int slot_number = fBarrelMap->getSlotNumber(slot);
-  int layer_number = fBarrelMap->getLayerNumber(slot.getLayer());
-
-  return Form("%slayer_%d_slot_%d_thr_%d", prefix, layer_number, slot_number, threshold);
-
+  TimeCalibrationHistos histos;
+  histos.layer = layer;
+  histos.slot = slot;
+  for (int thr = 1; thr <= 4; thr++) { // loop over thresholds
+//histos for leading edge
+    const char* histo_name_l = Form("%slayer_%d_slot_%d_thr_%d", "timeDiffAB_leading_", layer, slot, thr);
+    getStatistics().createHistogram( new TH1F(histo_name_l, histo_name_l, 400, -20., 20.) );
+    histos.timeDiffABLeading[thr - 1] = getStatistics().getHisto1D(histo_name_l);
+    //
+//histograms for leading edge refference detector time difference
+    const char* histo_name_Ref_l = Form("%slayer_%d_slot_%d_thr_%d", "timeDiffRef_leading_", layer, slot, thr);
+    getStatistics().createHistogram( new TH1F(histo_name_Ref_l, histo_name_Ref_l, 800, -80., 80.) );
+    histos.timeDiffRefLeading[thr - 1] = getStatistics().getHisto1D(histo_name_Ref_l);
+    //
+//histos for trailing edge
+    const char* histo_name_t = Form("%slayer_%d_slot_%d_thr_%d", "timeDiffAB_trailing_", layer, slot, thr);
+    getStatistics().createHistogram( new TH1F(histo_name_t, histo_name_t, 400, -20., 20.) );
+    histos.timeDiffABTrailing[thr - 1] = getStatistics().getHisto1D(histo_name_t);
+    //
+//histograms for leading edge refference detector time difference
+    const char* histo_name_Ref_t = Form("%slayer_%d_slot_%d_thr_%d", "timeDiffRef_trailing_", layer, slot, thr);
+    getStatistics().createHistogram( new TH1F(histo_name_Ref_t, histo_name_Ref_t, 1000, -100., 100.) );
+    histos.timeDiffRefTrailing[thr - 1] = getStatistics().getHisto1D(histo_name_Ref_t);
+    //
+  }
+  for (auto slotID : slotIDs) {
+    if (slotID >= (int) fSlotToStrip.size()) fSlotToStrip.resize(slotID + 1, -1);
+    fSlotToStrip[slotID] = fStripHistos.size();
+  }
+  fStripHistos.push_back(histos);
 }
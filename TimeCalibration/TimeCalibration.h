@@ -20,12 +20,49 @@
 #include <JPetHit/JPetHit.h>
 #include <JPetRawSignal/JPetRawSignal.h>
 #include <JPetGeomMapping/JPetGeomMapping.h>
+#include "../LargeBarrelAnalysis/ParallelFitter.h"
+#include <fstream>
+#include <TH1F.h>
+#include <vector>
 class JPetWriter;
 #ifdef __CINT__
 //when cint is used instead of compiler, override word is not recognized
 //nevertheless it's needed for checking if the structure of project is correct
 #	define override
 #endif
+/**
+ * @brief Histograms of one calibrated strip, index of the array is the threshold number - 1
+ */
+struct TimeCalibrationHistos {
+	int layer = 0;
+	int slot = 0;
+	TH1F* timeDiffABLeading[4] = {nullptr, nullptr, nullptr, nullptr};
+	TH1F* timeDiffRefLeading[4] = {nullptr, nullptr, nullptr, nullptr};
+	TH1F* timeDiffABTrailing[4] = {nullptr, nullptr, nullptr, nullptr};
+	TH1F* timeDiffRefTrailing[4] = {nullptr, nullptr, nullptr, nullptr};
+};
+
+/**
+ * @brief Fits of one threshold of a strip, indexes of the fits in ParallelFitter
+ */
+struct TimeCalibrationFits {
+	const TimeCalibrationHistos* histos = nullptr;
+	int thr = 0;
+	size_t leading = 0;
+	size_t trailing = 0;
+	size_t refLeading = 0;
+	size_t refTrailing = 0;
+};
+
+/**
+ * @brief User Task: calibration of times of strips with the reference detector
+ *
+ * One strip, given with TimeWindowCreator_MainStrip, is calibrated in a run,
+ * or all strips of the barrel at once, if TimeCalibration_AllStrips_bool is set.
+ * Histograms of the strips are created in init() and kept in an array indexed
+ * by the barrel slot ID, all of them are fitted in terminate() at once with
+ * ParallelFitter, then the constants are written in the order of strips.
+ */
 class TimeCalibration:public JPetUserTask{
 public:
 	TimeCalibration(const char * name);
@@ -34,7 +71,9 @@ public:
 	virtual bool exec()override;
 	virtual bool terminate()override;
 protected:
-	const char * formatUniqueSlotDescription(const JPetBarrelSlot & slot, int threshold,const char * prefix);
+	void createStripHistos(int layer, int slot, const std::vector<int>& slotIDs);
+	void addStripFits(const TimeCalibrationHistos& histos, ParallelFitter& fitter, std::vector<TimeCalibrationFits>& fits);
+	void writeFits(const TimeCalibrationFits& fits, const ParallelFitter& fitter, std::ofstream& results_fit);
 	void fillHistosForHit(const JPetHit & hit,const std::vector<double> &RefTimesL,const std::vector<double> & RefTimesT);
 	JPetGeomMapping* fBarrelMap;
 	std::string OutputFile = "TimeConstantsCalib.txt";
@@ -46,10 +85,18 @@ protected:
 	const std::string fTOTcutLow  = "TOTcutLow";
 	const std::string fTOTcutHigh  = "TOTcutHigh";
 	const std::string kMainStripKey = "TimeWindowCreator_MainStrip";
+	const std::string kAllStripsKey = "TimeCalibration_AllStrips_bool";
 	double frac_err=0.3;  //maximal fractional uncertainty of parameters accepted by calibration
 	int min_ev = 100;     //minimal number of events for a distribution to be fitted                         
 	int LayerToCalib = 0; //Layer of calibrated slot
 	int StripToCalib = 0; //Slot to be calibrated
+	bool fAllStrips = false; //all strips of the barrel are calibrated in one pass
+	std::vector<TimeCalibrationHistos> fStripHistos; //histograms of the calibrated strips, ordered by layer and slot
+	std::vector<int> fSlotToStrip; //index in fStripHistos for each barrel slot ID, -1 if not calibrated
+	unsigned fFitThreads = 0; //threads of the fits in terminate(), 0 for one per core
+	PeakEstimator::Method fPeakMethod = PeakEstimator::kFit; //Gaussian fits or analytic estimates of peaks
+	bool fDeferFit = false; //histograms are fitted after the merge of shards of the run
+	bool fFitOnly = false;  //histograms are read from the merged shards, no windows are processed
 	float CAlTmp[4]    = {0.,0.,0.,0.};
 	float SigCAlTmp[4] = {0.,0.,0.,0.};
 	float CAtTemp[4]   = {0.,0.,0.,0.};
@@ -0,0 +1,50 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file TimeCalibrationTools.cpp
+ */
+
+#include "TimeCalibrationTools.h"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Sorting the times of the reference detector in a window. Hits of the reference
+ * detector are usually already ordered, then the check is the only cost.
+ */
+void TimeCalibrationTools::sortReferenceTimes(std::vector<double>& refTimes)
+{
+  if (!std::is_sorted(refTimes.begin(), refTimes.end())) {
+    std::sort(refTimes.begin(), refTimes.end());
+  }
+}
+
+/**
+ * Difference of the time and the nearest time of the reference detector,
+ * the times have to be sorted. Returns false if there are no reference times.
+ */
+bool TimeCalibrationTools::findNearestDifference(
+  const std::vector<double>& sortedRefTimes, double time, double& difference
+) {
+  if (sortedRefTimes.empty()) return false;
+  auto next = std::lower_bound(sortedRefTimes.begin(), sortedRefTimes.end(), time);
+  if (next == sortedRefTimes.end()) {
+    difference = time - sortedRefTimes.back();
+  } else if (next == sortedRefTimes.begin()) {
+    difference = time - *next;
+  } else {
+    double afterDiff = time - *next;
+    double beforeDiff = time - *(next - 1);
+    difference = std::fabs(beforeDiff) <= std::fabs(afterDiff) ? beforeDiff : afterDiff;
+  }
+  return true;
+}
@@ -0,0 +1,36 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file TimeCalibrationTools.h
+ */
+
+#ifndef TIMECALIBRATIONTOOLS_H
+#define TIMECALIBRATIONTOOLS_H
+
+#include <vector>
+
+/**
+ * @brief Tools for TimeCalibration module
+ *
+ * Times of the reference detector in a window are sorted once, then the
+ * nearest of them to a time of a hit is found with a binary search.
+ */
+class TimeCalibrationTools
+{
+public:
+  static void sortReferenceTimes(std::vector<double>& refTimes);
+  static bool findNearestDifference(
+    const std::vector<double>& sortedRefTimes, double time, double& difference
+  );
+};
+
+#endif /* !TIMECALIBRATIONTOOLS_H */
@@ -0,0 +1,107 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file TimeCalibrationToolsTest.cpp
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE TimeCalibrationToolsTest
+
+#include <boost/test/unit_test.hpp>
+#include "TimeCalibrationTools.h"
+#include <algorithm>
+#include <cmath>
+
+BOOST_AUTO_TEST_SUITE(TimeCalibrationToolsTestSuite)
+
+BOOST_AUTO_TEST_CASE(empty_test)
+{
+  std::vector<double> refTimes;
+  double difference = 123.0;
+  BOOST_REQUIRE(!TimeCalibrationTools::findNearestDifference(refTimes, 10.0, difference));
+  BOOST_REQUIRE_EQUAL(difference, 123.0);
+}
+
+BOOST_AUTO_TEST_CASE(outside_test)
+{
+  std::vector<double> refTimes = {100.0, 200.0, 300.0};
+  double difference = 0.0;
+  // Before the first time
+  BOOST_REQUIRE(TimeCalibrationTools::findNearestDifference(refTimes, 40.0, difference));
+  BOOST_REQUIRE_EQUAL(difference, -60.0);
+  // After the last time
+  BOOST_REQUIRE(TimeCalibrationTools::findNearestDifference(refTimes, 320.0, difference));
+  BOOST_REQUIRE_EQUAL(difference, 20.0);
+  // One reference time
+  std::vector<double> single = {50.0};
+  BOOST_REQUIRE(TimeCalibrationTools::findNearestDifference(single, 20.0, difference));
+  BOOST_REQUIRE_EQUAL(difference, -30.0);
+  BOOST_REQUIRE(TimeCalibrationTools::findNearestDifference(single, 70.0, difference));
+  BOOST_REQUIRE_EQUAL(difference, 20.0);
+}
+
+BOOST_AUTO_TEST_CASE(between_test)
+{
+  std::vector<double> refTimes = {100.0, 200.0, 300.0};
+  double difference = 0.0;
+  BOOST_REQUIRE(TimeCalibrationTools::findNearestDifference(refTimes, 140.0, difference));
+  BOOST_REQUIRE_EQUAL(difference, 40.0);
+  BOOST_REQUIRE(TimeCalibrationTools::findNearestDifference(refTimes, 170.0, difference));
+  BOOST_REQUIRE_EQUAL(difference, -30.0);
+  // Exactly at a reference time
+  BOOST_REQUIRE(TimeCalibrationTools::findNearestDifference(refTimes, 200.0, difference));
+  BOOST_REQUIRE_EQUAL(difference, 0.0);
+  BOOST_REQUIRE(TimeCalibrationTools::findNearestDifference(refTimes, 100.0, difference));
+  BOOST_REQUIRE_EQUAL(difference, 0.0);
+  BOOST_REQUIRE(TimeCalibrationTools::findNearestDifference(refTimes, 300.0, difference));
+  BOOST_REQUIRE_EQUAL(difference, 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(tie_test)
+{
+  // Equally distant reference times, the earlier one is taken
+  std::vector<double> refTimes = {100.0, 200.0};
+  double difference = 0.0;
+  BOOST_REQUIRE(TimeCalibrationTools::findNearestDifference(refTimes, 150.0, difference));
+  BOOST_REQUIRE_EQUAL(difference, 50.0);
+  // Repeated reference times
+  std::vector<double> repeated = {100.0, 100.0, 100.0, 200.0};
+  BOOST_REQUIRE(TimeCalibrationTools::findNearestDifference(repeated, 100.0, difference));
+  BOOST_REQUIRE_EQUAL(difference, 0.0);
+  BOOST_REQUIRE(TimeCalibrationTools::findNearestDifference(repeated, 120.0, difference));
+  BOOST_REQUIRE_EQUAL(difference, 20.0);
+}
+
+BOOST_AUTO_TEST_CASE(unsorted_test)
+{
+  std::vector<double> refTimes = {300.0, -50.0, 200.0, 100.0, 250.0};
+  TimeCalibrationTools::sortReferenceTimes(refTimes);
+  BOOST_REQUIRE(std::is_sorted(refTimes.begin(), refTimes.end()));
+  BOOST_REQUIRE_EQUAL(refTimes.size(), 5u);
+  // Same result as the linear search over the unsorted times
+  std::vector<double> unsorted = {300.0, -50.0, 200.0, 100.0, 250.0};
+  for (double time = -100.0; time <= 350.0; time += 7.0) {
+    double expected = time - unsorted[0];
+    for (double refTime : unsorted) {
+      if (std::fabs(time - refTime) < std::fabs(expected)) expected = time - refTime;
+    }
+    double difference = 0.0;
+    BOOST_REQUIRE(TimeCalibrationTools::findNearestDifference(refTimes, time, difference));
+    BOOST_REQUIRE_EQUAL(std::fabs(difference), std::fabs(expected));
+  }
+  // Sorted times are left as they are
+  std::vector<double> sorted = {1.0, 2.0, 3.0};
+  TimeCalibrationTools::sortReferenceTimes(sorted);
+  BOOST_REQUIRE(sorted == std::vector<double>({1.0, 2.0, 3.0}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,140 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file benchmarkTimeCalibration.cpp
+ */
+
+#include "TimeCalibrationTools.h"
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+/// Results of the measured calls are added here, so they are not optimized away
+static volatile double gSink = 0.0;
+
+/**
+ * Window of the reference run: times of the reference detector and mean times
+ * of hits of the strips, both uniform in the window, in ps.
+ */
+struct BenchmarkWindow {
+  vector<double> refTimes;
+  vector<double> hitTimes;
+};
+
+/**
+ * Nearest reference time searched in all of them, as done before
+ */
+double findNearestLinear(const vector<double>& refTimes, double time)
+{
+  double minDiff = 1.e43;
+  for (auto refTime : refTimes) {
+    double diff = time - refTime;
+    if (fabs(diff) < fabs(minDiff)) minDiff = diff;
+  }
+  return minDiff;
+}
+
+/**
+ * Nanoseconds per hit of the search in the windows, repeated until minTime
+ */
+template<class Search>
+double measure(vector<BenchmarkWindow>& windows, double minTime, Search search)
+{
+  double nanoseconds = 0.0;
+  unsigned long hits = 0;
+  while (nanoseconds < minTime * 1.0e9) {
+    for (auto& window : windows) {
+      auto start = chrono::steady_clock::now();
+      gSink = gSink + search(window);
+      nanoseconds += chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+      hits += window.hitTimes.size();
+    }
+  }
+  return nanoseconds / max(hits, 1ul);
+}
+
+int main(int argc, char* argv[])
+{
+  double minTime = 0.2;
+  double windowLength = 20.0e6;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    string flag = argv[i];
+    if (flag == "-t") minTime = atof(argv[i+1]);
+    else if (flag == "-w") windowLength = atof(argv[i+1]);
+    else {
+      cerr << "Usage: " << argv[0] << " [-t <min time per case in s>] [-w <window length in ps>]" << endl;
+      return EXIT_FAILURE;
+    }
+  }
+  // Rates of the reference detector and of hits of the strips in kHz
+  const vector<long> refRates = {10, 100, 1000, 10000};
+  const vector<long> hitRates = {100, 1000, 10000};
+  const int kWindows = 100;
+  mt19937 generator(2018);
+  uniform_real_distribution<double> uniform(0.0, windowLength);
+  cout << left << setw(16) << "ref rate [kHz]" << setw(16) << "hit rate [kHz]" << right
+    << setw(12) << "refs/window" << setw(14) << "linear [ns]" << setw(14) << "sorted [ns]"
+    << setw(10) << "speedup" << endl;
+  for (auto refRate : refRates) {
+    for (auto hitRate : hitRates) {
+      poisson_distribution<int> refCount(refRate * windowLength * 1.0e-9);
+      poisson_distribution<int> hitCount(hitRate * windowLength * 1.0e-9);
+      vector<BenchmarkWindow> windows(kWindows);
+      unsigned long refs = 0;
+      for (auto& window : windows) {
+        window.refTimes.resize(refCount(generator));
+        window.hitTimes.resize(hitCount(generator));
+        for (auto& time : window.refTimes) time = uniform(generator);
+        for (auto& time : window.hitTimes) time = uniform(generator);
+        sort(window.refTimes.begin(), window.refTimes.end());
+        refs += window.refTimes.size();
+      }
+      // Both searches have to give the same differences
+      for (const auto& window : windows) {
+        for (auto time : window.hitTimes) {
+          double difference = 0.0;
+          if (TimeCalibrationTools::findNearestDifference(window.refTimes, time, difference)
+            && fabs(difference) != fabs(findNearestLinear(window.refTimes, time))) {
+            cerr << "Different nearest reference time for hit at " << time << " ps" << endl;
+            return EXIT_FAILURE;
+          }
+        }
+      }
+      double linear = measure(windows, minTime, [](BenchmarkWindow& window) {
+        double sum = 0.0;
+        for (auto time : window.hitTimes) sum += findNearestLinear(window.refTimes, time);
+        return sum;
+      });
+      double sorted = measure(windows, minTime, [](BenchmarkWindow& window) {
+        // Times are sorted in each window, as done in TimeCalibration::exec()
+        TimeCalibrationTools::sortReferenceTimes(window.refTimes);
+        double sum = 0.0;
+        for (auto time : window.hitTimes) {
+          double difference = 0.0;
+          if (TimeCalibrationTools::findNearestDifference(window.refTimes, time, difference)) sum += difference;
+        }
+        return sum;
+      });
+      cout << left << setw(16) << refRate << setw(16) << hitRate << right << fixed << setprecision(1)
+        << setw(12) << (double) refs / kWindows << setw(14) << linear << setw(14) << sorted
+        << setw(10) << (sorted > 0.0 ? linear / sorted : 0.0) << endl;
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -19,6 +19,8 @@
 #include <iostream>
 #include <JPetOptionsTools/JPetOptionsTools.h>
 #include "DeltaTFinder.h"
+#include "../LargeBarrelAnalysis/ParallelFitter.h"
+#include "../LargeBarrelAnalysis/ShardedRun.h"
 
 
 using namespace std;
@@ -69,17 +71,24 @@ bool DeltaTFinder::init()
 
   int positions = std::stoi(sPos);
 
+  file_path = JPetCommonTools::extractFileNameFromFullPath( file_path );
+  file_path = JPetCommonTools::stripFileNameSuffix( file_path );
+  file_path = JPetCommonTools::stripFileNameSuffix( file_path );
+  fFileName = file_path;
+
   for (int i = 1; i <= positions; i++) {
     std::string pos = fPosition;
     pos += boost::lexical_cast<std::string>(i);
     pos += "_std::string";
     if (isOptionSet(fParams.getOptions(), pos)) {
       auto res = retrievePositionAndFileName(getOptionAsString(fParams.getOptions(), pos));
-      file_path = JPetCommonTools::extractFileNameFromFullPath( file_path );      
-      file_path = JPetCommonTools::stripFileNameSuffix( file_path );      
-      file_path = JPetCommonTools::stripFileNameSuffix( file_path );      
-      if ( file_path == res.second )
+      if ( res.second.empty() )
+        continue;
+      fNumberOfFiles++;
+      if ( file_path == res.second ) {
         fPos = res.first;
+        fPositionFound = true;
+      }
     }
   }
 
@@ -89,6 +98,32 @@ bool DeltaTFinder::init()
   if (isOptionSet(fParams.getOptions(), fVelocityCalibFile_key ) )
     fOutputVelocityCalibName = getOptionAsString(fParams.getOptions(),  fVelocityCalibFile_key );
 
+  if (isOptionSet(fParams.getOptions(), fSingleRun_key ))
+    fSingleRun = getOptionAsBool(fParams.getOptions(), fSingleRun_key );
+
+  if (isOptionSet(fParams.getOptions(), fSavePlots_key ))
+    fSavePlots = getOptionAsBool(fParams.getOptions(), fSavePlots_key );
+
+  if (isOptionSet(fParams.getOptions(), fVelocitiesFile_key ))
+    fOutputVelocitiesName = getOptionAsString(fParams.getOptions(), fVelocitiesFile_key );
+
+  fFitThreads = ParallelFitter::getNumberOfThreads(fParams.getOptions());
+  fPeakMethod = PeakEstimator::getMethod(fParams.getOptions());
+
+  fDeferFit = ShardedRun::isFitDeferred(fParams.getOptions());
+
+  // velocities need the histograms of all positions, that are not available to shards of one file
+  if (fSingleRun && (fDeferFit || ShardedRun::hasMergedStatistics(fParams.getOptions()))) {
+    ERROR("Single run velocity calibration cannot be used with sharded runs.");
+    return false;
+  }
+
+  // histograms summed over the shards of the run are only fitted
+  if (ShardedRun::hasMergedStatistics(fParams.getOptions())) {
+    if (!ShardedRun::loadMergedStatistics(fParams.getOptions(), getStatistics())) return false;
+    fFitOnly = true;
+  }
+
   return true;
 }
 
@@ -106,6 +141,7 @@ const char* DeltaTFinder::formatUniqueSlotDescription(const JPetBarrelSlot& slot
 
 bool DeltaTFinder::exec()
 {
+  if (fFitOnly) return true;
   if (auto timeWindow = dynamic_cast<const JPetTimeWindow* const>(fEvent)) {
     uint nhits = timeWindow->getNumberOfEvents();
     for (uint i = 0; i < nhits; ++i) {
@@ -120,6 +156,16 @@ bool DeltaTFinder::exec()
 
 bool DeltaTFinder::terminate()
 {
+  if (fDeferFit) {
+    INFO("DeltaT fits deferred to the merge of the shards of the run.");
+    delete fBarrelMap;
+    return true;
+  }
+  if (fSingleRun) {
+    bool added = addToDataset();
+    delete fBarrelMap;
+    return added;
+  }
   std::ofstream outStream;
   outStream.open( (fOutputPath + fOutputVelocityCalibName).c_str() , std::ios_base::app);
   std::map<int, char> thresholdConversionMap;
@@ -135,21 +181,31 @@ bool DeltaTFinder::terminate()
     return false;
   }
 
+  // all histograms are fitted at once, then drawn and written in the same order
+  ParallelFitter fitter(fFitThreads, fPeakMethod);
   for (auto & slot : getParamBank().getBarrelSlots()) {
     for (int thr = 1; thr <= 4; thr++) {
       const char* histo_name = formatUniqueSlotDescription(*(slot.second), thr, "timeDiffAB_");
       TH1F* histoToSave = getStatistics().getHisto1D(histo_name);
       int highestBin = histoToSave->GetBinCenter( histoToSave->GetMaximumBin() );
-      histoToSave->Fit("gaus", "", "", highestBin - fRangeAroundMaximumBin, highestBin + fRangeAroundMaximumBin);
+      fitter.add(histoToSave, highestBin - fRangeAroundMaximumBin, highestBin + fRangeAroundMaximumBin, histo_name);
+    }
+  }
+  fitter.run();
+  fitter.reportFailures("DeltaTFinder");
+
+  size_t job = 0;
+  for (auto & slot : getParamBank().getBarrelSlots()) {
+    for (int thr = 1; thr <= 4; thr++) {
+      const FitJob& fit = fitter[job++];
       TCanvas* c = new TCanvas();
-      histoToSave->Draw();
+      fit.histogram->Draw();
       std::string sHistoName = (std::string)results_folder_name;
-      sHistoName += "/" + std::string(histo_name) + "_position_" + boost::lexical_cast<std::string>(fPos) + ".png";
+      sHistoName += "/" + fit.label + "_position_" + boost::lexical_cast<std::string>(fPos) + ".png";
       c->SaveAs( (sHistoName).c_str() );
-      if ( histoToSave->GetEntries() != 0 ) {
-        TF1* fit = histoToSave->GetFunction("gaus");
-        outStream << slot.first << "\t" << fPos << "\t" << thresholdConversionMap[thr] << "\t" << fit->GetParameter(1)
-                  << "\t" << fit->GetParError(1) << "\t" << fit->GetChisquare() << "\t" << fit->GetNDF() << std::endl;
+      if ( fit.succeeded ) {
+        outStream << slot.first << "\t" << fPos << "\t" << thresholdConversionMap[thr] << "\t" << fit.position
+                  << "\t" << fit.positionError << "\t" << fit.chi2 << "\t" << fit.ndf << std::endl;
       }
 
     }
@@ -162,6 +218,58 @@ bool DeltaTFinder::terminate()
   return true;
 }
 
+/**
+ * Histograms of the file are added to the dataset shared by the tasks of all files,
+ * the task of the last file estimates the velocities and writes them.
+ * A file with no position is counted with no histograms, so that the last file is still found.
+ */
+bool DeltaTFinder::addToDataset()
+{
+  VelocityDataset& dataset = VelocityDataset::getShared();
+  std::lock_guard<std::mutex> lock(dataset.getMutex());
+  if (!dataset.addFile(fFileName)) {
+    WARNING("File " + fFileName + " was already added to the velocity calibration.");
+    return true;
+  }
+  if (!fPositionFound) {
+    WARNING("No position given for the file " + fFileName + ", it is not used for the velocity calibration.");
+  } else {
+    for (auto & slot : getParamBank().getBarrelSlots()) {
+      dataset.setSlot(slot.first, fBarrelMap->getLayerNumber(slot.second->getLayer()),
+                      fBarrelMap->getSlotNumber(*(slot.second)));
+      for (int thr = 1; thr <= 4; thr++) {
+        TH1F* histo = getStatistics().getHisto1D(formatUniqueSlotDescription(*(slot.second), thr, "timeDiffAB_"));
+        if (histo) dataset.add(fPos, slot.first, thr, *histo);
+      }
+    }
+  }
+  if ((int)dataset.getNumberOfFiles() < fNumberOfFiles) {
+    INFO(Form("File %s added to the velocity calibration, %lu of %d files done.",
+              fFileName.c_str(), dataset.getNumberOfFiles(), fNumberOfFiles));
+    return true;
+  }
+  if (dataset.getNumberOfPositions() == 0) {
+    ERROR("No file of the velocity calibration has a position, velocities are not estimated.");
+    dataset.clear();
+    return false;
+  }
+
+  INFO(Form("Estimating velocities from %lu positions.", dataset.getNumberOfPositions()));
+  auto results = dataset.estimateVelocities(fFitThreads, fPeakMethod, fRangeAroundMaximumBin);
+  if (fSavePlots) {
+    std::string results_folder_name = fOutputPath + "Results/velocities";
+    if (system(("mkdir -p " + results_folder_name).c_str()) == -1) {
+      ERROR("Error while creating the folder:" + results_folder_name);
+    } else {
+      dataset.savePlots(results_folder_name, results);
+    }
+  }
+  bool written = VelocityDataset::writeVelocities(fOutputPath + fOutputVelocitiesName, results);
+  dataset.clear();
+  INFO("Velocity calibration ended.");
+  return written;
+}
+
 void DeltaTFinder::fillHistosForHit(const JPetHit& hit)
 {
   
@@ -29,6 +29,8 @@
 #include <JPetParamManager/JPetParamManager.h>
 #include <JPetGeomMapping/JPetGeomMapping.h>
 #include <JPetCommonTools/JPetCommonTools.h>
+#include "../LargeBarrelAnalysis/PeakEstimator.h"
+#include "VelocityDataset.h"
 
 class JPetWriter;
 
@@ -48,6 +50,7 @@ protected:
 	static std::pair<int, std::string> retrievePositionAndFileName(const std::string inString);
 	const char * formatUniqueSlotDescription(const JPetBarrelSlot & slot, int threshold,const char * prefix);
 	void fillHistosForHit(const JPetHit& hit);
+	bool addToDataset();
 	JPetGeomMapping* fBarrelMap = nullptr;
   	bool fSaveControlHistos = true;
 	const std::string fInput_file_key = "inputFile_std::string";
@@ -55,9 +58,22 @@ protected:
 	const std::string fNumberOfPositionsKey = "DeltaTFinder_numberOfPositions_std::string";
 	const std::string fOutputPath_key = "DeltaTFinder_outputPath_std::string";
 	const std::string fVelocityCalibFile_key = "DeltaTFinder_velocityCalibFile_std::string";
+	const std::string fSingleRun_key = "DeltaTFinder_SingleRun_bool";
+	const std::string fSavePlots_key = "DeltaTFinder_SavePlots_bool";
+	const std::string fVelocitiesFile_key = "DeltaTFinder_EffVelocitiesFile_std::string";
 	std::string fOutputPath = "";
 	std::string fOutputVelocityCalibName = "";
 	double fPos = 999;
+	bool fPositionFound = false;
+	std::string fFileName = ""; // input file name with no path and extensions
+	int fNumberOfFiles = 0; // files of all positions given in the options
+	bool fSingleRun = false; // all positions are processed in one run, velocities are written at the end
+	bool fSavePlots = false; // plots of peaks and velocity fits of the single run mode
+	std::string fOutputVelocitiesName = "EffVelocities.txt";
  	const int fRangeAroundMaximumBin = 2;
+	unsigned fFitThreads = 0; // threads of the fits in terminate(), 0 for one per core
+	PeakEstimator::Method fPeakMethod = PeakEstimator::kFit; // Gaussian fits or analytic estimates of peaks
+	bool fDeferFit = false; // histograms are fitted after the merge of shards of the run
+	bool fFitOnly = false;  // histograms are read from the merged shards, no windows are processed
 };
 #endif /*  !DELTATFINDER_H */
@@ -0,0 +1,234 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file VelocityDataset.cpp
+ */
+
+#include <JPetLoggerInclude.h>
+#include "VelocityDataset.h"
+#include "../LargeBarrelAnalysis/ParallelFitter.h"
+#include <TGraphErrors.h>
+#include <TCanvas.h>
+#include <TString.h>
+#include <TF1.h>
+#include <fstream>
+#include <cmath>
+
+VelocityDataset& VelocityDataset::getShared()
+{
+  static VelocityDataset dataset;
+  return dataset;
+}
+
+void VelocityDataset::setSlot(int slotID, int layer, int slot)
+{
+  fSlots[slotID] = std::make_pair(layer, slot);
+}
+
+/**
+ * Histogram is added to the sum of its position, slot and threshold,
+ * the sum is created with the binning of the first added histogram
+ */
+void VelocityDataset::add(double position, int slotID, int threshold, const TH1F& histogram)
+{
+  auto& sum = fHistograms[position][std::make_pair(slotID, threshold)];
+  if (!sum) {
+    const char* name = Form("%s_position_%g", histogram.GetName(), position);
+    sum.reset(new TH1F(name, name, histogram.GetNbinsX(),
+      histogram.GetXaxis()->GetXmin(), histogram.GetXaxis()->GetXmax()));
+    sum->SetDirectory(nullptr);
+  }
+  sum->Add(&histogram);
+}
+
+/**
+ * Returns false if the file was already added
+ */
+bool VelocityDataset::addFile(const std::string& fileName)
+{
+  return fFiles.insert(fileName).second;
+}
+
+TH1F* VelocityDataset::getHistogram(double position, int slotID, int threshold) const
+{
+  auto histograms = fHistograms.find(position);
+  if (histograms == fHistograms.end()) return nullptr;
+  auto histogram = histograms->second.find(std::make_pair(slotID, threshold));
+  return histogram == histograms->second.end() ? nullptr : histogram->second.get();
+}
+
+/**
+ * Peaks of all histograms are fitted at once in the range around the highest bin,
+ * then for each slot and threshold the peak positions are fitted with
+ * a straight line vs the source positions. Positions with failed fits are omitted.
+ */
+std::vector<VelocityResult> VelocityDataset::estimateVelocities(
+  unsigned threads, PeakEstimator::Method method, double rangeAroundMaximum)
+{
+  ParallelFitter fitter(threads, method);
+  std::map<SlotThreshold, std::vector<std::pair<double, size_t>>> jobs;
+  for (const auto& position : fHistograms) {
+    for (const auto& histogram : position.second) {
+      TH1F* histo = histogram.second.get();
+      double highestBin = histo->GetBinCenter(histo->GetMaximumBin());
+      size_t job = fitter.add(histo, highestBin - rangeAroundMaximum,
+        highestBin + rangeAroundMaximum, histo->GetName());
+      jobs[histogram.first].push_back(std::make_pair(position.first, job));
+    }
+  }
+  fitter.run();
+  fitter.reportFailures("VelocityDataset");
+
+  std::vector<VelocityResult> results;
+  for (const auto& slotJobs : jobs) {
+    VelocityResult result;
+    result.slotID = slotJobs.first.first;
+    result.threshold = slotJobs.first.second;
+    auto slot = fSlots.find(result.slotID);
+    if (slot != fSlots.end()) {
+      result.layer = slot->second.first;
+      result.slot = slot->second.second;
+    }
+    for (const auto& positionJob : slotJobs.second) {
+      const FitJob& fit = fitter[positionJob.second];
+      if (!fit.succeeded || fit.positionError <= 0.0) continue;
+      result.positions.push_back(positionJob.first);
+      result.deltaT.push_back(fit.position);
+      result.deltaTErrors.push_back(fit.positionError);
+    }
+    calculateVelocity(result);
+    results.push_back(result);
+  }
+  return results;
+}
+
+/**
+ * Plots of the summed histograms of each position with their peaks
+ * and of the peak positions vs the source positions with the fitted lines
+ */
+void VelocityDataset::savePlots(const std::string& folder, const std::vector<VelocityResult>& results) const
+{
+  for (const auto& position : fHistograms) {
+    for (const auto& histogram : position.second) {
+      TCanvas canvas;
+      histogram.second->Draw();
+      canvas.SaveAs((folder + "/" + histogram.second->GetName() + ".png").c_str());
+    }
+  }
+  for (const auto& result : results) {
+    if (result.positions.empty()) continue;
+    TCanvas canvas;
+    TGraphErrors graph(result.positions.size(), result.positions.data(), result.deltaT.data(),
+      nullptr, result.deltaTErrors.data());
+    graph.SetTitle(Form("layer %d slot %d thr %d;Position [mm];TimeDiffAB [ns]",
+      result.layer, result.slot, result.threshold));
+    graph.SetMarkerStyle(20);
+    graph.Draw("AP");
+    TF1 line("pol1", "pol1", result.positions.front(), result.positions.back());
+    if (result.line.valid) {
+      line.SetParameter(0, result.line.offset);
+      line.SetParameter(1, result.line.slope);
+      line.Draw("same");
+    }
+    canvas.SaveAs(Form("%s/velocity_layer_%d_slot_%d_thr_%d.png", folder.c_str(),
+      result.layer, result.slot, result.threshold));
+  }
+}
+
+void VelocityDataset::clear()
+{
+  fFiles.clear();
+  fSlots.clear();
+  fHistograms.clear();
+}
+
+/**
+ * Weighted least squares with weights 1/yErrors^2, errors of the parameters
+ * are not scaled by chi2. At least two points are needed.
+ */
+bool VelocityDataset::fitLine(const std::vector<double>& x, const std::vector<double>& y,
+  const std::vector<double>& yErrors, LineFit& fit)
+{
+  fit = LineFit();
+  if (x.size() < 2 || x.size() != y.size() || x.size() != yErrors.size()) return false;
+  double s = 0.0, sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+  for (size_t i = 0; i < x.size(); i++) {
+    if (yErrors[i] <= 0.0) return false;
+    double weight = 1.0 / (yErrors[i] * yErrors[i]);
+    s += weight;
+    sx += weight * x[i];
+    sy += weight * y[i];
+    sxx += weight * x[i] * x[i];
+    sxy += weight * x[i] * y[i];
+  }
+  double determinant = s * sxx - sx * sx;
+  if (determinant <= 0.0) return false;
+  fit.slope = (s * sxy - sx * sy) / determinant;
+  fit.offset = (sxx * sy - sx * sxy) / determinant;
+  fit.slopeError = std::sqrt(s / determinant);
+  fit.offsetError = std::sqrt(sxx / determinant);
+  for (size_t i = 0; i < x.size(); i++) {
+    double residual = (y[i] - fit.offset - fit.slope * x[i]) / yErrors[i];
+    fit.chi2 += residual * residual;
+  }
+  fit.ndf = x.size() - 2;
+  fit.valid = true;
+  return true;
+}
+
+/**
+ * A-B time difference changes with the position z along the strip
+ * as -2z/v, so with positions in mm and times in ns the velocity in cm/ns
+ * is -0.2 divided by the slope of the line.
+ */
+bool VelocityDataset::calculateVelocity(VelocityResult& result)
+{
+  if (!fitLine(result.positions, result.deltaT, result.deltaTErrors, result.line)
+      || result.line.slope == 0.0) {
+    result.line.valid = false;
+    return false;
+  }
+  result.velocity = -0.2 / result.line.slope;
+  result.velocityError = 0.2 * result.line.slopeError / (result.line.slope * result.line.slope);
+  return true;
+}
+
+/**
+ * Velocities are written in the format of the effective velocities file
+ * read by HitFinder, with the same velocity for both sides of the slot.
+ * Slots and thresholds without a velocity are omitted.
+ */
+bool VelocityDataset::writeVelocities(const std::string& fileName, const std::vector<VelocityResult>& results)
+{
+  std::ofstream output(fileName.c_str());
+  if (!output.good()) {
+    ERROR("Cannot open the velocities file " + fileName);
+    return false;
+  }
+  int omitted = 0;
+  for (const auto& result : results) {
+    if (!result.line.valid) {
+      omitted++;
+      continue;
+    }
+    for (const char* side : {"A", "B"}) {
+      output << result.layer << "\t" << result.slot << "\t" << side << "\t" << result.threshold
+             << "\t" << result.velocity << "\t" << result.velocityError
+             << "\t0\t0\t0\t0\t0\t0" << std::endl;
+    }
+  }
+  if (omitted > 0) {
+    WARNING(Form("No velocity for %d of %lu thresholds of slots, not enough positions with a peak",
+      omitted, results.size()));
+  }
+  return true;
+}
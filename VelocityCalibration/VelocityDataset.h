@@ -0,0 +1,101 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file VelocityDataset.h
+ */
+
+#ifndef VELOCITYDATASET_H
+#define VELOCITYDATASET_H
+
+#include "../LargeBarrelAnalysis/PeakEstimator.h"
+#include <TH1F.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+
+/**
+ * @brief Straight line y = offset + slope * x fitted by weighted least squares
+ */
+struct LineFit {
+  bool valid = false;
+  double offset = 0.0;
+  double offsetError = 0.0;
+  double slope = 0.0;
+  double slopeError = 0.0;
+  double chi2 = 0.0;
+  int ndf = 0;
+};
+
+/**
+ * @brief Effective velocity of one threshold of a slot, in cm/ns
+ *
+ * Peak positions of the A-B time differences are given for each source
+ * position where the peak was found, in the order of positions.
+ */
+struct VelocityResult {
+  int slotID = 0;
+  int layer = 0;
+  int slot = 0;
+  int threshold = 0;
+  std::vector<double> positions;
+  std::vector<double> deltaT;
+  std::vector<double> deltaTErrors;
+  LineFit line;
+  double velocity = 0.0;
+  double velocityError = 0.0;
+};
+
+/**
+ * @brief A-B time differences of all source positions of the velocity calibration
+ *
+ * Histograms of each source position, slot and threshold are summed over
+ * the files of the position. Each DeltaTFinder adds the histograms of its
+ * file in terminate(), so the data of all positions is collected in one
+ * process. Once all files are added, peaks of all histograms are fitted at once
+ * and straight lines of the peak positions vs the source positions give
+ * the velocities, written in the format read by HitFinder. Since the tasks of
+ * the files can finish in any thread, the shared dataset has to be used with
+ * its mutex locked.
+ */
+class VelocityDataset
+{
+public:
+  static VelocityDataset& getShared();
+  std::mutex& getMutex() { return fMutex; }
+  void setSlot(int slotID, int layer, int slot);
+  void add(double position, int slotID, int threshold, const TH1F& histogram);
+  bool addFile(const std::string& fileName);
+  size_t getNumberOfFiles() const { return fFiles.size(); }
+  size_t getNumberOfPositions() const { return fHistograms.size(); }
+  TH1F* getHistogram(double position, int slotID, int threshold) const;
+  std::vector<VelocityResult> estimateVelocities(
+    unsigned threads, PeakEstimator::Method method, double rangeAroundMaximum);
+  void savePlots(const std::string& folder, const std::vector<VelocityResult>& results) const;
+  void clear();
+
+  static bool fitLine(const std::vector<double>& x, const std::vector<double>& y,
+    const std::vector<double>& yErrors, LineFit& fit);
+  static bool calculateVelocity(VelocityResult& result);
+  static bool writeVelocities(const std::string& fileName, const std::vector<VelocityResult>& results);
+
+private:
+  typedef std::pair<int, int> SlotThreshold;
+  std::mutex fMutex;
+  std::set<std::string> fFiles;
+  std::map<int, std::pair<int, int>> fSlots; //layer and slot numbers of slot IDs
+  std::map<double, std::map<SlotThreshold, std::unique_ptr<TH1F>>> fHistograms;
+};
+
+#endif /* !VELOCITYDATASET_H */
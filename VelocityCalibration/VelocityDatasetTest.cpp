@@ -0,0 +1,150 @@
+/**
+ *  @copyright Copyright 2018 The J-PET Framework Authors. All rights reserved.
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may find a copy of the License in the LICENCE file.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  @file VelocityDatasetTest.cpp
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE VelocityDatasetTest
+
+#include <boost/test/unit_test.hpp>
+#include "VelocityDataset.h"
+#include "../LargeBarrelAnalysis/UniversalFileLoader.h"
+#include <cstdio>
+#include <cmath>
+
+/**
+ * Peaks of the A-B time differences for the velocity of 12 cm/ns,
+ * deltaT = -2z/v, with z in mm and deltaT in ns
+ */
+VelocityResult createResult(double velocity, double error)
+{
+  VelocityResult result;
+  result.slotID = 50;
+  result.layer = 2;
+  result.slot = 2;
+  result.threshold = 3;
+  for (double z : {-100.0, 0.0, 100.0}) {
+    result.positions.push_back(z);
+    result.deltaT.push_back(1.5 - 2.0 * z / (10.0 * velocity));
+    result.deltaTErrors.push_back(error);
+  }
+  return result;
+}
+
+BOOST_AUTO_TEST_SUITE(VelocityDatasetTestSuite)
+
+BOOST_AUTO_TEST_CASE(fitLine_test)
+{
+  LineFit fit;
+  BOOST_REQUIRE(VelocityDataset::fitLine({0.0, 1.0, 2.0, 3.0}, {1.0, 3.0, 5.0, 7.0}, {0.1, 0.1, 0.1, 0.1}, fit));
+  BOOST_REQUIRE(fit.valid);
+  BOOST_REQUIRE_CLOSE(fit.slope, 2.0, 1e-9);
+  BOOST_REQUIRE_CLOSE(fit.offset, 1.0, 1e-9);
+  BOOST_REQUIRE_SMALL(fit.chi2, 1e-12);
+  BOOST_REQUIRE_EQUAL(fit.ndf, 2);
+  // Errors of the parameters for equal errors of points, x = 0..3
+  BOOST_REQUIRE_CLOSE(fit.slopeError, 0.1 / std::sqrt(5.0), 1e-9);
+  BOOST_REQUIRE_CLOSE(fit.offsetError, 0.1 * std::sqrt(14.0 / 20.0), 1e-9);
+
+  // Points are weighted with their errors
+  BOOST_REQUIRE(VelocityDataset::fitLine({0.0, 1.0, 2.0}, {0.0, 1.0, 4.0}, {0.001, 0.001, 100.0}, fit));
+  BOOST_REQUIRE_CLOSE(fit.slope, 1.0, 1e-3);
+  BOOST_REQUIRE(fit.chi2 > 0.0);
+
+  // Not enough points, no spread of positions or invalid errors
+  BOOST_REQUIRE(!VelocityDataset::fitLine({1.0}, {1.0}, {0.1}, fit));
+  BOOST_REQUIRE(!fit.valid);
+  BOOST_REQUIRE(!VelocityDataset::fitLine({}, {}, {}, fit));
+  BOOST_REQUIRE(!VelocityDataset::fitLine({1.0, 1.0}, {1.0, 2.0}, {0.1, 0.1}, fit));
+  BOOST_REQUIRE(!VelocityDataset::fitLine({1.0, 2.0}, {1.0, 2.0}, {0.1, 0.0}, fit));
+  BOOST_REQUIRE(!VelocityDataset::fitLine({1.0, 2.0}, {1.0}, {0.1, 0.1}, fit));
+}
+
+BOOST_AUTO_TEST_CASE(calculateVelocity_test)
+{
+  auto result = createResult(12.0, 0.1);
+  BOOST_REQUIRE(VelocityDataset::calculateVelocity(result));
+  BOOST_REQUIRE(result.line.valid);
+  BOOST_REQUIRE_CLOSE(result.velocity, 12.0, 1e-9);
+  // Error of the slope 0.1 / sqrt(20000) ns/mm for the slope -1/60 ns/mm
+  double slopeError = 0.1 / std::sqrt(20000.0);
+  BOOST_REQUIRE_CLOSE(result.line.slopeError, slopeError, 1e-9);
+  BOOST_REQUIRE_CLOSE(result.velocityError, 0.2 * slopeError * 3600.0, 1e-9);
+
+  // Same velocity as estimateVelocity, fitting positions vs deltaT
+  // with slope p1 [mm/ns] and velocity p1 * -0.2
+  double p1 = (result.positions.back() - result.positions.front())
+    / (result.deltaT.back() - result.deltaT.front());
+  BOOST_REQUIRE_CLOSE(result.velocity, p1 * -0.2, 1e-9);
+
+  // Two positions are enough, with no degrees of freedom
+  auto twoPositions = createResult(12.0, 0.1);
+  twoPositions.positions.pop_back();
+  twoPositions.deltaT.pop_back();
+  twoPositions.deltaTErrors.pop_back();
+  BOOST_REQUIRE(VelocityDataset::calculateVelocity(twoPositions));
+  BOOST_REQUIRE_EQUAL(twoPositions.line.ndf, 0);
+  BOOST_REQUIRE_CLOSE(twoPositions.velocity, 12.0, 1e-9);
+
+  // One position
+  auto onePosition = createResult(12.0, 0.1);
+  onePosition.positions.resize(1);
+  onePosition.deltaT.resize(1);
+  onePosition.deltaTErrors.resize(1);
+  BOOST_REQUIRE(!VelocityDataset::calculateVelocity(onePosition));
+  BOOST_REQUIRE(!onePosition.line.valid);
+
+  // Same time difference at all positions
+  auto flat = createResult(12.0, 0.1);
+  flat.deltaT = {1.0, 1.0, 1.0};
+  BOOST_REQUIRE(!VelocityDataset::calculateVelocity(flat));
+  BOOST_REQUIRE(!flat.line.valid);
+}
+
+BOOST_AUTO_TEST_CASE(writeVelocities_test)
+{
+  std::vector<VelocityResult> results;
+  results.push_back(createResult(12.0, 0.1));
+  results.push_back(createResult(13.0, 0.1));
+  results.back().slotID = 1;
+  results.back().layer = 1;
+  results.back().slot = 1;
+  results.back().threshold = 1;
+  results.push_back(createResult(12.0, 0.1));
+  results.back().deltaT = {1.0, 1.0, 1.0};
+  for (auto& result : results) VelocityDataset::calculateVelocity(result);
+
+  const std::string fileName = "VelocityDatasetTest.txt";
+  BOOST_REQUIRE(VelocityDataset::writeVelocities(fileName, results));
+  auto records = UniversalFileLoader::readConfigurationParametersFromFile(fileName);
+  std::remove(fileName.c_str());
+  // Both sides of the two slots with a velocity
+  BOOST_REQUIRE_EQUAL(records.size(), 4u);
+  BOOST_REQUIRE(UniversalFileLoader::areConfRecordsValid(records));
+  BOOST_REQUIRE_EQUAL(records[0].layer, 2);
+  BOOST_REQUIRE_EQUAL(records[0].slot, 2);
+  BOOST_REQUIRE_EQUAL(records[0].side, JPetPM::SideA);
+  BOOST_REQUIRE_EQUAL(records[0].thresholdNumber, 3);
+  BOOST_REQUIRE_EQUAL(records[1].side, JPetPM::SideB);
+  BOOST_REQUIRE_EQUAL(records[2].layer, 1);
+  BOOST_REQUIRE_EQUAL(records[2].thresholdNumber, 1);
+  BOOST_REQUIRE_EQUAL(records[0].parameters.size(), 8u);
+  BOOST_REQUIRE_CLOSE(records[0].parameters[0], 12.0, 1e-3);
+  BOOST_REQUIRE_CLOSE(records[0].parameters[1], results[0].velocityError, 1e-3);
+  BOOST_REQUIRE_CLOSE(records[3].parameters[0], 13.0, 1e-3);
+  BOOST_REQUIRE(records[0].parameters[1] > 0.0);
+
+  BOOST_REQUIRE(!VelocityDataset::writeVelocities("/nonexistent/directory/velocities.txt", results));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
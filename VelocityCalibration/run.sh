@@ -7,3 +7,7 @@
 wait
 
 ./estimateVelocity <resultFile>
+
+# With DeltaTFinder_SingleRun_bool set in userParams.json all positions are processed in one run,
+# velocities are written to EffVelocities.txt with no estimateVelocity step:
+# ./VelocityCalibration.x -t zip -f ./firstFile.xz ./secondFile.xz ./thirdFile.xz ./fourthFile.xz ./fifthFile.xz -p conf_trb3.xml -u userParams.json -i 2 -c ../../CalibrationFiles/?_RUN/<TOTconfigFile> -l ../../CalibrationFiles/?_RUN/detectorSetupRun?.json